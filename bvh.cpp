@@ -0,0 +1,629 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#include <algorithm>
+#include <vector>
+
+#include "bvh.h"
+#include "timer.h"
+
+
+#define BVH_NUM_BINS        16      // Candidate split planes per axis, between the bins.
+#define BVH_MAX_LEAF_PRIMS  4       // Larger leaves are split even if the SAH favours a leaf.
+#define BVH_MAX_DEPTH       48      // Deeper nodes are leaves, which bounds the traversal stacks.
+#define BVH_TRAVERSAL_COST  1.0f    // Cost of visiting a node, relative to testing a primitive's box.
+
+
+struct BVHNode
+{
+    float boxMin[3];
+    int first;          // For a leaf, its first primitive in primIndices; otherwise, its second child.
+    float boxMax[3];
+    int numPrims;       // 0 if the node is not a leaf, in which case its first child follows it.
+};
+
+
+struct BVH
+{
+    std::vector<BVHNode> nodes;     // In depth-first order, the root first.
+    std::vector<int> primIndices;   // The primitives of each leaf, one after the other.
+    std::vector<float> primBoxes;   // The boxes of the primitives, in the order of primIndices.
+    int maxDepth;
+};
+
+
+static BVHStats bvhStats;
+
+
+
+// Half the surface area of the box, which the SAH only compares.
+static float GetHalfArea(const float boxMin[3], const float boxMax[3])
+{
+    float dx = boxMax[0] - boxMin[0];
+    float dy = boxMax[1] - boxMin[1];
+    float dz = boxMax[2] - boxMin[2];
+    return dx * dy + dy * dz + dz * dx;
+}
+
+
+static void ClearBox(float boxMin[3], float boxMax[3])
+{
+    for (int a = 0; a < 3; a++) {
+        boxMin[a] = HUGE_VALF;
+        boxMax[a] = -HUGE_VALF;
+    }
+}
+
+
+static void GrowBox(float boxMin[3], float boxMax[3], const float *growMin, const float *growMax)
+{
+    for (int a = 0; a < 3; a++) {
+        if (growMin[a] < boxMin[a]) boxMin[a] = growMin[a];
+        if (growMax[a] > boxMax[a]) boxMax[a] = growMax[a];
+    }
+}
+
+
+// The bin of the centroid along the axis, for centroids from centroidMin
+// to centroidMin + extent.
+static int GetBin(float centroid, float centroidMin, float extent)
+{
+    int bin = (int)((centroid - centroidMin) * (BVH_NUM_BINS / extent));
+    return (bin < 0) ? 0 : (bin >= BVH_NUM_BINS) ? BVH_NUM_BINS - 1 : bin;
+}
+
+
+// Build the subtree of the primitives from primIndices[begin] to
+// primIndices[end - 1], which are reordered so that those of each leaf
+// are together. centroids holds 3 floats per primitive.
+static void BuildNode(BVH *bvh, const float *boxes, const float *centroids, int begin, int end, int depth)
+{
+    const int nodeIndex = (int)bvh->nodes.size();
+    bvh->nodes.push_back(BVHNode());
+    if (depth > bvh->maxDepth) bvh->maxDepth = depth;
+
+    float boxMin[3], boxMax[3], centroidMin[3], centroidMax[3];
+    ClearBox(boxMin, boxMax);
+    ClearBox(centroidMin, centroidMax);
+    for (int i = begin; i < end; i++) {
+        const int prim = bvh->primIndices[i];
+        GrowBox(boxMin, boxMax, &boxes[6 * prim], &boxes[6 * prim + 3]);
+        GrowBox(centroidMin, centroidMax, &centroids[3 * prim], &centroids[3 * prim]);
+    }
+    for (int a = 0; a < 3; a++) {
+        bvh->nodes[nodeIndex].boxMin[a] = boxMin[a];
+        bvh->nodes[nodeIndex].boxMax[a] = boxMax[a];
+    }
+
+    // Find the cheapest split between the bins of the centroids along each
+    // axis. Splitting costs a visit of the node and a test of the boxes of
+    // each child in proportion to the area of its box; not splitting costs
+    // a test of every box.
+    const int numPrims = end - begin;
+    const float nodeArea = GetHalfArea(boxMin, boxMax);
+    float bestCost = HUGE_VALF;
+    int bestAxis = -1, bestSplit = 0;
+
+    for (int a = 0; a < 3 && numPrims > 1 && depth < BVH_MAX_DEPTH; a++) {
+        const float extent = centroidMax[a] - centroidMin[a];
+        if (!(extent > 0.0f)) continue;
+
+        int binCounts[BVH_NUM_BINS] = { 0 };
+        float binMin[BVH_NUM_BINS][3], binMax[BVH_NUM_BINS][3];
+        for (int b = 0; b < BVH_NUM_BINS; b++) ClearBox(binMin[b], binMax[b]);
+        for (int i = begin; i < end; i++) {
+            const int prim = bvh->primIndices[i];
+            const int b = GetBin(centroids[3 * prim + a], centroidMin[a], extent);
+            binCounts[b]++;
+            GrowBox(binMin[b], binMax[b], &boxes[6 * prim], &boxes[6 * prim + 3]);
+        }
+
+        // Areas and counts of the bins right of each split, swept from the right.
+        float rightAreas[BVH_NUM_BINS];
+        int rightCounts[BVH_NUM_BINS];
+        float sweepMin[3], sweepMax[3];
+        ClearBox(sweepMin, sweepMax);
+        int count = 0;
+        for (int b = BVH_NUM_BINS - 1; b > 0; b--) {
+            GrowBox(sweepMin, sweepMax, binMin[b], binMax[b]);
+            count += binCounts[b];
+            rightAreas[b] = GetHalfArea(sweepMin, sweepMax);
+            rightCounts[b] = count;
+        }
+
+        ClearBox(sweepMin, sweepMax);
+        count = 0;
+        for (int b = 0; b < BVH_NUM_BINS - 1; b++) {
+            GrowBox(sweepMin, sweepMax, binMin[b], binMax[b]);
+            count += binCounts[b];
+            if (count == 0 || rightCounts[b + 1] == 0) continue;
+
+            const float cost = BVH_TRAVERSAL_COST +
+                               (GetHalfArea(sweepMin, sweepMax) * count + rightAreas[b + 1] * rightCounts[b + 1]) / nodeArea;
+            if (cost < bestCost) {
+                bestCost = cost;
+                bestAxis = a;
+                bestSplit = b;
+            }
+        }
+    }
+
+    // Large leaves are split even if the split costs more.
+    if (bestAxis < 0 || (bestCost >= (float)numPrims && numPrims <= BVH_MAX_LEAF_PRIMS)) {
+        bvh->nodes[nodeIndex].first = begin;
+        bvh->nodes[nodeIndex].numPrims = numPrims;
+        return;
+    }
+
+    // Move the primitives left of the split to the front.
+    const float extent = centroidMax[bestAxis] - centroidMin[bestAxis];
+    int split = begin;
+    for (int i = begin; i < end; i++) {
+        const int prim = bvh->primIndices[i];
+        if (GetBin(centroids[3 * prim + bestAxis], centroidMin[bestAxis], extent) <= bestSplit)
+            std::swap(bvh->primIndices[i], bvh->primIndices[split++]);
+    }
+
+    bvh->nodes[nodeIndex].numPrims = 0;
+    BuildNode(bvh, boxes, centroids, begin, split, depth + 1);
+    bvh->nodes[nodeIndex].first = (int)bvh->nodes.size();
+    BuildNode(bvh, boxes, centroids, split, end, depth + 1);
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Build a BVH over the numBoxes boxes, 6 floats each. Primitive i is the
+// one with the i-th box.
+/////////////////////////////////////////////////////////////////////////////
+
+BVH *BuildBVH(const float *boxes, int numBoxes)
+{
+    BVH *bvh = new BVH;
+    bvh->maxDepth = 0;
+    if (numBoxes <= 0) return bvh;
+
+    std::vector<float> centroids(3 * numBoxes);
+    for (int i = 0; i < numBoxes; i++) {
+        for (int a = 0; a < 3; a++)
+            centroids[3 * i + a] = 0.5f * (boxes[6 * i + a] + boxes[6 * i + 3 + a]);
+    }
+
+    bvh->primIndices.resize(numBoxes);
+    for (int i = 0; i < numBoxes; i++) bvh->primIndices[i] = i;
+    bvh->nodes.reserve(2 * numBoxes);
+    BuildNode(bvh, boxes, centroids.data(), 0, numBoxes, 0);
+
+    RefitBVH(bvh, boxes);
+    return bvh;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Update the bounds of the nodes to the new boxes of the primitives, of
+// which there must be as many as the BVH was built over.
+/////////////////////////////////////////////////////////////////////////////
+
+void RefitBVH(BVH *bvh, const float *boxes)
+{
+    const int numPrims = (int)bvh->primIndices.size();
+    bvh->primBoxes.resize(6 * numPrims);
+    for (int i = 0; i < numPrims; i++) {
+        const float *box = &boxes[6 * bvh->primIndices[i]];
+        std::copy(box, box + 6, &bvh->primBoxes[6 * i]);
+    }
+
+    // The children of a node come after it, so they are refitted first.
+    for (int n = (int)bvh->nodes.size() - 1; n >= 0; n--) {
+        BVHNode &node = bvh->nodes[n];
+        ClearBox(node.boxMin, node.boxMax);
+        if (node.numPrims > 0) {
+            for (int i = node.first; i < node.first + node.numPrims; i++)
+                GrowBox(node.boxMin, node.boxMax, &bvh->primBoxes[6 * i], &bvh->primBoxes[6 * i + 3]);
+        }
+        else {
+            GrowBox(node.boxMin, node.boxMax, bvh->nodes[n + 1].boxMin, bvh->nodes[n + 1].boxMax);
+            GrowBox(node.boxMin, node.boxMax, bvh->nodes[node.first].boxMin, bvh->nodes[node.first].boxMax);
+        }
+    }
+}
+
+
+
+// Test the box against the planes whose bits are set in *planeMask.
+// Returns false if the box is wholly outside one of them; otherwise clears
+// the bits of the planes that the box is wholly inside, which need not be
+// tested again for the boxes inside it.
+static bool TestBoxPlanes(const float *boxMin, const float *boxMax, const float (*planes)[4], int numPlanes,
+                          unsigned int *planeMask)
+{
+    for (int p = 0; p < numPlanes; p++) {
+        if ((*planeMask & (1u << p)) == 0) continue;
+
+        // The distances of the corners furthest along and against the normal.
+        const float *plane = planes[p];
+        float farDist = plane[3], nearDist = plane[3];
+        for (int a = 0; a < 3; a++) {
+            if (plane[a] >= 0.0f) {
+                farDist += plane[a] * boxMax[a];
+                nearDist += plane[a] * boxMin[a];
+            }
+            else {
+                farDist += plane[a] * boxMin[a];
+                nearDist += plane[a] * boxMax[a];
+            }
+        }
+        if (farDist < 0.0f) return false;
+        if (nearDist >= 0.0f) *planeMask &= ~(1u << p);
+    }
+    return true;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Set indices to the primitives whose boxes are not wholly outside any of
+// the numPlanes planes (up to 32), i.e. that may lie in the convex volume
+// where a*x + b*y + c*z + d >= 0 for every plane ( a, b, c, d ).
+// The indices are in no particular order.
+/////////////////////////////////////////////////////////////////////////////
+
+void QueryBVHFrustum(const BVH *bvh, const float (*planes)[4], int numPlanes, std::vector<int> *indices)
+{
+    indices->clear();
+    bvhStats.numFrustumQueries++;
+    if (bvh->nodes.empty()) return;
+    if (numPlanes > 32) numPlanes = 32;
+
+    // The nodes still to visit, with the planes that their boxes are not
+    // known to be wholly inside.
+    struct { int node; unsigned int planeMask; } stack[BVH_MAX_DEPTH + 2];
+    int stackSize = 0;
+    stack[stackSize].node = 0;
+    stack[stackSize++].planeMask = (numPlanes == 32) ? ~0u : (1u << numPlanes) - 1;
+
+    while (stackSize > 0) {
+        stackSize--;
+        const BVHNode &node = bvh->nodes[stack[stackSize].node];
+        unsigned int planeMask = stack[stackSize].planeMask;
+        bvhStats.numNodesVisited++;
+
+        if (planeMask != 0 && !TestBoxPlanes(node.boxMin, node.boxMax, planes, numPlanes, &planeMask)) continue;
+
+        if (node.numPrims > 0) {
+            for (int i = node.first; i < node.first + node.numPrims; i++) {
+                unsigned int primMask = planeMask;
+                if (primMask == 0 ||
+                    TestBoxPlanes(&bvh->primBoxes[6 * i], &bvh->primBoxes[6 * i + 3], planes, numPlanes, &primMask))
+                    indices->push_back(bvh->primIndices[i]);
+            }
+        }
+        else {
+            stack[stackSize].node = node.first;
+            stack[stackSize++].planeMask = planeMask;
+            stack[stackSize].node = (int)(&node - &bvh->nodes[0]) + 1;
+            stack[stackSize++].planeMask = planeMask;
+        }
+    }
+
+    bvhStats.numPrimsCulled += bvh->primIndices.size() - indices->size();
+}
+
+
+
+// Returns true if the ray from origin, with the reciprocals of the
+// components of its direction in invDirection, enters the box before
+// maxDistance, at the distance returned in entryDistance.
+static bool IntersectBoxRay(const float *boxMin, const float *boxMax, const float origin[3],
+                            const float invDirection[3], float maxDistance, float *entryDistance)
+{
+    float entry = 0.0f, exit = maxDistance;
+    for (int a = 0; a < 3; a++) {
+        float t0 = (boxMin[a] - origin[a]) * invDirection[a];
+        float t1 = (boxMax[a] - origin[a]) * invDirection[a];
+        if (t0 > t1) std::swap(t0, t1);
+        // NaNs, where the origin is on a side of the slab that the ray is
+        // parallel to, fail the comparisons and leave the interval as is.
+        if (t0 > entry) entry = t0;
+        if (t1 < exit) exit = t1;
+        if (entry > exit) return false;
+    }
+    *entryDistance = entry;
+    return true;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns the primitive whose box the ray from origin in the input
+// direction enters first, within maxDistance (in units of the length of
+// direction), or -1 if none. The distance to the box, which is 0 if the
+// origin is inside it, is returned in hitDistance if it is not NULL.
+/////////////////////////////////////////////////////////////////////////////
+
+int IntersectBVHRay(const BVH *bvh, const float origin[3], const float direction[3],
+                    float maxDistance, float *hitDistance)
+{
+    bvhStats.numRayQueries++;
+    if (bvh->nodes.empty()) return -1;
+
+    const float invDirection[3] = { 1.0f / direction[0], 1.0f / direction[1], 1.0f / direction[2] };
+    int hitPrim = -1;
+    float hitDist = maxDistance;
+
+    // The nearer child is visited first, so that the further one can be
+    // skipped if a box is hit before it.
+    struct { int node; float entryDistance; } stack[BVH_MAX_DEPTH + 2];
+    int stackSize = 0;
+    float entry;
+    if (!IntersectBoxRay(bvh->nodes[0].boxMin, bvh->nodes[0].boxMax, origin, invDirection, hitDist, &entry))
+        return -1;
+    stack[stackSize].node = 0;
+    stack[stackSize++].entryDistance = entry;
+
+    while (stackSize > 0) {
+        stackSize--;
+        if (stack[stackSize].entryDistance > hitDist) continue;
+        const int n = stack[stackSize].node;
+        const BVHNode &node = bvh->nodes[n];
+        bvhStats.numNodesVisited++;
+
+        if (node.numPrims > 0) {
+            for (int i = node.first; i < node.first + node.numPrims; i++) {
+                if (IntersectBoxRay(&bvh->primBoxes[6 * i], &bvh->primBoxes[6 * i + 3], origin, invDirection,
+                                    hitDist, &entry) && (hitPrim < 0 || entry < hitDist)) {
+                    hitPrim = bvh->primIndices[i];
+                    hitDist = entry;
+                }
+            }
+            continue;
+        }
+
+        float entries[2];
+        const int children[2] = { n + 1, node.first };
+        bool hits[2];
+        for (int c = 0; c < 2; c++)
+            hits[c] = IntersectBoxRay(bvh->nodes[children[c]].boxMin, bvh->nodes[children[c]].boxMax, origin,
+                                      invDirection, hitDist, &entries[c]);
+        const int nearer = (hits[0] && hits[1] && entries[1] < entries[0]) ? 1 : 0;
+        for (int c = 1; c >= 0; c--) {
+            const int child = (c == 0) ? nearer : 1 - nearer;
+            if (!hits[child]) continue;
+            stack[stackSize].node = children[child];
+            stack[stackSize++].entryDistance = entries[child];
+        }
+    }
+
+    if (hitPrim >= 0 && hitDistance != NULL) *hitDistance = hitDist;
+    return hitPrim;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Delete the BVH.
+/////////////////////////////////////////////////////////////////////////////
+
+void DeleteBVH(BVH *bvh)
+{
+    delete bvh;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Get the bounding box, 6 floats, of the box from boxMin to boxMax
+// transformed by the column-major 4x4 affine matrix.
+/////////////////////////////////////////////////////////////////////////////
+
+void GetTransformedBox(const float *matrix, const float boxMin[3], const float boxMax[3], float box[6])
+{
+    // Each coordinate of the transformed box is the sum of the extremes
+    // of the terms contributed by each input coordinate.
+    for (int i = 0; i < 3; i++) {
+        box[i] = box[3 + i] = matrix[12 + i];
+        for (int j = 0; j < 3; j++) {
+            const float a = matrix[4 * j + i] * boxMin[j];
+            const float b = matrix[4 * j + i] * boxMax[j];
+            box[i] += (a < b) ? a : b;
+            box[3 + i] += (a < b) ? b : a;
+        }
+    }
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Counts of the queries made and the nodes visited by them, and of the
+// primitives left out by the frustum queries, since the start of the
+// program.
+/////////////////////////////////////////////////////////////////////////////
+
+void GetBVHStats(BVHStats *stats)
+{
+    *stats = bvhStats;
+}
+
+
+
+// Uniformly distributed random number from 0 to 1.
+static float RandomFloat(void)
+{
+    return (float)rand() / (float)RAND_MAX;
+}
+
+
+// Set the planes of a view frustum with a 45-degree vertical field of view
+// and a 4:3 aspect ratio, from eye looking in the direction forward, which
+// is horizontal, out to farDist.
+static void GetViewFrustum(const float eye[3], const float forward[3], float farDist, float planes[6][4])
+{
+    const float tanY = tanf(22.5f * 3.14159265f / 180.0f);
+    const float tanX = tanY * 4.0f / 3.0f;
+    const float right[3] = { forward[1], -forward[0], 0.0f };
+    const float up[3] = { 0.0f, 0.0f, 1.0f };
+
+    // Side planes, through the eye, then the near and far planes.
+    for (int a = 0; a < 3; a++) {
+        planes[0][a] = tanX * forward[a] + right[a];
+        planes[1][a] = tanX * forward[a] - right[a];
+        planes[2][a] = tanY * forward[a] + up[a];
+        planes[3][a] = tanY * forward[a] - up[a];
+        planes[4][a] = forward[a];
+        planes[5][a] = -forward[a];
+    }
+    for (int p = 0; p < 6; p++)
+        planes[p][3] = -(planes[p][0] * eye[0] + planes[p][1] * eye[1] + planes[p][2] * eye[2]);
+    planes[4][3] -= 0.1f;
+    planes[5][3] += farDist;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Measure the time taken to build and to refit BVHs, and the throughput
+// of frustum and ray queries against testing every box, over the input
+// boxes and over sets of random boxes spread over their bounds, and print
+// the results. The results of the queries are checked against those of
+// testing every box.
+/////////////////////////////////////////////////////////////////////////////
+
+void BenchmarkBVH(const float *boxes, int numBoxes)
+{
+    const int numRuns = 5;
+    const int numViews = 256;
+    const int numRays = 4096;
+    const int setSizes[] = { numBoxes, 1000, 10000, 100000 };
+    const int numSets = sizeof(setSizes) / sizeof(setSizes[0]);
+
+    float sceneMin[3], sceneMax[3];
+    ClearBox(sceneMin, sceneMax);
+    for (int i = 0; i < numBoxes; i++) GrowBox(sceneMin, sceneMax, &boxes[6 * i], &boxes[6 * i + 3]);
+    if (numBoxes == 0) return;
+    float sceneExtent[3], diagonal = 0.0f;
+    for (int a = 0; a < 3; a++) {
+        sceneExtent[a] = sceneMax[a] - sceneMin[a];
+        diagonal += sceneExtent[a] * sceneExtent[a];
+    }
+    diagonal = sqrtf(diagonal);
+
+    // Views from inside the middle half of the bounds, looking in random
+    // horizontal directions, and rays from there in random directions.
+    srand(1);
+    std::vector<float> viewPlanes(numViews * 6 * 4);
+    for (int v = 0; v < numViews; v++) {
+        float eye[3];
+        for (int a = 0; a < 3; a++) eye[a] = sceneMin[a] + sceneExtent[a] * (0.25f + 0.5f * RandomFloat());
+        const float angle = 2.0f * 3.14159265f * RandomFloat();
+        const float forward[3] = { cosf(angle), sinf(angle), 0.0f };
+        GetViewFrustum(eye, forward, diagonal, (float (*)[4])&viewPlanes[v * 24]);
+    }
+    std::vector<float> rays(numRays * 6);
+    for (int r = 0; r < numRays; r++) {
+        for (int a = 0; a < 3; a++) {
+            rays[6 * r + a] = sceneMin[a] + sceneExtent[a] * (0.25f + 0.5f * RandomFloat());
+            rays[6 * r + 3 + a] = 2.0f * RandomFloat() - 1.0f;
+        }
+    }
+
+    printf("Best of %d runs. Frustum queries over %d views and ray queries over %d rays from inside the\n"
+           "bounds of the scene; 'linear' tests every box. Throughput in thousands of queries per second.\n\n",
+           numRuns, numViews, numRays);
+    printf("%-8s %8s %7s %6s %10s %10s %9s %9s %8s %9s %9s %10s\n", "boxes", "count", "nodes", "depth",
+           "build ms", "refit ms", "frustum", "linear", "kept", "ray", "linear", "mismatches");
+
+    for (int s = 0; s < numSets; s++) {
+        // Random boxes of sizes up to twice the spacing of boxes spread
+        // evenly over the bounds.
+        const int count = setSizes[s];
+        std::vector<float> setBoxes;
+        if (s == 0) {
+            setBoxes.assign(boxes, boxes + 6 * numBoxes);
+        }
+        else {
+            setBoxes.resize(6 * count);
+            const float spacing = cbrtf(sceneExtent[0] * sceneExtent[1] * sceneExtent[2] / count);
+            for (int i = 0; i < count; i++) {
+                for (int a = 0; a < 3; a++) {
+                    const float size = 2.0f * spacing * RandomFloat();
+                    setBoxes[6 * i + a] = sceneMin[a] + (sceneExtent[a] - size) * RandomFloat();
+                    setBoxes[6 * i + 3 + a] = setBoxes[6 * i + a] + size;
+                }
+            }
+        }
+
+        // Times for: build, refit, BVH frustum, linear frustum, BVH ray, linear ray.
+        double bestMs[6] = { -1.0, -1.0, -1.0, -1.0, -1.0, -1.0 };
+        BVH *bvh = NULL;
+        std::vector<int> indices;
+        size_t numKept = 0;
+        int numMismatches = 0;
+
+        for (int run = 0; run < numRuns; run++) {
+            double runMs[6];
+            double startMs = GetWallClockMs();
+            DeleteBVH(bvh);
+            bvh = BuildBVH(setBoxes.data(), count);
+            runMs[0] = GetWallClockMs() - startMs;
+
+            startMs = GetWallClockMs();
+            RefitBVH(bvh, setBoxes.data());
+            runMs[1] = GetWallClockMs() - startMs;
+
+            startMs = GetWallClockMs();
+            numKept = 0;
+            for (int v = 0; v < numViews; v++) {
+                QueryBVHFrustum(bvh, (const float (*)[4])&viewPlanes[v * 24], 6, &indices);
+                numKept += indices.size();
+            }
+            runMs[2] = GetWallClockMs() - startMs;
+
+            startMs = GetWallClockMs();
+            size_t numLinearKept = 0;
+            for (int v = 0; v < numViews; v++) {
+                for (int i = 0; i < count; i++) {
+                    unsigned int planeMask = 0x3F;
+                    if (TestBoxPlanes(&setBoxes[6 * i], &setBoxes[6 * i + 3],
+                                      (const float (*)[4])&viewPlanes[v * 24], 6, &planeMask))
+                        numLinearKept++;
+                }
+            }
+            runMs[3] = GetWallClockMs() - startMs;
+            numMismatches = (numLinearKept == numKept) ? 0 : 1;
+
+            startMs = GetWallClockMs();
+            std::vector<float> hitDists(numRays, -1.0f);
+            for (int r = 0; r < numRays; r++)
+                IntersectBVHRay(bvh, &rays[6 * r], &rays[6 * r + 3], diagonal, &hitDists[r]);
+            runMs[4] = GetWallClockMs() - startMs;
+
+            startMs = GetWallClockMs();
+            std::vector<float> linearHitDists(numRays, -1.0f);
+            for (int r = 0; r < numRays; r++) {
+                const float *direction = &rays[6 * r + 3];
+                const float invDirection[3] = { 1.0f / direction[0], 1.0f / direction[1], 1.0f / direction[2] };
+                float hitDist = diagonal, entry;
+                for (int i = 0; i < count; i++) {
+                    if (IntersectBoxRay(&setBoxes[6 * i], &setBoxes[6 * i + 3], &rays[6 * r], invDirection,
+                                        hitDist, &entry) && (linearHitDists[r] < 0.0f || entry < hitDist)) {
+                        hitDist = entry;
+                        linearHitDists[r] = entry;
+                    }
+                }
+            }
+            runMs[5] = GetWallClockMs() - startMs;
+            for (int r = 0; r < numRays; r++)
+                if (hitDists[r] != linearHitDists[r]) numMismatches++;
+
+            for (int t = 0; t < 6; t++)
+                if (bestMs[t] < 0.0 || runMs[t] < bestMs[t]) bestMs[t] = runMs[t];
+        }
+
+        printf("%-8s %8d %7d %6d %10.3f %10.3f %9.1f %9.1f %7.1f%% %9.1f %9.1f %10d\n",
+               (s == 0) ? "scene" : "random", count, (int)bvh->nodes.size(), bvh->maxDepth, bestMs[0], bestMs[1],
+               numViews / bestMs[2], numViews / bestMs[3], 100.0 * numKept / ((double)numViews * count),
+               numRays / bestMs[4], numRays / bestMs[5], numMismatches);
+        DeleteBVH(bvh);
+    }
+}
@@ -0,0 +1,110 @@
+#ifndef _BVH_H_
+#define _BVH_H_
+
+#include <stddef.h>
+#include <vector>
+
+/////////////////////////////////////////////////////////////////////////////
+// Bounding volume hierarchy.
+//
+// A BVH is built over the axis-aligned bounding boxes of a set of
+// primitives, such as the parts of the scene, each given by 6 floats: its
+// minimum x, y and z, then its maximum x, y and z. The tree is built top
+// down, splitting each node where the surface area heuristic (SAH) finds
+// it cheapest to test the boxes below it, and is stored in depth-first
+// order in a flat array of 32-byte nodes, with the first child of a node
+// right after it. The primitives of a leaf are stored together too.
+//
+// The BVH answers which primitives may lie inside a convex volume, such
+// as a view frustum, and which primitive's box a ray hits first. When the
+// primitives move, the BVH is refitted to their new boxes without being
+// rebuilt, which keeps the queries exact but may make them slower.
+/////////////////////////////////////////////////////////////////////////////
+
+
+struct BVH;
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Build a BVH over the numBoxes boxes, 6 floats each. Primitive i is the
+// one with the i-th box.
+/////////////////////////////////////////////////////////////////////////////
+
+extern BVH *BuildBVH( const float *boxes, int numBoxes );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Update the bounds of the nodes to the new boxes of the primitives, of
+// which there must be as many as the BVH was built over.
+/////////////////////////////////////////////////////////////////////////////
+
+extern void RefitBVH( BVH *bvh, const float *boxes );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Set indices to the primitives whose boxes are not wholly outside any of
+// the numPlanes planes (up to 32), i.e. that may lie in the convex volume
+// where a*x + b*y + c*z + d >= 0 for every plane ( a, b, c, d ).
+// The indices are in no particular order.
+/////////////////////////////////////////////////////////////////////////////
+
+extern void QueryBVHFrustum( const BVH *bvh, const float (*planes)[4], int numPlanes,
+                             std::vector<int> *indices );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns the primitive whose box the ray from origin in the input
+// direction enters first, within maxDistance (in units of the length of
+// direction), or -1 if none. The distance to the box, which is 0 if the
+// origin is inside it, is returned in hitDistance if it is not NULL.
+/////////////////////////////////////////////////////////////////////////////
+
+extern int IntersectBVHRay( const BVH *bvh, const float origin[3], const float direction[3],
+                            float maxDistance, float *hitDistance );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Delete the BVH.
+/////////////////////////////////////////////////////////////////////////////
+
+extern void DeleteBVH( BVH *bvh );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Get the bounding box, 6 floats, of the box from boxMin to boxMax
+// transformed by the column-major 4x4 affine matrix.
+/////////////////////////////////////////////////////////////////////////////
+
+extern void GetTransformedBox( const float *matrix, const float boxMin[3], const float boxMax[3],
+                               float box[6] );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Counts of the queries made and the nodes visited by them, and of the
+// primitives left out by the frustum queries, since the start of the
+// program.
+/////////////////////////////////////////////////////////////////////////////
+
+struct BVHStats
+{
+    size_t numFrustumQueries;
+    size_t numRayQueries;
+    size_t numNodesVisited;
+    size_t numPrimsCulled;
+};
+
+extern void GetBVHStats( BVHStats *stats );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Measure the time taken to build and to refit BVHs, and the throughput
+// of frustum and ray queries against testing every box, over the input
+// boxes and over sets of random boxes spread over their bounds, and print
+// the results. The results of the queries are checked against those of
+// testing every box.
+/////////////////////////////////////////////////////////////////////////////
+
+extern void BenchmarkBVH( const float *boxes, int numBoxes );
+
+
+#endif
@@ -0,0 +1,349 @@
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __APPLE__
+#define GL_SILENCE_DEPRECATION
+#include <GLUT/glut.h>
+#else
+#include <GL/glew.h>
+#include <GL/glut.h>
+#endif
+
+#include "culling.h"
+
+
+
+static bool cullingEnabled = false;
+static float projection[16];                        // Column-major, as in OpenGL.
+static float eyePlanes[MAX_CULLING_PLANES][4];      // Extra planes in eye coordinates.
+static int numEyePlanes = 0;
+static CullingStats cullingStats;
+
+static bool GetEyePlane(const double equation[4], float plane[4]);
+
+
+
+// Transform the point p (with w = 1) by the column-major 4x4 matrix m.
+static void TransformPoint(const float *m, const float p[3], float out[4])
+{
+    for (int i = 0; i < 4; i++)
+        out[i] = m[i] * p[0] + m[4 + i] * p[1] + m[8 + i] * p[2] + m[12 + i];
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Cull against the view frustum of the current projection matrix, until
+// DisableCulling(), with no extra planes.
+/////////////////////////////////////////////////////////////////////////////
+
+void SetCullingFrustum(void)
+{
+    glGetFloatv(GL_PROJECTION_MATRIX, projection);
+    numEyePlanes = 0;
+    cullingEnabled = true;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Cut the culling volume by the plane with the input equation, given in
+// the coordinates of the current modelview matrix as with glClipPlane():
+// the points where a*x + b*y + c*z + d >= 0 are kept. Up to
+// MAX_CULLING_PLANES planes can be added to each frustum.
+/////////////////////////////////////////////////////////////////////////////
+
+void AddCullingPlane(const double equation[4])
+{
+    if (numEyePlanes >= MAX_CULLING_PLANES) return;
+    if (GetEyePlane(equation, eyePlanes[numEyePlanes])) numEyePlanes++;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Make the near plane of the current projection matrix the plane with the
+// input equation, given as with AddCullingPlane(), so that the points
+// where a*x + b*y + c*z + d < 0 are clipped by the near plane, as by a
+// user clip plane, but without one. The eye must be on that side of the
+// plane. The far plane is tilted to keep the rest of the view frustum,
+// which leaves less depth precision the more oblique the plane is to the
+// view direction. See Eric Lengyel, "Oblique View Frustum Depth
+// Projection and Clipping", Journal of Game Development, 2005.
+/////////////////////////////////////////////////////////////////////////////
+
+void SetObliqueNearPlane(const double equation[4])
+{
+    float c[4];
+    if (!GetEyePlane(equation, c)) return;
+
+    float p[16];
+    glGetFloatv(GL_PROJECTION_MATRIX, p);
+
+    // The corner of the view frustum opposite the plane, on the far plane,
+    // in eye coordinates, is q = P^-1 ( sgn(c.x), sgn(c.y), 1, 1 ). The
+    // third row of P becomes the scaled plane minus the fourth row, so
+    // that z = -w on the plane, and z = w at q.
+    float q[4];
+    q[0] = (((c[0] > 0.0f) ? 1.0f : (c[0] < 0.0f) ? -1.0f : 0.0f) + p[8]) / p[0];
+    q[1] = (((c[1] > 0.0f) ? 1.0f : (c[1] < 0.0f) ? -1.0f : 0.0f) + p[9]) / p[5];
+    q[2] = -1.0f;
+    q[3] = (1.0f + p[10]) / p[14];
+    float scale = 2.0f / (c[0] * q[0] + c[1] * q[1] + c[2] * q[2] + c[3] * q[3]);
+
+    p[2] = scale * c[0] - p[3];
+    p[6] = scale * c[1] - p[7];
+    p[10] = scale * c[2] - p[11];
+    p[14] = scale * c[3] - p[15];
+
+    GLint matrixMode;
+    glGetIntegerv(GL_MATRIX_MODE, &matrixMode);
+    glMatrixMode(GL_PROJECTION);
+    glLoadMatrixf(p);
+    glMatrixMode(matrixMode);
+}
+
+
+
+// Transform the plane with the input equation, given in the coordinates of
+// the current modelview matrix, into eye coordinates, as glClipPlane()
+// does. Returns false if the modelview matrix is singular.
+static bool GetEyePlane(const double equation[4], float plane[4])
+{
+    // The plane is transformed by the inverse of the modelview matrix,
+    // which is affine, so its inverse is that of the upper-left 3x3 part A
+    // and the translation t: the eye-space plane is (n A^-1, d - n A^-1 t).
+    float m[16];
+    glGetFloatv(GL_MODELVIEW_MATRIX, m);
+    float c[9] = {
+        m[5] * m[10] - m[6] * m[9],  m[6] * m[8] - m[4] * m[10],  m[4] * m[9] - m[5] * m[8],
+        m[2] * m[9] - m[1] * m[10],  m[0] * m[10] - m[2] * m[8],  m[1] * m[8] - m[0] * m[9],
+        m[1] * m[6] - m[2] * m[5],   m[2] * m[4] - m[0] * m[6],   m[0] * m[5] - m[1] * m[4]
+    };
+    float det = m[0] * c[0] + m[1] * c[1] + m[2] * c[2];
+    if (det == 0.0f) return false;
+
+    // The columns of c are the rows of the inverse of A times det.
+    for (int j = 0; j < 3; j++)
+        plane[j] = (float)((equation[0] * c[j] + equation[1] * c[3 + j] + equation[2] * c[6 + j]) / det);
+    plane[3] = (float)equation[3] - (plane[0] * m[12] + plane[1] * m[13] + plane[2] * m[14]);
+    return true;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Get the planes of the culling volume in the coordinates of the current
+// modelview matrix, in the form of AddCullingPlane(), e.g. in world space
+// to query a BVH over the scene. Returns the number of planes, which is at
+// most MAX_CULLING_VOLUME_PLANES, or 0 if culling is disabled.
+/////////////////////////////////////////////////////////////////////////////
+
+int GetCullingPlanes(float planes[][4])
+{
+    if (!cullingEnabled) return 0;
+
+    float modelview[16];
+    glGetFloatv(GL_MODELVIEW_MATRIX, modelview);
+
+    // A plane e of eye space is the plane e M of the modelview matrix M's
+    // input space, and the planes of the frustum, -w <= x, y, z <= w, are
+    // the sums and differences of the rows of the projection matrix P in
+    // eye space, so they are those of P M here.
+    float rows[4][4];
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 4; j++)
+            rows[i][j] = projection[i] * modelview[4 * j] + projection[4 + i] * modelview[4 * j + 1] +
+                         projection[8 + i] * modelview[4 * j + 2] + projection[12 + i] * modelview[4 * j + 3];
+    }
+    int numPlanes = 0;
+    for (int p = 0; p < 6; p++, numPlanes++) {
+        float sign = (p & 1) ? -1.0f : 1.0f;
+        for (int j = 0; j < 4; j++) planes[numPlanes][j] = rows[3][j] + sign * rows[p / 2][j];
+    }
+
+    for (int p = 0; p < numEyePlanes; p++, numPlanes++) {
+        for (int j = 0; j < 4; j++)
+            planes[numPlanes][j] = eyePlanes[p][0] * modelview[4 * j] + eyePlanes[p][1] * modelview[4 * j + 1] +
+                                   eyePlanes[p][2] * modelview[4 * j + 2];
+        planes[numPlanes][3] += eyePlanes[p][3];
+    }
+    return numPlanes;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Stop culling. IsBoxCulled() then returns 0 for every box.
+/////////////////////////////////////////////////////////////////////////////
+
+void DisableCulling(void)
+{
+    cullingEnabled = false;
+    numEyePlanes = 0;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns 1 if the axis-aligned box from boxMin to boxMax, in the
+// coordinates of the current modelview matrix, lies wholly outside the
+// culling volume, or 0 if it may be inside it.
+/////////////////////////////////////////////////////////////////////////////
+
+int IsBoxCulled(const float boxMin[3], const float boxMax[3])
+{
+    if (!cullingEnabled) return 0;
+    cullingStats.numTested++;
+
+    float modelview[16];
+    glGetFloatv(GL_MODELVIEW_MATRIX, modelview);
+
+    // The corners of the box in eye and in clip coordinates.
+    float eye[8][4], clip[8][4];
+    for (int k = 0; k < 8; k++) {
+        float corner[3] = { (k & 1) ? boxMax[0] : boxMin[0],
+                            (k & 2) ? boxMax[1] : boxMin[1],
+                            (k & 4) ? boxMax[2] : boxMin[2] };
+        TransformPoint(modelview, corner, eye[k]);
+        for (int i = 0; i < 4; i++)
+            clip[k][i] = projection[i] * eye[k][0] + projection[4 + i] * eye[k][1] +
+                         projection[8 + i] * eye[k][2] + projection[12 + i] * eye[k][3];
+    }
+
+    // The frustum is -w <= x, y, z <= w in clip coordinates.
+    for (int p = 0; p < 6; p++) {
+        int axis = p / 2;
+        float sign = (p & 1) ? -1.0f : 1.0f;
+        int k = 0;
+        while (k < 8 && clip[k][3] + sign * clip[k][axis] < 0.0f) k++;
+        if (k == 8) {
+            cullingStats.numCulled++;
+            return 1;
+        }
+    }
+
+    for (int p = 0; p < numEyePlanes; p++) {
+        const float *plane = eyePlanes[p];
+        int k = 0;
+        while (k < 8 && plane[0] * eye[k][0] + plane[1] * eye[k][1] + plane[2] * eye[k][2] + plane[3] < 0.0f) k++;
+        if (k == 8) {
+            cullingStats.numCulled++;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns the area, as a fraction of the viewport, of the convex polygon
+// with the input corners (up to MAX_COVERAGE_POINTS), in the coordinates
+// of the current modelview matrix, projected by the current projection
+// matrix after it is clipped to the planes of the view frustum in
+// clipPlanes: bit 2 * axis for -w <= x, y or z, and the next bit for
+// x, y or z <= w.
+/////////////////////////////////////////////////////////////////////////////
+
+static float GetClippedPolygonArea(const float (*points)[3], int numPoints, unsigned int clipPlanes)
+{
+    if (numPoints < 3 || numPoints > MAX_COVERAGE_POINTS) return 0.0f;
+
+    float modelview[16], proj[16];
+    glGetFloatv(GL_MODELVIEW_MATRIX, modelview);
+    glGetFloatv(GL_PROJECTION_MATRIX, proj);
+
+    // Each of the 6 planes of the frustum adds at most one corner.
+    float poly[2][MAX_COVERAGE_POINTS + 6][4];
+    int n = numPoints;
+    for (int k = 0; k < n; k++) {
+        float eye[4];
+        TransformPoint(modelview, points[k], eye);
+        for (int i = 0; i < 4; i++)
+            poly[0][k][i] = proj[i] * eye[0] + proj[4 + i] * eye[1] + proj[8 + i] * eye[2] + proj[12 + i] * eye[3];
+    }
+
+    // Clip the polygon in clip coordinates to the planes of clipPlanes, one
+    // plane at a time (Sutherland-Hodgman).
+    int cur = 0;
+    for (int p = 0; p < 6 && n > 0; p++) {
+        if (!(clipPlanes & (1u << p))) continue;
+        int axis = p / 2;
+        float sign = (p & 1) ? -1.0f : 1.0f;
+        const float (*in)[4] = poly[cur];
+        float (*out)[4] = poly[1 - cur];
+        int m = 0;
+        for (int k = 0; k < n; k++) {
+            const float *a = in[k];
+            const float *b = in[(k + 1) % n];
+            float da = a[3] + sign * a[axis];
+            float db = b[3] + sign * b[axis];
+            if (da >= 0.0f) {
+                for (int i = 0; i < 4; i++) out[m][i] = a[i];
+                m++;
+            }
+            if ((da >= 0.0f) != (db >= 0.0f)) {
+                float t = da / (da - db);
+                for (int i = 0; i < 4; i++) out[m][i] = a[i] + t * (b[i] - a[i]);
+                m++;
+            }
+        }
+        n = m;
+        cur = 1 - cur;
+    }
+    if (n < 3) return 0.0f;
+
+    // The area in normalized device coordinates, where the viewport is 2 x 2.
+    float area = 0.0f;
+    for (int k = 0; k < n; k++) {
+        const float *a = poly[cur][k];
+        const float *b = poly[cur][(k + 1) % n];
+        area += (a[0] / a[3]) * (b[1] / b[3]) - (b[0] / b[3]) * (a[1] / a[3]);
+    }
+    return 0.125f * ((area < 0.0f) ? -area : area);
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns the fraction of the viewport, from 0 to 1, that the convex
+// polygon with the input corners (up to MAX_COVERAGE_POINTS), in the
+// coordinates of the current modelview matrix, covers when it is projected
+// by the current projection matrix, after it is clipped to the view
+// frustum. So it is 0 if the polygon lies outside the frustum.
+// This does not depend on whether culling is enabled.
+/////////////////////////////////////////////////////////////////////////////
+
+float GetPolygonCoverage(const float (*points)[3], int numPoints)
+{
+    float coverage = GetClippedPolygonArea(points, numPoints, 0x3f);
+    return (coverage > 1.0f) ? 1.0f : coverage;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns the area of the convex polygon with the input corners (up to
+// MAX_COVERAGE_POINTS), in the coordinates of the current modelview
+// matrix, projected by the current projection matrix, as a fraction of
+// the viewport. Unlike GetPolygonCoverage(), the polygon is only clipped
+// to the near plane, so the area includes the parts of the polygon beside
+// the viewport and may be greater than 1.
+/////////////////////////////////////////////////////////////////////////////
+
+float GetPolygonProjectedArea(const float (*points)[3], int numPoints)
+{
+    return GetClippedPolygonArea(points, numPoints, 0x10);
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Counts of the boxes tested and culled, since the start of the program.
+/////////////////////////////////////////////////////////////////////////////
+
+void GetCullingStats(CullingStats *stats)
+{
+    *stats = cullingStats;
+}
@@ -0,0 +1,121 @@
+#ifndef _CULLING_H_
+#define _CULLING_H_
+
+#include <stddef.h>
+
+/////////////////////////////////////////////////////////////////////////////
+// View-frustum culling.
+//
+// The culling volume is the view frustum of the projection matrix, cut by
+// any number of extra planes, such as the plane of a mirror, behind which
+// nothing can be seen in the reflection. Geometry is culled on the CPU,
+// before it is submitted, by testing its bounding box, given in the
+// coordinates of the current modelview matrix, against the planes of the
+// volume. A box is culled if it lies wholly outside one of the planes,
+// which is conservative: some boxes outside the volume near its corners
+// are kept.
+/////////////////////////////////////////////////////////////////////////////
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Cull against the view frustum of the current projection matrix, until
+// DisableCulling(), with no extra planes.
+/////////////////////////////////////////////////////////////////////////////
+
+extern void SetCullingFrustum( void );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Cut the culling volume by the plane with the input equation, given in
+// the coordinates of the current modelview matrix as with glClipPlane():
+// the points where a*x + b*y + c*z + d >= 0 are kept. Up to
+// MAX_CULLING_PLANES planes can be added to each frustum.
+/////////////////////////////////////////////////////////////////////////////
+
+#define MAX_CULLING_PLANES  4
+
+extern void AddCullingPlane( const double equation[4] );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Make the near plane of the current projection matrix the plane with the
+// input equation, given as with AddCullingPlane(), so that the points
+// where a*x + b*y + c*z + d < 0 are clipped by the near plane, as by a
+// user clip plane, but without one. The eye must be on that side of the
+// plane. The far plane is tilted to keep the rest of the view frustum,
+// which leaves less depth precision the more oblique the plane is to the
+// view direction. See Eric Lengyel, "Oblique View Frustum Depth
+// Projection and Clipping", Journal of Game Development, 2005.
+/////////////////////////////////////////////////////////////////////////////
+
+extern void SetObliqueNearPlane( const double equation[4] );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Get the planes of the culling volume in the coordinates of the current
+// modelview matrix, in the form of AddCullingPlane(), e.g. in world space
+// to query a BVH over the scene. Returns the number of planes, which is at
+// most MAX_CULLING_VOLUME_PLANES, or 0 if culling is disabled.
+/////////////////////////////////////////////////////////////////////////////
+
+#define MAX_CULLING_VOLUME_PLANES   ( 6 + MAX_CULLING_PLANES )
+
+extern int GetCullingPlanes( float planes[][4] );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Stop culling. IsBoxCulled() then returns 0 for every box.
+/////////////////////////////////////////////////////////////////////////////
+
+extern void DisableCulling( void );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns 1 if the axis-aligned box from boxMin to boxMax, in the
+// coordinates of the current modelview matrix, lies wholly outside the
+// culling volume, or 0 if it may be inside it.
+/////////////////////////////////////////////////////////////////////////////
+
+extern int IsBoxCulled( const float boxMin[3], const float boxMax[3] );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns the fraction of the viewport, from 0 to 1, that the convex
+// polygon with the input corners (up to MAX_COVERAGE_POINTS), in the
+// coordinates of the current modelview matrix, covers when it is projected
+// by the current projection matrix, after it is clipped to the view
+// frustum. So it is 0 if the polygon lies outside the frustum.
+// This does not depend on whether culling is enabled.
+/////////////////////////////////////////////////////////////////////////////
+
+#define MAX_COVERAGE_POINTS 8
+
+extern float GetPolygonCoverage( const float (*points)[3], int numPoints );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns the area of the convex polygon with the input corners (up to
+// MAX_COVERAGE_POINTS), in the coordinates of the current modelview
+// matrix, projected by the current projection matrix, as a fraction of
+// the viewport. Unlike GetPolygonCoverage(), the polygon is only clipped
+// to the near plane, so the area includes the parts of the polygon beside
+// the viewport and may be greater than 1.
+/////////////////////////////////////////////////////////////////////////////
+
+extern float GetPolygonProjectedArea( const float (*points)[3], int numPoints );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Counts of the boxes tested and culled, since the start of the program.
+/////////////////////////////////////////////////////////////////////////////
+
+struct CullingStats
+{
+    size_t numTested;
+    size_t numCulled;
+};
+
+extern void GetCullingStats( CullingStats *stats );
+
+
+#endif
@@ -0,0 +1,364 @@
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#ifdef __APPLE__
+#define GL_SILENCE_DEPRECATION
+#include <GLUT/glut.h>
+#else
+#include <GL/glew.h>
+#include <GL/glut.h>
+#endif
+
+#include "draw_queue.h"
+
+
+
+struct DrawItem
+{
+    int materialId;                     // Index into materials, or -1 for none.
+    unsigned int texObj;
+    unsigned int bindTexObj;            // Texture object bound by applying texObj.
+    bool cullFace;
+    float normal[3];
+    float modelview[16];
+    DrawFunc draw;
+    DrawInstancedFunc drawInstanced;    // NULL if the item is never instanced.
+    int numParams;
+    float params[DRAW_ITEM_MAX_PARAMS];
+};
+
+
+// Distinct materials set so far. An item refers to its material by its
+// index, so materials with the same values share an ID.
+static std::vector<Material> materials;
+
+// Draw state of the items submitted next.
+static int drawMaterialId = -1;
+static unsigned int drawTexObj = 0;
+static bool drawCullFace = true;
+static float drawNormal[3] = { 0.0f, 0.0f, 1.0f };
+
+static std::vector<DrawItem> drawItems;
+static std::vector<DrawItem> recordedItems;
+static bool recordItems = false;
+static std::vector<std::pair<unsigned long long, size_t> > sortKeys;   // Sort key and item index.
+static bool sortItems = true;
+static bool instanceItems = true;
+static std::vector<float> instanceModelviews;
+
+static void (*useTextureFunc)(unsigned int texObj) = NULL;
+static unsigned int (*getTextureBindingFunc)(unsigned int texObj) = NULL;
+
+static DrawQueueStats drawQueueStats;
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Set the functions that apply a texture, and that return the texture
+// object that applying a texture binds, e.g. a texture atlas holding it.
+// Items are sorted by the latter, so that textures in the same atlas are
+// drawn together. Texture 0 stands for no texture.
+/////////////////////////////////////////////////////////////////////////////
+
+void SetDrawQueueTextureFuncs(void (*useTexture)(unsigned int texObj),
+                              unsigned int (*getTextureBinding)(unsigned int texObj))
+{
+    useTextureFunc = useTexture;
+    getTextureBindingFunc = getTextureBinding;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Enable or disable sorting. Without sorting, the items are drawn in the
+// order in which they were submitted, still without redundant state
+// changes. Sorting is enabled by default.
+/////////////////////////////////////////////////////////////////////////////
+
+void SetDrawQueueSorting(bool sort)
+{
+    sortItems = sort;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Enable or disable instancing. Without instancing, the items submitted
+// with SubmitInstancedDraw() are drawn one by one, as the other items.
+// Instancing is enabled by default.
+/////////////////////////////////////////////////////////////////////////////
+
+void SetDrawQueueInstancing(bool instance)
+{
+    instanceItems = instance;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Set the draw state of the items submitted after the call: the material,
+// which is copied, so that materials with the same values share an ID;
+// the texture; the normal of geometry that has no normals of its own;
+// and whether back faces are culled.
+/////////////////////////////////////////////////////////////////////////////
+
+void SetDrawMaterial(const Material *material)
+{
+    size_t i = 0;
+    while (i < materials.size() && memcmp(&materials[i], material, sizeof(Material)) != 0) i++;
+    if (i == materials.size()) materials.push_back(*material);
+    drawMaterialId = (int)i;
+}
+
+void SetDrawTexture(unsigned int texObj)
+{
+    drawTexObj = texObj;
+}
+
+void SetDrawNormal(float x, float y, float z)
+{
+    drawNormal[0] = x;
+    drawNormal[1] = y;
+    drawNormal[2] = z;
+}
+
+void SetDrawCullFace(bool cullFace)
+{
+    drawCullFace = cullFace;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Submit an item that is drawn by calling draw with the numParams
+// (up to DRAW_ITEM_MAX_PARAMS) input parameters, with the current draw
+// state and the current modelview matrix.
+/////////////////////////////////////////////////////////////////////////////
+
+void SubmitDraw(DrawFunc draw, const float *params, int numParams)
+{
+    SubmitInstancedDraw(draw, NULL, params, numParams);
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Submit an item as with SubmitDraw(), which may be drawn together with
+// the items that are drawn right before and after it, if they were
+// submitted with the same functions and parameters and have the same
+// draw state, by calling drawInstanced with the modelview matrices of
+// all of them.
+/////////////////////////////////////////////////////////////////////////////
+
+void SubmitInstancedDraw(DrawFunc draw, DrawInstancedFunc drawInstanced, const float *params, int numParams)
+{
+    DrawItem item;
+    item.materialId = drawMaterialId;
+    item.texObj = drawTexObj;
+    item.bindTexObj = (getTextureBindingFunc != NULL) ? getTextureBindingFunc(drawTexObj) : drawTexObj;
+    item.cullFace = drawCullFace;
+    memcpy(item.normal, drawNormal, sizeof(item.normal));
+    glGetFloatv(GL_MODELVIEW_MATRIX, item.modelview);
+    item.draw = draw;
+    item.drawInstanced = drawInstanced;
+    if (numParams > DRAW_ITEM_MAX_PARAMS) numParams = DRAW_ITEM_MAX_PARAMS;
+    if (numParams < 0) numParams = 0;
+    item.numParams = numParams;
+    if (numParams > 0) memcpy(item.params, params, numParams * sizeof(float));
+    if (recordItems) recordedItems.push_back(item);
+    else drawItems.push_back(item);
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Record the items submitted until EndDrawRecording() in the list of
+// recorded items, which is emptied first, instead of the queue.
+// EndDrawRecording() returns the number of items recorded.
+/////////////////////////////////////////////////////////////////////////////
+
+void BeginDrawRecording(void)
+{
+    recordedItems.clear();
+    recordItems = true;
+}
+
+int EndDrawRecording(void)
+{
+    recordItems = false;
+    return (int)recordedItems.size();
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Submit the numIndices recorded items with the input indices to the
+// queue, in the order given, with their draw state and their modelview
+// matrices multiplied onto the current modelview matrix. So a part of the
+// scene that is recorded once in world space, under the identity matrix,
+// can be submitted under each view without running the code that drew it.
+/////////////////////////////////////////////////////////////////////////////
+
+void SubmitRecordedDraws(const int *indices, int numIndices)
+{
+    float modelview[16];
+    glGetFloatv(GL_MODELVIEW_MATRIX, modelview);
+
+    for (int k = 0; k < numIndices; k++) {
+        const DrawItem &recordedItem = recordedItems[indices[k]];
+        drawItems.push_back(recordedItem);
+        DrawItem &item = drawItems.back();
+
+        // The texture that a texture is applied with may have changed
+        // since the item was recorded, e.g. if a texture atlas is turned off.
+        item.bindTexObj = (getTextureBindingFunc != NULL) ? getTextureBindingFunc(item.texObj) : item.texObj;
+
+        for (int j = 0; j < 4; j++) {
+            for (int i = 0; i < 4; i++)
+                item.modelview[4 * j + i] = modelview[i] * recordedItem.modelview[4 * j] +
+                                            modelview[4 + i] * recordedItem.modelview[4 * j + 1] +
+                                            modelview[8 + i] * recordedItem.modelview[4 * j + 2] +
+                                            modelview[12 + i] * recordedItem.modelview[4 * j + 3];
+        }
+    }
+}
+
+
+
+// Returns the sort key of an item. The texture binding is the most costly
+// state to change, so it is the most significant part of the key, then
+// the material, the texture within the binding, which only changes the
+// texture matrix in an atlas, and back-face culling. The fields are
+// truncated to 16 bits, which can only make the sorting less effective.
+static unsigned long long GetSortKey(const DrawItem &item)
+{
+    return ((unsigned long long)(item.bindTexObj & 0xFFFF) << 48) |
+           ((unsigned long long)(item.materialId & 0xFFFF) << 32) |
+           ((unsigned long long)(item.texObj & 0xFFFF) << 16) |
+           (item.cullFace ? 0 : 1);
+}
+
+
+// Returns true if the two items can be drawn by the same instanced call.
+static bool CanInstanceTogether(const DrawItem &a, const DrawItem &b)
+{
+    return a.drawInstanced != NULL && a.drawInstanced == b.drawInstanced && a.draw == b.draw &&
+           a.materialId == b.materialId && a.texObj == b.texObj && a.cullFace == b.cullFace &&
+           memcmp(a.normal, b.normal, sizeof(a.normal)) == 0 && a.numParams == b.numParams &&
+           memcmp(a.params, b.params, a.numParams * sizeof(float)) == 0;
+}
+
+
+// Set the material's properties of both front and back faces.
+static void ApplyMaterial(const Material &material)
+{
+    glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT, material.ambient);
+    glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE, material.diffuse);
+    glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR, material.specular);
+    glMaterialfv(GL_FRONT_AND_BACK, GL_SHININESS, &material.shininess);
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Sort and draw the submitted items, and empty the queue. The modelview
+// matrix is restored, and back-face culling is enabled afterwards.
+/////////////////////////////////////////////////////////////////////////////
+
+void FlushDrawQueue(void)
+{
+    // Sorting pairs of keys and indices keeps items with equal keys in
+    // the order in which they were submitted.
+    sortKeys.resize(drawItems.size());
+    for (size_t i = 0; i < drawItems.size(); i++) {
+        sortKeys[i].first = sortItems ? GetSortKey(drawItems[i]) : 0;
+        sortKeys[i].second = i;
+    }
+    if (sortItems) std::sort(sortKeys.begin(), sortKeys.end());
+
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    glEnable(GL_CULL_FACE);
+
+    // The first item sets all its state. loadedModelview is the modelview
+    // matrix of the item that was loaded last, if any, and identityLoaded
+    // is true while the identity matrix is loaded for instanced calls.
+    const DrawItem *prevItem = NULL;
+    const float *loadedModelview = NULL;
+    bool identityLoaded = false;
+
+    for (size_t i = 0; i < sortKeys.size(); i++) {
+        const DrawItem &item = drawItems[sortKeys[i].second];
+
+        if (prevItem == NULL || item.materialId != prevItem->materialId) {
+            if (item.materialId >= 0) ApplyMaterial(materials[item.materialId]);
+            drawQueueStats.numMaterialChanges++;
+        }
+        if (prevItem == NULL || item.texObj != prevItem->texObj) {
+            if (useTextureFunc != NULL) useTextureFunc(item.texObj);
+            drawQueueStats.numTextureChanges++;
+        }
+        if (prevItem == NULL || item.cullFace != prevItem->cullFace) {
+            if (item.cullFace) glEnable(GL_CULL_FACE);
+            else glDisable(GL_CULL_FACE);
+        }
+        glNormal3fv(item.normal);
+
+        // Draw the run of items that can be instanced together with one call.
+        size_t runEnd = i + 1;
+        if (instanceItems) {
+            while (runEnd < sortKeys.size() && CanInstanceTogether(item, drawItems[sortKeys[runEnd].second]))
+                runEnd++;
+        }
+        if (runEnd - i > 1) {
+            instanceModelviews.resize((runEnd - i) * 16);
+            for (size_t k = i; k < runEnd; k++)
+                memcpy(&instanceModelviews[(k - i) * 16], drawItems[sortKeys[k].second].modelview, 16 * sizeof(float));
+            if (!identityLoaded) {
+                glLoadIdentity();
+                drawQueueStats.numMatrixChanges++;
+                identityLoaded = true;
+                loadedModelview = NULL;
+            }
+            item.drawInstanced(item.params, instanceModelviews.data(), (int)(runEnd - i));
+            drawQueueStats.numDraws++;
+            drawQueueStats.numInstances += runEnd - i;
+
+            prevItem = &drawItems[sortKeys[runEnd - 1].second];
+            i = runEnd - 1;
+            continue;
+        }
+
+        if (loadedModelview == NULL || memcmp(item.modelview, loadedModelview, sizeof(item.modelview)) != 0) {
+            glLoadMatrixf(item.modelview);
+            drawQueueStats.numMatrixChanges++;
+            loadedModelview = item.modelview;
+            identityLoaded = false;
+        }
+
+        item.draw(item.params);
+        drawQueueStats.numDraws++;
+
+        prevItem = &item;
+    }
+
+    glEnable(GL_CULL_FACE);
+    glPopMatrix();
+
+    drawItems.clear();
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Counts of the items drawn and the state changes made by the queue,
+// since the start of the program.
+/////////////////////////////////////////////////////////////////////////////
+
+void GetDrawQueueStats(DrawQueueStats *stats)
+{
+    *stats = drawQueueStats;
+}
@@ -0,0 +1,157 @@
+#ifndef _DRAW_QUEUE_H_
+#define _DRAW_QUEUE_H_
+
+#include <stddef.h>
+
+/////////////////////////////////////////////////////////////////////////////
+// Render-state sorted draw queue.
+//
+// Instead of setting the material and the texture and drawing right away,
+// the drawing code sets the draw state with SetDrawMaterial(),
+// SetDrawTexture() and so on, and submits draw items with SubmitDraw(),
+// which records the draw state and the current modelview matrix.
+// FlushDrawQueue() then sorts the items by a key packed from their
+// texture binding, material and texture, and draws them, making only the
+// state changes between consecutive items that are actually needed.
+//
+// As the scene is opaque and depth-tested, the order of the items only
+// matters where surfaces coincide, and items with equal state keep the
+// order in which they were submitted.
+//
+// Items submitted with SubmitInstancedDraw() that are drawn one after the
+// other, with the same geometry and draw state, are drawn together by one
+// instanced call, each with its own modelview matrix.
+/////////////////////////////////////////////////////////////////////////////
+
+
+struct Material
+{
+    float ambient[4];
+    float diffuse[4];
+    float specular[4];
+    float shininess;
+};
+
+
+// Draws an item's geometry from the parameters given to SubmitDraw().
+typedef void (*DrawFunc)( const float *params );
+
+// Draws numInstances instances of an item's geometry from the parameters
+// given to SubmitInstancedDraw(), the i-th with the modelview matrix at
+// modelviews + 16 * i, while the modelview matrix is the identity, e.g.
+// with DrawMeshInstanced().
+typedef void (*DrawInstancedFunc)( const float *params, const float *modelviews, int numInstances );
+
+#define DRAW_ITEM_MAX_PARAMS    24
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Set the functions that apply a texture, and that return the texture
+// object that applying a texture binds, e.g. a texture atlas holding it.
+// Items are sorted by the latter, so that textures in the same atlas are
+// drawn together. Texture 0 stands for no texture.
+/////////////////////////////////////////////////////////////////////////////
+
+extern void SetDrawQueueTextureFuncs( void (*useTexture)( unsigned int texObj ),
+                                      unsigned int (*getTextureBinding)( unsigned int texObj ) );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Enable or disable sorting. Without sorting, the items are drawn in the
+// order in which they were submitted, still without redundant state
+// changes. Sorting is enabled by default.
+/////////////////////////////////////////////////////////////////////////////
+
+extern void SetDrawQueueSorting( bool sort );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Enable or disable instancing. Without instancing, the items submitted
+// with SubmitInstancedDraw() are drawn one by one, as the other items.
+// Instancing is enabled by default.
+/////////////////////////////////////////////////////////////////////////////
+
+extern void SetDrawQueueInstancing( bool instance );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Set the draw state of the items submitted after the call: the material,
+// which is copied, so that materials with the same values share an ID;
+// the texture; the normal of geometry that has no normals of its own;
+// and whether back faces are culled.
+/////////////////////////////////////////////////////////////////////////////
+
+extern void SetDrawMaterial( const Material *material );
+extern void SetDrawTexture( unsigned int texObj );
+extern void SetDrawNormal( float x, float y, float z );
+extern void SetDrawCullFace( bool cullFace );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Submit an item that is drawn by calling draw with the numParams
+// (up to DRAW_ITEM_MAX_PARAMS) input parameters, with the current draw
+// state and the current modelview matrix.
+/////////////////////////////////////////////////////////////////////////////
+
+extern void SubmitDraw( DrawFunc draw, const float *params, int numParams );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Submit an item as with SubmitDraw(), which may be drawn together with
+// the items that are drawn right before and after it, if they were
+// submitted with the same functions and parameters and have the same
+// draw state, by calling drawInstanced with the modelview matrices of
+// all of them.
+/////////////////////////////////////////////////////////////////////////////
+
+extern void SubmitInstancedDraw( DrawFunc draw, DrawInstancedFunc drawInstanced,
+                                 const float *params, int numParams );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Record the items submitted until EndDrawRecording() in the list of
+// recorded items, which is emptied first, instead of the queue.
+// EndDrawRecording() returns the number of items recorded.
+/////////////////////////////////////////////////////////////////////////////
+
+extern void BeginDrawRecording( void );
+extern int EndDrawRecording( void );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Submit the numIndices recorded items with the input indices to the
+// queue, in the order given, with their draw state and their modelview
+// matrices multiplied onto the current modelview matrix. So a part of the
+// scene that is recorded once in world space, under the identity matrix,
+// can be submitted under each view without running the code that drew it.
+/////////////////////////////////////////////////////////////////////////////
+
+extern void SubmitRecordedDraws( const int *indices, int numIndices );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Sort and draw the submitted items, and empty the queue. The modelview
+// matrix is restored, and back-face culling is enabled afterwards.
+/////////////////////////////////////////////////////////////////////////////
+
+extern void FlushDrawQueue( void );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Counts of the items drawn and the state changes made by the queue,
+// since the start of the program.
+/////////////////////////////////////////////////////////////////////////////
+
+struct DrawQueueStats
+{
+    size_t numDraws;            // Calls of the draw functions, an instanced call counting once.
+    size_t numInstances;        // Items drawn by instanced calls.
+    size_t numMaterialChanges;
+    size_t numTextureChanges;   // Calls of the function that applies a texture.
+    size_t numMatrixChanges;
+};
+
+extern void GetDrawQueueStats( DrawQueueStats *stats );
+
+
+#endif
@@ -0,0 +1,338 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+
+#ifdef __APPLE__
+#define GL_SILENCE_DEPRECATION
+#include <GLUT/glut.h>
+#else
+#include <GL/glew.h>
+#include <GL/glut.h>
+#endif
+
+#include "frame_capture.h"
+#include "image_io.h"
+
+
+
+#define FRAME_CAPTURE_RING_SIZE     3   // Number of pixel buffer objects.
+#define FRAME_CAPTURE_MAX_QUEUED    8   // Max captures waiting to be encoded.
+#define FRAME_CAPTURE_MIN_AGE       2   // Frames to wait when there is no fence.
+
+
+// A frame whose read-back into a pixel buffer object is in flight.
+struct PendingCapture
+{
+    bool inUse;
+    GLuint buffer;
+    GLsizeiptr bufferSize;
+#ifndef __APPLE__
+    GLsync fence;       // NULL where fences are unsupported.
+#endif
+    int age;            // Number of frames presented since the read-back.
+    int width, height;
+    std::string filename;
+};
+
+
+// A frame that has been read back and is waiting to be encoded.
+// The pixels are RGBA with the origin at the bottom-left.
+struct EncodeJob
+{
+    Image pixels;
+    std::string filename;
+};
+
+
+// The state of the capture subsystem.
+struct FrameCapture
+{
+    bool started;
+    bool usePixelBuffers;
+    bool useFences;
+
+    PendingCapture ring[FRAME_CAPTURE_RING_SIZE];
+    int nextSlot;
+
+    std::thread *encoder;           // Never destroyed while running, so that exit() is safe.
+    std::mutex mutex;
+    std::condition_variable jobQueued;
+    std::condition_variable jobDone;
+    std::deque<EncodeJob> jobs;     // Protected by mutex.
+    bool stopEncoder;               // Protected by mutex.
+};
+
+static FrameCapture capture;
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Remove the alpha channel of the RGBA image in place.
+/////////////////////////////////////////////////////////////////////////////
+
+static void StripAlphaChannel(uchar *pixels, int numPixels)
+{
+    for (int i = 0; i < numPixels; i++) {
+        pixels[3 * i + 0] = pixels[4 * i + 0];
+        pixels[3 * i + 1] = pixels[4 * i + 1];
+        pixels[3 * i + 2] = pixels[4 * i + 2];
+    }
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Encoder thread body. Writes the queued frames to their PNG files
+// until it is told to stop and the queue is empty.
+/////////////////////////////////////////////////////////////////////////////
+
+static void EncoderThread()
+{
+    for (;;) {
+        EncodeJob job;
+        {
+            std::unique_lock<std::mutex> lock(capture.mutex);
+            capture.jobQueued.wait(lock, [] { return !capture.jobs.empty() || capture.stopEncoder; });
+            if (capture.jobs.empty()) return;
+            job = std::move(capture.jobs.front());
+            capture.jobs.pop_front();
+        }
+        capture.jobDone.notify_one();   // The queue has room again.
+
+        // The frame is read back as RGBA, which is the fast path of most
+        // drivers, so the alpha channel is dropped here, off the GL thread.
+        StripAlphaChannel(job.pixels.Data(), job.pixels.Width() * job.pixels.Height());
+        SaveImageToFilePNG(job.filename.c_str(), job.pixels.Data(), job.pixels.Width(), job.pixels.Height(), 3);
+    }
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Queue a frame for the encoder thread, which takes over the pixels.
+// Blocks while the queue is full.
+/////////////////////////////////////////////////////////////////////////////
+
+static void QueueEncodeJob(Image *pixels, const std::string &filename)
+{
+    EncodeJob job;
+    job.pixels = std::move(*pixels);
+    job.filename = filename;
+    {
+        std::unique_lock<std::mutex> lock(capture.mutex);
+        capture.jobDone.wait(lock, [] { return capture.jobs.size() < FRAME_CAPTURE_MAX_QUEUED; });
+        capture.jobs.push_back(std::move(job));
+    }
+    capture.jobQueued.notify_one();
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Check which read-back mechanisms are supported and start the encoder.
+/////////////////////////////////////////////////////////////////////////////
+
+static void StartFrameCapture()
+{
+#ifdef __APPLE__
+    capture.usePixelBuffers = true;     // All Macs support OpenGL 2.1.
+    capture.useFences = false;
+#else
+    capture.usePixelBuffers = GLEW_VERSION_2_1 || (GLEW_VERSION_1_5 && GLEW_ARB_pixel_buffer_object);
+    capture.useFences = capture.usePixelBuffers && (GLEW_VERSION_3_2 || GLEW_ARB_sync);
+#endif
+
+    for (int i = 0; i < FRAME_CAPTURE_RING_SIZE; i++) {
+        capture.ring[i].inUse = false;
+        capture.ring[i].buffer = 0;
+        capture.ring[i].bufferSize = 0;
+#ifndef __APPLE__
+        capture.ring[i].fence = NULL;
+#endif
+    }
+    if (capture.usePixelBuffers) {
+        for (int i = 0; i < FRAME_CAPTURE_RING_SIZE; i++) glGenBuffers(1, &capture.ring[i].buffer);
+    }
+    capture.nextSlot = 0;
+
+    capture.stopEncoder = false;
+    capture.encoder = new std::thread(EncoderThread);
+    capture.started = true;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns true if the read-back into the ring slot has completed, or if
+// wait is true, after waiting for it to complete.
+/////////////////////////////////////////////////////////////////////////////
+
+static bool IsReadBackComplete(PendingCapture *slot, bool wait)
+{
+    if (wait) return true;     // Mapping the buffer waits for the read-back.
+#ifndef __APPLE__
+    if (slot->fence != NULL) {
+        GLint status = GL_UNSIGNALED;
+        glGetSynciv(slot->fence, GL_SYNC_STATUS, 1, NULL, &status);
+        return status == GL_SIGNALED;
+    }
+#endif
+    return slot->age >= FRAME_CAPTURE_MIN_AGE;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Map the pixel buffer object of the ring slot, copy the frame out of it
+// and queue the frame for encoding.
+/////////////////////////////////////////////////////////////////////////////
+
+static void ResolveCapture(PendingCapture *slot)
+{
+    Image pixels(slot->width, slot->height, 4);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot->buffer);
+    const void *mapped = glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+    if (mapped != NULL && !pixels.IsEmpty()) memcpy(pixels.Data(), mapped, slot->bufferSize);
+    if (mapped != NULL) glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+#ifndef __APPLE__
+    if (slot->fence != NULL) glDeleteSync(slot->fence);
+    slot->fence = NULL;
+#endif
+    slot->inUse = false;
+
+    if (mapped == NULL || pixels.IsEmpty()) {
+        fprintf(stderr, "Error: Cannot read back frame for %s.\n", slot->filename.c_str());
+        return;
+    }
+    QueueEncodeJob(&pixels, slot->filename);
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Start capturing the rectangle of the current read buffer with lower-left
+// corner (x, y) and the given size, into the PNG file with the input
+// filename. The first call starts the background encoder thread.
+/////////////////////////////////////////////////////////////////////////////
+
+void CaptureFrame(int x, int y, int width, int height, const char *filename)
+{
+    if (!capture.started) StartFrameCapture();
+
+    GLint packAlignment;
+    glGetIntegerv(GL_PACK_ALIGNMENT, &packAlignment);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    GLsizeiptr size = (GLsizeiptr) width * height * 4;
+
+    if (!capture.usePixelBuffers) {
+        Image pixels(width, height, 4);
+        if (!pixels.IsEmpty()) glReadPixels(x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.Data());
+        glPixelStorei(GL_PACK_ALIGNMENT, packAlignment);
+        if (!pixels.IsEmpty()) QueueEncodeJob(&pixels, filename);
+        return;
+    }
+
+    // Reusing the oldest slot of the ring before its frame has been
+    // resolved means waiting for its read-back.
+    PendingCapture *slot = &capture.ring[capture.nextSlot];
+    capture.nextSlot = (capture.nextSlot + 1) % FRAME_CAPTURE_RING_SIZE;
+    if (slot->inUse) ResolveCapture(slot);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot->buffer);
+    if (slot->bufferSize != size) {
+        glBufferData(GL_PIXEL_PACK_BUFFER, size, NULL, GL_STREAM_READ);
+        slot->bufferSize = size;
+    }
+    glReadPixels(x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, (void *) 0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glPixelStorei(GL_PACK_ALIGNMENT, packAlignment);
+
+#ifndef __APPLE__
+    slot->fence = capture.useFences ? glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0) : NULL;
+#endif
+    slot->inUse = true;
+    slot->age = 0;
+    slot->width = width;
+    slot->height = height;
+    slot->filename = filename;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Count one more frame presented since the pending captures were started.
+// Should be called once per frame, after the buffers are swapped. Without
+// fences, a capture is only taken to be read back when
+// FRAME_CAPTURE_MIN_AGE frames have been presented after it.
+/////////////////////////////////////////////////////////////////////////////
+
+void AgeFrameCaptures(void)
+{
+    if (!capture.started) return;
+
+    for (int i = 0; i < FRAME_CAPTURE_RING_SIZE; i++)
+        if (capture.ring[i].inUse) capture.ring[i].age++;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Pass the captures whose read-back has completed to the encoder thread.
+// Should be called once per frame, and when idle while captures are pending.
+// If wait is true, waits for all the pending read-backs to complete.
+// Returns the number of captures still waiting for their read-back.
+/////////////////////////////////////////////////////////////////////////////
+
+int ResolveFrameCaptures(bool wait)
+{
+    if (!capture.started) return 0;
+
+    // Resolve in capture order, oldest first, so that the files are
+    // queued for encoding in the order they were captured.
+    int numPending = 0;
+    for (int i = 0; i < FRAME_CAPTURE_RING_SIZE; i++) {
+        PendingCapture *slot = &capture.ring[(capture.nextSlot + i) % FRAME_CAPTURE_RING_SIZE];
+        if (!slot->inUse) continue;
+
+        if (numPending == 0 && IsReadBackComplete(slot, wait)) ResolveCapture(slot);
+        else numPending++;
+    }
+    return numPending;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Complete all the pending captures, wait for all the PNG files to be
+// written, stop the encoder thread and delete the pixel buffer objects.
+// Capturing may be started again afterwards.
+/////////////////////////////////////////////////////////////////////////////
+
+void FinishFrameCapture(void)
+{
+    if (!capture.started) return;
+
+    ResolveFrameCaptures(true);
+
+    {
+        std::lock_guard<std::mutex> lock(capture.mutex);
+        capture.stopEncoder = true;
+    }
+    capture.jobQueued.notify_one();
+    capture.encoder->join();
+    delete capture.encoder;
+
+    for (int i = 0; i < FRAME_CAPTURE_RING_SIZE; i++) {
+        if (capture.ring[i].buffer != 0) glDeleteBuffers(1, &capture.ring[i].buffer);
+    }
+    capture.started = false;
+}
@@ -0,0 +1,59 @@
+#ifndef _FRAME_CAPTURE_H_
+#define _FRAME_CAPTURE_H_
+
+/////////////////////////////////////////////////////////////////////////////
+// Asynchronous frame capture to PNG files.
+//
+// CaptureFrame() only starts an asynchronous read-back of the framebuffer
+// into one of a ring of pixel buffer objects. A frame or two later, when
+// the read-back has completed, ResolveFrameCaptures() maps the buffer,
+// copies the pixels out and hands them to a background thread, which
+// encodes and writes the PNG file. So the GL thread never waits for the
+// GPU or for the encoder, except when the ring or the encode queue is full.
+//
+// Where pixel buffer objects are unsupported, the read-back is synchronous,
+// but the encoding is still done on the background thread.
+//
+// All functions must be called on the thread of the OpenGL context.
+/////////////////////////////////////////////////////////////////////////////
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Start capturing the rectangle of the current read buffer with lower-left
+// corner (x, y) and the given size, into the PNG file with the input
+// filename. The first call starts the background encoder thread.
+/////////////////////////////////////////////////////////////////////////////
+
+extern void CaptureFrame(int x, int y, int width, int height, const char *filename);
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Count one more frame presented since the pending captures were started.
+// Should be called once per frame, after the buffers are swapped. Without
+// fences, a capture is only taken to be read back when
+// FRAME_CAPTURE_MIN_AGE frames have been presented after it.
+/////////////////////////////////////////////////////////////////////////////
+
+extern void AgeFrameCaptures(void);
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Pass the captures whose read-back has completed to the encoder thread.
+// Should be called once per frame, and when idle while captures are pending.
+// If wait is true, waits for all the pending read-backs to complete.
+// Returns the number of captures still waiting for their read-back.
+/////////////////////////////////////////////////////////////////////////////
+
+extern int ResolveFrameCaptures(bool wait);
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Complete all the pending captures, wait for all the PNG files to be
+// written, stop the encoder thread and delete the pixel buffer objects.
+// Capturing may be started again afterwards.
+/////////////////////////////////////////////////////////////////////////////
+
+extern void FinishFrameCapture(void);
+
+
+#endif
@@ -1,128 +1,340 @@
-#include <stdlib.h>
-#include <stdio.h>
-
-#define STB_IMAGE_IMPLEMENTATION
-#include "stb_image.h"
-
-#define STB_IMAGE_WRITE_IMPLEMENTATION
-#include "stb_image_write.h"
-
-#include "image_io.h"
-
-
-
-/////////////////////////////////////////////////////////////////////////////
-// Deallocate the memory allocated to (*imageData) returned by 
-// the function ReadImageFile().
-// (*imageData) will be set to NULL.
-/////////////////////////////////////////////////////////////////////////////
-
-void DeallocateImageData(uchar **imageData)
-{
-    stbi_image_free(*imageData);
-    (*imageData) = NULL;
-}
-
-
-
-/////////////////////////////////////////////////////////////////////////////
-// Read an image from the input filename. 
-// Returns 1 if successful or 0 if unsuccessful.
-// The returned image data will be pointed to by (*imageData).
-// The image width, image height, and number of components (color channels) 
-// per pixel will be returned in (*imageWidth), (*imageHeight),
-// and (*numComponents).
-// The value of (*numComponents) can be 1, 2, 3 or 4.
-// The returned image data is always packed tightly with red, green, blue,
-// and alpha arranged from lower to higher memory addresses. 
-// Each color channel take one byte.
-// The first pixel (origin of the image) is at the bottom-left of the image.
-/////////////////////////////////////////////////////////////////////////////
-
-int ReadImageFile(const char *filename, uchar **imageData,
-                  int *imageWidth, int *imageHeight, int *numComponents)
-{
-    // Enable flipping of images vertically when read in.
-    // This is to follow OpenGL's image coordinate system, i.e. bottom-leftmost is (0, 0).
-    stbi_set_flip_vertically_on_load(true);
-
-    int w, h, n;
-    unsigned char *data = stbi_load(filename, &w, &h, &n, 0);
-
-    if (data == NULL) {
-        fprintf(stderr, "Error: Cannot read image file %s.\n", filename);
-        return 0;
-    }
-    else {
-        *imageData = data;
-        *imageWidth = w;
-        *imageHeight = h;
-        *numComponents = n;
-        return 1;
-    }
-}
-
-
-
-/////////////////////////////////////////////////////////////////////////////
-// Save an image to the output filename in PNG format. 
-// Returns 1 if successful or 0 if unsuccessful.
-// The input image data is pointed to by imageData.
-// The image width, image height, and number of components (color channels) 
-// per pixel are provided in imageWidth, imageHeight, numComponents.
-// The value of numComponents can be 1, 2, 3 or 4.
-// Note that some numComponents cannot be supported by some image file formats. 
-// The input image data is assumed packed tightly with red, green, blue,
-// and alpha arranged from lower to higher memory addresses. 
-// Each color channel take one byte.
-// The first pixel (origin of the image) is at the bottom-left of the image.
-/////////////////////////////////////////////////////////////////////////////
-
-int SaveImageToFilePNG(const char *filename, const uchar *imageData,
-                       int imageWidth, int imageHeight, int numComponents)
-{ 
-    stbi_flip_vertically_on_write(true);
-
-    int write_status = stbi_write_png(filename, imageWidth, imageHeight, numComponents, imageData, 0);
-
-    if (write_status == 0) {
-        fprintf(stderr, "Error: Cannot write image file %s.\n", filename);
-        return 0;
-    }
-    else {
-        return 1;
-    }
-}
-
-
-
-/////////////////////////////////////////////////////////////////////////////
-// Save an image to the output filename in JPEG format. 
-// Returns 1 if successful or 0 if unsuccessful.
-// The input image data is pointed to by imageData.
-// The image width, image height, and number of components (color channels) 
-// per pixel are provided in imageWidth, imageHeight, numComponents.
-// The value of numComponents can be 1, 2, 3 or 4.
-// Note that some numComponents cannot be supported by some image file formats. 
-// The input image data is assumed packed tightly with red, green, blue,
-// and alpha arranged from lower to higher memory addresses. 
-// Each color channel take one byte.
-// The first pixel (origin of the image) is at the bottom-left of the image.
-// The quality value ranges from 1 to 100; default is 90.
-/////////////////////////////////////////////////////////////////////////////
-
-int SaveImageToFileJPEG(const char *filename, const uchar *imageData,
-                        int imageWidth, int imageHeight, int numComponents, int quality)
-{
-    stbi_flip_vertically_on_write(true);
-
-    int write_status = stbi_write_jpg(filename, imageWidth, imageHeight, numComponents, imageData, quality);
-
-    if (write_status == 0) {
-        fprintf(stderr, "Error: Cannot write image file %s.\n", filename);
-        return 0;
-    }
-    else {
-        return 1;
-    }
-}
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "image_pool.h"
+
+// All the memory that stb_image allocates, including the decoded images,
+// comes from the image pool.
+#define STBI_MALLOC(size)           AllocatePooledBlock(size)
+#define STBI_REALLOC(block, size)   ReallocatePooledBlock(block, size)
+#define STBI_FREE(block)            FreePooledBlock(block)
+
+// The failure reason kept by stb_image is a process-global variable, which
+// would make concurrent calls to ReadImageFile() race on it. Without the
+// failure strings, stb_image still defines the function that sets it, and
+// no longer calls it. The GIF reader also cleared it directly, so
+// stb_image.h is patched to skip that too without the failure strings.
+#define STBI_NO_FAILURE_STRINGS
+#define STB_IMAGE_IMPLEMENTATION
+#if defined(__GNUC__) || defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-function"
+#endif
+#include "stb_image.h"
+#if defined(__GNUC__) || defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "stb_image_write.h"
+
+#include "image_io.h"
+#include "mapped_file.h"
+#include "png_writer.h"
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Flip the rows of the image in place, so that the first row becomes
+// the last row.
+/////////////////////////////////////////////////////////////////////////////
+
+static void FlipImageVertically(uchar *imageData, int imageWidth, int imageHeight, int numComponents)
+{
+    size_t rowSize = (size_t) imageWidth * numComponents;
+    uchar tmp[2048];
+
+    for (int row = 0; row < imageHeight / 2; row++) {
+        uchar *row0 = imageData + row * rowSize;
+        uchar *row1 = imageData + (imageHeight - 1 - row) * rowSize;
+        size_t bytesLeft = rowSize;
+
+        while (bytesLeft > 0) {
+            size_t bytesCopy = (bytesLeft < sizeof(tmp)) ? bytesLeft : sizeof(tmp);
+            memcpy(tmp, row0, bytesCopy);
+            memcpy(row0, row1, bytesCopy);
+            memcpy(row1, tmp, bytesCopy);
+            row0 += bytesCopy;
+            row1 += bytesCopy;
+            bytesLeft -= bytesCopy;
+        }
+    }
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Image.
+/////////////////////////////////////////////////////////////////////////////
+
+Image::Image() : data(NULL), width(0), height(0), numComponents(0)
+{
+}
+
+
+Image::Image(int imageWidth, int imageHeight, int numComponents) : data(NULL)
+{
+    Allocate(imageWidth, imageHeight, numComponents);
+}
+
+
+Image::Image(Image &&other)
+    : data(other.data), width(other.width), height(other.height), numComponents(other.numComponents)
+{
+    other.data = NULL;
+    other.width = other.height = other.numComponents = 0;
+}
+
+
+Image &Image::operator=(Image &&other)
+{
+    if (this != &other) {
+        Adopt(other.data, other.width, other.height, other.numComponents);
+        other.data = NULL;
+        other.width = other.height = other.numComponents = 0;
+    }
+    return *this;
+}
+
+
+Image::~Image()
+{
+    FreePooledBlock(data);
+}
+
+
+int Image::Allocate(int imageWidth, int imageHeight, int numComponents)
+{
+    Reset();
+    data = (uchar *) AllocatePooledBlock((size_t) imageWidth * imageHeight * numComponents);
+    if (data == NULL) return 0;
+
+    this->width = imageWidth;
+    this->height = imageHeight;
+    this->numComponents = numComponents;
+    return 1;
+}
+
+
+void Image::Adopt(uchar *imageData, int imageWidth, int imageHeight, int numComponents)
+{
+    if (imageData != data) FreePooledBlock(data);
+    data = imageData;
+    this->width = imageWidth;
+    this->height = imageHeight;
+    this->numComponents = numComponents;
+}
+
+
+void Image::Reset()
+{
+    FreePooledBlock(data);
+    data = NULL;
+    width = height = numComponents = 0;
+}
+
+
+uchar *Image::Release()
+{
+    uchar *imageData = data;
+    data = NULL;
+    width = height = numComponents = 0;
+    return imageData;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Read an image from the input filename into (*image), replacing its
+// previous content. The image layout is the same as for ReadImageFile().
+// Returns 1 if successful or 0 if unsuccessful, leaving (*image) empty.
+// If useMapping is true, the file is memory-mapped and the image is decoded
+// straight from the mapped file instead of through buffered reads.
+// This function is safe to call from multiple threads at the same time.
+/////////////////////////////////////////////////////////////////////////////
+
+int ReadImage(const char *filename, Image *image, bool useMapping)
+{
+    unsigned char *data = NULL;
+    int w, h, n;
+
+    image->Reset();
+
+    if (!useMapping) {
+        data = stbi_load(filename, &w, &h, &n, 0);
+    }
+    else {
+        MappedFile file;
+        if (MapFile(filename, &file)) {
+            if (file.size > 0 && file.size <= 0x7fffffff)
+                data = stbi_load_from_memory(file.data, (int) file.size, &w, &h, &n, 0);
+            UnmapFile(&file);
+        }
+    }
+
+    if (data == NULL) {
+        fprintf(stderr, "Error: Cannot read image file %s.\n", filename);
+        return 0;
+    }
+    else {
+        // Flip the image vertically to follow OpenGL's image coordinate system,
+        // i.e. bottom-leftmost is (0, 0). This is done here rather than with
+        // stbi_set_flip_vertically_on_load(), whose flag is process-global.
+        FlipImageVertically(data, w, h, n);
+
+        image->Adopt(data, w, h, n);
+        return 1;
+    }
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Deallocate the memory allocated to (*imageData) returned by 
+// the function ReadImageFile() or by Image::Release().
+// (*imageData) will be set to NULL.
+/////////////////////////////////////////////////////////////////////////////
+
+void DeallocateImageData(uchar **imageData)
+{
+    FreePooledBlock(*imageData);
+    (*imageData) = NULL;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Read an image from the input filename. 
+// Returns 1 if successful or 0 if unsuccessful.
+// The returned image data will be pointed to by (*imageData).
+// The image width, image height, and number of components (color channels) 
+// per pixel will be returned in (*imageWidth), (*imageHeight),
+// and (*numComponents).
+// The value of (*numComponents) can be 1, 2, 3 or 4.
+// The returned image data is always packed tightly with red, green, blue,
+// and alpha arranged from lower to higher memory addresses. 
+// Each color channel take one byte.
+// The first pixel (origin of the image) is at the bottom-left of the image.
+// This function is safe to call from multiple threads at the same time.
+// This is a thin wrapper around ReadImage().
+/////////////////////////////////////////////////////////////////////////////
+
+int ReadImageFile(const char *filename, uchar **imageData,
+                  int *imageWidth, int *imageHeight, int *numComponents)
+{
+    Image image;
+    if (!ReadImage(filename, &image)) return 0;
+
+    *imageWidth = image.Width();
+    *imageHeight = image.Height();
+    *numComponents = image.NumComponents();
+    *imageData = image.Release();
+    return 1;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Same as ReadImageFile(), but the file is memory-mapped and the image is
+// decoded straight from the mapped file instead of through buffered reads.
+// The returned image data must also be deallocated with DeallocateImageData().
+// This function is safe to call from multiple threads at the same time.
+/////////////////////////////////////////////////////////////////////////////
+
+int ReadImageFileMapped(const char *filename, uchar **imageData,
+                        int *imageWidth, int *imageHeight, int *numComponents)
+{
+    Image image;
+    if (!ReadImage(filename, &image, true)) return 0;
+
+    *imageWidth = image.Width();
+    *imageHeight = image.Height();
+    *numComponents = image.NumComponents();
+    *imageData = image.Release();
+    return 1;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Read only the header of the image file with the input filename, without
+// decoding the image.
+// Returns 1 if successful or 0 if unsuccessful.
+// The image width, image height, and number of components (color channels)
+// per pixel that ReadImageFile() would return for this file are returned
+// in (*imageWidth), (*imageHeight), and (*numComponents).
+// This function is safe to call from multiple threads at the same time.
+/////////////////////////////////////////////////////////////////////////////
+
+int ProbeImageFile(const char *filename, int *imageWidth, int *imageHeight, int *numComponents)
+{
+    int w, h, n;
+
+    if (stbi_info(filename, &w, &h, &n) == 0) {
+        fprintf(stderr, "Error: Cannot read image file %s.\n", filename);
+        return 0;
+    }
+    else {
+        *imageWidth = w;
+        *imageHeight = h;
+        *numComponents = n;
+        return 1;
+    }
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Save an image to the output filename in PNG format. 
+// Returns 1 if successful or 0 if unsuccessful.
+// The input image data is pointed to by imageData.
+// The image width, image height, and number of components (color channels) 
+// per pixel are provided in imageWidth, imageHeight, numComponents.
+// The value of numComponents can be 1, 2, 3 or 4.
+// Note that some numComponents cannot be supported by some image file formats. 
+// The input image data is assumed packed tightly with red, green, blue,
+// and alpha arranged from lower to higher memory addresses. 
+// Each color channel take one byte.
+// The first pixel (origin of the image) is at the bottom-left of the image.
+// The image is encoded with one thread per hardware core (see png_writer.h).
+/////////////////////////////////////////////////////////////////////////////
+
+int SaveImageToFilePNG(const char *filename, const uchar *imageData,
+                       int imageWidth, int imageHeight, int numComponents)
+{ 
+    return WritePNGFile(filename, imageData, imageWidth, imageHeight, numComponents, 0);
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Save an image to the output filename in JPEG format. 
+// Returns 1 if successful or 0 if unsuccessful.
+// The input image data is pointed to by imageData.
+// The image width, image height, and number of components (color channels) 
+// per pixel are provided in imageWidth, imageHeight, numComponents.
+// The value of numComponents can be 1, 2, 3 or 4.
+// Note that some numComponents cannot be supported by some image file formats. 
+// The input image data is assumed packed tightly with red, green, blue,
+// and alpha arranged from lower to higher memory addresses. 
+// Each color channel take one byte.
+// The first pixel (origin of the image) is at the bottom-left of the image.
+// The quality value ranges from 1 to 100; default is 90.
+/////////////////////////////////////////////////////////////////////////////
+
+int SaveImageToFileJPEG(const char *filename, const uchar *imageData,
+                        int imageWidth, int imageHeight, int numComponents, int quality)
+{
+    stbi_flip_vertically_on_write(true);
+
+    int write_status = stbi_write_jpg(filename, imageWidth, imageHeight, numComponents, imageData, quality);
+
+    if (write_status == 0) {
+        fprintf(stderr, "Error: Cannot write image file %s.\n", filename);
+        return 0;
+    }
+    else {
+        return 1;
+    }
+}
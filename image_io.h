@@ -1,70 +1,162 @@
-#ifndef _IMAGE_IO_H_
-#define _IMAGE_IO_H_
-
-typedef unsigned char uchar;
-
-/////////////////////////////////////////////////////////////////////////////
-// Deallocate the memory allocated to (*imageData) returned by 
-// the function ReadImageFile().
-// (*imageData) will be set to NULL.
-/////////////////////////////////////////////////////////////////////////////
-
-extern void DeallocateImageData( uchar **imageData );
-
-
-/////////////////////////////////////////////////////////////////////////////
-// Read an image from the input filename. 
-// Returns 1 if successful or 0 if unsuccessful.
-// The returned image data will be pointed to by (*imageData).
-// The image width, image height, and number of components (color channels) 
-// per pixel will be returned in (*imageWidth), (*imageHeight),
-// and (*numComponents).
-// The value of (*numComponents) can be 1, 2, 3 or 4.
-// The returned image data is always packed tightly with red, green, blue,
-// and alpha arranged from lower to higher memory addresses. 
-// Each color channel take one byte.
-// The first pixel (origin of the image) is at the bottom-left of the image.
-/////////////////////////////////////////////////////////////////////////////
-
-extern int ReadImageFile( const char *filename, uchar **imageData,
-                          int *imageWidth, int *imageHeight, int *numComponents );
-
-
-/////////////////////////////////////////////////////////////////////////////
-// Save an image to the output filename in PNG format. 
-// Returns 1 if successful or 0 if unsuccessful.
-// The input image data is pointed to by imageData.
-// The image width, image height, and number of components (color channels) 
-// per pixel are provided in imageWidth, imageHeight, numComponents.
-// The value of numComponents can be 1, 2, 3 or 4.
-// Note that some numComponents cannot be supported by some image file formats. 
-// The input image data is assumed packed tightly with red, green, blue,
-// and alpha arranged from lower to higher memory addresses. 
-// Each color channel take one byte.
-// The first pixel (origin of the image) is at the bottom-left of the image.
-/////////////////////////////////////////////////////////////////////////////
-
-extern int SaveImageToFilePNG(const char *filename, const uchar *imageData,
-                              int imageWidth, int imageHeight, int numComponents);
-
-
-/////////////////////////////////////////////////////////////////////////////
-// Save an image to the output filename in JPEG format. 
-// Returns 1 if successful or 0 if unsuccessful.
-// The input image data is pointed to by imageData.
-// The image width, image height, and number of components (color channels) 
-// per pixel are provided in imageWidth, imageHeight, numComponents.
-// The value of numComponents can be 1, 2, 3 or 4.
-// Note that some numComponents cannot be supported by some image file formats. 
-// The input image data is assumed packed tightly with red, green, blue,
-// and alpha arranged from lower to higher memory addresses. 
-// Each color channel take one byte.
-// The first pixel (origin of the image) is at the bottom-left of the image.
-// The quality value ranges from 1 to 100; default is 90.
-/////////////////////////////////////////////////////////////////////////////
-
-int SaveImageToFileJPEG(const char *filename, const uchar *imageData,
-                        int imageWidth, int imageHeight, int numComponents, int quality = 90);
-
-
-#endif
+#ifndef _IMAGE_IO_H_
+#define _IMAGE_IO_H_
+
+#include <stddef.h>
+
+typedef unsigned char uchar;
+
+
+/////////////////////////////////////////////////////////////////////////////
+// An image that owns its pixels. The pixel storage comes from the image
+// pool (see image_pool.h) and goes back to it when the image is destroyed
+// or reset, so images can be loaded and processed again and again without
+// allocating memory from the system.
+// The pixels are packed tightly with numComponents (1 to 4) bytes per pixel,
+// and the first pixel (origin of the image) is at the bottom-left.
+// An image can be moved but not copied.
+/////////////////////////////////////////////////////////////////////////////
+
+class Image
+{
+public:
+    Image();
+    Image( int imageWidth, int imageHeight, int numComponents );
+    Image( Image &&other );
+    Image &operator=( Image &&other );
+    ~Image();
+
+    Image( const Image & ) = delete;
+    Image &operator=( const Image & ) = delete;
+
+    // Replace the pixels with uninitialized ones of the given size.
+    // Returns 1 if successful or 0 if out of memory, leaving the image empty.
+    int Allocate( int imageWidth, int imageHeight, int numComponents );
+
+    // Take ownership of pixels allocated from the image pool.
+    void Adopt( uchar *imageData, int imageWidth, int imageHeight, int numComponents );
+
+    // Return the pixels to the pool, leaving the image empty.
+    void Reset();
+
+    // Give up ownership of the pixels, which must then be deallocated with
+    // DeallocateImageData(), and leave the image empty.
+    uchar *Release();
+
+    bool IsEmpty() const { return data == NULL; }
+    uchar *Data() { return data; }
+    const uchar *Data() const { return data; }
+    int Width() const { return width; }
+    int Height() const { return height; }
+    int NumComponents() const { return numComponents; }
+    size_t Size() const { return (size_t) width * height * numComponents; }
+
+private:
+    uchar *data;
+    int width, height, numComponents;
+};
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Read an image from the input filename into (*image), replacing its
+// previous content. The image layout is the same as for ReadImageFile().
+// Returns 1 if successful or 0 if unsuccessful, leaving (*image) empty.
+// If useMapping is true, the file is memory-mapped and the image is decoded
+// straight from the mapped file instead of through buffered reads.
+// This function is safe to call from multiple threads at the same time.
+/////////////////////////////////////////////////////////////////////////////
+
+extern int ReadImage( const char *filename, Image *image, bool useMapping = false );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Deallocate the memory allocated to (*imageData) returned by 
+// the function ReadImageFile() or by Image::Release().
+// (*imageData) will be set to NULL.
+/////////////////////////////////////////////////////////////////////////////
+
+extern void DeallocateImageData( uchar **imageData );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Read an image from the input filename. 
+// Returns 1 if successful or 0 if unsuccessful.
+// The returned image data will be pointed to by (*imageData).
+// The image width, image height, and number of components (color channels) 
+// per pixel will be returned in (*imageWidth), (*imageHeight),
+// and (*numComponents).
+// The value of (*numComponents) can be 1, 2, 3 or 4.
+// The returned image data is always packed tightly with red, green, blue,
+// and alpha arranged from lower to higher memory addresses. 
+// Each color channel take one byte.
+// The first pixel (origin of the image) is at the bottom-left of the image.
+// This function is safe to call from multiple threads at the same time.
+/////////////////////////////////////////////////////////////////////////////
+
+extern int ReadImageFile( const char *filename, uchar **imageData,
+                          int *imageWidth, int *imageHeight, int *numComponents );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Same as ReadImageFile(), but the file is memory-mapped and the image is
+// decoded straight from the mapped file instead of through buffered reads.
+// The returned image data must also be deallocated with DeallocateImageData().
+// This function is safe to call from multiple threads at the same time.
+/////////////////////////////////////////////////////////////////////////////
+
+extern int ReadImageFileMapped( const char *filename, uchar **imageData,
+                                int *imageWidth, int *imageHeight, int *numComponents );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Read only the header of the image file with the input filename, without
+// decoding the image.
+// Returns 1 if successful or 0 if unsuccessful.
+// The image width, image height, and number of components (color channels)
+// per pixel that ReadImageFile() would return for this file are returned
+// in (*imageWidth), (*imageHeight), and (*numComponents).
+// This function is safe to call from multiple threads at the same time.
+/////////////////////////////////////////////////////////////////////////////
+
+extern int ProbeImageFile( const char *filename,
+                           int *imageWidth, int *imageHeight, int *numComponents );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Save an image to the output filename in PNG format. 
+// Returns 1 if successful or 0 if unsuccessful.
+// The input image data is pointed to by imageData.
+// The image width, image height, and number of components (color channels) 
+// per pixel are provided in imageWidth, imageHeight, numComponents.
+// The value of numComponents can be 1, 2, 3 or 4.
+// Note that some numComponents cannot be supported by some image file formats. 
+// The input image data is assumed packed tightly with red, green, blue,
+// and alpha arranged from lower to higher memory addresses. 
+// Each color channel take one byte.
+// The first pixel (origin of the image) is at the bottom-left of the image.
+// The image is encoded with one thread per hardware core (see png_writer.h).
+/////////////////////////////////////////////////////////////////////////////
+
+extern int SaveImageToFilePNG(const char *filename, const uchar *imageData,
+                              int imageWidth, int imageHeight, int numComponents);
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Save an image to the output filename in JPEG format. 
+// Returns 1 if successful or 0 if unsuccessful.
+// The input image data is pointed to by imageData.
+// The image width, image height, and number of components (color channels) 
+// per pixel are provided in imageWidth, imageHeight, numComponents.
+// The value of numComponents can be 1, 2, 3 or 4.
+// Note that some numComponents cannot be supported by some image file formats. 
+// The input image data is assumed packed tightly with red, green, blue,
+// and alpha arranged from lower to higher memory addresses. 
+// Each color channel take one byte.
+// The first pixel (origin of the image) is at the bottom-left of the image.
+// The quality value ranges from 1 to 100; default is 90.
+/////////////////////////////////////////////////////////////////////////////
+
+int SaveImageToFileJPEG(const char *filename, const uchar *imageData,
+                        int imageWidth, int imageHeight, int numComponents, int quality = 90);
+
+
+#endif
@@ -0,0 +1,147 @@
+#include <stdlib.h>
+#include <string.h>
+#include <mutex>
+#include <vector>
+
+#include "image_pool.h"
+
+
+
+#define MIN_SIZE_CLASS      12      // Smallest block is 4 KB.
+#define NUM_SIZE_CLASSES    (sizeof(size_t) * 8)
+
+
+// Header hidden in front of every block, padded to keep the block aligned.
+struct BlockHeader
+{
+    size_t sizeClass;       // The block holds (1 << sizeClass) bytes.
+    size_t padding;
+};
+
+
+struct ImagePool
+{
+    std::mutex mutex;
+    std::vector<BlockHeader *> freeBlocks[NUM_SIZE_CLASSES];    // Protected by mutex.
+    ImagePoolStats stats;                                       // Protected by mutex.
+};
+
+static ImagePool pool;
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns the smallest size class that holds size bytes.
+/////////////////////////////////////////////////////////////////////////////
+
+static size_t GetSizeClass(size_t size)
+{
+    size_t sizeClass = MIN_SIZE_CLASS;
+    while (sizeClass < NUM_SIZE_CLASSES - 1 && ((size_t) 1 << sizeClass) < size) sizeClass++;
+    return sizeClass;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Allocate a block of at least size bytes, aligned to 16 bytes.
+// Returns NULL if out of memory.
+/////////////////////////////////////////////////////////////////////////////
+
+void *AllocatePooledBlock(size_t size)
+{
+    size_t sizeClass = GetSizeClass(size);
+    BlockHeader *header = NULL;
+    {
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        std::vector<BlockHeader *> &blocks = pool.freeBlocks[sizeClass];
+        if (!blocks.empty()) {
+            header = blocks.back();
+            blocks.pop_back();
+            pool.stats.numCachedBytes -= (size_t) 1 << sizeClass;
+            pool.stats.numReusedBlocks++;
+        }
+    }
+
+    if (header == NULL) {
+        header = (BlockHeader *) malloc(sizeof(BlockHeader) + ((size_t) 1 << sizeClass));
+        if (header == NULL) return NULL;
+        header->sizeClass = sizeClass;
+
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        pool.stats.numSystemAllocations++;
+    }
+    return header + 1;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Resize a block, keeping its content, like realloc(). block may be NULL.
+// Returns NULL if out of memory, in which case block is left unchanged.
+/////////////////////////////////////////////////////////////////////////////
+
+void *ReallocatePooledBlock(void *block, size_t newSize)
+{
+    if (block == NULL) return AllocatePooledBlock(newSize);
+
+    size_t capacity = (size_t) 1 << ((BlockHeader *) block - 1)->sizeClass;
+    if (newSize <= capacity) return block;
+
+    void *newBlock = AllocatePooledBlock(newSize);
+    if (newBlock == NULL) return NULL;
+    memcpy(newBlock, block, capacity);
+    FreePooledBlock(block);
+    return newBlock;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Return a block to the pool. block may be NULL.
+/////////////////////////////////////////////////////////////////////////////
+
+void FreePooledBlock(void *block)
+{
+    if (block == NULL) return;
+
+    BlockHeader *header = (BlockHeader *) block - 1;
+    size_t capacity = (size_t) 1 << header->sizeClass;
+    {
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        if (pool.stats.numCachedBytes + capacity <= IMAGE_POOL_MAX_CACHED_BYTES) {
+            pool.freeBlocks[header->sizeClass].push_back(header);
+            pool.stats.numCachedBytes += capacity;
+            return;
+        }
+    }
+    free(header);
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Usage statistics of the pool, since the start of the program.
+/////////////////////////////////////////////////////////////////////////////
+
+void GetImagePoolStats(ImagePoolStats *stats)
+{
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    *stats = pool.stats;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Return all the free blocks kept in the pool to the system.
+/////////////////////////////////////////////////////////////////////////////
+
+void TrimImagePool(void)
+{
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    for (size_t c = 0; c < NUM_SIZE_CLASSES; c++) {
+        for (size_t i = 0; i < pool.freeBlocks[c].size(); i++) free(pool.freeBlocks[c][i]);
+        pool.freeBlocks[c].clear();
+    }
+    pool.stats.numCachedBytes = 0;
+}
@@ -0,0 +1,66 @@
+#ifndef _IMAGE_POOL_H_
+#define _IMAGE_POOL_H_
+
+#include <stddef.h>
+
+/////////////////////////////////////////////////////////////////////////////
+// A pool of memory blocks for image pixels and image decoding.
+//
+// Block sizes are rounded up to a power of two. A freed block is kept in
+// the pool and handed out again for the next request of the same size
+// class, so decoding or processing images of the same sizes over and over
+// allocates no memory from the system once the pool is warm.
+// At most IMAGE_POOL_MAX_CACHED_BYTES of free blocks are kept; blocks freed
+// beyond that are returned to the system.
+//
+// All functions are safe to call from multiple threads at the same time.
+/////////////////////////////////////////////////////////////////////////////
+
+#define IMAGE_POOL_MAX_CACHED_BYTES     (256u << 20)
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Allocate a block of at least size bytes, aligned to 16 bytes.
+// Returns NULL if out of memory.
+/////////////////////////////////////////////////////////////////////////////
+
+extern void *AllocatePooledBlock(size_t size);
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Resize a block, keeping its content, like realloc(). block may be NULL.
+// Returns NULL if out of memory, in which case block is left unchanged.
+/////////////////////////////////////////////////////////////////////////////
+
+extern void *ReallocatePooledBlock(void *block, size_t newSize);
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Return a block to the pool. block may be NULL.
+/////////////////////////////////////////////////////////////////////////////
+
+extern void FreePooledBlock(void *block);
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Usage statistics of the pool, since the start of the program.
+/////////////////////////////////////////////////////////////////////////////
+
+struct ImagePoolStats
+{
+    size_t numSystemAllocations;    // Blocks that had to be allocated from the system.
+    size_t numReusedBlocks;         // Blocks handed out again from the pool.
+    size_t numCachedBytes;          // Bytes of free blocks currently kept in the pool.
+};
+
+extern void GetImagePoolStats(ImagePoolStats *stats);
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Return all the free blocks kept in the pool to the system.
+/////////////////////////////////////////////////////////////////////////////
+
+extern void TrimImagePool(void);
+
+
+#endif
@@ -0,0 +1,157 @@
+#include <stdlib.h>
+
+#ifdef __APPLE__
+#define GL_SILENCE_DEPRECATION
+#include <GLUT/glut.h>
+#else
+#include <GL/glew.h>
+#include <GL/glut.h>
+#endif
+
+#include "instanced_lighting.h"
+#include "mesh.h"
+#include "shader_program.h"
+
+
+
+// The lighting equation of the fixed-function pipeline, evaluated for the
+// front faces and for the back faces, whose normal is reversed. The
+// specular light goes into the secondary color, which the fixed-function
+// color sum adds after texturing.
+static const char *vertexShaderSource =
+    "#version 330 compatibility\n"
+    "\n"
+    "#define MAX_LIGHTS 2\n"               // MAX_INSTANCED_LIGHTS
+    "\n"
+    "layout(location = 9) in mat4 instanceMatrix;\n"          // MESH_INSTANCE_MATRIX_ATTRIB
+    "layout(location = 13) in mat3 instanceNormalMatrix;\n"   // MESH_INSTANCE_NORMAL_MATRIX_ATTRIB
+    "\n"
+    "uniform bool lightEnabled[MAX_LIGHTS];\n"
+    "\n"
+    "void Light( vec3 eyePosition, vec3 n, vec4 sceneColor, gl_MaterialParameters material,\n"
+    "            out vec4 color, out vec4 specular )\n"
+    "{\n"
+    "    vec3 v = normalize( -eyePosition );\n"
+    "    color = sceneColor;\n"
+    "    specular = vec4( 0.0, 0.0, 0.0, 1.0 );\n"
+    "\n"
+    "    for ( int i = 0; i < MAX_LIGHTS; i++ )\n"
+    "    {\n"
+    "        if ( !lightEnabled[i] ) continue;\n"
+    "\n"
+    "        vec4 lightPosition = gl_LightSource[i].position;\n"
+    "        vec3 l = lightPosition.xyz - eyePosition * lightPosition.w;\n"
+    "        float attenuation = 1.0;\n"
+    "        if ( lightPosition.w != 0.0 )\n"
+    "        {\n"
+    "            float d = length( l );\n"
+    "            attenuation = 1.0 / ( gl_LightSource[i].constantAttenuation +\n"
+    "                                  gl_LightSource[i].linearAttenuation * d +\n"
+    "                                  gl_LightSource[i].quadraticAttenuation * d * d );\n"
+    "        }\n"
+    "        l = normalize( l );\n"
+    "\n"
+    "        float nDotL = dot( n, l );\n"
+    "        color += attenuation * ( gl_LightSource[i].ambient * material.ambient +\n"
+    "                                 max( nDotL, 0.0 ) * gl_LightSource[i].diffuse * material.diffuse );\n"
+    "        if ( nDotL > 0.0 )\n"
+    "        {\n"
+    "            float nDotH = max( dot( n, normalize( l + v ) ), 0.0 );\n"
+    "            specular.rgb += attenuation * pow( nDotH, material.shininess ) *\n"
+    "                            gl_LightSource[i].specular.rgb * material.specular.rgb;\n"
+    "        }\n"
+    "    }\n"
+    "\n"
+    "    color = vec4( clamp( color.rgb, 0.0, 1.0 ), material.diffuse.a );\n"
+    "    specular.rgb = clamp( specular.rgb, 0.0, 1.0 );\n"
+    "}\n"
+    "\n"
+    "void main()\n"
+    "{\n"
+    "    vec4 vertex = instanceMatrix * gl_Vertex;\n"
+    "    vec4 position = gl_ModelViewMatrix * vertex;\n"
+    "    vec3 eyePosition = position.xyz / position.w;\n"
+    "    vec3 n = normalize( gl_NormalMatrix * ( instanceNormalMatrix * gl_Normal ) );\n"
+    "\n"
+    "    Light( eyePosition, n, gl_FrontLightModelProduct.sceneColor, gl_FrontMaterial,\n"
+    "           gl_FrontColor, gl_FrontSecondaryColor );\n"
+    "    Light( eyePosition, -n, gl_BackLightModelProduct.sceneColor, gl_BackMaterial,\n"
+    "           gl_BackColor, gl_BackSecondaryColor );\n"
+    "\n"
+    "    gl_TexCoord[0] = gl_TextureMatrix[0] * gl_MultiTexCoord0;\n"
+    "    gl_ClipVertex = position;\n"                            // For the user clip planes.
+    "    gl_Position = gl_ModelViewProjectionMatrix * vertex;\n"
+    "}\n";
+
+
+static GLuint program = 0;
+static GLint lightEnabledLocation = -1;
+static bool active = false;
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Compile and link the program.
+// Returns 1 if successful, or 0 if instanced meshes or GLSL 3.30 are
+// unsupported or the program fails to build, in which case the build log
+// is printed to stderr.
+/////////////////////////////////////////////////////////////////////////////
+
+int InitInstancedLighting(void)
+{
+    if (program != 0) return 1;
+    if (!HasInstancedMeshes() || !HasGLSL330()) return 0;
+
+    program = BuildShaderProgram("instanced lighting", vertexShaderSource, NULL);
+    if (program == 0) return 0;
+
+    lightEnabledLocation = glGetUniformLocation(program, "lightEnabled");
+    return 1;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Use the program for the following draws, with the lights that are
+// enabled at the time of the call, until EndInstancedLighting().
+/////////////////////////////////////////////////////////////////////////////
+
+void BeginInstancedLighting(void)
+{
+    if (program == 0) return;
+    glUseProgram(program);
+
+    GLint lightEnabled[MAX_INSTANCED_LIGHTS];
+    for (int i = 0; i < MAX_INSTANCED_LIGHTS; i++)
+        lightEnabled[i] = glIsEnabled(GL_LIGHT0 + i);
+    glUniform1iv(lightEnabledLocation, MAX_INSTANCED_LIGHTS, lightEnabled);
+    ResetMeshInstanceAttribs();
+
+    // With a vertex shader, the back colors are only selected for the back
+    // faces, and the secondary color is only added, if asked for.
+    glEnable(GL_VERTEX_PROGRAM_TWO_SIDE);
+    glEnable(GL_COLOR_SUM);
+    active = true;
+}
+
+void EndInstancedLighting(void)
+{
+    if (!active) return;
+    glDisable(GL_VERTEX_PROGRAM_TWO_SIDE);
+    glDisable(GL_COLOR_SUM);
+    glUseProgram(0);
+    active = false;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Delete the program.
+/////////////////////////////////////////////////////////////////////////////
+
+void DeleteInstancedLighting(void)
+{
+    EndInstancedLighting();
+    if (program != 0) glDeleteProgram(program);
+    program = 0;
+}
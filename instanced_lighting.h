@@ -0,0 +1,47 @@
+#ifndef _INSTANCED_LIGHTING_H_
+#define _INSTANCED_LIGHTING_H_
+
+/////////////////////////////////////////////////////////////////////////////
+// Fixed-function lighting of instanced meshes.
+//
+// The fixed-function pipeline cannot apply the instance matrices of
+// DrawMeshInstanced(), so instanced meshes are drawn with a GLSL 3.30
+// vertex shader that transforms and lights the vertices as the
+// fixed-function pipeline does: per vertex, with the lights, the light
+// model and the material of the OpenGL state, with local viewer,
+// two-sided lighting and separate specular color, for the enabled lights
+// among the first MAX_INSTANCED_LIGHTS. Spotlights are not supported.
+// The program has no fragment shader, so the fragments are still
+// textured by the fixed-function pipeline.
+/////////////////////////////////////////////////////////////////////////////
+
+#define MAX_INSTANCED_LIGHTS    2
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Compile and link the program.
+// Returns 1 if successful, or 0 if instanced meshes or GLSL 3.30 are
+// unsupported or the program fails to build, in which case the build log
+// is printed to stderr.
+/////////////////////////////////////////////////////////////////////////////
+
+extern int InitInstancedLighting( void );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Use the program for the following draws, with the lights that are
+// enabled at the time of the call, until EndInstancedLighting().
+/////////////////////////////////////////////////////////////////////////////
+
+extern void BeginInstancedLighting( void );
+extern void EndInstancedLighting( void );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Delete the program.
+/////////////////////////////////////////////////////////////////////////////
+
+extern void DeleteInstancedLighting( void );
+
+
+#endif
@@ -1,1281 +1,3358 @@
-
-#include <stdlib.h>
-#include <stdio.h>
-#include <math.h>
-#include <string>
-#include "image_io.h"
-
-#ifdef __APPLE__
-#define GL_SILENCE_DEPRECATION
-#include <GLUT/glut.h>
-#else
-#include <GL/glew.h>
-#include <GL/glut.h>
-#endif
-
-#ifdef _WIN32
-#include <direct.h>
-#define getcwd _getcwd
-#else
-#include <unistd.h>
-#endif
-
-
-
-/////////////////////////////////////////////////////////////////////////////
-// CONSTANTS
-/////////////////////////////////////////////////////////////////////////////
-
-#define PI                  3.1415926535897932384626433832795
-
-#define SCENE_RADIUS        6.0     // Mainly for setting far clipping plane distance.
-
-// The room has a square floor, which is centered at the world-space origin.
-// The z-axis is pointing up.
-
-#define ROOM_WIDTH          6.0
-#define ROOM_HEIGHT         4.0
-
-// The reflective tabletop is a rectangle that is always parallel to the x-y plane.
-// The sides of the tabletop are always parallel to the x-axis or y-axis.
-
-#define TABLETOP_X1         -1.0
-#define TABLETOP_X2         1.0
-#define TABLETOP_Y1         -1.5
-#define TABLETOP_Y2         1.5
-#define TABLETOP_Z          1.2     // This is the z coordinate of the top-most face of the table.
-#define TABLE_THICKNESS     0.1
-
-// The followings are for navigation and setting the view of the (actual) eye.
-
-#define LOOKAT_X            0.0     // Look-at point x coordinate.
-#define LOOKAT_Y            0.0     // Look-at point y coordinate.
-#define LOOKAT_Z            1.0     // Look-at point z coordinate.
-
-#define EYE_INIT_DIST       5.0     // Initial distance of eye from look-at point.
-#define EYE_DIST_INCR       0.2     // Distance increment when changing eye's distance.
-#define EYE_MIN_DIST        0.1     // Min eye's distance from look-at point.
-
-#define EYE_MIN_LATITUDE    -88.0   // Min eye's latitude (in degrees) w.r.t. look-at point.
-#define EYE_MAX_LATITUDE    88.0    // Max eye's latitude (in degrees) w.r.t. look-at point.
-#define EYE_LATITUDE_INCR   2.0     // Degree increment when changing eye's latitude.
-#define EYE_LONGITUDE_INCR  2.0     // Degree increment when changing eye's longitude.
-
-
-// Light 0.
-const GLfloat light0Ambient[] = { 0.1, 0.1, 0.1, 1.0 };
-const GLfloat light0Diffuse[] = { 1.0, 1.0, 1.0, 1.0 };
-const GLfloat light0Specular[] = { 1.0, 1.0, 1.0, 1.0 };
-const GLfloat light0Position[] = { 10.0, -5.0, 8.0, 1.0 };
-
-// Light 1.
-const GLfloat light1Ambient[] = { 0.1, 0.1, 0.1, 1.0 };
-const GLfloat light1Diffuse[] = { 1.0, 1.0, 1.0, 1.0 };
-const GLfloat light1Specular[] = { 1.0, 1.0, 1.0, 1.0 };
-const GLfloat light1Position[] = { -2.0, 10.0, -2.0, 1.0 };
-
-
-// Texture image filenames.
-const char ceilingTexFile[] = "images/ceiling.jpg";
-const char brickTexFile[] = "images/brick.jpg";
-const char checkerTexFile[] = "images/checker.png";
-const char spotsTexFile[] = "images/spots.png";
-const char woodTexFile[] = "images/wood.jpg";
-const char autoBotTexFile[] = "images/autoBot.jpg";
-const char eyesTexFile[] = "images/eyes.jpg";
-
-
-
-
-/////////////////////////////////////////////////////////////////////////////
-// GLOBAL VARIABLES
-/////////////////////////////////////////////////////////////////////////////
-
-// Window's size.
-int winWidth = 800;     // Window width in pixels.
-int winHeight = 600;    // Window height in pixels.
-
-
-// Define (actual) eye position.
-// Initial eye position is at [EYE_INIT_DIST, 0, 0] + [LOOKAT_X, LOOKAT_Y, LOOKAT_Z]
-// in the world space, looking at [LOOKAT_X, LOOKAT_Y, LOOKAT_Z].
-// The up-vector is always [0, 0, 1].
-
-double eyeLatitude = 0.0;
-double eyeLongitude = 0.0;
-double eyeDistance = EYE_INIT_DIST;
-
-// The actual eye position in world space.
-// This is computed from eyeLatitude, eyeLongitude, eyeDistance, and the look-at point.
-
-double eyePos[3];
-
-// Texture objects.
-GLuint reflectionTexObj;
-GLuint woodTexObj;
-GLuint ceilingTexObj;
-GLuint brickTexObj;
-GLuint checkerTexObj;
-GLuint spotsTexObj;
-GLuint autoBotTexObj;
-GLuint eyesTexObj;
-
-// Others.
-bool drawAxes = true;           // Draw world coordinate frame axes iff true.
-bool drawWireframe = false;     // Draw polygons in wireframe if true, otherwise polygons are filled.
-bool hasTexture = true;         // Toggle texture mapping.
-
-
-// Forward function declarations.
-void DrawAxes( double length );
-void DrawRoom( void );
-void DrawTeapot( void );
-void DrawSphere( void );
-void DrawTable( void );
-void DrawTransformerBody( void );
-void DrawTransformerHead( void );
-void DrawCuboid( void );
-
-
-
-
-/////////////////////////////////////////////////////////////////////////////
-// Render the scene from the imaginary viewpoint and capture the image as
-// a texture map.
-//
-// This texture map is then used to texture map the tabletop rectangle
-// to simulate the reflection of the scene from the tabletop.
-/////////////////////////////////////////////////////////////////////////////
-
-void MakeReflectionImage( void )
-{
-
-   
-
-    glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
-    
-  
-    glMatrixMode(GL_PROJECTION);
-    glLoadIdentity();
-        glFrustum(TABLETOP_Y1 - eyePos[1], TABLETOP_Y2 - eyePos[1], TABLETOP_X1 - eyePos[0] , TABLETOP_X2 - eyePos[0],  eyePos[2] - TABLETOP_Z, eyePos[2] + SCENE_RADIUS);
-        
-    
-
-    glMatrixMode(GL_MODELVIEW);
-    glLoadIdentity();
-        gluLookAt( eyePos[0], eyePos[1], 2 * TABLETOP_Z - eyePos[2], eyePos[0], eyePos[1], eyePos[2], 1.0, 0.0, 0.0 );
-    
-    
-
-    glEnable(GL_LIGHTING);
-    glEnable(GL_LIGHT0);
-    glEnable(GL_LIGHT1);
-    glLightfv(GL_LIGHT0, GL_POSITION, light0Position);
-    glLightfv(GL_LIGHT1, GL_POSITION, light1Position);
-    
-    
-  
-    DrawRoom();
-    DrawTeapot();
-    DrawSphere();
-    DrawTransformerBody();
-    DrawTransformerHead();
-        
-
-    glReadBuffer(GL_BACK);
-    glBindTexture(GL_TEXTURE_2D, reflectionTexObj);
-    glCopyTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 0, 0, winWidth, winHeight, 0);
-    
- 
-
-
-}
-
-
-
-
-/////////////////////////////////////////////////////////////////////////////
-// The display callback function.
-/////////////////////////////////////////////////////////////////////////////
-
-void MyDisplay( void )
-{
-    if ( hasTexture )
-        glEnable( GL_TEXTURE_2D );
-    else
-        glDisable( GL_TEXTURE_2D );
-
-    // Compute world-space eye position from eyeLatitude, eyeLongitude, eyeDistance, and look-at point.
-    eyePos[2] = eyeDistance * sin( eyeLatitude * PI / 180.0 ) + LOOKAT_Z;
-    double xy = eyeDistance * cos( eyeLatitude * PI / 180.0 );
-    eyePos[0] = xy * cos( eyeLongitude * PI / 180.0 ) + LOOKAT_X;
-    eyePos[1] = xy * sin( eyeLongitude * PI / 180.0 ) + LOOKAT_Y;
-
-    MakeReflectionImage();
-
-    glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
-
-    glMatrixMode( GL_PROJECTION );
-    glLoadIdentity();
-    gluPerspective( 45.0, (double)winWidth/winHeight, EYE_MIN_DIST, eyeDistance + SCENE_RADIUS );
-
-    glMatrixMode( GL_MODELVIEW );
-    glLoadIdentity();
-    gluLookAt( eyePos[0], eyePos[1], eyePos[2], LOOKAT_X, LOOKAT_Y, LOOKAT_Z, 0.0, 0.0, 1.0 );
-
-    // Set world-space positions of the two lights.
-    glLightfv( GL_LIGHT0, GL_POSITION, light0Position );
-    glLightfv( GL_LIGHT1, GL_POSITION, light1Position );
-
-    // Draw axes.
-    if ( drawAxes ) DrawAxes( SCENE_RADIUS );
-
-    // Draw scene.
-    DrawRoom();
-    DrawTeapot();
-    DrawSphere();
-    DrawTable();
-    DrawTransformerBody();
-    DrawTransformerHead();
-
-    glutSwapBuffers();
-}
-
-
-
-
-/////////////////////////////////////////////////////////////////////////////
-// The keyboard callback function.
-/////////////////////////////////////////////////////////////////////////////
-
-void MyKeyboard( unsigned char key, int x, int y )
-{
-    switch ( key )
-    {
-        // Quit program.
-        case 'q':
-        case 'Q':
-            exit(0);
-            break;
-
-        // Toggle between wireframe and filled polygons.
-        case 'w':
-        case 'W':
-            drawWireframe = !drawWireframe;
-            if ( drawWireframe )
-                glPolygonMode( GL_FRONT_AND_BACK, GL_LINE );
-            else
-                glPolygonMode( GL_FRONT_AND_BACK, GL_FILL );
-            glutPostRedisplay();
-            break;
-
-        // Toggle axes.
-        case 'x':
-        case 'X':
-            drawAxes = !drawAxes;
-            glutPostRedisplay();
-            break;
-
-        // Toggle texture mapping.
-        case 't':
-        case 'T':
-            hasTexture = !hasTexture;
-            glutPostRedisplay();
-            break;
-
-       // Reset to initial view.
-        case 'r':
-        case 'R':
-            eyeLatitude = 0.0;
-            eyeLongitude = 0.0;
-            eyeDistance = EYE_INIT_DIST;
-            glutPostRedisplay();
-            break;
-    }
-}
-
-
-
-
-/////////////////////////////////////////////////////////////////////////////
-// The special key callback function.
-/////////////////////////////////////////////////////////////////////////////
-
-void MySpecialKey( int key, int x, int y )
-{
-    int modi = glutGetModifiers();
-
-    switch ( key )
-    {
-        case GLUT_KEY_LEFT:
-            eyeLongitude -= EYE_LONGITUDE_INCR;
-            if ( eyeLongitude < -360.0 ) eyeLongitude += 360.0 ;
-            glutPostRedisplay();
-            break;
-
-        case GLUT_KEY_RIGHT:
-            eyeLongitude += EYE_LONGITUDE_INCR;
-            if ( eyeLongitude > 360.0 ) eyeLongitude -= 360.0 ;
-            glutPostRedisplay();
-            break;
-
-        case GLUT_KEY_UP:
-            if ( modi != GLUT_ACTIVE_SHIFT )
-            {
-                eyeLatitude += EYE_LATITUDE_INCR;
-                if ( eyeLatitude > EYE_MAX_LATITUDE ) eyeLatitude = EYE_MAX_LATITUDE;
-            }
-            else
-            {
-                eyeDistance -= EYE_DIST_INCR;
-                if ( eyeDistance < EYE_MIN_DIST ) eyeDistance = EYE_MIN_DIST;
-            }
-            glutPostRedisplay();
-            break;
-
-        case GLUT_KEY_DOWN:
-            if ( modi != GLUT_ACTIVE_SHIFT )
-            {
-                eyeLatitude -= EYE_LATITUDE_INCR;
-                if ( eyeLatitude < EYE_MIN_LATITUDE ) eyeLatitude = EYE_MIN_LATITUDE;
-            }
-            else
-            {
-                eyeDistance += EYE_DIST_INCR;
-            }
-            glutPostRedisplay();
-            break;
-    }
-}
-
-
-
-
-/////////////////////////////////////////////////////////////////////////////
-// The reshape callback function.
-/////////////////////////////////////////////////////////////////////////////
-
-void MyReshape( int w, int h )
-{
-    winWidth = w;
-    winHeight = h;
-    glViewport( 0, 0, w, h );
-}
-
-
-
-
-/////////////////////////////////////////////////////////////////////////////
-// Initialize some OpenGL states.
-/////////////////////////////////////////////////////////////////////////////
-
-void GLInit( void )
-{
-    glClearColor( 0.0, 0.0, 0.0, 1.0 ); // Set black background color.
-
-    glShadeModel( GL_SMOOTH ); // Enable Gouraud shading.
-    glEnable( GL_DEPTH_TEST ); // Use depth-buffer for hidden surface removal.
-    glEnable( GL_CULL_FACE );  // Enable back-face culling.
-
-    glDisable( GL_DITHER );
-    glDisable( GL_BLEND );
-
-    // Set Light 0.
-    glLightfv( GL_LIGHT0, GL_AMBIENT, light0Ambient );
-    glLightfv( GL_LIGHT0, GL_DIFFUSE, light0Diffuse );
-    glLightfv( GL_LIGHT0, GL_SPECULAR, light0Specular );
-    glEnable( GL_LIGHT0 );
-
-    // Set Light 1.
-    glLightfv( GL_LIGHT1, GL_AMBIENT, light1Ambient );
-    glLightfv( GL_LIGHT1, GL_DIFFUSE, light1Diffuse );
-    glLightfv( GL_LIGHT1, GL_SPECULAR, light1Specular );
-    glEnable( GL_LIGHT1 );
-
-    glEnable( GL_LIGHTING );
-
-    // Set some global light properties.
-    GLfloat globalAmbient[] = { 0.1, 0.1, 0.1, 1.0 };
-    glLightModelfv( GL_LIGHT_MODEL_AMBIENT, globalAmbient );
-    glLightModeli( GL_LIGHT_MODEL_LOCAL_VIEWER, GL_TRUE );
-    glLightModeli( GL_LIGHT_MODEL_TWO_SIDE, GL_TRUE );
-    glLightModeli( GL_LIGHT_MODEL_COLOR_CONTROL, GL_SEPARATE_SPECULAR_COLOR );
-
-    // Set initial material properties.
-    GLfloat initMaterialAmbient[] = { 1.0, 1.0, 1.0, 1.0 };
-    GLfloat initMaterialDiffuse[] = { 1.0, 1.0, 1.0, 1.0 };
-    GLfloat initMaterialSpecular[] = { 0.5, 0.5, 0.5, 1.0 };
-    GLfloat initMaterialShininess[] = { 16.0 };
-    GLfloat initMaterialEmission[] = { 0.0, 0.0, 0.0, 1.0 };
-    glMaterialfv( GL_FRONT_AND_BACK, GL_AMBIENT, initMaterialAmbient );
-    glMaterialfv( GL_FRONT_AND_BACK, GL_DIFFUSE, initMaterialDiffuse );
-    glMaterialfv( GL_FRONT_AND_BACK, GL_SPECULAR, initMaterialSpecular );
-    glMaterialfv( GL_FRONT_AND_BACK, GL_SHININESS, initMaterialShininess );
-    glMaterialfv( GL_FRONT_AND_BACK, GL_EMISSION, initMaterialEmission );
-
-    // Let OpenGL automatically renomarlize all normal vectors.
-    // This is important if objects are to be scaled.
-    glEnable( GL_NORMALIZE );
-}
-
-
-
-
-/////////////////////////////////////////////////////////////////////////////
-// Set up texture maps.
-/////////////////////////////////////////////////////////////////////////////
-
-void SetUpTextureMaps( std::string execPath )
-{
-    unsigned char *imageData = NULL;
-    int imageWidth, imageHeight, numComponents;
-
-    glPixelStorei( GL_UNPACK_ALIGNMENT, 1 );
-
-//    Concatenate the execution path to the image paths so that fopen() works.
-    std::string woodPath = execPath + "/" + std::string(woodTexFile);
-    std::string ceilingPath = execPath + "/" + std::string(ceilingTexFile);
-    std::string brickPath = execPath + "/" + std::string(brickTexFile);
-    std::string checkerPath = execPath + "/" + std::string(checkerTexFile);
-    std::string spotsPath = execPath + "/" + std::string(spotsTexFile);
-    std::string autobotPath = execPath + "/" + std::string(autoBotTexFile);
-     std::string eyesPath = execPath + "/" + std::string(eyesTexFile);
-
-// This texture object is for the wood texture map.
-
-    glGenTextures( 1, &woodTexObj );
-    glBindTexture( GL_TEXTURE_2D, woodTexObj );
-    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT );
-    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT );
-    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
-    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR );
-
-    if ( ReadImageFile( woodPath.data(), &imageData,
-                        &imageWidth, &imageHeight, &numComponents ) == 0 ) exit( 1 );
-    if ( numComponents != 3 )
-    {
-        fprintf( stderr, "Error: Texture image is not in RGB format.\n" );
-        exit( 1 );
-    }
-
-    gluBuild2DMipmaps( GL_TEXTURE_2D, GL_RGB, imageWidth, imageHeight,
-                       GL_RGB, GL_UNSIGNED_BYTE, imageData );
-
-    DeallocateImageData( &imageData );
-
-
-// This texture object is for the ceiling texture map.
-
-    glGenTextures( 1, &ceilingTexObj );
-    glBindTexture( GL_TEXTURE_2D, ceilingTexObj );
-    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT );
-    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT );
-    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
-    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR );
-
-    if ( ReadImageFile( ceilingPath.data(), &imageData,
-                        &imageWidth, &imageHeight, &numComponents ) == 0 ) exit( 1 );
-    if ( numComponents != 3 )
-    {
-        fprintf( stderr, "Error: Texture image is not in RGB format.\n" );
-        exit( 1 );
-    }
-
-    gluBuild2DMipmaps( GL_TEXTURE_2D, GL_RGB, imageWidth, imageHeight,
-                       GL_RGB, GL_UNSIGNED_BYTE, imageData );
-
-    DeallocateImageData( &imageData );
-
-
-// This texture object is for the brick texture map.
-
-    glGenTextures( 1, &brickTexObj );
-    glBindTexture( GL_TEXTURE_2D, brickTexObj );
-    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT );
-    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT );
-    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
-    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR );
-
-    if ( ReadImageFile( brickPath.data(), &imageData,
-                        &imageWidth, &imageHeight, &numComponents ) == 0 ) exit( 1 );
-    if ( numComponents != 3 )
-    {
-        fprintf( stderr, "Error: Texture image is not in RGB format.\n" );
-        exit( 1 );
-    }
-
-    gluBuild2DMipmaps( GL_TEXTURE_2D, GL_RGB, imageWidth, imageHeight,
-                       GL_RGB, GL_UNSIGNED_BYTE, imageData );
-
-    DeallocateImageData( &imageData );
-
-
-// This texture object is for the checkered texture map.
-
-    glGenTextures( 1, &checkerTexObj );
-    glBindTexture( GL_TEXTURE_2D, checkerTexObj );
-    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT );
-    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT );
-    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
-    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR );
-
-    if ( ReadImageFile( checkerPath.data(), &imageData,
-                        &imageWidth, &imageHeight, &numComponents ) == 0 ) exit( 1 );
-    if ( numComponents != 3 )
-    {
-        fprintf( stderr, "Error: Texture image is not in RGB format.\n" );
-        exit( 1 );
-    }
-    gluBuild2DMipmaps( GL_TEXTURE_2D, GL_RGB, imageWidth, imageHeight,
-                       GL_RGB, GL_UNSIGNED_BYTE, imageData );
-
-
-
-// This texture object is for the spots texture map.
-
-    glGenTextures( 1, &spotsTexObj );
-    glBindTexture( GL_TEXTURE_2D, spotsTexObj );
-    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT );
-    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT );
-    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
-    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR );
-
-    if ( ReadImageFile( spotsPath.data(), &imageData,
-                        &imageWidth, &imageHeight, &numComponents ) == 0 ) exit( 1 );
-    if ( numComponents != 3 )
-    {
-        fprintf( stderr, "Error: Texture image is not in RGB format.\n" );
-        exit( 1 );
-    }
-
-    gluBuild2DMipmaps( GL_TEXTURE_2D, GL_RGB, imageWidth, imageHeight,
-                       GL_RGB, GL_UNSIGNED_BYTE, imageData );
-
-    DeallocateImageData( &imageData );
-    
-    
- // This texture object is for the autobot texture map.
-    
-    glGenTextures( 1, &autoBotTexObj );
-    glBindTexture( GL_TEXTURE_2D, autoBotTexObj );
-    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT );
-    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT );
-    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
-    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR );
-
-    if ( ReadImageFile( autobotPath.data(), &imageData,
-                        &imageWidth, &imageHeight, &numComponents ) == 0 ) exit( 1 );
-    if ( numComponents != 3 )
-    {
-        fprintf( stderr, "Error: Texture image is not in RGB format.\n" );
-        exit( 1 );
-    }
-
-    gluBuild2DMipmaps( GL_TEXTURE_2D, GL_RGB, imageWidth, imageHeight,
-                       GL_RGB, GL_UNSIGNED_BYTE, imageData );
-
-    DeallocateImageData( &imageData );
-    
-    
- // This texture object is for the decepticon texture map.
-       
-       glGenTextures( 1, &eyesTexObj);
-       glBindTexture( GL_TEXTURE_2D, eyesTexObj );
-       glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT );
-       glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT );
-       glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
-       glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR );
-
-       if ( ReadImageFile( eyesPath.data(), &imageData,
-                           &imageWidth, &imageHeight, &numComponents ) == 0 ) exit( 1 );
-       if ( numComponents != 3 )
-       {
-           fprintf( stderr, "Error: Texture image is not in RGB format.\n" );
-           exit( 1 );
-       }
-
-       gluBuild2DMipmaps( GL_TEXTURE_2D, GL_RGB, imageWidth, imageHeight,
-                          GL_RGB, GL_UNSIGNED_BYTE, imageData );
-
-       DeallocateImageData( &imageData );
-    
-
-
-
-// This texture object is for storing the reflection image read from the color buffer.
-
-    glGenTextures( 1, &reflectionTexObj);
-    glBindTexture( GL_TEXTURE_2D, reflectionTexObj );
-    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
-    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR );
-    glTexParameteri(GL_TEXTURE_2D, GL_GENERATE_MIPMAP, GL_TRUE);
-     
-     
-}
-
-
-
-
-/////////////////////////////////////////////////////////////////////////////
-// The main function.
-/////////////////////////////////////////////////////////////////////////////
-
-int main( int argc, char** argv )
-{
-// Initialize GLUT and create window.
-
-    glutInit( &argc, argv );
-    glutInitDisplayMode ( GLUT_RGB | GLUT_DOUBLE | GLUT_DEPTH );
-    glutInitWindowSize( winWidth, winHeight );
-    glutCreateWindow( "Lab3" );
-    fprintf(stdout, "Running %s...\n", argv[0]);
-
-
-// Register the callback functions.
-
-    glutDisplayFunc( MyDisplay );
-    glutReshapeFunc( MyReshape );
-    glutKeyboardFunc( MyKeyboard );
-    glutSpecialFunc( MySpecialKey );
-
-
-// Initialize GLEW.
-// The followings make sure OpenGL 1.4 is supported and set up the extensions.
-// macOS does not require GLEW, so an extra check is performed.
-
-#ifndef __APPLE__
-    GLenum err = glewInit();
-    if ( err != GLEW_OK )
-    {
-        fprintf( stderr, "Error: %s.\n", glewGetErrorString( err ) );
-        exit( 1 );
-    }
-    printf( "Status: Using GLEW %s.\n\n", glewGetString( GLEW_VERSION ) );
-
-    if ( !GLEW_VERSION_1_4 )
-    {
-        fprintf( stderr, "Error: OpenGL 1.4 is not supported.\n" );
-        exit( 1 );
-    }
-#endif
-
-
-// Setup the initial render context.
-
-    GLInit();
-    SetUpTextureMaps(std::string(getcwd(NULL, 256)).data());
-
-
-// Display user instructions in console window.
-
-    printf( "Press LEFT to move eye left.\n" );
-    printf( "Press RIGHT to move eye right.\n" );
-    printf( "Press UP to move eye up.\n" );
-    printf( "Press DOWN to move eye down.\n" );
-    printf( "Press SHIFT+UP to move closer.\n" );
-    printf( "Press SHIFT+DOWN to move further.\n" );
-    printf( "Press 'W' to toggle wireframe.\n" );
-    printf( "Press 'T' to toggle texture mapping.\n" );
-    printf( "Press 'X' to toggle axes.\n" );
-    printf( "Press 'R' to reset to initial view.\n" );
-    printf( "Press 'Q' to quit.\n\n" );
-
-
-// Enter GLUT event loop.
-
-    glutMainLoop();
-    return 0;
-}
-
-
-
-
-//============================================================================
-//============================================================================
-// Functions below are for modeling the 3D objects.
-//============================================================================
-//============================================================================
-
-
-/////////////////////////////////////////////////////////////////////////////
-// Draw the x, y, z axes. Each is drawn with the input length.
-// The x-axis is red, y-axis green, and z-axis blue.
-/////////////////////////////////////////////////////////////////////////////
-
-void DrawAxes( double length )
-{
-    glPushAttrib( GL_ALL_ATTRIB_BITS );
-    glDisable( GL_LIGHTING );
-    glDisable( GL_TEXTURE_2D );
-    glLineWidth( 3.0 );
-    glBegin( GL_LINES );
-        // x-axis.
-        glColor3f( 1.0, 0.0, 0.0 );
-        glVertex3d( 0.0, 0.0, 0.0 );
-        glVertex3d( length, 0.0, 0.0 );
-        // y-axis.
-        glColor3f( 0.0, 1.0, 0.0 );
-        glVertex3d( 0.0, 0.0, 0.0 );
-        glVertex3d( 0.0, length, 0.0 );
-        // z-axis.
-        glColor3f( 0.0, 0.0, 1.0 );
-        glVertex3d( 0.0, 0.0, 0.0 );
-        glVertex3d( 0.0, 0.0, length );
-    glEnd();
-    glPopAttrib();
-}
-
-
-
-
-/////////////////////////////////////////////////////////////////////////////
-// Subdivide input quad into uSteps x vSteps smaller quads, and draw them.
-// The first vertex of the input quad has texture coordinates (s0, t0) and
-// vertex position (x0, y0, z0), and so on.
-//
-// The vertices of the input quad should be given in anti-clockwise order.
-//
-// The texture coordinates at the input vertices are bilinearly
-// interpolated to the newly created vertices.
-/////////////////////////////////////////////////////////////////////////////
-
-void SubdivideAndDrawQuad( int uSteps, int vSteps,
-                           float s0, float t0, float x0, float y0, float z0,
-                           float s1, float t1, float x1, float y1, float z1,
-                           float s2, float t2, float x2, float y2, float z2,
-                           float s3, float t3, float x3, float y3, float z3 )
-{
-    float tc0[3] = { s0, t0, 0.0 };  float v0[3] = { x0, y0, z0 };
-    float tc1[3] = { s1, t1, 0.0 };  float v1[3] = { x1, y1, z1 };
-    float tc2[3] = { s2, t2, 0.0 };  float v2[3] = { x2, y2, z2 };
-    float tc3[3] = { s3, t3, 0.0 };  float v3[3] = { x3, y3, z3 };
-
-    glBegin( GL_QUADS );
-
-    for ( int u = 0; u < uSteps; u++ )
-    {
-        float uu = (float) u / uSteps;
-        float uu1 = (float) (u + 1) / uSteps;
-        float Atc[3], Btc[3], Ctc[3], Dtc[3];
-        float Av[3], Bv[3], Cv[3], Dv[3];
-
-        for ( int i = 0; i < 3; i++ )
-        {
-            Atc[i] = tc0[i] + uu  * ( tc1[i] - tc0[i] );
-            Btc[i] = tc3[i] + uu  * ( tc2[i] - tc3[i] );
-            Ctc[i] = tc0[i] + uu1 * ( tc1[i] - tc0[i] );
-            Dtc[i] = tc3[i] + uu1 * ( tc2[i] - tc3[i] );
-            Av[i] = v0[i] + uu  * ( v1[i] - v0[i] );
-            Bv[i] = v3[i] + uu  * ( v2[i] - v3[i] );
-            Cv[i] = v0[i] + uu1 * ( v1[i] - v0[i] );
-            Dv[i] = v3[i] + uu1 * ( v2[i] - v3[i] );
-        }
-
-        for ( int v = 0; v < vSteps; v++ )
-        {
-            float vv = (float) v / vSteps;
-            float vv1 = (float) (v + 1) / vSteps;
-            float Etc[3], Ftc[3], Gtc[3], Htc[3];
-            float Ev[3], Fv[3], Gv[3], Hv[3];
-
-            for ( int i = 0; i < 3; i++ )
-            {
-                Etc[i] = Atc[i] + vv  * ( Btc[i] - Atc[i] );
-                Ftc[i] = Ctc[i] + vv  * ( Dtc[i] - Ctc[i] );
-                Gtc[i] = Atc[i] + vv1 * ( Btc[i] - Atc[i] );
-                Htc[i] = Ctc[i] + vv1 * ( Dtc[i] - Ctc[i] );
-                Ev[i] = Av[i] + vv  * ( Bv[i] - Av[i] );
-                Fv[i] = Cv[i] + vv  * ( Dv[i] - Cv[i] );
-                Gv[i] = Av[i] + vv1 * ( Bv[i] - Av[i] );
-                Hv[i] = Cv[i] + vv1 * ( Dv[i] - Cv[i] );
-            }
-
-            glTexCoord2fv( Etc );  glVertex3fv( Ev );
-            glTexCoord2fv( Ftc );  glVertex3fv( Fv );
-            glTexCoord2fv( Htc );  glVertex3fv( Hv );
-            glTexCoord2fv( Gtc );  glVertex3fv( Gv );
-        }
-    }
-
-    glEnd();
-}
-
-
-
-
-/////////////////////////////////////////////////////////////////////////////
-// Draw the room.
-// The walls, ceiling and floor are all texture-mapped.
-/////////////////////////////////////////////////////////////////////////////
-
-void DrawRoom( void )
-{
-    const float ROOM_HALF_WIDTH = ROOM_WIDTH / 2.0f;
-
-    glTexEnvf( GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE );
-
-// Ceiling.
-
-    GLfloat matAmbient1[] = { 0.6, 0.6, 0.6, 1.0 };
-    GLfloat matDiffuse1[] = { 0.6, 0.6, 0.6, 1.0 };
-    GLfloat matSpecular1[] = { 0.2, 0.2, 0.2, 1.0 };
-    GLfloat matShininess1[] = { 8.0 };
-    glMaterialfv( GL_FRONT_AND_BACK, GL_AMBIENT, matAmbient1 );
-    glMaterialfv( GL_FRONT_AND_BACK, GL_DIFFUSE, matDiffuse1 );
-    glMaterialfv( GL_FRONT_AND_BACK, GL_SPECULAR, matSpecular1 );
-    glMaterialfv( GL_FRONT_AND_BACK, GL_SHININESS, matShininess1 );
-
-    glBindTexture( GL_TEXTURE_2D, ceilingTexObj );
-    glNormal3f( 0.0, 0.0, -1.0 ); // Normal vector.
-    SubdivideAndDrawQuad( 24, 24, 0.0, 0.0, ROOM_HALF_WIDTH, ROOM_HALF_WIDTH, ROOM_HEIGHT,
-                                  ROOM_WIDTH, 0.0, ROOM_HALF_WIDTH, -ROOM_HALF_WIDTH, ROOM_HEIGHT,
-                                  ROOM_WIDTH, ROOM_WIDTH, -ROOM_HALF_WIDTH, -ROOM_HALF_WIDTH, ROOM_HEIGHT,
-                                  0.0, ROOM_WIDTH, -ROOM_HALF_WIDTH, ROOM_HALF_WIDTH, ROOM_HEIGHT );
-
-// Walls.
-
-    glBindTexture( GL_TEXTURE_2D, brickTexObj );
-
-    // In +y direction.
-    glNormal3f( 0.0, -1.0, 0.0 ); // Normal vector.
-    SubdivideAndDrawQuad( 24, 16, 0.0, 0.0, -ROOM_HALF_WIDTH, ROOM_HALF_WIDTH, 0.0,
-                                  ROOM_WIDTH/2, 0.0, ROOM_HALF_WIDTH, ROOM_HALF_WIDTH, 0.0,
-                                  ROOM_WIDTH/2, ROOM_HEIGHT/2, ROOM_HALF_WIDTH, ROOM_HALF_WIDTH, ROOM_HEIGHT,
-                                  0.0, ROOM_HEIGHT/2, -ROOM_HALF_WIDTH, ROOM_HALF_WIDTH, ROOM_HEIGHT );
-    // In -y direction.
-    glNormal3f( 0.0, 1.0, 0.0 ); // Normal vector.
-    SubdivideAndDrawQuad( 24, 16, 0.0, 0.0, ROOM_HALF_WIDTH, -ROOM_HALF_WIDTH, 0.0,
-                                  ROOM_WIDTH/2, 0.0, -ROOM_HALF_WIDTH, -ROOM_HALF_WIDTH, 0.0,
-                                  ROOM_WIDTH/2, ROOM_HEIGHT/2, -ROOM_HALF_WIDTH, -ROOM_HALF_WIDTH, ROOM_HEIGHT,
-                                  0.0, ROOM_HEIGHT/2, ROOM_HALF_WIDTH, -ROOM_HALF_WIDTH, ROOM_HEIGHT );
-    // In +x direction.
-    glNormal3f( -1.0, 0.0, 0.0 ); // Normal vector.
-    SubdivideAndDrawQuad( 24, 16, 0.0, 0.0, ROOM_HALF_WIDTH, ROOM_HALF_WIDTH, 0.0,
-                                  ROOM_WIDTH/2, 0.0, ROOM_HALF_WIDTH, -ROOM_HALF_WIDTH, 0.0,
-                                  ROOM_WIDTH/2, ROOM_HEIGHT/2, ROOM_HALF_WIDTH, -ROOM_HALF_WIDTH, ROOM_HEIGHT,
-                                  0.0, ROOM_HEIGHT/2, ROOM_HALF_WIDTH, ROOM_HALF_WIDTH, ROOM_HEIGHT );
-    // In -x direction.
-    glNormal3f( 1.0, 0.0, 0.0 ); // Normal vector.
-    SubdivideAndDrawQuad( 24, 16, 0.0, 0.0, -ROOM_HALF_WIDTH, -ROOM_HALF_WIDTH, 0.0,
-                                  ROOM_WIDTH/2, 0.0, -ROOM_HALF_WIDTH, ROOM_HALF_WIDTH, 0.0,
-                                  ROOM_WIDTH/2, ROOM_HEIGHT/2, -ROOM_HALF_WIDTH, ROOM_HALF_WIDTH, ROOM_HEIGHT,
-                                  0.0, ROOM_HEIGHT/2, -ROOM_HALF_WIDTH, -ROOM_HALF_WIDTH, ROOM_HEIGHT );
-
-// Floor.
-
-    GLfloat matAmbient2[] = { 0.5, 0.5, 0.5, 1.0 };
-    GLfloat matDiffuse2[] = { 0.5, 0.5, 0.5, 1.0 };
-    GLfloat matSpecular2[] = { 0.8, 0.8, 0.8, 1.0 };
-    GLfloat matShininess2[] = { 128.0 };
-    glMaterialfv( GL_FRONT_AND_BACK, GL_AMBIENT, matAmbient2 );
-    glMaterialfv( GL_FRONT_AND_BACK, GL_DIFFUSE, matDiffuse2 );
-    glMaterialfv( GL_FRONT_AND_BACK, GL_SPECULAR, matSpecular2 );
-    glMaterialfv( GL_FRONT_AND_BACK, GL_SHININESS, matShininess2 );
-
-    glBindTexture( GL_TEXTURE_2D, checkerTexObj );
-    glNormal3f( 0.0, 0.0, 1.0 ); // Normal vector.
-    SubdivideAndDrawQuad( 24, 24, 0.0, 0.0, ROOM_HALF_WIDTH, -ROOM_HALF_WIDTH, 0.0,
-                                  ROOM_WIDTH, 0.0, ROOM_HALF_WIDTH, ROOM_HALF_WIDTH, 0.0,
-                                  ROOM_WIDTH, ROOM_WIDTH, -ROOM_HALF_WIDTH, ROOM_HALF_WIDTH, 0.0,
-                                  0.0, ROOM_WIDTH, -ROOM_HALF_WIDTH, -ROOM_HALF_WIDTH, 0.0 );
-}
-
-
-
-
-/////////////////////////////////////////////////////////////////////////////
-// Draw a texture-mapped teapot.
-/////////////////////////////////////////////////////////////////////////////
-
-void DrawTeapot( void )
-{
-    double size = 0.45;
-
-    GLfloat matAmbient[] = { 0.8, 0.8, 0.8, 1.0 };
-    GLfloat matDiffuse[] = { 0.8, 0.8, 0.8, 1.0 };
-    GLfloat matSpecular[] = { 1.0, 1.0, 1.0, 1.0 };
-    GLfloat matShininess[] = { 128.0 };
-    glMaterialfv( GL_FRONT_AND_BACK, GL_AMBIENT, matAmbient );
-    glMaterialfv( GL_FRONT_AND_BACK, GL_DIFFUSE, matDiffuse );
-    glMaterialfv( GL_FRONT_AND_BACK, GL_SPECULAR, matSpecular );
-    glMaterialfv( GL_FRONT_AND_BACK, GL_SHININESS, matShininess );
-
-    glTexEnvf( GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE );
-    glBindTexture( GL_TEXTURE_2D, spotsTexObj );
-
-    glFrontFace( GL_CW ); // Need to do this because the built-in teapot is modelled using clockwise polygon winding.
-    glDisable( GL_CULL_FACE );  // Disable back-face culling.
-
-    glPushMatrix();
-    glTranslated( -0.3, -0.5, size * 0.75 + TABLETOP_Z );
-    glRotated( 90.0, 0.0, 0.0, 1.0 );
-    glRotated( 90.0, 1.0, 0.0, 0.0 );
-    glutSolidTeapot( size ); // This function also generates texture coordinates on the teapot.
-    glPopMatrix();
-
-    glEnable( GL_CULL_FACE );   // Enable back-face culling.
-    glFrontFace( GL_CCW );      // Go back to counter-clockwise polygon winding.
-}
-
-
-
-
-/////////////////////////////////////////////////////////////////////////////
-// Draw a non-texture-mapped sphere.
-/////////////////////////////////////////////////////////////////////////////
-
-void DrawSphere( void )
-{
-    double radius = 0.35;
-
-    GLfloat matAmbient[] = { 0.7, 0.5, 0.2, 1.0 };
-    GLfloat matDiffuse[] = { 0.7, 0.5, 0.2, 1.0 };
-    GLfloat matSpecular[] = { 1.0, 1.0, 1.0, 1.0 };
-    GLfloat matShininess[] = { 128.0 };
-    glMaterialfv( GL_FRONT_AND_BACK, GL_AMBIENT, matAmbient );
-    glMaterialfv( GL_FRONT_AND_BACK, GL_DIFFUSE, matDiffuse );
-    glMaterialfv( GL_FRONT_AND_BACK, GL_SPECULAR, matSpecular );
-    glMaterialfv( GL_FRONT_AND_BACK, GL_SHININESS, matShininess );
-
-    glBindTexture( GL_TEXTURE_2D, 0 );  // Texture object ID == 0 means no texture mapping.
-
-    glPushMatrix();
-    glTranslated( 0.3, 0.5, radius + TABLETOP_Z );
-    glutSolidSphere( radius, 64, 32 );
-    glPopMatrix();
-}
-
-
-
-
-
-/////////////////////////////////////////////////////////////////////////////
-// Draw the table.
-/////////////////////////////////////////////////////////////////////////////
-
-void DrawTable( void )
-{
-// Tabletop.
-
-    GLfloat matAmbient1[] = { 0.5, 0.7, 1.0, 1.0 };
-    GLfloat matDiffuse1[] = { 0.5, 0.7, 1.0, 1.0 };
-    GLfloat matSpecular1[] = { 0.8, 0.8, 0.8, 1.0 };
-    GLfloat matShininess1[] = { 128.0 };
-    glMaterialfv( GL_FRONT_AND_BACK, GL_AMBIENT, matAmbient1 );
-    glMaterialfv( GL_FRONT_AND_BACK, GL_DIFFUSE, matDiffuse1 );
-    glMaterialfv( GL_FRONT_AND_BACK, GL_SPECULAR, matSpecular1 );
-    glMaterialfv( GL_FRONT_AND_BACK, GL_SHININESS, matShininess1 );
-
- 
-    glTexEnvf( GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
-    glBindTexture( GL_TEXTURE_2D, reflectionTexObj);
-    glNormal3f( 0.0, 0.0, 1.0 );
-    SubdivideAndDrawQuad( 24, 24, 0.0, 0.0, TABLETOP_X1, TABLETOP_Y1, TABLETOP_Z,
-                                0.0, 1.0, TABLETOP_X2, TABLETOP_Y1, TABLETOP_Z,
-                                1.0, 1.0, TABLETOP_X2, TABLETOP_Y2, TABLETOP_Z,
-                                1.0, 0.0, TABLETOP_X1, TABLETOP_Y2, TABLETOP_Z );
-     
-    
-    
-    //****************************
-
-
-
-
-// Sides.
-
-    GLfloat matAmbient2[] = { 0.2, 0.3, 0.4, 1.0 };
-    GLfloat matDiffuse2[] = { 0.2, 0.3, 0.4, 1.0 };
-    GLfloat matSpecular2[] = { 0.6, 0.8, 1.0, 1.0 };
-    GLfloat matShininess2[] = { 128.0 };
-    glMaterialfv( GL_FRONT_AND_BACK, GL_AMBIENT, matAmbient2 );
-    glMaterialfv( GL_FRONT_AND_BACK, GL_DIFFUSE, matDiffuse2 );
-    glMaterialfv( GL_FRONT_AND_BACK, GL_SPECULAR, matSpecular2 );
-    glMaterialfv( GL_FRONT_AND_BACK, GL_SHININESS, matShininess2 );
-
-    glBindTexture( GL_TEXTURE_2D, 0 ); // Texture object ID == 0 means no texture mapping.
-
-    // In +y direction.
-    glNormal3f( 0.0, 1.0, 0.0 ); // Normal vector.
-    SubdivideAndDrawQuad( 24, 2,  0.0, 0.0, TABLETOP_X2, TABLETOP_Y2, TABLETOP_Z - TABLE_THICKNESS,
-                                  1.0, 0.0, TABLETOP_X1, TABLETOP_Y2, TABLETOP_Z - TABLE_THICKNESS,
-                                  1.0, 1.0, TABLETOP_X1, TABLETOP_Y2, TABLETOP_Z,
-                                  0.0, 1.0, TABLETOP_X2, TABLETOP_Y2, TABLETOP_Z );
-    // In -y direction.
-    glNormal3f( 0.0, -1.0, 0.0 ); // Normal vector.
-    SubdivideAndDrawQuad( 24, 2,  0.0, 0.0, TABLETOP_X1, TABLETOP_Y1, TABLETOP_Z - TABLE_THICKNESS,
-                                  1.0, 0.0, TABLETOP_X2, TABLETOP_Y1, TABLETOP_Z - TABLE_THICKNESS,
-                                  1.0, 1.0, TABLETOP_X2, TABLETOP_Y1, TABLETOP_Z,
-                                  0.0, 1.0, TABLETOP_X1, TABLETOP_Y1, TABLETOP_Z );
-    // In +x direction.
-    glNormal3f( 1.0, 0.0, 0.0 ); // Normal vector.
-    SubdivideAndDrawQuad( 24, 2,  0.0, 0.0, TABLETOP_X2, TABLETOP_Y1, TABLETOP_Z - TABLE_THICKNESS,
-                                  1.0, 0.0, TABLETOP_X2, TABLETOP_Y2, TABLETOP_Z - TABLE_THICKNESS,
-                                  1.0, 1.0, TABLETOP_X2, TABLETOP_Y2, TABLETOP_Z,
-                                  0.0, 1.0, TABLETOP_X2, TABLETOP_Y1, TABLETOP_Z );
-    // In -x direction.
-    glNormal3f( -1.0, 0.0, 0.0 ); // Normal vector.
-    SubdivideAndDrawQuad( 24, 2,  0.0, 0.0, TABLETOP_X1, TABLETOP_Y2, TABLETOP_Z - TABLE_THICKNESS,
-                                  1.0, 0.0, TABLETOP_X1, TABLETOP_Y1, TABLETOP_Z - TABLE_THICKNESS,
-                                  1.0, 1.0, TABLETOP_X1, TABLETOP_Y1, TABLETOP_Z,
-                                  0.0, 1.0, TABLETOP_X1, TABLETOP_Y2, TABLETOP_Z );
-
-// Bottom.
-
-    glNormal3f( 0.0, 0.0, -1.0 ); // Normal vector.
-    SubdivideAndDrawQuad( 24, 24, 0.0, 0.0, TABLETOP_X1, TABLETOP_Y1, TABLETOP_Z - TABLE_THICKNESS,
-                                  1.0, 0.0, TABLETOP_X1, TABLETOP_Y2, TABLETOP_Z - TABLE_THICKNESS,
-                                  1.0, 1.0, TABLETOP_X2, TABLETOP_Y2, TABLETOP_Z - TABLE_THICKNESS,
-                                  0.0, 1.0, TABLETOP_X2, TABLETOP_Y1, TABLETOP_Z - TABLE_THICKNESS );
-
-// Legs.
-
-    GLfloat matAmbient3[] = { 0.4, 0.4, 0.4, 1.0 };
-    GLfloat matDiffuse3[] = { 0.4, 0.4, 0.4, 1.0 };
-    GLfloat matSpecular3[] = { 0.8, 0.8, 0.8, 1.0 };
-    GLfloat matShininess3[] = { 64.0 };
-    glMaterialfv( GL_FRONT_AND_BACK, GL_AMBIENT, matAmbient3 );
-    glMaterialfv( GL_FRONT_AND_BACK, GL_DIFFUSE, matDiffuse3 );
-    glMaterialfv( GL_FRONT_AND_BACK, GL_SPECULAR, matSpecular3 );
-    glMaterialfv( GL_FRONT_AND_BACK, GL_SHININESS, matShininess3 );
-
-    glPushMatrix();
-    glTranslated( TABLETOP_X1 + TABLE_THICKNESS, TABLETOP_Y1 + TABLE_THICKNESS, 0.0 );
-    glScaled( TABLE_THICKNESS, TABLE_THICKNESS, TABLETOP_Z - TABLE_THICKNESS );
-    glTranslated( 0.0, 0.0, 0.5 );
-    glutSolidCube( 1.0 );
-    glPopMatrix();
-
-    glPushMatrix();
-    glTranslated( TABLETOP_X2 - TABLE_THICKNESS, TABLETOP_Y1 + TABLE_THICKNESS, 0.0 );
-    glScaled( TABLE_THICKNESS, TABLE_THICKNESS, TABLETOP_Z - TABLE_THICKNESS );
-    glTranslated( 0.0, 0.0, 0.5 );
-    glutSolidCube( 1.0 );
-    glPopMatrix();
-
-    glPushMatrix();
-    glTranslated( TABLETOP_X2 - TABLE_THICKNESS, TABLETOP_Y2 - TABLE_THICKNESS, 0.0 );
-    glScaled( TABLE_THICKNESS, TABLE_THICKNESS, TABLETOP_Z - TABLE_THICKNESS );
-    glTranslated( 0.0, 0.0, 0.5 );
-    glutSolidCube( 1.0 );
-    glPopMatrix();
-
-    glPushMatrix();
-    glTranslated( TABLETOP_X1 + TABLE_THICKNESS, TABLETOP_Y2 - TABLE_THICKNESS, 0.0 );
-    glScaled( TABLE_THICKNESS, TABLE_THICKNESS, TABLETOP_Z - TABLE_THICKNESS );
-    glTranslated( 0.0, 0.0, 0.5 );
-    glutSolidCube( 1.0 );
-    glPopMatrix();
-}
-
-
-
-/////////////////////////////////////////////////////////////////////////////
-// Draw the Transformer( Head and Body)
-/////////////////////////////////////////////////////////////////////////////
-void DrawTransformerHead( void )
-{
-    glFrontFace( GL_CW );
-    glDisable( GL_CULL_FACE );
-    
-    GLfloat matAmbient[] = { 0.8, 0.8, 0.8, 1.0 };
-    GLfloat matDiffuse[] = { 0.8, 0.8, 0.8, 1.0 };
-    GLfloat matSpecular[] = { 1.0, 1.0, 1.0, 1.0 };
-    GLfloat matShininess[] = { 128.0 };
-    glMaterialfv( GL_FRONT_AND_BACK, GL_AMBIENT, matAmbient );
-    glMaterialfv( GL_FRONT_AND_BACK, GL_DIFFUSE, matDiffuse );
-    glMaterialfv( GL_FRONT_AND_BACK, GL_SPECULAR, matSpecular );
-    glMaterialfv( GL_FRONT_AND_BACK, GL_SHININESS, matShininess );
-
-    glTexEnvf( GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE );
-    glBindTexture( GL_TEXTURE_2D, eyesTexObj);
-    glMatrixMode(GL_MODELVIEW);
-    glTranslated(TABLETOP_X1/2, TABLETOP_Y2/2 + TABLETOP_Y1/16,TABLETOP_Z + TABLETOP_Y2/16 + TABLETOP_Z/3 + TABLETOP_Z/6);
-    
-    for(int i = 0; i <= 24; i++) {
-        double lat0 = PI * (-0.5 + (double) (i - 1) / 24);
-        double z0  = sin(lat0);
-        double zr0 =  cos(lat0);
-
-        double lat1 = PI * (-0.5 + (double) i / 24);
-        double z1 = sin(lat1);
-        double zr1 = cos(lat1);
-        
-        glBegin(GL_QUAD_STRIP);
-        for(int j = 0; j <= 24; j++) {
-            double lng = 2 * PI * (double) (j - 1) / 24;
-            double x = cos(lng);
-            double y = sin(lng);
-
-            glNormal3f(x * zr0, y * zr0, z0);
-            glTexCoord2f(x * zr0, z0); glVertex3f(TABLETOP_Y2/16 * x * zr0, TABLETOP_Y2/16 * y * zr0, TABLETOP_Y2/16 * z0);
-            glNormal3f(x * zr1, y * zr1, z1);
-            glTexCoord2f(x * zr0, z0); glVertex3f(TABLETOP_Y2/16 * x * zr1, TABLETOP_Y2/16 * y * zr1, TABLETOP_Y2/16 * z1);
-        }
-        glEnd();
-    }
-    
-    glEnable( GL_CULL_FACE );   // Enable back-face culling.
-    glFrontFace( GL_CCW );
-    
-    
-        
-    
-}
- 
-
-void DrawTransformerBody( void )
-{
-
-    
-    GLfloat matAmbient[] = { 0.9, 0.9, 0.9, 1.0 };
-    GLfloat matDiffuse[] = { 0.9, 0.9, 0.9, 1.0 };
-    GLfloat matSpecular[] = { 0.5, 0.5, 0.5, 1.0 };
-    GLfloat matShininess[] = { 128.0 };
-    glMaterialfv( GL_FRONT_AND_BACK, GL_AMBIENT, matAmbient );
-    glMaterialfv( GL_FRONT_AND_BACK, GL_DIFFUSE, matDiffuse );
-    glMaterialfv( GL_FRONT_AND_BACK, GL_SPECULAR, matSpecular );
-    glMaterialfv( GL_FRONT_AND_BACK, GL_SHININESS, matShininess );
-
-    glTexEnvf( GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE );
-    glBindTexture( GL_TEXTURE_2D, autoBotTexObj);
-    
-    
-    
-    //Front of decepticon body
-    glNormal3f( 0.0, -1.0, 0.0 ); // Normal vector.
-    SubdivideAndDrawQuad( 24, 24,  1.0, 1.0, 2*TABLETOP_X1/3, TABLETOP_Y2/2, TABLETOP_Z + TABLETOP_Z/3 + TABLETOP_Z/6,
-                                     0.0, 1.0, TABLETOP_X1/3, TABLETOP_Y2/2, TABLETOP_Z + TABLETOP_Z/3 + TABLETOP_Z/6,
-                                     0.0, 0.0, TABLETOP_X1/3, TABLETOP_Y2/2, TABLETOP_Z + TABLETOP_Z/6,
-                                     1.0, 0.0, 2*TABLETOP_X1/3, TABLETOP_Y2/2, TABLETOP_Z + TABLETOP_Z/6 );
-    
-    
-    
-    glBindTexture( GL_TEXTURE_2D, eyesTexObj);
-    
-    //Back of decepticon body
-    glNormal3f( 0.0, -1.0, 0.0 ); // Normal vector.
-    SubdivideAndDrawQuad( 24, 24,  1.0, 0.0, 2*TABLETOP_X1/3, TABLETOP_Y2/2 + TABLETOP_Y1/8, TABLETOP_Z + TABLETOP_Z/3 + TABLETOP_Z/6,
-                                        1.0, 1.0, 2*TABLETOP_X1/3, TABLETOP_Y2/2 + TABLETOP_Y1/8, TABLETOP_Z + TABLETOP_Z/6,
-                                        0.0, 1.0, TABLETOP_X1/3, TABLETOP_Y2/2 + TABLETOP_Y1/8, TABLETOP_Z + TABLETOP_Z/6,
-                                        0.0, 0.0, TABLETOP_X1/3, TABLETOP_Y2/2 + TABLETOP_Y1/8, TABLETOP_Z + TABLETOP_Z/3 + TABLETOP_Z/6);
-    
-    
-    //left sideof decepticon body
-    glNormal3f( 1.0, 0.0, 0.0 ); // Normal vector.
-    SubdivideAndDrawQuad( 24, 2,  1.0, 0.0, TABLETOP_X1/3, TABLETOP_Y2/2 + TABLETOP_Y1/8, TABLETOP_Z + TABLETOP_Z/6,
-                                        1.0, 1.0, TABLETOP_X1/3, TABLETOP_Y2/2, TABLETOP_Z + TABLETOP_Z/6,
-                                        0.0, 1.0, TABLETOP_X1/3, TABLETOP_Y2/2, TABLETOP_Z + TABLETOP_Z/3 + TABLETOP_Z/6,
-                                        0.0, 0.0, TABLETOP_X1/3, TABLETOP_Y2/2 + TABLETOP_Y1/8, TABLETOP_Z + TABLETOP_Z/3 + TABLETOP_Z/6);
-    
-    //right of decepticon body
-    glNormal3f( 1.0, 0.0, 0.0 ); // Normal vector.
-    SubdivideAndDrawQuad( 24, 2,  1.0, 0.0, 2*TABLETOP_X1/3, TABLETOP_Y2/2 + TABLETOP_Y1/8, TABLETOP_Z + TABLETOP_Z/6,
-                                        0.0, 0.0, 2*TABLETOP_X1/3, TABLETOP_Y2/2 + TABLETOP_Y1/8, TABLETOP_Z + TABLETOP_Z/3 + TABLETOP_Z/6,
-                                        0.0, 1.0, 2*TABLETOP_X1/3, TABLETOP_Y2/2, TABLETOP_Z + TABLETOP_Z/3 + TABLETOP_Z/6,
-                                        1.0, 1.0, 2*TABLETOP_X1/3, TABLETOP_Y2/2, TABLETOP_Z + TABLETOP_Z/6);
-
-    //bottom of decepticon body
-    glNormal3f( 0.0, 0.0, 1.0 ); // Normal vector.
-    SubdivideAndDrawQuad( 24, 2,  1.0, 0.0, TABLETOP_X1/3, TABLETOP_Y2/2 + TABLETOP_Y1/8, TABLETOP_Z + TABLETOP_Z/3 + TABLETOP_Z/6,
-                                        1.0, 1.0, TABLETOP_X1/3, TABLETOP_Y2/2, TABLETOP_Z + TABLETOP_Z/3 + TABLETOP_Z/6,
-                                        0.0, 1.0, 2*TABLETOP_X1/3, TABLETOP_Y2/2, TABLETOP_Z + TABLETOP_Z/3 + TABLETOP_Z/6,
-                                        0.0, 0.0, 2*TABLETOP_X1/3, TABLETOP_Y2/2 + TABLETOP_Y1/8, TABLETOP_Z + TABLETOP_Z/3 + TABLETOP_Z/6);
-    
-    //top of decepticon body
-    glNormal3f( 0.0, 0.0, -1.0 ); // Normal vector.
-    SubdivideAndDrawQuad( 24, 24,  1.0, 0.0, TABLETOP_X1/3, TABLETOP_Y2/2 + TABLETOP_Y1/8, TABLETOP_Z + 0.01 + TABLETOP_Z/6,
-                                        0.0, 0.0, 2*TABLETOP_X1/3, TABLETOP_Y2/2 + TABLETOP_Y1/8, TABLETOP_Z + 0.01 + TABLETOP_Z/6,
-                                        0.0, 1.0, 2*TABLETOP_X1/3, TABLETOP_Y2/2, TABLETOP_Z + 0.01 + TABLETOP_Z/6,
-                                        1.0, 1.0, TABLETOP_X1/3, TABLETOP_Y2/2, TABLETOP_Z + 0.01 + TABLETOP_Z/6);
-    
-    
-    //left arm
-    glPushMatrix();
-    glTranslated(TABLETOP_X1/3,TABLETOP_Y2/2 - TABLETOP_Y2/16,TABLETOP_Z + TABLETOP_Z/3 + TABLETOP_Z/30);
-    glScaled(TABLETOP_Z/20,TABLETOP_Z/20,TABLETOP_Z/9);
-    DrawCuboid();
-    glPopMatrix();
-    
-    //right arm
-    glPushMatrix();
-    glTranslated(2 *TABLETOP_X1/3,TABLETOP_Y2/2 - TABLETOP_Y2/16,TABLETOP_Z + TABLETOP_Z/3 + TABLETOP_Z/30);
-    glScaled(TABLETOP_Z/20,TABLETOP_Z/20,TABLETOP_Z/9);
-    DrawCuboid();
-    glPopMatrix();
-    
-    //left leg
-    glPushMatrix();
-    glTranslated(2 *TABLETOP_X1/3 - TABLETOP_X1/16,TABLETOP_Y2/2 - TABLETOP_Y2/16,TABLETOP_Z + TABLETOP_Z/8);
-    glScaled(TABLETOP_Z/25,TABLETOP_Z/20,TABLETOP_Z/15);
-    DrawCuboid();
-    glPopMatrix();
-    
-    //right leg
-    glPushMatrix();
-    glTranslated(TABLETOP_X1/3 + TABLETOP_X1/16,TABLETOP_Y2/2 - TABLETOP_Y2/16,TABLETOP_Z + TABLETOP_Z/8);
-    glScaled(TABLETOP_Z/25,TABLETOP_Z/20,TABLETOP_Z/15);
-    DrawCuboid();
-    glPopMatrix();
-    
-    
-    GLfloat matAmbient1[] = { 0.0, 0.7, 1.0, 1.0 };
-    GLfloat matDiffuse1[] = { 0.0, 0.7, 1.0, 1.0 };
-    GLfloat matSpecular1[] = { 0.8, 0.8, 0.8, 1.0 };
-    GLfloat matShininess1[] = { 128.0 };
-    glMaterialfv( GL_FRONT_AND_BACK, GL_AMBIENT, matAmbient1 );
-    glMaterialfv( GL_FRONT_AND_BACK, GL_DIFFUSE, matDiffuse1 );
-    glMaterialfv( GL_FRONT_AND_BACK, GL_SPECULAR, matSpecular1 );
-    glMaterialfv( GL_FRONT_AND_BACK, GL_SHININESS, matShininess1 );
-    
-    
-    //eyes
-    glPushMatrix();
-    glTranslated(2 *TABLETOP_X1/3 - TABLETOP_X1/16 - TABLETOP_X1/20,TABLETOP_Y2/2 - TABLETOP_Y2/16 + TABLETOP_Y2/20 ,TABLETOP_Z + TABLETOP_Z/3 + TABLETOP_Z/4);
-    glScaled(TABLETOP_Z/100,TABLETOP_Z/100,TABLETOP_Z/100);
-    DrawCuboid();
-    glPopMatrix();
-       
-    glPushMatrix();
-    glTranslated(TABLETOP_X1/3 + TABLETOP_X1/16 + TABLETOP_X1/20,TABLETOP_Y2/2 - TABLETOP_Y2/16 + TABLETOP_Y2/20 ,TABLETOP_Z + TABLETOP_Z/3 + TABLETOP_Z/4);
-    glScaled(TABLETOP_Z/100,TABLETOP_Z/100,TABLETOP_Z/100);
-    DrawCuboid();
-    glPopMatrix();
-    
-}
-
-
-void DrawCuboid( void ){
-    glBegin(GL_QUADS);
-        glTexCoord2f( 0,0 );  glVertex3f(-1,-1,1);
-        glTexCoord2f( 1,0 );  glVertex3f(1,-1,1 );
-        glTexCoord2f( 1,1);  glVertex3f( 1,1,1);
-        glTexCoord2f( 0,1 );  glVertex3f( -1,1,1 );
-    
-        glTexCoord2f( 0,0 );  glVertex3f(-1,-1,-1);
-        glTexCoord2f( 0,1 );  glVertex3f(-1,1,-1 );
-        glTexCoord2f( 1,1 );  glVertex3f( 1,1,-1);
-        glTexCoord2f( 1,0 );  glVertex3f( 1,-1,-1);
-
-     
-        glTexCoord2f( 0,0 );  glVertex3f(-1,-1,1);
-        glTexCoord2f( 0,1 );  glVertex3f( -1,1,1 );
-        glTexCoord2f( 1,1);  glVertex3f( -1,1,-1 );
-        glTexCoord2f( 1,0 );  glVertex3f(-1,-1,-1 );
-   
-        glTexCoord2f( 0,0 );  glVertex3f(1,-1,1);
-        glTexCoord2f( 0,1 );  glVertex3f( 1,-1,-1 );
-        glTexCoord2f( 1,1);  glVertex3f( 1,1,-1 );
-        glTexCoord2f( 1,0 );  glVertex3f( 1,1,1 );
- 
-        glTexCoord2f( 0,0 );  glVertex3f(-1,1,1);
-        glTexCoord2f( 0,1 );  glVertex3f( 1,1,1 );
-        glTexCoord2f( 1,1);  glVertex3f( 1,1,-1 );
-        glTexCoord2f( 1,0 );  glVertex3f( -1,1,-1);
-
-        glTexCoord2f( 0,0 );  glVertex3f(-1,-1,1);
-        glTexCoord2f( 0,1 );  glVertex3f( -1,-1,-1 );
-        glTexCoord2f( 1,1 );  glVertex3f( 1,-1,-1 );
-        glTexCoord2f( 1,0 );  glVertex3f( 1,-1,1 );
-    glEnd();
-}
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#include <algorithm>
+#include <string>
+#include <string.h>
+#include <vector>
+#include "bvh.h"
+#include "culling.h"
+#include "draw_queue.h"
+#include "frame_capture.h"
+#include "image_io.h"
+#include "image_pool.h"
+#include "instanced_lighting.h"
+#include "mesh.h"
+#include "mipmap.h"
+#include "pixel_lighting.h"
+#include "png_writer.h"
+#include "render_target.h"
+#include "texture_atlas.h"
+#include "texture_cache.h"
+#include "texture_compression.h"
+#include "texture_loader.h"
+#include "timer.h"
+
+#ifdef __APPLE__
+#define GL_SILENCE_DEPRECATION
+#include <GLUT/glut.h>
+#else
+#include <GL/glew.h>
+#include <GL/glut.h>
+#endif
+
+#ifdef _WIN32
+#include <direct.h>
+#define getcwd _getcwd
+#else
+#include <unistd.h>
+#endif
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// CONSTANTS
+/////////////////////////////////////////////////////////////////////////////
+
+#define PI                  3.1415926535897932384626433832795
+
+#define SCENE_RADIUS        6.0     // Mainly for setting far clipping plane distance.
+
+// The room has a square floor, which is centered at the world-space origin.
+// The z-axis is pointing up.
+
+#define ROOM_WIDTH          6.0
+#define ROOM_HEIGHT         4.0
+#define ROOM_TILES          4       // Tiles along each side of the walls, floor and ceiling,
+                                    // which are culled one by one.
+
+// The reflective tabletop is a rectangle that is always parallel to the x-y plane.
+// The sides of the tabletop are always parallel to the x-axis or y-axis.
+
+#define TABLETOP_X1         -1.0
+#define TABLETOP_X2         1.0
+#define TABLETOP_Y1         -1.5
+#define TABLETOP_Y2         1.5
+#define TABLETOP_Z          1.2     // This is the z coordinate of the top-most face of the table.
+#define TABLE_THICKNESS     0.1
+
+// Smallest fraction of the width and height of the reflection's render
+// target that is drawn, when its resolution is scaled to a frame budget.
+
+#define REFLECTION_MIN_SCALE    0.25f
+
+// Number of tiles along each side of the tabletop, each of which is
+// reprojected with the depths at its corners, with amortised reflection
+// updates.
+
+#define REFLECTION_REPROJECTION_TILES   32
+
+// Largest number of frames that amortised reflection updates are spread
+// over. The reprojection fills what the old eye did not see by stretching
+// the image, and resamples the texture in every frame, so the error grows
+// quickly with the interval.
+
+#define REFLECTION_MAX_INTERVAL         4
+
+// Resolution of the spherical props, in cells along the longitude and latitude.
+
+#define SPHERE_SLICES       64
+#define SPHERE_STACKS       32
+#define HEAD_SLICES         24
+#define HEAD_STACKS         24
+
+// First parameters of the meshes in the mesh cache that are not quads,
+// which are negative to tell them apart from the number of steps of a quad.
+
+#define SPHERE_MESH_ID      -1.0f
+#define TEAPOT_MESH_ID      -2.0f
+#define CUBE_MESH_ID        -3.0f
+#define CUBOID_MESH_ID      -4.0f
+
+// The followings are for navigation and setting the view of the (actual) eye.
+
+#define LOOKAT_X            0.0     // Look-at point x coordinate.
+#define LOOKAT_Y            0.0     // Look-at point y coordinate.
+#define LOOKAT_Z            1.0     // Look-at point z coordinate.
+
+#define EYE_INIT_DIST       5.0     // Initial distance of eye from look-at point.
+#define EYE_DIST_INCR       0.2     // Distance increment when changing eye's distance.
+#define EYE_MIN_DIST        0.1     // Min eye's distance from look-at point.
+
+#define EYE_MIN_LATITUDE    -88.0   // Min eye's latitude (in degrees) w.r.t. look-at point.
+#define EYE_MAX_LATITUDE    88.0    // Max eye's latitude (in degrees) w.r.t. look-at point.
+#define EYE_LATITUDE_INCR   2.0     // Degree increment when changing eye's latitude.
+#define EYE_LONGITUDE_INCR  2.0     // Degree increment when changing eye's longitude.
+
+
+// Light 0.
+const GLfloat light0Ambient[] = { 0.1, 0.1, 0.1, 1.0 };
+const GLfloat light0Diffuse[] = { 1.0, 1.0, 1.0, 1.0 };
+const GLfloat light0Specular[] = { 1.0, 1.0, 1.0, 1.0 };
+const GLfloat light0Position[] = { 10.0, -5.0, 8.0, 1.0 };
+
+// Light 1.
+const GLfloat light1Ambient[] = { 0.1, 0.1, 0.1, 1.0 };
+const GLfloat light1Diffuse[] = { 1.0, 1.0, 1.0, 1.0 };
+const GLfloat light1Specular[] = { 1.0, 1.0, 1.0, 1.0 };
+const GLfloat light1Position[] = { -2.0, 10.0, -2.0, 1.0 };
+
+
+// Texture image filenames.
+const char ceilingTexFile[] = "images/ceiling.jpg";
+const char brickTexFile[] = "images/brick.jpg";
+const char checkerTexFile[] = "images/checker.png";
+const char spotsTexFile[] = "images/spots.png";
+const char woodTexFile[] = "images/wood.jpg";
+const char autoBotTexFile[] = "images/autoBot.jpg";
+const char eyesTexFile[] = "images/eyes.jpg";
+
+// Directory of the baked-texture cache, relative to the execution path.
+const char textureCacheDir[] = "texcache";
+
+// Name under which the texture atlas is stored in the baked-texture cache.
+const char textureAtlasCacheName[] = "texture_atlas";
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// GLOBAL VARIABLES
+/////////////////////////////////////////////////////////////////////////////
+
+// Window's size.
+int winWidth = 800;     // Window width in pixels.
+int winHeight = 600;    // Window height in pixels.
+
+
+// Define (actual) eye position.
+// Initial eye position is at [EYE_INIT_DIST, 0, 0] + [LOOKAT_X, LOOKAT_Y, LOOKAT_Z]
+// in the world space, looking at [LOOKAT_X, LOOKAT_Y, LOOKAT_Z].
+// The up-vector is always [0, 0, 1].
+
+double eyeLatitude = 0.0;
+double eyeLongitude = 0.0;
+double eyeDistance = EYE_INIT_DIST;
+
+// The actual eye position in world space.
+// This is computed from eyeLatitude, eyeLongitude, eyeDistance, and the look-at point.
+
+double eyePos[3];
+
+// Texture objects.
+GLuint reflectionTexObj;
+GLuint woodTexObj;
+GLuint ceilingTexObj;
+GLuint brickTexObj;
+GLuint checkerTexObj;
+GLuint spotsTexObj;
+GLuint autoBotTexObj;
+GLuint eyesTexObj;
+
+// Texture atlas of the static scene textures, so that the whole static
+// scene is drawn with a single texture binding.
+bool useTextureAtlas = true;        // Build the atlas at start-up if true.
+GLuint atlasTexObj = 0;             // 0 if the atlas is not in use.
+const int numAtlasTextures = 7;
+GLuint atlasTexObjs[numAtlasTextures];  // Texture objects packed into the atlas; 0 stands for no texture.
+AtlasRegion atlasRegions[numAtlasTextures];
+
+// Texture bindings made through BindTexture().
+GLuint boundTexObj = 0;                 // Texture object bound last.
+unsigned long numTextureBinds = 0;      // Number of glBindTexture() calls so far.
+
+// Draw queue, which sorts the parts of the scene by texture and material.
+bool sortDraws = true;                  // Turned off with --no-draw-sorting.
+
+// Per-pixel lighting with a GLSL program instead of the fixed-function
+// lighting, under which every flat surface is a single quad.
+bool usePixelLighting = false;          // Turned on with --pixel-lighting or 'L'.
+
+// Instanced drawing of the repeated cubes and cuboids, each group of which
+// is drawn with a single call.
+bool useInstancing = true;              // Turned off with --no-instancing.
+
+// Culling of the parts of the scene outside the view frustum, and behind
+// the tabletop in its reflection, before they are submitted.
+bool useCulling = true;                 // Turned off with --no-culling.
+
+// Culling through BVHs over the bounds of the parts of the scene, which
+// is recorded once in world space, so that the parts in view are found
+// without testing every part, and are submitted from the recording
+// without running the code that draws them.
+bool useBVH = true;                     // Turned off with --no-bvh, to cull part by part.
+bool recordingScene = false;            // True while the scene is recorded.
+std::vector<float> scenePartBoxes;      // World-space bounds of the recorded parts, 6 floats each.
+int numReflectedParts = 0;              // The parts seen in the tabletop, which are recorded first.
+BVH *reflectedPartsBVH = NULL;          // Over the parts seen in the tabletop.
+BVH *tablePartsBVH = NULL;              // Over the parts of the table, which follow them.
+int mirrorPart = 0;                     // The tabletop, which is recorded last and is in no BVH.
+
+// Offscreen render target of the reflection, with a resolution that is
+// independent of the window's. Without framebuffer objects, the reflection
+// is drawn in the back buffer and copied into its texture, which is only
+// reallocated when the window is resized.
+int reflectionWidth = 800;              // Set with --reflection-size.
+int reflectionHeight = 600;
+RenderTarget *reflectionTarget = NULL;  // NULL where framebuffer objects are unsupported.
+int reflectionCopyWidth = 0;            // Size of the texture copied into, without the target.
+int reflectionCopyHeight = 0;
+
+// Dynamic resolution of the reflection, which is scaled so that the frame
+// takes about frameBudgetMs on the GPU, as measured by the GPU timers.
+double frameBudgetMs = 0.0;             // Set with --frame-budget; 0 for a fixed resolution.
+GPUTimer *frameTimer = NULL;            // NULL without a budget or timer queries.
+GPUTimer *reflectionTimer = NULL;
+
+// Skipping the reflection pass when the tabletop faces away from the eye or
+// is out of view, and lowering the resolution of the reflection to about
+// that of the part of the view that the tabletop covers.
+bool skipHiddenReflection = true;       // Turned off with --no-reflection-skipping.
+bool reflectionDrawn = false;           // True if the reflection was drawn in the last frame.
+const float mirrorCorners[4][3] = { { TABLETOP_X1, TABLETOP_Y1, TABLETOP_Z }, { TABLETOP_X2, TABLETOP_Y1, TABLETOP_Z },
+                                    { TABLETOP_X2, TABLETOP_Y2, TABLETOP_Z }, { TABLETOP_X1, TABLETOP_Y2, TABLETOP_Z } };
+
+// Amortised updates of the reflection, which redraw one of
+// reflectionInterval bands of its texture in each frame, over the rest of
+// the texture reprojected from the eye that it was drawn from to the new
+// eye, so that each band is redrawn every reflectionInterval frames.
+int reflectionInterval = 1;             // Set with --reflection-interval; 1 to redraw it all.
+int nextReflectionBand = 0;             // The band to redraw next.
+int staleReflectionBands = 0;           // Bands not redrawn since the eye last moved.
+bool reflectionReprojectable = false;   // True if the texture holds the reflection from reflectionEye.
+double reflectionEye[3];                // The eye position that the texture was drawn from.
+float reflectionHeights[REFLECTION_REPROJECTION_TILES + 1][REFLECTION_REPROJECTION_TILES + 1];  // Scene heights at the texture's tile corners.
+
+// Drawing the reflection straight into the window, where the stencil
+// buffer marks the tabletop, instead of into a texture.
+bool useStencilReflection = false;      // Turned on with --stencil-reflection or 'M'.
+bool useObliqueClipping = true;         // Turned off with --no-oblique-clipping, to use a clip plane.
+
+// Inputs of the passes, whose changes are tracked so that the window only
+// redraws the passes whose inputs have changed since they were last drawn.
+// The scene is static, so only the view and the toggles change. The axes
+// are drawn over the scene in every frame, so no pass depends on them.
+#define INPUT_EYE           0x01    // eyeLatitude, eyeLongitude and eyeDistance.
+#define INPUT_WINDOW        0x02    // The window's size.
+#define INPUT_WIREFRAME     0x04    // drawWireframe.
+#define INPUT_TEXTURE       0x08    // hasTexture.
+#define INPUT_LIGHTING      0x10    // usePixelLighting.
+#define INPUT_AXES          0x20    // drawAxes.
+#define INPUT_REFLECTION    0x40    // The reflection's texture or resolution.
+#define INPUT_MIRROR        0x80    // useStencilReflection.
+#define INPUT_STALE_BANDS   0x100   // staleReflectionBands, with amortised reflection updates.
+#define INPUT_ALL           0x1ff
+
+// The window's size is only an input of the reflection when it is copied
+// from the window, without a render target.
+#define REFLECTION_INPUTS   ( INPUT_EYE | INPUT_WIREFRAME | INPUT_TEXTURE | INPUT_LIGHTING | INPUT_REFLECTION | \
+                              INPUT_MIRROR | INPUT_STALE_BANDS )
+#define SCENE_INPUTS        ( REFLECTION_INPUTS | INPUT_WINDOW )
+
+bool trackChanges = true;               // Turned off with --no-change-tracking.
+unsigned int reflectionChanges = INPUT_ALL; // Inputs changed since the reflection was last drawn.
+unsigned int sceneChanges = INPUT_ALL;  // Inputs changed since the scene was last drawn and cached.
+FrameCache *sceneCache = NULL;          // The scene without the axes; NULL if unsupported.
+
+// Retained meshes of the subdivided quads, so that each is generated once
+// and drawn with a single call.
+bool useRetainedMeshes = true;          // Turned off with --no-retained-meshes.
+unsigned long numImmediateVertices = 0; // Vertices of the generated meshes sent in immediate mode.
+int teapotSubdivisions = 7;             // Cells along each side of the teapot's patches.
+
+// Others.
+bool drawAxes = true;           // Draw world coordinate frame axes iff true.
+bool drawWireframe = false;     // Draw polygons in wireframe if true, otherwise polygons are filled.
+bool hasTexture = true;         // Toggle texture mapping.
+bool gammaCorrectMipmaps = false;   // Filter texture mipmaps in linear space if true.
+bool compressTextures = false;      // Use block-compressed scene textures if true.
+
+// Frame capture.
+bool captureNextFrame = false;  // Capture the next frame drawn to a PNG file.
+bool captureBurst = false;      // Draw and capture frames continuously while true.
+int numCapturedFrames = 0;      // For numbering the capture files.
+
+// Poster capture.
+int posterWidth = 16384;        // Poster size in pixels, set with --poster-size.
+int posterHeight = 12288;
+int numPosters = 0;             // For numbering the poster files.
+
+
+// Forward function declarations.
+void DrawAxes( double length );
+void DrawRoom( void );
+void DrawTeapot( void );
+void DrawSphere( void );
+void DrawTable( void );
+void DrawTabletop( GLuint texObj, bool diffuse, bool specular );
+void DrawTransformerBody( void );
+void DrawTransformerHead( void );
+void BindTexture( GLuint texObj );
+void UseSceneTexture( GLuint texObj );
+GLuint GetSceneTextureBinding( GLuint texObj );
+void FlushSceneDraws( void );
+void RecordScene( void );
+void SubmitPartsInView( const BVH *bvh, int firstPart );
+void ScaleReflectionToBudget( void );
+void SetViewMatrices( double aspect, double x0, double x1, double y0, double y1 );
+float GetMirrorCoverage( void );
+float GetMirrorProjectedArea( void );
+void DrawScene( double aspect, double x0, double x1, double y0, double y1, bool redrawReflection );
+void InputsChanged( unsigned int inputs );
+void DrawStencilReflection( bool drawReflection );
+void ReprojectReflection( void );
+void ReadReflectionHeights( const GLint viewport[4], int firstRow, int endRow );
+double GetReflectionHeight( double x, double y );
+void MyIdle( void );
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Draw the parts of the scene submitted to the draw queue, with per-pixel
+// lighting if it is enabled.
+/////////////////////////////////////////////////////////////////////////////
+
+void FlushSceneDraws( void )
+{
+    if ( usePixelLighting ) BeginPixelLighting();
+    FlushDrawQueue();
+    if ( usePixelLighting ) EndPixelLighting();
+}
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Record the parts of the scene in world space, with the room in tiles,
+// and the bounds of each part, and build the BVHs over them.
+/////////////////////////////////////////////////////////////////////////////
+
+void RecordScene( void )
+{
+    scenePartBoxes.clear();
+    recordingScene = true;
+
+    glMatrixMode( GL_MODELVIEW );
+    glPushMatrix();
+    glLoadIdentity();
+    BeginDrawRecording();
+    DrawRoom();
+    DrawTeapot();
+    DrawSphere();
+    DrawTransformerBody();
+    DrawTransformerHead();
+    numReflectedParts = (int)scenePartBoxes.size() / 6;
+    DrawTable();
+    mirrorPart = (int)scenePartBoxes.size() / 6;
+    DrawTabletop( reflectionTexObj, true, true );
+    EndDrawRecording();
+    glPopMatrix();
+
+    recordingScene = false;
+
+    DeleteBVH( reflectedPartsBVH );
+    DeleteBVH( tablePartsBVH );
+    reflectedPartsBVH = BuildBVH( scenePartBoxes.data(), numReflectedParts );
+    tablePartsBVH = BuildBVH( scenePartBoxes.data() + 6 * numReflectedParts, mirrorPart - numReflectedParts );
+}
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Submit the recorded parts in the BVH that may be inside the culling
+// volume. firstPart is the index of the first part of the BVH among the
+// recorded parts.
+/////////////////////////////////////////////////////////////////////////////
+
+void SubmitPartsInView( const BVH *bvh, int firstPart )
+{
+    static std::vector<int> parts;
+    float planes[MAX_CULLING_VOLUME_PLANES][4];
+    QueryBVHFrustum( bvh, planes, GetCullingPlanes( planes ), &parts );
+
+    // Submit the parts in the order in which they were recorded, which
+    // the draw queue keeps where surfaces coincide.
+    std::sort( parts.begin(), parts.end() );
+    for ( size_t i = 0; i < parts.size(); i++ ) parts[i] += firstPart;
+    SubmitRecordedDraws( parts.data(), (int)parts.size() );
+}
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Render the scene from the imaginary viewpoint and capture the image as
+// a texture map.
+//
+// This texture map is then used to texture map the tabletop rectangle
+// to simulate the reflection of the scene from the tabletop.
+//
+// With amortised updates, only the next of the reflectionInterval bands of
+// the image is rendered, over the last image reprojected to the current
+// eye. If the eye has not moved, the render target still holds the last
+// image, at the same scale, since any other change of its scale redraws the
+// whole image, while the window has to be redrawn from the texture. Nothing
+// is rendered if the image is up to date.
+/////////////////////////////////////////////////////////////////////////////
+
+void MakeReflectionImage( void )
+{
+    bool amortise = ( reflectionInterval > 1 && reflectionReprojectable && eyePos[2] > TABLETOP_Z );
+    bool eyeMoved = ( eyePos[0] != reflectionEye[0] || eyePos[1] != reflectionEye[1] ||
+                      eyePos[2] != reflectionEye[2] );
+    if ( amortise && !eyeMoved && staleReflectionBands == 0 ) return;
+
+    if ( reflectionTimer != NULL ) BeginGPUTimer( reflectionTimer );
+    if ( reflectionTarget != NULL ) BeginRenderTarget( reflectionTarget );
+
+    // The band is a range of rows of the viewport, and of the frustum.
+    GLint viewport[4];
+    glGetIntegerv( GL_VIEWPORT, viewport );
+    int firstRow = 0, endRow = viewport[3];
+    if ( viewport[3] < reflectionInterval ) amortise = false;
+    if ( amortise )
+    {
+        if ( eyeMoved || reflectionTarget == NULL ) ReprojectReflection();
+        firstRow = viewport[3] * nextReflectionBand / reflectionInterval;
+        endRow = viewport[3] * ( nextReflectionBand + 1 ) / reflectionInterval;
+        nextReflectionBand = ( nextReflectionBand + 1 ) % reflectionInterval;
+        staleReflectionBands = eyeMoved ? reflectionInterval - 1 : staleReflectionBands - 1;
+
+        glViewport( viewport[0], viewport[1] + firstRow, viewport[2], endRow - firstRow );
+        glScissor( viewport[0], viewport[1] + firstRow, viewport[2], endRow - firstRow );
+        glEnable( GL_SCISSOR_TEST );
+    }
+    else staleReflectionBands = 0;
+
+    glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
+    
+  
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+    // The near plane is the tabletop's own plane, so it already removes what
+    // lies below the tabletop, and needs no oblique or user clip plane.
+    double bottom = TABLETOP_X1 - eyePos[0] + ( TABLETOP_X2 - TABLETOP_X1 ) * firstRow / viewport[3];
+    double top = TABLETOP_X1 - eyePos[0] + ( TABLETOP_X2 - TABLETOP_X1 ) * endRow / viewport[3];
+        glFrustum(TABLETOP_Y1 - eyePos[1], TABLETOP_Y2 - eyePos[1], bottom, top,  eyePos[2] - TABLETOP_Z, eyePos[2] + SCENE_RADIUS);
+        
+    
+
+    glMatrixMode(GL_MODELVIEW);
+    glLoadIdentity();
+        gluLookAt( eyePos[0], eyePos[1], 2 * TABLETOP_Z - eyePos[2], eyePos[0], eyePos[1], eyePos[2], 1.0, 0.0, 0.0 );
+    
+    // Only what is inside the frustum through the tabletop, and above the
+    // tabletop's plane, can be seen in the reflection.
+    if ( useCulling )
+    {
+        const double mirrorPlane[4] = { 0.0, 0.0, 1.0, -TABLETOP_Z };
+        SetCullingFrustum();
+        AddCullingPlane( mirrorPlane );
+    }
+
+    glEnable(GL_LIGHTING);
+    glEnable(GL_LIGHT0);
+    glEnable(GL_LIGHT1);
+    glLightfv(GL_LIGHT0, GL_POSITION, light0Position);
+    glLightfv(GL_LIGHT1, GL_POSITION, light1Position);
+    
+    
+  
+    if ( useCulling && useBVH )
+        SubmitPartsInView( reflectedPartsBVH, 0 );
+    else
+    {
+        DrawRoom();
+        DrawTeapot();
+        DrawSphere();
+        DrawTransformerBody();
+        DrawTransformerHead();
+    }
+    FlushSceneDraws();
+    DisableCulling();
+
+    if ( reflectionInterval > 1 ) ReadReflectionHeights( viewport, firstRow, endRow );
+
+    if ( amortise )
+    {
+        glDisable( GL_SCISSOR_TEST );
+        glViewport( viewport[0], viewport[1], viewport[2], viewport[3] );
+    }
+        
+
+    if ( reflectionTarget != NULL )
+        EndRenderTarget( reflectionTarget );
+    else
+    {
+        glReadBuffer(GL_BACK);
+        BindTexture(reflectionTexObj);
+        if ( reflectionCopyWidth != winWidth || reflectionCopyHeight != winHeight )
+        {
+            glCopyTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 0, 0, winWidth, winHeight, 0);
+            reflectionCopyWidth = winWidth;
+            reflectionCopyHeight = winHeight;
+        }
+        else glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, winWidth, winHeight);
+    }
+
+    if ( reflectionTimer != NULL ) EndGPUTimer( reflectionTimer );
+
+    for ( int i = 0; i < 3; i++ ) reflectionEye[i] = eyePos[i];
+    reflectionReprojectable = ( reflectionInterval > 1 && eyePos[2] > TABLETOP_Z );
+}
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Draw the reflection's texture, which holds the reflection from
+// reflectionEye, over the viewport, reprojected to the reflection from the
+// current eye. Both eyes must be above the tabletop.
+//
+// The tabletop is split into REFLECTION_REPROJECTION_TILES tiles along
+// each side. Each corner of the tiles maps to the point of the scene seen
+// through it from the current mirrored eye, and that to the point of the
+// tabletop through which the old mirrored eye saw it. The height of the
+// scene point is found from the heights that the old eye saw, in
+// reflectionHeights, by starting with the height at the corner itself and
+// moving to the height at the old point a few times. The texture is drawn
+// over the grid of tiles with the texture coordinates of the old points,
+// so each tile is reprojected with the depth of the scene behind it, and
+// the heights are reprojected with it. The map is the identity if the eye
+// has not moved. What the old eye did not see is filled with the edge of
+// its image, or stretched between the tiles next to it.
+/////////////////////////////////////////////////////////////////////////////
+
+void ReprojectReflection( void )
+{
+    const int numTiles = REFLECTION_REPROJECTION_TILES;
+    const int numIterations = 3;
+    double oldEyeHeight = reflectionEye[2] - TABLETOP_Z;
+    double newEyeHeight = eyePos[2] - TABLETOP_Z;
+
+    // Texture coordinates s and t run along the tabletop's y and x axes.
+    static double texCoords[REFLECTION_REPROJECTION_TILES + 1][REFLECTION_REPROJECTION_TILES + 1][2];
+    static float heights[REFLECTION_REPROJECTION_TILES + 1][REFLECTION_REPROJECTION_TILES + 1];
+    for ( int i = 0; i <= numTiles; i++ )
+        for ( int j = 0; j <= numTiles; j++ )
+        {
+            double x = TABLETOP_X1 + ( TABLETOP_X2 - TABLETOP_X1 ) * i / numTiles;
+            double y = TABLETOP_Y1 + ( TABLETOP_Y2 - TABLETOP_Y1 ) * j / numTiles;
+            double oldX = x, oldY = y, height = 0.0;
+            for ( int n = 0; n < numIterations; n++ )
+            {
+                height = GetReflectionHeight( oldX, oldY );
+                double newScale = newEyeHeight / ( newEyeHeight + height );
+                double oldScale = oldEyeHeight / ( oldEyeHeight + height );
+                double sceneX = eyePos[0] + ( x - eyePos[0] ) / newScale;
+                double sceneY = eyePos[1] + ( y - eyePos[1] ) / newScale;
+                oldX = reflectionEye[0] + ( sceneX - reflectionEye[0] ) * oldScale;
+                oldY = reflectionEye[1] + ( sceneY - reflectionEye[1] ) * oldScale;
+            }
+            texCoords[i][j][0] = ( oldY - TABLETOP_Y1 ) / ( TABLETOP_Y2 - TABLETOP_Y1 );
+            texCoords[i][j][1] = ( oldX - TABLETOP_X1 ) / ( TABLETOP_X2 - TABLETOP_X1 );
+            heights[i][j] = (float)height;
+        }
+    memcpy( reflectionHeights, heights, sizeof( heights ) );
+
+    glPushAttrib( GL_ENABLE_BIT | GL_POLYGON_BIT | GL_CURRENT_BIT );
+    glDisable( GL_LIGHTING );
+    glDisable( GL_DEPTH_TEST );
+    glDisable( GL_BLEND );
+    glDisable( GL_CULL_FACE );
+    glEnable( GL_TEXTURE_2D );
+    glPolygonMode( GL_FRONT_AND_BACK, GL_FILL );
+    glColor3f( 1.0f, 1.0f, 1.0f );
+    BindTexture( reflectionTexObj );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+
+    // The texture matrix may still map into a region of the atlas.
+    glMatrixMode( GL_TEXTURE );
+    glPushMatrix();
+    glLoadIdentity();
+    glMatrixMode( GL_PROJECTION );
+    glLoadIdentity();
+    glMatrixMode( GL_MODELVIEW );
+    glLoadIdentity();
+
+    // The viewport's x and y run along the tabletop's y and x axes.
+    for ( int i = 0; i < numTiles; i++ )
+    {
+        glBegin( GL_QUAD_STRIP );
+        for ( int j = 0; j <= numTiles; j++ )
+            for ( int k = 1; k >= 0; k-- )
+            {
+                glTexCoord2dv( texCoords[i + k][j] );
+                glVertex2d( 2.0 * j / numTiles - 1.0, 2.0 * ( i + k ) / numTiles - 1.0 );
+            }
+        glEnd();
+    }
+
+    glMatrixMode( GL_TEXTURE );
+    glPopMatrix();
+    glMatrixMode( GL_MODELVIEW );
+
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT );
+    glPopAttrib();
+}
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Read the heights above the tabletop of the scene seen through the tile
+// corners of the reflection from the depth buffer that it was just drawn
+// with, into reflectionHeights. Only the corners on the rows from firstRow
+// up to endRow of the viewport were drawn, so only those are read, one row
+// of depths for each row of corners.
+/////////////////////////////////////////////////////////////////////////////
+
+void ReadReflectionHeights( const GLint viewport[4], int firstRow, int endRow )
+{
+    const int numTiles = REFLECTION_REPROJECTION_TILES;
+    double nearDist = eyePos[2] - TABLETOP_Z;
+    double farDist = eyePos[2] + SCENE_RADIUS;
+    std::vector<GLfloat> depths( viewport[2] );
+
+    glPushClientAttrib( GL_CLIENT_PIXEL_STORE_BIT );
+    glPixelStorei( GL_PACK_ALIGNMENT, 1 );
+    for ( int i = 0; i <= numTiles; i++ )
+    {
+        int row = ( i < numTiles ) ? viewport[3] * i / numTiles : viewport[3] - 1;
+        if ( row < firstRow || row >= endRow ) continue;
+        glReadPixels( viewport[0], viewport[1] + row, viewport[2], 1, GL_DEPTH_COMPONENT, GL_FLOAT, depths.data() );
+        for ( int j = 0; j <= numTiles; j++ )
+        {
+            int column = ( j < numTiles ) ? viewport[2] * j / numTiles : viewport[2] - 1;
+            // Undo the perspective division to get the distance along the
+            // mirrored eye's view direction, which is straight up.
+            double z = 2.0 * depths[column] - 1.0;
+            double dist = 2.0 * farDist * nearDist / ( farDist + nearDist - z * ( farDist - nearDist ) );
+            reflectionHeights[i][j] = (float)( dist - nearDist );
+        }
+    }
+    glPopClientAttrib();
+}
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns the height above the tabletop of the point of the scene seen in
+// the reflection's texture at the point ( x, y ) of the tabletop,
+// interpolated between the heights at the corners of the tile around it.
+// Points off the tabletop take the height at its nearest edge.
+/////////////////////////////////////////////////////////////////////////////
+
+double GetReflectionHeight( double x, double y )
+{
+    const int numTiles = REFLECTION_REPROJECTION_TILES;
+    double u = ( x - TABLETOP_X1 ) / ( TABLETOP_X2 - TABLETOP_X1 ) * numTiles;
+    double v = ( y - TABLETOP_Y1 ) / ( TABLETOP_Y2 - TABLETOP_Y1 ) * numTiles;
+    u = ( u < 0.0 ) ? 0.0 : ( u > numTiles ) ? numTiles : u;
+    v = ( v < 0.0 ) ? 0.0 : ( v > numTiles ) ? numTiles : v;
+    int i = ( u < numTiles ) ? (int)u : numTiles - 1;
+    int j = ( v < numTiles ) ? (int)v : numTiles - 1;
+    double fu = u - i, fv = v - j;
+    return ( reflectionHeights[i][j] * ( 1.0 - fv ) + reflectionHeights[i][j + 1] * fv ) * ( 1.0 - fu ) +
+           ( reflectionHeights[i + 1][j] * ( 1.0 - fv ) + reflectionHeights[i + 1][j + 1] * fv ) * fu;
+}
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Scale the resolution of the reflection so that a frame takes about
+// frameBudgetMs on the GPU, from the latest timings of the frame and of
+// the reflection. Only the reflection is scaled, so its budget is what the
+// rest of the frame leaves of the frame's.
+/////////////////////////////////////////////////////////////////////////////
+
+void ScaleReflectionToBudget( void )
+{
+    if ( reflectionTarget == NULL || frameTimer == NULL || reflectionTimer == NULL ) return;
+    if ( !reflectionDrawn ) return;
+
+    double frameMs = GetGPUTimerMs( frameTimer );
+    double reflectionMs = GetGPUTimerMs( reflectionTimer );
+    if ( frameMs < 0.0 || reflectionMs < 0.0 ) return;
+
+    float scale = GetRenderTargetScale( reflectionTarget );
+    UpdateRenderTargetScale( reflectionTarget, reflectionMs, frameBudgetMs - ( frameMs - reflectionMs ),
+                             REFLECTION_MIN_SCALE );
+    if ( GetRenderTargetScale( reflectionTarget ) != scale ) InputsChanged( INPUT_REFLECTION );
+}
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Record that the inputs, a combination of the INPUT_* flags, have
+// changed, so that the passes that depend on them are redrawn. The
+// reflection's texture is only reprojected when the eye alone has moved.
+/////////////////////////////////////////////////////////////////////////////
+
+void InputsChanged( unsigned int inputs )
+{
+    reflectionChanges |= inputs;
+    sceneChanges |= inputs;
+
+    if ( ( inputs & ~( INPUT_EYE | INPUT_AXES | INPUT_STALE_BANDS ) ) != 0 )
+    {
+        reflectionReprojectable = false;
+        staleReflectionBands = 0;
+    }
+}
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Set the projection and the modelview matrices of the view, for the part
+// of the view frustum from fraction x0 to x1 of its width and from y0 to y1
+// of its height, with the full view having the input aspect ratio.
+/////////////////////////////////////////////////////////////////////////////
+
+void SetViewMatrices( double aspect, double x0, double x1, double y0, double y1 )
+{
+    // Scale and shift the part of the view to fill the window.
+    glMatrixMode( GL_PROJECTION );
+    glLoadIdentity();
+    glScaled( 1.0 / ( x1 - x0 ), 1.0 / ( y1 - y0 ), 1.0 );
+    glTranslated( 1.0 - x0 - x1, 1.0 - y0 - y1, 0.0 );
+    gluPerspective( 45.0, aspect, EYE_MIN_DIST, eyeDistance + SCENE_RADIUS );
+
+    glMatrixMode( GL_MODELVIEW );
+    glLoadIdentity();
+    gluLookAt( eyePos[0], eyePos[1], eyePos[2], LOOKAT_X, LOOKAT_Y, LOOKAT_Z, 0.0, 0.0, 1.0 );
+}
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns the fraction of the window that the tabletop covers in the
+// current view, or 0 if it is out of view or if the eye is not above it,
+// where it shows the underside of the table and no reflection.
+/////////////////////////////////////////////////////////////////////////////
+
+float GetMirrorCoverage( void )
+{
+    if ( eyePos[2] <= TABLETOP_Z ) return 0.0f;
+    return GetPolygonCoverage( mirrorCorners, 4 );
+}
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns the area of the whole tabletop in the current view, as a
+// fraction of the window, including the parts of it outside the window.
+/////////////////////////////////////////////////////////////////////////////
+
+float GetMirrorProjectedArea( void )
+{
+    return GetPolygonProjectedArea( mirrorCorners, 4 );
+}
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Draw the frame into the back buffer. The window shows the part of the
+// view frustum from fraction x0 to x1 of its width and from y0 to y1 of
+// its height, with the full view having the input aspect ratio.
+// The full view in the window is given by ( 0, 1, 0, 1 ) with the window's
+// aspect ratio; other parts are used for rendering posters in tiles.
+/////////////////////////////////////////////////////////////////////////////
+
+void DrawFrame( double aspect, double x0, double x1, double y0, double y1 )
+{
+    DrawScene( aspect, x0, x1, y0, y1, true );
+
+    // Draw axes.
+    if ( drawAxes ) DrawAxes( SCENE_RADIUS );
+}
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Draw the scene, without the axes, as DrawFrame() does, leaving the
+// matrices of the view set. The reflection is drawn first, unless
+// redrawReflection is false, in which case its texture is reused.
+/////////////////////////////////////////////////////////////////////////////
+
+void DrawScene( double aspect, double x0, double x1, double y0, double y1, bool redrawReflection )
+{
+    // Other code may have bound other textures since the last frame.
+    boundTexObj = (GLuint)-1;
+
+    if ( hasTexture )
+        glEnable( GL_TEXTURE_2D );
+    else
+        glDisable( GL_TEXTURE_2D );
+
+    // Compute world-space eye position from eyeLatitude, eyeLongitude, eyeDistance, and look-at point.
+    eyePos[2] = eyeDistance * sin( eyeLatitude * PI / 180.0 ) + LOOKAT_Z;
+    double xy = eyeDistance * cos( eyeLatitude * PI / 180.0 );
+    eyePos[0] = xy * cos( eyeLongitude * PI / 180.0 ) + LOOKAT_X;
+    eyePos[1] = xy * sin( eyeLongitude * PI / 180.0 ) + LOOKAT_Y;
+
+    // The reflection is skipped if the tabletop covers less than a pixel,
+    // and is otherwise drawn with at most twice as many texels across as
+    // the pixels that the tabletop would cover, to allow for the
+    // perspective, since the finer mipmap levels would not be sampled.
+    // The reflection image spans the whole tabletop, so this counts the
+    // pixels of the tabletop outside the window too.
+    reflectionDrawn = redrawReflection && !useStencilReflection;
+    if ( reflectionDrawn && skipHiddenReflection )
+    {
+        SetViewMatrices( aspect, x0, x1, y0, y1 );
+        double coveredPixels = GetMirrorCoverage() * winWidth * winHeight;
+        reflectionDrawn = ( coveredPixels >= 1.0 );
+        if ( reflectionTarget != NULL )
+        {
+            double projectedPixels = GetMirrorProjectedArea() * winWidth * winHeight;
+            double maxScale = 2.0 * sqrt( projectedPixels / ( (double)reflectionWidth * reflectionHeight ) );
+            SetRenderTargetMaxScale( reflectionTarget, ( maxScale > REFLECTION_MIN_SCALE ) ? (float)maxScale : REFLECTION_MIN_SCALE );
+        }
+    }
+    if ( reflectionDrawn )
+        MakeReflectionImage();
+    else if ( redrawReflection )
+    {
+        reflectionReprojectable = false;
+        staleReflectionBands = 0;
+    }
+
+    glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT );
+
+    SetViewMatrices( aspect, x0, x1, y0, y1 );
+
+    // In the stencil mode, the tabletop is drawn first, with the reflection.
+    if ( useStencilReflection &&
+         ( !skipHiddenReflection || GetMirrorCoverage() * winWidth * winHeight >= 1.0 ) )
+        DrawStencilReflection( hasTexture );
+
+    if ( useCulling ) SetCullingFrustum();
+
+    // Set world-space positions of the two lights.
+    glLightfv( GL_LIGHT0, GL_POSITION, light0Position );
+    glLightfv( GL_LIGHT1, GL_POSITION, light1Position );
+
+    // Draw scene. The objects submit their parts that may be in view to the
+    // draw queue, which draws them sorted by texture and material. With
+    // per-pixel lighting, the floor is a single quad, whose depth differs
+    // from that of the axes along it, so the polygons are pushed back
+    // slightly to keep the axes in front of it.
+    if ( usePixelLighting )
+    {
+        glEnable( GL_POLYGON_OFFSET_FILL );
+        glPolygonOffset( 0.0, 4.0 );
+    }
+    if ( useCulling && useBVH )
+    {
+        SubmitPartsInView( reflectedPartsBVH, 0 );
+        SubmitPartsInView( tablePartsBVH, numReflectedParts );
+        if ( !useStencilReflection && GetMirrorCoverage() > 0.0f ) SubmitRecordedDraws( &mirrorPart, 1 );
+    }
+    else
+    {
+        DrawRoom();
+        DrawTeapot();
+        DrawSphere();
+        DrawTransformerBody();
+        DrawTransformerHead();
+        DrawTable();
+        if ( !useStencilReflection ) DrawTabletop( reflectionTexObj, true, true );
+    }
+    FlushSceneDraws();
+    DisableCulling();
+    glDisable( GL_POLYGON_OFFSET_FILL );
+}
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Draw the tabletop and its reflection straight into the window, for the
+// stencil mode, with the matrices of the view set. The pixels of the
+// tabletop are marked in the stencil buffer, and the scene is drawn there
+// mirrored in the tabletop's plane, clipped to what is above the plane by
+// the near plane of an oblique projection, or by a user clip plane.
+// The tabletop is then drawn over it, modulating the reflection by the
+// ambient and diffuse light, as the texture method does, and adding the
+// specular light. Its depth then hides the mirrored scene from the rest of
+// the scene. Without drawReflection, only the tabletop is drawn.
+/////////////////////////////////////////////////////////////////////////////
+
+void DrawStencilReflection( bool drawReflection )
+{
+    // The tabletop is pushed back as the rest of the scene is.
+    if ( usePixelLighting )
+    {
+        glEnable( GL_POLYGON_OFFSET_FILL );
+        glPolygonOffset( 0.0, 4.0 );
+    }
+
+    if ( drawReflection )
+    {
+        // Mark the pixels of the tabletop, without drawing it.
+        glEnable( GL_STENCIL_TEST );
+        glStencilFunc( GL_ALWAYS, 1, 1 );
+        glStencilOp( GL_KEEP, GL_KEEP, GL_REPLACE );
+        glColorMask( GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE );
+        glDepthMask( GL_FALSE );
+        glPushAttrib( GL_ENABLE_BIT );
+        glDisable( GL_LIGHTING );
+        glDisable( GL_TEXTURE_2D );
+        glBegin( GL_QUADS );
+            glVertex3d( TABLETOP_X1, TABLETOP_Y1, TABLETOP_Z );
+            glVertex3d( TABLETOP_X2, TABLETOP_Y1, TABLETOP_Z );
+            glVertex3d( TABLETOP_X2, TABLETOP_Y2, TABLETOP_Z );
+            glVertex3d( TABLETOP_X1, TABLETOP_Y2, TABLETOP_Z );
+        glEnd();
+        glPopAttrib();
+        glColorMask( GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE );
+        glDepthMask( GL_TRUE );
+
+        // Draw the mirrored scene into the marked pixels. The mirror reverses
+        // the winding of the polygons. The clipping plane and the lights are
+        // given in the coordinates of the scene before it is mirrored, in
+        // which the mirrored eye is below the tabletop.
+        const double mirrorPlane[4] = { 0.0, 0.0, 1.0, -TABLETOP_Z };
+        glStencilFunc( GL_EQUAL, 1, 1 );
+        glStencilOp( GL_KEEP, GL_KEEP, GL_KEEP );
+        glMatrixMode( GL_PROJECTION );
+        glPushMatrix();
+        glMatrixMode( GL_MODELVIEW );
+        glPushMatrix();
+        glTranslated( 0.0, 0.0, 2.0 * TABLETOP_Z );
+        glScaled( 1.0, 1.0, -1.0 );
+        glFrontFace( GL_CW );
+        if ( useObliqueClipping )
+            SetObliqueNearPlane( mirrorPlane );
+        else
+        {
+            glClipPlane( GL_CLIP_PLANE0, mirrorPlane );
+            glEnable( GL_CLIP_PLANE0 );
+        }
+        glLightfv( GL_LIGHT0, GL_POSITION, light0Position );
+        glLightfv( GL_LIGHT1, GL_POSITION, light1Position );
+
+        // The culling volume has the oblique near plane, or the clip plane.
+        if ( useCulling )
+        {
+            SetCullingFrustum();
+            if ( !useObliqueClipping ) AddCullingPlane( mirrorPlane );
+        }
+        if ( useCulling && useBVH )
+            SubmitPartsInView( reflectedPartsBVH, 0 );
+        else
+        {
+            DrawRoom();
+            DrawTeapot();
+            DrawSphere();
+            DrawTransformerBody();
+            DrawTransformerHead();
+        }
+        FlushSceneDraws();
+        DisableCulling();
+
+        glDisable( GL_CLIP_PLANE0 );
+        glFrontFace( GL_CCW );
+        glPopMatrix();
+        glMatrixMode( GL_PROJECTION );
+        glPopMatrix();
+        glMatrixMode( GL_MODELVIEW );
+        glDisable( GL_STENCIL_TEST );
+    }
+
+    glLightfv( GL_LIGHT0, GL_POSITION, light0Position );
+    glLightfv( GL_LIGHT1, GL_POSITION, light1Position );
+
+    // The depth of the mirrored scene, which may be in another projection,
+    // is replaced by the tabletop's, as nothing else has been drawn yet.
+    if ( drawReflection )
+    {
+        glEnable( GL_BLEND );
+        glBlendFunc( GL_DST_COLOR, GL_ZERO );
+        glDepthFunc( GL_ALWAYS );
+        DrawTabletop( 0, true, false );
+        FlushSceneDraws();
+
+        glBlendFunc( GL_ONE, GL_ONE );
+        glDepthFunc( GL_EQUAL );
+        DrawTabletop( 0, false, true );
+        FlushSceneDraws();
+        glDepthFunc( GL_LESS );
+        glDisable( GL_BLEND );
+    }
+    else
+    {
+        DrawTabletop( 0, true, true );
+        FlushSceneDraws();
+    }
+
+    glDisable( GL_POLYGON_OFFSET_FILL );
+}
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Render the current view into a PNG file of posterWidth x posterHeight
+// pixels, which may be much larger than the window and than the maximum
+// viewport size. The poster is drawn in window-sized tiles, a row of tiles
+// at a time from the top down, and each row is read back into one band of
+// the image and streamed to the file. So only one band of the poster is
+// ever held in memory.
+/////////////////////////////////////////////////////////////////////////////
+
+void RenderPoster( const char *filename )
+{
+    PNGStreamWriter *writer = BeginPNGStream( filename, posterWidth, posterHeight, 3, 0 );
+    if ( writer == NULL ) return;
+
+    double startTime = GetWallClockMs();
+    double aspect = (double)posterWidth / posterHeight;
+    Image band;
+
+    glReadBuffer( GL_BACK );
+    glPixelStorei( GL_PACK_ALIGNMENT, 1 );
+    glPixelStorei( GL_PACK_ROW_LENGTH, posterWidth );
+
+    bool success = true;
+
+    // Every tile redraws the whole reflection.
+    int sceneReflectionInterval = reflectionInterval;
+    reflectionInterval = 1;
+
+    for ( int bandTop = posterHeight; success && bandTop > 0; bandTop -= winHeight )
+    {
+        // The tiles of the bottom band are aligned to the bottom of the
+        // poster, overlapping the band above.
+        int bandHeight = ( bandTop < winHeight ) ? bandTop : winHeight;
+        int tileY = bandTop - winHeight;
+        if ( tileY < 0 ) tileY = 0;
+
+        if ( !band.Allocate( posterWidth, bandHeight, 3 ) )
+        {
+            success = false;
+            break;
+        }
+
+        for ( int tileX = 0; tileX < posterWidth; tileX += winWidth )
+        {
+            DrawFrame( aspect, (double)tileX / posterWidth, (double)( tileX + winWidth ) / posterWidth,
+                       (double)tileY / posterHeight, (double)( tileY + winHeight ) / posterHeight );
+
+            int width = ( posterWidth - tileX < winWidth ) ? posterWidth - tileX : winWidth;
+            glReadPixels( 0, 0, width, bandHeight, GL_RGB, GL_UNSIGNED_BYTE, band.Data() + tileX * 3 );
+        }
+
+        success = WritePNGStreamBand( writer, bandTop - bandHeight, bandHeight, band.Data() ) != 0;
+    }
+
+    glPixelStorei( GL_PACK_ROW_LENGTH, 0 );
+    glPixelStorei( GL_PACK_ALIGNMENT, 4 );
+    reflectionInterval = sceneReflectionInterval;
+
+    if ( EndPNGStream( writer ) && success )
+        printf( "Poster %s (%d x %d) written in %.0f ms.\n", filename, posterWidth, posterHeight,
+                GetWallClockMs() - startTime );
+}
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// The display callback function.
+/////////////////////////////////////////////////////////////////////////////
+
+void MyDisplay( void )
+{
+    if ( !trackChanges ) reflectionChanges = sceneChanges = INPUT_ALL;
+    // The reflection depends on the window's size if it is drawn in the
+    // window, or if its resolution and whether it is skipped depend on how
+    // many pixels of the window the tabletop covers.
+    unsigned int reflectionInputs = REFLECTION_INPUTS |
+        ( ( reflectionTarget == NULL || skipHiddenReflection ) ? INPUT_WINDOW : 0 );
+    double aspect = (double)winWidth / winHeight;
+
+    if ( frameTimer != NULL ) BeginGPUTimer( frameTimer );
+
+    // Redraw only the passes whose inputs have changed, and otherwise
+    // restore the cached scene and draw the axes over it.
+    if ( ( sceneChanges & SCENE_INPUTS ) == 0 && sceneCache != NULL &&
+         RestoreFrameCache( sceneCache, winWidth, winHeight ) )
+    {
+        reflectionDrawn = false;
+        SetViewMatrices( aspect, 0.0, 1.0, 0.0, 1.0 );
+    }
+    else
+    {
+        bool redrawReflection = ( reflectionChanges & reflectionInputs ) != 0;
+        DrawScene( aspect, 0.0, 1.0, 0.0, 1.0, redrawReflection );
+        // A skipped reflection is still out of date, and is drawn once the
+        // tabletop comes into view.
+        if ( reflectionDrawn ) reflectionChanges = 0;
+        sceneChanges = 0;
+
+        if ( sceneCache != NULL && !SaveFrameCache( sceneCache, winWidth, winHeight ) )
+        {
+            fprintf( stderr, "Warning: Cannot cache the scene; it is redrawn in every frame.\n" );
+            DeleteFrameCache( sceneCache );
+            sceneCache = NULL;
+        }
+    }
+    if ( drawAxes ) DrawAxes( SCENE_RADIUS );
+
+    if ( frameTimer != NULL ) EndGPUTimer( frameTimer );
+
+    // Start an asynchronous capture of the back buffer before it is swapped.
+    if ( captureNextFrame || captureBurst )
+    {
+        char filename[64];
+        sprintf( filename, "capture_%04d.png", numCapturedFrames++ );
+        CaptureFrame( 0, 0, winWidth, winHeight, filename );
+        captureNextFrame = false;
+    }
+
+    glutSwapBuffers();
+    AgeFrameCaptures();
+    ScaleReflectionToBudget();
+
+    // Keep redrawing bands of the reflection until all of them are redrawn
+    // from the eye's latest position.
+    if ( staleReflectionBands > 0 )
+    {
+        InputsChanged( INPUT_STALE_BANDS );
+        glutPostRedisplay();
+    }
+
+    // Hand finished captures to the encoder, and keep polling while idle
+    // until all of them are resolved.
+    if ( ResolveFrameCaptures( false ) > 0 || captureBurst )
+        glutIdleFunc( MyIdle );
+}
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// The idle callback function. Only registered while captures are pending
+// or a capture burst is on. Once the burst is off, no more frames are
+// drawn until the next event, so the pending captures are waited for,
+// which delays no frame, and is the only way to resolve them without
+// fences, since only presented frames age them.
+/////////////////////////////////////////////////////////////////////////////
+
+void MyIdle( void )
+{
+    if ( captureBurst )
+        glutPostRedisplay();
+    else
+    {
+        ResolveFrameCaptures( true );
+        glutIdleFunc( NULL );
+    }
+}
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// The keyboard callback function.
+/////////////////////////////////////////////////////////////////////////////
+
+void MyKeyboard( unsigned char key, int x, int y )
+{
+    switch ( key )
+    {
+        // Quit program.
+        case 'q':
+        case 'Q':
+            FinishFrameCapture();
+            exit(0);
+            break;
+
+        // Toggle between wireframe and filled polygons.
+        case 'w':
+        case 'W':
+            drawWireframe = !drawWireframe;
+            if ( drawWireframe )
+                glPolygonMode( GL_FRONT_AND_BACK, GL_LINE );
+            else
+                glPolygonMode( GL_FRONT_AND_BACK, GL_FILL );
+            InputsChanged( INPUT_WIREFRAME );
+            glutPostRedisplay();
+            break;
+
+        // Toggle axes.
+        case 'x':
+        case 'X':
+            drawAxes = !drawAxes;
+            InputsChanged( INPUT_AXES );
+            glutPostRedisplay();
+            break;
+
+        // Toggle texture mapping.
+        case 't':
+        case 'T':
+            hasTexture = !hasTexture;
+            InputsChanged( INPUT_TEXTURE );
+            glutPostRedisplay();
+            break;
+
+        // Toggle between the reflection drawn into a texture and drawn
+        // through the stencil buffer.
+        case 'm':
+        case 'M':
+            useStencilReflection = !useStencilReflection;
+            InputsChanged( INPUT_MIRROR );
+            glutPostRedisplay();
+            break;
+
+        // Toggle between per-pixel and fixed-function lighting.
+        case 'l':
+        case 'L':
+            usePixelLighting = !usePixelLighting && InitPixelLighting();
+            InputsChanged( INPUT_LIGHTING );
+            glutPostRedisplay();
+            break;
+
+       // Reset to initial view.
+        case 'r':
+        case 'R':
+            eyeLatitude = 0.0;
+            eyeLongitude = 0.0;
+            eyeDistance = EYE_INIT_DIST;
+            InputsChanged( INPUT_EYE );
+            glutPostRedisplay();
+            break;
+
+        // Capture the next frame to a PNG file.
+        case 'c':
+        case 'C':
+            captureNextFrame = true;
+            glutPostRedisplay();
+            break;
+
+        // Render the current view to a poster-size PNG file.
+        case 'p':
+        case 'P':
+        {
+            char filename[64];
+            sprintf( filename, "poster_%04d.png", numPosters++ );
+            RenderPoster( filename );
+            // The poster overwrote the reflection, but not the cached scene.
+            reflectionChanges |= INPUT_REFLECTION;
+            glutPostRedisplay();
+            break;
+        }
+
+        // Toggle a capture burst, which captures every frame.
+        case 'v':
+        case 'V':
+            captureBurst = !captureBurst;
+            glutPostRedisplay();
+            break;
+    }
+}
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// The special key callback function.
+/////////////////////////////////////////////////////////////////////////////
+
+void MySpecialKey( int key, int x, int y )
+{
+    int modi = glutGetModifiers();
+
+    switch ( key )
+    {
+        case GLUT_KEY_LEFT:
+            eyeLongitude -= EYE_LONGITUDE_INCR;
+            if ( eyeLongitude < -360.0 ) eyeLongitude += 360.0 ;
+            InputsChanged( INPUT_EYE );
+            glutPostRedisplay();
+            break;
+
+        case GLUT_KEY_RIGHT:
+            eyeLongitude += EYE_LONGITUDE_INCR;
+            if ( eyeLongitude > 360.0 ) eyeLongitude -= 360.0 ;
+            InputsChanged( INPUT_EYE );
+            glutPostRedisplay();
+            break;
+
+        case GLUT_KEY_UP:
+            if ( modi != GLUT_ACTIVE_SHIFT )
+            {
+                eyeLatitude += EYE_LATITUDE_INCR;
+                if ( eyeLatitude > EYE_MAX_LATITUDE ) eyeLatitude = EYE_MAX_LATITUDE;
+            }
+            else
+            {
+                eyeDistance -= EYE_DIST_INCR;
+                if ( eyeDistance < EYE_MIN_DIST ) eyeDistance = EYE_MIN_DIST;
+            }
+            InputsChanged( INPUT_EYE );
+            glutPostRedisplay();
+            break;
+
+        case GLUT_KEY_DOWN:
+            if ( modi != GLUT_ACTIVE_SHIFT )
+            {
+                eyeLatitude -= EYE_LATITUDE_INCR;
+                if ( eyeLatitude < EYE_MIN_LATITUDE ) eyeLatitude = EYE_MIN_LATITUDE;
+            }
+            else
+            {
+                eyeDistance += EYE_DIST_INCR;
+            }
+            InputsChanged( INPUT_EYE );
+            glutPostRedisplay();
+            break;
+    }
+}
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// The reshape callback function.
+/////////////////////////////////////////////////////////////////////////////
+
+void MyReshape( int w, int h )
+{
+    winWidth = w;
+    winHeight = h;
+    glViewport( 0, 0, w, h );
+    InputsChanged( INPUT_WINDOW );
+}
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Initialize some OpenGL states.
+/////////////////////////////////////////////////////////////////////////////
+
+void GLInit( void )
+{
+    glClearColor( 0.0, 0.0, 0.0, 1.0 ); // Set black background color.
+
+    glShadeModel( GL_SMOOTH ); // Enable Gouraud shading.
+    glEnable( GL_DEPTH_TEST ); // Use depth-buffer for hidden surface removal.
+    glEnable( GL_CULL_FACE );  // Enable back-face culling.
+
+    glDisable( GL_DITHER );
+    glDisable( GL_BLEND );
+
+    // Set Light 0.
+    glLightfv( GL_LIGHT0, GL_AMBIENT, light0Ambient );
+    glLightfv( GL_LIGHT0, GL_DIFFUSE, light0Diffuse );
+    glLightfv( GL_LIGHT0, GL_SPECULAR, light0Specular );
+    glEnable( GL_LIGHT0 );
+
+    // Set Light 1.
+    glLightfv( GL_LIGHT1, GL_AMBIENT, light1Ambient );
+    glLightfv( GL_LIGHT1, GL_DIFFUSE, light1Diffuse );
+    glLightfv( GL_LIGHT1, GL_SPECULAR, light1Specular );
+    glEnable( GL_LIGHT1 );
+
+    glEnable( GL_LIGHTING );
+
+    // Set some global light properties.
+    GLfloat globalAmbient[] = { 0.1, 0.1, 0.1, 1.0 };
+    glLightModelfv( GL_LIGHT_MODEL_AMBIENT, globalAmbient );
+    glLightModeli( GL_LIGHT_MODEL_LOCAL_VIEWER, GL_TRUE );
+    glLightModeli( GL_LIGHT_MODEL_TWO_SIDE, GL_TRUE );
+    glLightModeli( GL_LIGHT_MODEL_COLOR_CONTROL, GL_SEPARATE_SPECULAR_COLOR );
+
+    // Set initial material properties.
+    GLfloat initMaterialAmbient[] = { 1.0, 1.0, 1.0, 1.0 };
+    GLfloat initMaterialDiffuse[] = { 1.0, 1.0, 1.0, 1.0 };
+    GLfloat initMaterialSpecular[] = { 0.5, 0.5, 0.5, 1.0 };
+    GLfloat initMaterialShininess[] = { 16.0 };
+    GLfloat initMaterialEmission[] = { 0.0, 0.0, 0.0, 1.0 };
+    glMaterialfv( GL_FRONT_AND_BACK, GL_AMBIENT, initMaterialAmbient );
+    glMaterialfv( GL_FRONT_AND_BACK, GL_DIFFUSE, initMaterialDiffuse );
+    glMaterialfv( GL_FRONT_AND_BACK, GL_SPECULAR, initMaterialSpecular );
+    glMaterialfv( GL_FRONT_AND_BACK, GL_SHININESS, initMaterialShininess );
+    glMaterialfv( GL_FRONT_AND_BACK, GL_EMISSION, initMaterialEmission );
+
+    // Let OpenGL automatically renomarlize all normal vectors.
+    // This is important if objects are to be scaled.
+    glEnable( GL_NORMALIZE );
+
+    // All textures modulate the lit color.
+    glTexEnvf( GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE );
+
+    // The draw queue applies the scene textures through the texture atlas.
+    SetDrawQueueTextureFuncs( UseSceneTexture, GetSceneTextureBinding );
+}
+
+
+
+
+// A scene texture whose image has to be decoded because it has no valid
+// entry in the baked-texture cache.
+struct SceneTextureUpload
+{
+    GLuint texObj;
+    bool bakeCache;                 // Write the texture to the cache after it is built.
+    unsigned long long sourceHash;
+    std::string cacheFilename;
+    int atlasIndex;                 // Index in the texture atlas, or -1 if uploaded on its own.
+    uchar *atlasImage;              // Decoded image kept for building the atlas, or NULL.
+    int imageWidth, imageHeight;
+};
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Bind the texture object and set the sampling parameters used by all
+// the scene textures.
+/////////////////////////////////////////////////////////////////////////////
+
+void BindSceneTexture( GLuint texObj )
+{
+    glBindTexture( GL_TEXTURE_2D, texObj );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR );
+}
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Bind the texture atlas and set its sampling parameters. The atlas has no
+// GL_REPEAT of its own; its textures repeat in their gutters instead.
+/////////////////////////////////////////////////////////////////////////////
+
+void BindAtlasTexture( GLuint texObj )
+{
+    glBindTexture( GL_TEXTURE_2D, texObj );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR );
+}
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Upload a decoded texture image into its texture object and build its
+// mipmaps, or keep a copy of it if it goes into the texture atlas.
+// This is called on the GL thread by the texture loader.
+/////////////////////////////////////////////////////////////////////////////
+
+void UploadSceneTexture( int index, const uchar *imageData,
+                         int imageWidth, int imageHeight, int numComponents, void *userData )
+{
+    SceneTextureUpload *upload = (SceneTextureUpload *) userData + index;
+
+    // The atlas is built once all its images are decoded. A texture that
+    // cannot be kept is uploaded on its own, and the atlas is not built.
+    if ( upload->atlasIndex >= 0 )
+    {
+        size_t imageSize = (size_t)imageWidth * imageHeight * numComponents;
+        upload->atlasImage = (uchar *)AllocatePooledBlock( imageSize );
+        upload->imageWidth = imageWidth;
+        upload->imageHeight = imageHeight;
+        if ( upload->atlasImage != NULL )
+        {
+            memcpy( upload->atlasImage, imageData, imageSize );
+            return;
+        }
+        upload->atlasIndex = -1;
+    }
+
+    BindSceneTexture( upload->texObj );
+    int uploaded;
+    if ( compressTextures )
+        uploaded = UploadCompressedMipmappedTexture( imageData, imageWidth, imageHeight, numComponents,
+                                                     gammaCorrectMipmaps );
+    else
+        uploaded = UploadMipmappedTexture( imageData, imageWidth, imageHeight, numComponents, gammaCorrectMipmaps );
+    if ( !uploaded )
+    {
+        fprintf( stderr, "Error: Out of memory for the mipmaps of texture %d.\n", index );
+        return;
+    }
+
+    if ( upload->bakeCache )
+        BakeCachedTexture( upload->cacheFilename.data(), upload->sourceHash );
+}
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Upload the texture atlas from the baked-texture cache into atlasTexObj,
+// and work out the regions of its textures from the sizes of their image
+// files. Returns true if successful, or false if the cache file is missing
+// or stale, or does not match the layout of the atlas.
+/////////////////////////////////////////////////////////////////////////////
+
+bool UploadCachedTextureAtlas( const std::string *texPaths, const int *atlasIndices, int numTextures,
+                               const std::string &cacheFilename, unsigned long long sourceHash )
+{
+    int imageWidths[numAtlasTextures], imageHeights[numAtlasTextures];
+    imageWidths[numAtlasTextures - 1] = imageHeights[numAtlasTextures - 1] = 1;     // The white texel.
+    for ( int i = 0; i < numTextures; i++ )
+    {
+        int numComponents;
+        if ( atlasIndices[i] >= 0 &&
+             !ProbeImageFile( texPaths[i].data(), &imageWidths[atlasIndices[i]], &imageHeights[atlasIndices[i]],
+                              &numComponents ) ) return false;
+    }
+
+    int atlasWidth, atlasHeight;
+    if ( !PackTextureAtlas( numAtlasTextures, imageWidths, imageHeights, &atlasWidth, &atlasHeight, atlasRegions ) )
+        return false;
+
+    BindAtlasTexture( atlasTexObj );
+    if ( !UploadCachedTexture( cacheFilename.data(), sourceHash ) ) return false;
+
+    GLint width = 0, height = 0;
+    glGetTexLevelParameteriv( GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width );
+    glGetTexLevelParameteriv( GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height );
+    return width == atlasWidth && height == atlasHeight;
+}
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Pack the decoded images kept by UploadSceneTexture(), and a white texel
+// for the untextured objects, into the texture atlas, and write it to the
+// cache if bakeCache is true. If the atlas cannot be built, it is not used
+// and the images are uploaded into their own texture objects instead.
+// The kept images are freed either way.
+/////////////////////////////////////////////////////////////////////////////
+
+void BuildSceneTextureAtlas( int numUploads, SceneTextureUpload *uploads, bool bakeCache,
+                             const std::string &cacheFilename, unsigned long long sourceHash )
+{
+    const uchar *images[numAtlasTextures] = { NULL };
+    int imageWidths[numAtlasTextures], imageHeights[numAtlasTextures];
+    imageWidths[numAtlasTextures - 1] = imageHeights[numAtlasTextures - 1] = 1;     // The white texel.
+
+    int numImages = 0;
+    for ( int u = 0; u < numUploads; u++ )
+    {
+        int i = uploads[u].atlasIndex;
+        if ( i < 0 ) continue;
+        images[i] = uploads[u].atlasImage;
+        imageWidths[i] = uploads[u].imageWidth;
+        imageHeights[i] = uploads[u].imageHeight;
+        numImages++;
+    }
+
+    BindAtlasTexture( atlasTexObj );
+    bool built = numImages == numAtlasTextures - 1 &&
+                 BuildTextureAtlas( numAtlasTextures, images, imageWidths, imageHeights, gammaCorrectMipmaps,
+                                    compressTextures, atlasRegions );
+    if ( built && bakeCache )
+        BakeCachedTexture( cacheFilename.data(), sourceHash );
+
+    if ( !built )
+    {
+        fprintf( stderr, "Warning: Cannot build the texture atlas.\n" );
+        glDeleteTextures( 1, &atlasTexObj );
+        atlasTexObj = 0;
+    }
+
+    for ( int u = 0; u < numUploads; u++ )
+    {
+        if ( uploads[u].atlasIndex < 0 ) continue;
+        uploads[u].atlasIndex = -1;
+        if ( !built )
+            UploadSceneTexture( u, uploads[u].atlasImage, uploads[u].imageWidth, uploads[u].imageHeight, 3, uploads );
+        FreePooledBlock( uploads[u].atlasImage );
+        uploads[u].atlasImage = NULL;
+    }
+}
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Set up texture maps.
+// Each texture is first looked up in the baked-texture cache if
+// useTextureCache is true. The images of the remaining textures are decoded
+// with numDecodeThreads worker threads (0 means one per hardware core,
+// 1 means decode serially on this thread), each is uploaded on this thread
+// as soon as it has been decoded, and is then written to the cache.
+// If useTextureAtlas is true, the static scene textures are packed into
+// the texture atlas, which is looked up in and written to the cache as a
+// whole. They are only uploaded as part of the atlas, so their own texture
+// objects get no storage and just name the textures in the atlas.
+/////////////////////////////////////////////////////////////////////////////
+
+void SetUpTextureMaps( std::string execPath, int numDecodeThreads, bool useTextureCache )
+{
+    // The texture image files and the texture objects they are loaded into.
+    const char *texFiles[] = { woodTexFile, ceilingTexFile, brickTexFile, checkerTexFile,
+                               spotsTexFile, autoBotTexFile, eyesTexFile };
+    GLuint *texObjs[] = { &woodTexObj, &ceilingTexObj, &brickTexObj, &checkerTexObj,
+                          &spotsTexObj, &autoBotTexObj, &eyesTexObj };
+    // The index of each texture in the texture atlas, or -1 if it is not packed into it.
+    const int atlasIndices[] = { -1, 0, 1, 2, 3, 4, 5 };
+    const int numTextures = sizeof( texFiles ) / sizeof( texFiles[0] );
+
+    glPixelStorei( GL_UNPACK_ALIGNMENT, 1 );
+
+    std::string cacheDir = execPath + "/" + std::string( textureCacheDir );
+
+    // Textures built differently are cached separately.
+    std::string cacheVariant = compressTextures ? "bc1" : "";
+    if ( gammaCorrectMipmaps ) cacheVariant += cacheVariant.empty() ? "srgb" : ".srgb";
+
+    std::string texPaths[numTextures];
+    unsigned long long sourceHashes[numTextures];
+    bool hashed[numTextures];
+
+    for ( int i = 0; i < numTextures; i++ )
+    {
+        glGenTextures( 1, texObjs[i] );
+
+    //  Concatenate the execution path to the image path so that fopen() works.
+        texPaths[i] = execPath + "/" + std::string( texFiles[i] );
+        sourceHashes[i] = 0;
+        hashed[i] = useTextureCache && HashFileContent( texPaths[i].data(), &sourceHashes[i] );
+    }
+
+    // This texture object is for storing the reflection image read from the color buffer.
+    glGenTextures( 1, &reflectionTexObj );
+    glBindTexture( GL_TEXTURE_2D, reflectionTexObj );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR );
+    glTexParameteri( GL_TEXTURE_2D, GL_GENERATE_MIPMAP, GL_TRUE );
+
+    // The atlas is cached under the combined hash of the images packed into it.
+    bool buildAtlas = false, bakeAtlas = false;
+    unsigned long long atlasHash = 0;
+    std::string atlasCacheFilename = GetTextureCacheFilename( cacheDir, textureAtlasCacheName, cacheVariant.data() );
+    atlasTexObj = 0;
+    if ( useTextureAtlas )
+    {
+        glGenTextures( 1, &atlasTexObj );
+        bakeAtlas = useTextureCache;
+        for ( int i = 0; i < numTextures; i++ )
+        {
+            if ( atlasIndices[i] < 0 ) continue;
+            atlasTexObjs[atlasIndices[i]] = *texObjs[i];
+            bakeAtlas = bakeAtlas && hashed[i];
+            atlasHash = ( atlasHash ^ sourceHashes[i] ) * 1099511628211ull;
+        }
+        atlasTexObjs[numAtlasTextures - 1] = 0;
+        buildAtlas = !( bakeAtlas && UploadCachedTextureAtlas( texPaths, atlasIndices, numTextures,
+                                                               atlasCacheFilename, atlasHash ) );
+    }
+
+    SceneTextureUpload uploads[numTextures];
+    const char *texPathPtrs[numTextures];
+    int numUploads = 0;
+
+    for ( int i = 0; i < numTextures; i++ )
+    {
+        bool inAtlas = useTextureAtlas && atlasIndices[i] >= 0;
+        if ( inAtlas && !buildAtlas ) continue;
+
+        std::string cacheFilename = GetTextureCacheFilename( cacheDir, texFiles[i], cacheVariant.data() );
+
+        BindSceneTexture( *texObjs[i] );
+        if ( !inAtlas && hashed[i] && UploadCachedTexture( cacheFilename.data(), sourceHashes[i] ) ) continue;
+
+        // Cache miss: decode the image, and bake it into the cache afterwards.
+        // Check the image format from its header before spending time on decoding.
+        int imageWidth, imageHeight, numComponents;
+        if ( ProbeImageFile( texPaths[i].data(), &imageWidth, &imageHeight, &numComponents ) == 0 ) exit( 1 );
+        if ( numComponents != 3 )
+        {
+            fprintf( stderr, "Error: Texture image is not in RGB format.\n" );
+            exit( 1 );
+        }
+
+        // Allocate the texture storage now, so that the upload only has to fill it in.
+        // Compressed levels are specified one by one instead.
+        if ( !compressTextures && !inAtlas )
+            AllocateMipmappedTexture( imageWidth, imageHeight, numComponents );
+
+        uploads[numUploads].texObj = *texObjs[i];
+        uploads[numUploads].bakeCache = hashed[i];
+        uploads[numUploads].sourceHash = sourceHashes[i];
+        uploads[numUploads].cacheFilename = cacheFilename;
+        uploads[numUploads].atlasIndex = inAtlas ? atlasIndices[i] : -1;
+        uploads[numUploads].atlasImage = NULL;
+        texPathPtrs[numUploads] = texPaths[i].data();
+        numUploads++;
+    }
+
+    if ( LoadImageFiles( numUploads, texPathPtrs, numDecodeThreads,
+                         UploadSceneTexture, uploads ) == 0 ) exit( 1 );
+
+    if ( buildAtlas ) BuildSceneTextureAtlas( numUploads, uploads, bakeAtlas, atlasCacheFilename, atlasHash );
+}
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Delete the texture objects created by SetUpTextureMaps().
+/////////////////////////////////////////////////////////////////////////////
+
+void DeleteTextureMaps( void )
+{
+    GLuint texObjs[] = { woodTexObj, ceilingTexObj, brickTexObj, checkerTexObj,
+                         spotsTexObj, autoBotTexObj, eyesTexObj, reflectionTexObj, atlasTexObj };
+    glDeleteTextures( sizeof( texObjs ) / sizeof( texObjs[0] ), texObjs );
+    atlasTexObj = 0;
+}
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Measure the time taken by SetUpTextureMaps() with serial and with
+// parallel texture decoding, and with a warm baked-texture cache,
+// and print the results.
+/////////////////////////////////////////////////////////////////////////////
+
+void BenchmarkTextureSetUp( std::string execPath )
+{
+    const int numRuns = 5;
+    const int numModes = 3;
+    const char *modeNames[numModes] = { "serial decode", "parallel decode", "warm cache" };
+    const int modeThreads[numModes] = { 1, 0, 0 };
+    const bool modeUseCache[numModes] = { false, false, true };
+
+    // Make sure the cache is warm for the last mode.
+    SetUpTextureMaps( execPath, 0, true );
+    DeleteTextureMaps();
+
+    for ( int m = 0; m < numModes; m++ )
+    {
+        double bestMs = 0.0, totalMs = 0.0;
+
+        for ( int run = 0; run < numRuns; run++ )
+        {
+            glFinish();
+            double startMs = GetWallClockMs();
+            SetUpTextureMaps( execPath, modeThreads[m], modeUseCache[m] );
+            glFinish();
+            double runMs = GetWallClockMs() - startMs;
+            DeleteTextureMaps();
+
+            totalMs += runMs;
+            if ( run == 0 || runMs < bestMs ) bestMs = runMs;
+        }
+
+        printf( "SetUpTextureMaps() %-15s: best %8.2f ms, mean %8.2f ms over %d runs.\n",
+                modeNames[m], bestMs, totalMs / numRuns, numRuns );
+    }
+
+    // Once the pool is warm, reloading the textures should reuse every block.
+    ImagePoolStats poolStats;
+    GetImagePoolStats( &poolStats );
+    printf( "Image pool: %lu blocks allocated from the system, %lu reused.\n",
+            (unsigned long) poolStats.numSystemAllocations, (unsigned long) poolStats.numReusedBlocks );
+}
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Measure the time taken to draw a frame, and the CPU time taken to submit
+// it, and count the texture bindings and the vertices of the generated
+// meshes per frame, with and without the texture atlas and the retained
+// meshes, and print the results. The eye is raised above the initial
+// view, from which the tabletop is not seen, so that the reflection is
+// drawn. The textures in the atlas have no storage of their own, so the
+// separate textures are only measured with --no-texture-atlas, and the
+// atlas only without it.
+/////////////////////////////////////////////////////////////////////////////
+
+#define BENCH_EYE_LATITUDE  24.0
+
+void BenchmarkFrame( void )
+{
+    const int numFrames = 100;
+    const double sceneEyeLatitude = eyeLatitude;
+    const GLuint sceneAtlasTexObj = atlasTexObj;
+    const bool sceneUseRetainedMeshes = useRetainedMeshes;
+    const bool sceneUseCulling = useCulling;
+    const bool sceneUseBVH = useBVH;
+    const float sceneReflectionScale = ( reflectionTarget != NULL ) ? GetRenderTargetScale( reflectionTarget ) : 1.0f;
+    const bool sceneUsePixelLighting = usePixelLighting;
+    const bool sceneUseStencilReflection = useStencilReflection;
+    const int sceneReflectionInterval = reflectionInterval;
+
+    eyeLatitude = BENCH_EYE_LATITUDE;
+    reflectionInterval = 1;
+
+    struct { const char *name; bool atlas; bool retainedMeshes; bool sortDraws; bool instancing; bool culling;
+             bool bvh; bool pixelLighting; float reflectionScale; bool stencilReflection; } modes[] = {
+        { "separate textures, immediate mode", false, false, false, false, false, false, false, 1.0f, false },
+        { "texture atlas, immediate mode", true, false, false, false, false, false, false, 1.0f, false },
+        { "texture atlas, retained meshes", true, true, false, false, false, false, false, 1.0f, false },
+        { "texture atlas, retained, sorted draws", true, true, true, false, false, false, false, 1.0f, false },
+        { "as above, instanced draws", true, true, true, true, false, false, false, 1.0f, false },
+        { "as above, culled part by part", true, true, true, true, true, false, false, 1.0f, false },
+        { "as above, culled through the BVH", true, true, true, true, true, true, false, 1.0f, false },
+        { "as above, stencil reflection", true, true, true, true, true, true, false, 1.0f, true },
+        { "BVH culled, per-pixel lighting", true, true, true, true, true, true, true, 1.0f, false },
+        { "as above, half-size reflection", true, true, true, true, true, true, true, 0.5f, false },
+        { "as above, stencil reflection", true, true, true, true, true, true, true, 1.0f, true },
+    };
+
+    for ( size_t m = 0; m < sizeof( modes ) / sizeof( modes[0] ); m++ )
+    {
+        if ( modes[m].atlas != ( sceneAtlasTexObj != 0 ) ) continue;
+        if ( modes[m].instancing && !InitInstancedLighting() ) continue;
+        if ( modes[m].pixelLighting && !InitPixelLighting() ) continue;
+        atlasTexObj = modes[m].atlas ? sceneAtlasTexObj : 0;
+        useRetainedMeshes = modes[m].retainedMeshes;
+        SetDrawQueueSorting( modes[m].sortDraws );
+        SetDrawQueueInstancing( modes[m].instancing );
+        useCulling = modes[m].culling;
+        useBVH = modes[m].bvh;
+        if ( reflectionTarget != NULL ) SetRenderTargetScale( reflectionTarget, modes[m].reflectionScale );
+        usePixelLighting = modes[m].pixelLighting;
+        useStencilReflection = modes[m].stencilReflection;
+
+        DrawFrame( (double)winWidth / winHeight, 0.0, 1.0, 0.0, 1.0 );     // Warm up.
+        glFinish();
+
+        MeshStats startMeshStats;
+        GetMeshStats( &startMeshStats );
+        DrawQueueStats startQueueStats;
+        GetDrawQueueStats( &startQueueStats );
+        CullingStats startCullingStats;
+        GetCullingStats( &startCullingStats );
+        BVHStats startBVHStats;
+        GetBVHStats( &startBVHStats );
+        unsigned long startBinds = numTextureBinds;
+        unsigned long startImmediateVertices = numImmediateVertices;
+        double startMs = GetWallClockMs();
+        for ( int i = 0; i < numFrames; i++ )
+            DrawFrame( (double)winWidth / winHeight, 0.0, 1.0, 0.0, 1.0 );
+        double submitMs = ( GetWallClockMs() - startMs ) / numFrames;
+        glFinish();
+        double frameMs = ( GetWallClockMs() - startMs ) / numFrames;
+        MeshStats meshStats;
+        GetMeshStats( &meshStats );
+        DrawQueueStats queueStats;
+        GetDrawQueueStats( &queueStats );
+        CullingStats cullingStats;
+        GetCullingStats( &cullingStats );
+        BVHStats bvhStats;
+        GetBVHStats( &bvhStats );
+
+        printf( "%-38s: %8.3f ms per frame (%7.3f ms to submit), "
+                "%5.1f parts culled, %5.1f draws (%4.1f instanced items), %5.1f material changes, "
+                "%5.1f texture binds, %7.0f immediate-mode vertices, "
+                "%5.1f mesh draws (%7.0f vertices, %7.0f indices) per frame.\n",
+                modes[m].name, frameMs, submitMs,
+                (double)( cullingStats.numCulled - startCullingStats.numCulled +
+                          bvhStats.numPrimsCulled - startBVHStats.numPrimsCulled ) / numFrames,
+                (double)( queueStats.numDraws - startQueueStats.numDraws ) / numFrames,
+                (double)( queueStats.numInstances - startQueueStats.numInstances ) / numFrames,
+                (double)( queueStats.numMaterialChanges - startQueueStats.numMaterialChanges ) / numFrames,
+                (double)( numTextureBinds - startBinds ) / numFrames,
+                (double)( numImmediateVertices - startImmediateVertices ) / numFrames,
+                (double)( meshStats.numDraws - startMeshStats.numDraws ) / numFrames,
+                (double)( meshStats.numVerticesDrawn - startMeshStats.numVerticesDrawn ) / numFrames,
+                (double)( meshStats.numElementsDrawn - startMeshStats.numElementsDrawn ) / numFrames );
+    }
+
+    MeshStats meshStats;
+    GetMeshStats( &meshStats );
+    printf( "Retained meshes: %lu meshes, %.1f KB of vertex and index data.\n",
+            (unsigned long)meshStats.numMeshes, meshStats.numBufferBytes / 1024.0 );
+
+    atlasTexObj = sceneAtlasTexObj;
+    useRetainedMeshes = sceneUseRetainedMeshes;
+    SetDrawQueueSorting( sortDraws );
+    SetDrawQueueInstancing( useInstancing );
+    useCulling = sceneUseCulling;
+    useBVH = sceneUseBVH;
+    if ( reflectionTarget != NULL ) SetRenderTargetScale( reflectionTarget, sceneReflectionScale );
+    usePixelLighting = sceneUsePixelLighting;
+    useStencilReflection = sceneUseStencilReflection;
+    reflectionInterval = sceneReflectionInterval;
+    eyeLatitude = sceneEyeLatitude;
+}
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Measure the time taken to draw a frame with the texture reflection, and
+// with the stencil reflection clipped by a user clip plane and by an
+// oblique near plane, from views at several heights above the tabletop,
+// and print the results. The images of the two stencil reflections are
+// checked to be the same, up to a difference of 1 in any channel, except
+// for at most 1 pixel in 10000, where the two planes clip polygons a
+// little differently.
+//
+// Then measure the frame time with amortised reflection updates at several
+// intervals, as the eye circles the table by one step per frame, and the
+// PSNR of the reflection's texture in each frame against the texture
+// redrawn in full from the same eye.
+// Returns 1 if the two stencil reflections are the same in every view,
+// or 0 if not.
+/////////////////////////////////////////////////////////////////////////////
+
+int BenchmarkReflection( void )
+{
+    const int numFrames = 50;
+    const double latitudes[] = { 4.0, 8.0, 16.0, 32.0, 64.0 };
+    const int numViews = sizeof( latitudes ) / sizeof( latitudes[0] );
+    const double sceneEyeLatitude = eyeLatitude;
+    const bool sceneUseStencilReflection = useStencilReflection;
+    const bool sceneUseObliqueClipping = useObliqueClipping;
+    const double sceneEyeLongitude = eyeLongitude;
+    const int sceneReflectionInterval = reflectionInterval;
+    std::vector<unsigned char> images[2];
+    int numMatchingViews = 0;
+
+    reflectionInterval = 1;
+    glReadBuffer( GL_BACK );
+    glPixelStorei( GL_PACK_ALIGNMENT, 1 );
+
+    printf( "%8s %12s %12s %12s %16s %9s\n", "latitude", "texture ms", "clip ms", "oblique ms", "pixels differing", "max diff" );
+    for ( int v = 0; v < numViews; v++ )
+    {
+        eyeLatitude = latitudes[v];
+
+        double frameMs[3];
+        for ( int mode = 0; mode < 3; mode++ )
+        {
+            useStencilReflection = ( mode > 0 );
+            useObliqueClipping = ( mode == 2 );
+
+            DrawFrame( (double)winWidth / winHeight, 0.0, 1.0, 0.0, 1.0 );     // Warm up.
+            glFinish();
+            double startMs = GetWallClockMs();
+            for ( int i = 0; i < numFrames; i++ )
+                DrawFrame( (double)winWidth / winHeight, 0.0, 1.0, 0.0, 1.0 );
+            glFinish();
+            frameMs[mode] = ( GetWallClockMs() - startMs ) / numFrames;
+
+            if ( mode > 0 )
+            {
+                images[mode - 1].resize( (size_t)winWidth * winHeight * 3 );
+                glReadPixels( 0, 0, winWidth, winHeight, GL_RGB, GL_UNSIGNED_BYTE, images[mode - 1].data() );
+            }
+        }
+
+        int numDiffering = 0, maxDiff = 0;
+        for ( size_t k = 0; k < images[0].size(); k += 3 )
+        {
+            int diff = 0;
+            for ( int c = 0; c < 3; c++ )
+            {
+                int d = abs( (int)images[0][k + c] - (int)images[1][k + c] );
+                if ( d > diff ) diff = d;
+            }
+            if ( diff > 1 ) numDiffering++;
+            if ( diff > maxDiff ) maxDiff = diff;
+        }
+        if ( numDiffering <= winWidth * winHeight / 10000 ) numMatchingViews++;
+
+        printf( "%8.0f %12.3f %12.3f %12.3f %16d %9d\n", latitudes[v], frameMs[0], frameMs[1], frameMs[2],
+                numDiffering, maxDiff );
+    }
+    printf( "The oblique near plane gives the image of the clip plane in %d of %d views.\n",
+            numMatchingViews, numViews );
+
+    const int intervals[] = { 1, 2, 3, 4 };
+    eyeLatitude = BENCH_EYE_LATITUDE;
+    useStencilReflection = false;
+
+    printf( "%8s %12s %14s %14s\n", "interval", "frame ms", "mean PSNR dB", "min PSNR dB" );
+    for ( size_t n = 0; n < sizeof( intervals ) / sizeof( intervals[0] ); n++ )
+    {
+        reflectionInterval = intervals[n];
+
+        eyeLongitude = sceneEyeLongitude;
+        InputsChanged( INPUT_REFLECTION );
+        DrawFrame( (double)winWidth / winHeight, 0.0, 1.0, 0.0, 1.0 );     // Warm up.
+        glFinish();
+        double startMs = GetWallClockMs();
+        for ( int i = 0; i < numFrames; i++ )
+        {
+            eyeLongitude += EYE_LONGITUDE_INCR;
+            DrawFrame( (double)winWidth / winHeight, 0.0, 1.0, 0.0, 1.0 );
+        }
+        glFinish();
+        double frameMs = ( GetWallClockMs() - startMs ) / numFrames;
+
+        // Compare the texture in each frame with the texture redrawn in full,
+        // and then put it back, with the state of the amortised updates.
+        int width = ( reflectionTarget != NULL ) ? reflectionWidth : reflectionCopyWidth;
+        int height = ( reflectionTarget != NULL ) ? reflectionHeight : reflectionCopyHeight;
+        double sumPSNR = 0.0, minPSNR = 99.0;
+        int nextBand = 0, staleBands = 0;
+        bool reprojectable = false;
+        double eye[3];
+        static float heights[REFLECTION_REPROJECTION_TILES + 1][REFLECTION_REPROJECTION_TILES + 1];
+        eyeLongitude = sceneEyeLongitude;
+        InputsChanged( INPUT_REFLECTION );
+        DrawFrame( (double)winWidth / winHeight, 0.0, 1.0, 0.0, 1.0 );
+        for ( int i = 0; i < numFrames; i++ )
+        {
+            eyeLongitude += EYE_LONGITUDE_INCR;
+            DrawFrame( (double)winWidth / winHeight, 0.0, 1.0, 0.0, 1.0 );
+
+            for ( int k = 0; k < 2; k++ )
+            {
+                images[k].resize( (size_t)width * height * 3 );
+                if ( k == 1 ) MakeReflectionImage();
+                BindTexture( reflectionTexObj );
+                glGetTexImage( GL_TEXTURE_2D, 0, GL_RGB, GL_UNSIGNED_BYTE, images[k].data() );
+                if ( k == 0 )
+                {
+                    // The full redraw reads the heights of every row, so
+                    // keep the ones that the amortised updates have.
+                    nextBand = nextReflectionBand;
+                    staleBands = staleReflectionBands;
+                    reprojectable = reflectionReprojectable;
+                    memcpy( eye, reflectionEye, sizeof( eye ) );
+                    memcpy( heights, reflectionHeights, sizeof( heights ) );
+                    reflectionReprojectable = false;
+                }
+            }
+            nextReflectionBand = nextBand;
+            staleReflectionBands = staleBands;
+            reflectionReprojectable = reprojectable;
+            memcpy( reflectionEye, eye, sizeof( eye ) );
+            memcpy( reflectionHeights, heights, sizeof( heights ) );
+            glTexSubImage2D( GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, images[0].data() );
+            if ( reflectionTarget != NULL ) glGenerateMipmap( GL_TEXTURE_2D );
+
+            double sumSquares = 0.0;
+            for ( size_t k = 0; k < images[0].size(); k++ )
+            {
+                double d = (double)images[0][k] - (double)images[1][k];
+                sumSquares += d * d;
+            }
+            double mse = sumSquares / images[0].size();
+            double psnr = ( mse > 0.0 ) ? 10.0 * log10( 255.0 * 255.0 / mse ) : 99.0;
+            sumPSNR += psnr;
+            if ( psnr < minPSNR ) minPSNR = psnr;
+        }
+
+        printf( "%8d %12.3f %14.2f %14.2f\n", intervals[n], frameMs, sumPSNR / numFrames, minPSNR );
+    }
+
+    eyeLatitude = sceneEyeLatitude;
+    eyeLongitude = sceneEyeLongitude;
+    reflectionInterval = sceneReflectionInterval;
+    useStencilReflection = sceneUseStencilReflection;
+    useObliqueClipping = sceneUseObliqueClipping;
+    return numMatchingViews == numViews;
+}
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// The main function.
+/////////////////////////////////////////////////////////////////////////////
+
+int main( int argc, char** argv )
+{
+// Benchmarks that do not need an OpenGL context.
+
+    for ( int i = 1; i < argc; i++ )
+    {
+        if ( strcmp( argv[i], "--bench-png" ) == 0 )
+        {
+            BenchmarkPNGWriter( "out.png" );
+            return 0;
+        }
+    }
+
+
+// Initialize GLUT and create window.
+
+    glutInit( &argc, argv );
+    glutInitDisplayMode ( GLUT_RGB | GLUT_DOUBLE | GLUT_DEPTH | GLUT_STENCIL );
+    glutInitWindowSize( winWidth, winHeight );
+    glutCreateWindow( "Lab3" );
+    fprintf(stdout, "Running %s...\n", argv[0]);
+
+
+// Register the callback functions.
+
+    glutDisplayFunc( MyDisplay );
+    glutReshapeFunc( MyReshape );
+    glutKeyboardFunc( MyKeyboard );
+    glutSpecialFunc( MySpecialKey );
+
+
+// Initialize GLEW.
+// The followings make sure OpenGL 1.4 is supported and set up the extensions.
+// macOS does not require GLEW, so an extra check is performed.
+
+#ifndef __APPLE__
+    GLenum err = glewInit();
+    if ( err != GLEW_OK )
+    {
+        fprintf( stderr, "Error: %s.\n", glewGetErrorString( err ) );
+        exit( 1 );
+    }
+    printf( "Status: Using GLEW %s.\n\n", glewGetString( GLEW_VERSION ) );
+
+    if ( !GLEW_VERSION_1_4 )
+    {
+        fprintf( stderr, "Error: OpenGL 1.4 is not supported.\n" );
+        exit( 1 );
+    }
+#endif
+
+
+// Setup the initial render context.
+
+    GLInit();
+
+    std::string execPath( getcwd( NULL, 256 ) );
+
+    bool useTextureCache = true;
+
+    for ( int i = 1; i < argc; i++ )
+    {
+        if ( strcmp( argv[i], "--bench-startup" ) == 0 )
+        {
+            BenchmarkTextureSetUp( execPath );
+            return 0;
+        }
+        else if ( strcmp( argv[i], "--bench-mipmap" ) == 0 )
+        {
+            const char *texFiles[] = { woodTexFile, ceilingTexFile, brickTexFile, checkerTexFile,
+                                       spotsTexFile, autoBotTexFile, eyesTexFile };
+            BenchmarkMipmaps( sizeof( texFiles ) / sizeof( texFiles[0] ), texFiles );
+            return 0;
+        }
+        else if ( strcmp( argv[i], "--bench-compression" ) == 0 )
+        {
+            const char *texFiles[] = { woodTexFile, ceilingTexFile, brickTexFile, checkerTexFile,
+                                       spotsTexFile, autoBotTexFile, eyesTexFile };
+            BenchmarkTextureCompression( sizeof( texFiles ) / sizeof( texFiles[0] ), texFiles );
+            return 0;
+        }
+        else if ( strcmp( argv[i], "--no-texture-cache" ) == 0 )
+            useTextureCache = false;
+        else if ( strcmp( argv[i], "--no-texture-atlas" ) == 0 )
+            useTextureAtlas = false;
+        else if ( strcmp( argv[i], "--no-retained-meshes" ) == 0 )
+            useRetainedMeshes = false;
+        else if ( strcmp( argv[i], "--no-draw-sorting" ) == 0 )
+            sortDraws = false;
+        else if ( strcmp( argv[i], "--no-instancing" ) == 0 )
+            useInstancing = false;
+        else if ( strcmp( argv[i], "--no-culling" ) == 0 )
+            useCulling = false;
+        else if ( strcmp( argv[i], "--no-bvh" ) == 0 )
+            useBVH = false;
+        else if ( strcmp( argv[i], "--no-reflection-skipping" ) == 0 )
+            skipHiddenReflection = false;
+        else if ( strcmp( argv[i], "--no-change-tracking" ) == 0 )
+            trackChanges = false;
+        else if ( strcmp( argv[i], "--stencil-reflection" ) == 0 )
+            useStencilReflection = true;
+        else if ( strcmp( argv[i], "--no-oblique-clipping" ) == 0 )
+            useObliqueClipping = false;
+        else if ( strcmp( argv[i], "--pixel-lighting" ) == 0 )
+        {
+            usePixelLighting = InitPixelLighting() != 0;
+            if ( !usePixelLighting )
+                fprintf( stderr, "Warning: Per-pixel lighting is not supported.\n" );
+        }
+        else if ( strcmp( argv[i], "--teapot-subdivisions" ) == 0 && i + 1 < argc )
+        {
+            teapotSubdivisions = atoi( argv[++i] );
+            if ( teapotSubdivisions < 1 )
+            {
+                fprintf( stderr, "Error: Invalid number of teapot subdivisions %s.\n", argv[i] );
+                exit( 1 );
+            }
+        }
+        else if ( strcmp( argv[i], "--gamma-correct-mipmaps" ) == 0 )
+            gammaCorrectMipmaps = true;
+        else if ( strcmp( argv[i], "--compress-textures" ) == 0 )
+        {
+            compressTextures = HasTextureCompression() != 0;
+            if ( !compressTextures )
+                fprintf( stderr, "Warning: Compressed textures are not supported.\n" );
+        }
+        else if ( strcmp( argv[i], "--reflection-size" ) == 0 && i + 1 < argc )
+        {
+            if ( sscanf( argv[++i], "%dx%d", &reflectionWidth, &reflectionHeight ) != 2 ||
+                 reflectionWidth <= 0 || reflectionHeight <= 0 )
+            {
+                fprintf( stderr, "Error: Invalid reflection size %s.\n", argv[i] );
+                exit( 1 );
+            }
+        }
+        else if ( strcmp( argv[i], "--frame-budget" ) == 0 && i + 1 < argc )
+        {
+            frameBudgetMs = atof( argv[++i] );
+            if ( frameBudgetMs <= 0.0 )
+            {
+                fprintf( stderr, "Error: Invalid frame budget %s.\n", argv[i] );
+                exit( 1 );
+            }
+        }
+        else if ( strcmp( argv[i], "--reflection-interval" ) == 0 && i + 1 < argc )
+        {
+            reflectionInterval = atoi( argv[++i] );
+            if ( reflectionInterval < 1 || reflectionInterval > REFLECTION_MAX_INTERVAL )
+            {
+                fprintf( stderr, "Error: Invalid reflection interval %s.\n", argv[i] );
+                exit( 1 );
+            }
+        }
+        else if ( strcmp( argv[i], "--poster-size" ) == 0 && i + 1 < argc )
+        {
+            if ( sscanf( argv[++i], "%dx%d", &posterWidth, &posterHeight ) != 2 ||
+                 posterWidth <= 0 || posterHeight <= 0 )
+            {
+                fprintf( stderr, "Error: Invalid poster size %s.\n", argv[i] );
+                exit( 1 );
+            }
+        }
+    }
+
+    SetUpTextureMaps( execPath, 0, useTextureCache );
+    if ( HasRenderTargets() )
+        reflectionTarget = CreateRenderTarget( reflectionTexObj, reflectionWidth, reflectionHeight );
+    if ( HasRenderTargets() && trackChanges ) sceneCache = CreateFrameCache();
+    if ( frameBudgetMs > 0.0 )
+    {
+        frameTimer = CreateGPUTimer();
+        reflectionTimer = CreateGPUTimer();
+        if ( reflectionTarget == NULL || frameTimer == NULL )
+            fprintf( stderr, "Warning: Dynamic resolution is not supported.\n" );
+    }
+    SetDrawQueueSorting( sortDraws );
+    if ( useInstancing ) useInstancing = InitInstancedLighting() != 0;
+    SetDrawQueueInstancing( useInstancing );
+    RecordScene();
+
+    for ( int i = 1; i < argc; i++ )
+    {
+        if ( strcmp( argv[i], "--bench-frame" ) == 0 )
+        {
+            BenchmarkFrame();
+            return 0;
+        }
+        else if ( strcmp( argv[i], "--bench-reflection" ) == 0 )
+        {
+            // Fail if the two ways of clipping the stencil reflection differ.
+            return BenchmarkReflection() ? 0 : 1;
+        }
+        else if ( strcmp( argv[i], "--bench-bvh" ) == 0 )
+        {
+            BenchmarkBVH( scenePartBoxes.data(), (int)scenePartBoxes.size() / 6 );
+            return 0;
+        }
+    }
+
+
+// Display user instructions in console window.
+
+    printf( "Press LEFT to move eye left.\n" );
+    printf( "Press RIGHT to move eye right.\n" );
+    printf( "Press UP to move eye up.\n" );
+    printf( "Press DOWN to move eye down.\n" );
+    printf( "Press SHIFT+UP to move closer.\n" );
+    printf( "Press SHIFT+DOWN to move further.\n" );
+    printf( "Press 'W' to toggle wireframe.\n" );
+    printf( "Press 'T' to toggle texture mapping.\n" );
+    printf( "Press 'L' to toggle per-pixel lighting.\n" );
+    printf( "Press 'M' to toggle the stencil reflection.\n" );
+    printf( "Press 'X' to toggle axes.\n" );
+    printf( "Press 'R' to reset to initial view.\n" );
+    printf( "Press 'C' to capture a frame.\n" );
+    printf( "Press 'V' to start or stop capturing every frame.\n" );
+    printf( "Press 'P' to render a poster of the view.\n" );
+    printf( "Press 'Q' to quit.\n\n" );
+
+
+// Enter GLUT event loop.
+
+    glutMainLoop();
+    return 0;
+}
+
+
+
+
+//============================================================================
+//============================================================================
+// Functions below are for modeling the 3D objects.
+//============================================================================
+//============================================================================
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Draw the x, y, z axes. Each is drawn with the input length.
+// The x-axis is red, y-axis green, and z-axis blue.
+// The axes are drawn after the scene, and win ties in depth with it, so
+// they are hidden where they would have been if drawn before it.
+/////////////////////////////////////////////////////////////////////////////
+
+void DrawAxes( double length )
+{
+    glPushAttrib( GL_ALL_ATTRIB_BITS );
+    glDepthFunc( GL_LEQUAL );
+    glDisable( GL_LIGHTING );
+    glDisable( GL_TEXTURE_2D );
+    glLineWidth( 3.0 );
+    // The last axis drawn wins where they meet, so the x-axis is drawn last.
+    glBegin( GL_LINES );
+        // z-axis.
+        glColor3f( 0.0, 0.0, 1.0 );
+        glVertex3d( 0.0, 0.0, 0.0 );
+        glVertex3d( 0.0, 0.0, length );
+        // y-axis.
+        glColor3f( 0.0, 1.0, 0.0 );
+        glVertex3d( 0.0, 0.0, 0.0 );
+        glVertex3d( 0.0, length, 0.0 );
+        // x-axis.
+        glColor3f( 1.0, 0.0, 0.0 );
+        glVertex3d( 0.0, 0.0, 0.0 );
+        glVertex3d( length, 0.0, 0.0 );
+    glEnd();
+    glPopAttrib();
+}
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Bind the texture object to GL_TEXTURE_2D, unless it is bound already,
+// and count the binding.
+/////////////////////////////////////////////////////////////////////////////
+
+void BindTexture( GLuint texObj )
+{
+    if ( texObj == boundTexObj ) return;
+    glBindTexture( GL_TEXTURE_2D, texObj );
+    boundTexObj = texObj;
+    numTextureBinds++;
+}
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns the index of the texture object in the texture atlas, or -1 if
+// the atlas is not in use or does not hold the texture.
+/////////////////////////////////////////////////////////////////////////////
+
+int FindAtlasTexture( GLuint texObj )
+{
+    if ( atlasTexObj == 0 ) return -1;
+    for ( int i = 0; i < numAtlasTextures; i++ )
+        if ( atlasTexObjs[i] == texObj ) return i;
+    return -1;
+}
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Texture the following draws with the input texture object, or with no
+// texture if it is 0. If the texture is in the texture atlas, the atlas
+// is bound instead, and the texture matrix maps texture coordinates in
+// [0, 1] into the texture's region of the atlas. Objects with no texture
+// use a white texel of the atlas. With per-pixel lighting, the texture
+// coordinates repeat within the region, so that a texture in the atlas
+// can tile a single quad.
+/////////////////////////////////////////////////////////////////////////////
+
+void UseSceneTexture( GLuint texObj )
+{
+    glMatrixMode( GL_TEXTURE );
+    glLoadIdentity();
+
+    int i = FindAtlasTexture( texObj );
+
+    if ( i >= 0 )
+    {
+        const AtlasRegion &region = atlasRegions[i];
+        BindTexture( atlasTexObj );
+        if ( texObj == 0 )
+        {
+            // Any texture coordinates give the center of the white texel.
+            glTranslatef( 0.5f * ( region.s0 + region.s1 ), 0.5f * ( region.t0 + region.t1 ), 0.0f );
+            glScalef( 0.0f, 0.0f, 1.0f );
+        }
+        else
+        {
+            glTranslatef( region.s0, region.t0, 0.0f );
+            glScalef( region.s1 - region.s0, region.t1 - region.t0, 1.0f );
+        }
+    }
+    else BindTexture( texObj );
+
+    glMatrixMode( GL_MODELVIEW );
+
+    // Without a bound texture, the fixed-function pipeline does not texture,
+    // while the program would sample black.
+    SetPixelLightingTexture( hasTexture && ( i >= 0 || texObj != 0 ), i >= 0 );
+}
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns the texture object that UseSceneTexture() binds for the input
+// texture object: the texture atlas if it holds the texture, otherwise
+// the texture itself.
+/////////////////////////////////////////////////////////////////////////////
+
+GLuint GetSceneTextureBinding( GLuint texObj )
+{
+    return ( FindAtlasTexture( texObj ) >= 0 ) ? atlasTexObj : texObj;
+}
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Generate the vertices of the uSteps x vSteps smaller quads of the input
+// quad for SubdivideAndDrawQuad(), four per small quad, into vertices.
+// If wrapTexCoords is true, the texture coordinates of each small quad
+// are wrapped into [0, 1], for the texture atlas.
+/////////////////////////////////////////////////////////////////////////////
+
+void GenerateSubdividedQuad( int uSteps, int vSteps, bool wrapTexCoords,
+                             const float tc0[3], const float v0[3], const float tc1[3], const float v1[3],
+                             const float tc2[3], const float v2[3], const float tc3[3], const float v3[3],
+                             std::vector<MeshVertex> &vertices )
+{
+    vertices.clear();
+
+    for ( int u = 0; u < uSteps; u++ )
+    {
+        float uu = (float) u / uSteps;
+        float uu1 = (float) (u + 1) / uSteps;
+        float Atc[3], Btc[3], Ctc[3], Dtc[3];
+        float Av[3], Bv[3], Cv[3], Dv[3];
+
+        for ( int i = 0; i < 3; i++ )
+        {
+            Atc[i] = tc0[i] + uu  * ( tc1[i] - tc0[i] );
+            Btc[i] = tc3[i] + uu  * ( tc2[i] - tc3[i] );
+            Ctc[i] = tc0[i] + uu1 * ( tc1[i] - tc0[i] );
+            Dtc[i] = tc3[i] + uu1 * ( tc2[i] - tc3[i] );
+            Av[i] = v0[i] + uu  * ( v1[i] - v0[i] );
+            Bv[i] = v3[i] + uu  * ( v2[i] - v3[i] );
+            Cv[i] = v0[i] + uu1 * ( v1[i] - v0[i] );
+            Dv[i] = v3[i] + uu1 * ( v2[i] - v3[i] );
+        }
+
+        for ( int v = 0; v < vSteps; v++ )
+        {
+            float vv = (float) v / vSteps;
+            float vv1 = (float) (v + 1) / vSteps;
+            float Etc[3], Ftc[3], Gtc[3], Htc[3];
+            float Ev[3], Fv[3], Gv[3], Hv[3];
+
+            for ( int i = 0; i < 3; i++ )
+            {
+                Etc[i] = Atc[i] + vv  * ( Btc[i] - Atc[i] );
+                Ftc[i] = Ctc[i] + vv  * ( Dtc[i] - Ctc[i] );
+                Gtc[i] = Atc[i] + vv1 * ( Btc[i] - Atc[i] );
+                Htc[i] = Ctc[i] + vv1 * ( Dtc[i] - Ctc[i] );
+                Ev[i] = Av[i] + vv  * ( Bv[i] - Av[i] );
+                Fv[i] = Cv[i] + vv  * ( Dv[i] - Cv[i] );
+                Gv[i] = Av[i] + vv1 * ( Bv[i] - Av[i] );
+                Hv[i] = Cv[i] + vv1 * ( Dv[i] - Cv[i] );
+            }
+
+            // With the texture atlas, the texture coordinates must be in
+            // [0, 1], so repeating textures are wrapped for each small quad.
+            // This requires that the small quads do not cross a multiple of 1.
+            if ( wrapTexCoords )
+            {
+                for ( int i = 0; i < 2; i++ )
+                {
+                    float d = floorf( fminf( fminf( Etc[i], Ftc[i] ), fminf( Gtc[i], Htc[i] ) ) + 1e-4f );
+                    Etc[i] -= d;  Ftc[i] -= d;  Gtc[i] -= d;  Htc[i] -= d;
+                }
+            }
+
+            const float *tcs[4] = { Etc, Ftc, Htc, Gtc };
+            const float *vs[4] = { Ev, Fv, Hv, Gv };
+            for ( int k = 0; k < 4; k++ )
+            {
+                MeshVertex vertex = { { tcs[k][0], tcs[k][1] }, { 0.0f, 0.0f, 0.0f }, { vs[k][0], vs[k][1], vs[k][2] } };
+                vertices.push_back( vertex );
+            }
+        }
+    }
+}
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Subdivide input quad into uSteps x vSteps smaller quads, and draw them.
+// The first vertex of the input quad has texture coordinates (s0, t0) and
+// vertex position (x0, y0, z0), and so on.
+//
+// The vertices of the input quad should be given in anti-clockwise order.
+//
+// The texture coordinates at the input vertices are bilinearly
+// interpolated to the newly created vertices.
+//
+// With retained meshes, the small quads are generated the first time the
+// quad is drawn, as an indexed grid mesh whose vertices are shared by the
+// small quads around them, kept in the mesh cache, and drawn from there
+// with a single call afterwards. Otherwise, they are generated and drawn
+// in immediate mode on every call.
+//
+// The subdivision is only needed for the vertex lighting of the
+// fixed-function pipeline, so with per-pixel lighting the quad is drawn
+// undivided.
+/////////////////////////////////////////////////////////////////////////////
+
+void SubdivideAndDrawQuad( int uSteps, int vSteps,
+                           float s0, float t0, float x0, float y0, float z0,
+                           float s1, float t1, float x1, float y1, float z1,
+                           float s2, float t2, float x2, float y2, float z2,
+                           float s3, float t3, float x3, float y3, float z3 )
+{
+    float tc0[3] = { s0, t0, 0.0 };  float v0[3] = { x0, y0, z0 };
+    float tc1[3] = { s1, t1, 0.0 };  float v1[3] = { x1, y1, z1 };
+    float tc2[3] = { s2, t2, 0.0 };  float v2[3] = { x2, y2, z2 };
+    float tc3[3] = { s3, t3, 0.0 };  float v3[3] = { x3, y3, z3 };
+    bool wrapTexCoords = ( atlasTexObj != 0 && !usePixelLighting );
+
+    // Per-pixel lighting needs no vertices inside a flat quad, and repeats
+    // the texture coordinates within the atlas itself.
+    if ( usePixelLighting ) uSteps = vSteps = 1;
+
+    static std::vector<MeshVertex> vertices;
+    Mesh *mesh = NULL;
+
+    if ( useRetainedMeshes )
+    {
+        const float params[] = { (float)uSteps, (float)vSteps, (float)wrapTexCoords,
+                                 s0, t0, x0, y0, z0,  s1, t1, x1, y1, z1,
+                                 s2, t2, x2, y2, z2,  s3, t3, x3, y3, z3 };
+        const int numParams = sizeof( params ) / sizeof( params[0] );
+
+        mesh = FindCachedMesh( params, numParams );
+        if ( mesh == NULL )
+        {
+            const float texCoords[4][2] = { { s0, t0 }, { s1, t1 }, { s2, t2 }, { s3, t3 } };
+            const float positions[4][3] = { { x0, y0, z0 }, { x1, y1, z1 }, { x2, y2, z2 }, { x3, y3, z3 } };
+            std::vector<unsigned int> indices;
+            GenerateGridMesh( uSteps, vSteps, texCoords, positions, wrapTexCoords, vertices, indices );
+            mesh = AddCachedMesh( params, numParams, vertices.data(), (int)vertices.size(), false,
+                                  indices.data(), (int)indices.size(), GL_TRIANGLES );
+        }
+    }
+
+    if ( mesh != NULL )
+    {
+        DrawMesh( mesh );
+        return;
+    }
+
+    GenerateSubdividedQuad( uSteps, vSteps, wrapTexCoords, tc0, v0, tc1, v1, tc2, v2, tc3, v3, vertices );
+
+    glBegin( GL_QUADS );
+    for ( size_t k = 0; k < vertices.size(); k++ )
+    {
+        glTexCoord2fv( vertices[k].texCoord );
+        glVertex3fv( vertices[k].position );
+    }
+    glEnd();
+
+    numImmediateVertices += vertices.size();
+}
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns the mesh that the generator function makes from the input
+// parameters, whose first parameter identifies the generator. The mesh is
+// drawn as GL_TRIANGLES with the generated indices, and the normals of the
+// vertices if hasNormals is true.
+//
+// With retained meshes, the mesh is generated the first time it is asked
+// for and kept in the mesh cache. Otherwise, or if out of memory, returns
+// NULL.
+/////////////////////////////////////////////////////////////////////////////
+
+typedef void (*MeshGenerator)( const float *params, std::vector<MeshVertex> &vertices,
+                               std::vector<unsigned int> &indices );
+
+Mesh *GetGeneratedMesh( const float *params, int numParams, bool hasNormals, MeshGenerator generate )
+{
+    if ( !useRetainedMeshes ) return NULL;
+
+    Mesh *mesh = FindCachedMesh( params, numParams );
+    if ( mesh == NULL )
+    {
+        std::vector<MeshVertex> vertices;
+        std::vector<unsigned int> indices;
+        generate( params, vertices, indices );
+        mesh = AddCachedMesh( params, numParams, vertices.data(), (int)vertices.size(), hasNormals,
+                              indices.data(), (int)indices.size(), GL_TRIANGLES );
+    }
+    return mesh;
+}
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Draw the mesh that the generator function makes from the input
+// parameters, as returned by GetGeneratedMesh(). Without retained meshes,
+// the mesh is generated and drawn in immediate mode on every call.
+/////////////////////////////////////////////////////////////////////////////
+
+void DrawGeneratedMesh( const float *params, int numParams, bool hasNormals, MeshGenerator generate )
+{
+    Mesh *mesh = GetGeneratedMesh( params, numParams, hasNormals, generate );
+    if ( mesh != NULL )
+    {
+        DrawMesh( mesh );
+        return;
+    }
+
+    static std::vector<MeshVertex> vertices;
+    static std::vector<unsigned int> indices;
+    generate( params, vertices, indices );
+
+    glBegin( GL_TRIANGLES );
+    for ( size_t k = 0; k < indices.size(); k++ )
+    {
+        const MeshVertex &vertex = vertices[indices[k]];
+        if ( hasNormals ) glNormal3fv( vertex.normal );
+        glTexCoord2fv( vertex.texCoord );
+        glVertex3fv( vertex.position );
+    }
+    glEnd();
+
+    numImmediateVertices += indices.size();
+}
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Draw numInstances instances of the mesh of DrawGeneratedMesh(), each
+// transformed by its 4x4 matrix in matrices, multiplied onto the current
+// modelview matrix. The instances of a retained mesh are drawn with one
+// instanced call, lit by the per-pixel lighting or by the instanced
+// lighting program.
+/////////////////////////////////////////////////////////////////////////////
+
+void DrawGeneratedMeshInstances( const float *params, int numParams, bool hasNormals, MeshGenerator generate,
+                                 const float *matrices, int numInstances )
+{
+    Mesh *mesh = GetGeneratedMesh( params, numParams, hasNormals, generate );
+    if ( mesh == NULL )
+    {
+        glMatrixMode( GL_MODELVIEW );
+        for ( int i = 0; i < numInstances; i++ )
+        {
+            glPushMatrix();
+            glMultMatrixf( matrices + 16 * i );
+            DrawGeneratedMesh( params, numParams, hasNormals, generate );
+            glPopMatrix();
+        }
+        return;
+    }
+
+    if ( !usePixelLighting ) BeginInstancedLighting();
+    DrawMeshInstanced( mesh, matrices, numInstances );
+    if ( !usePixelLighting ) EndInstancedLighting();
+}
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Draw a sphere of the given radius, centered at the origin with its poles
+// on the z axis, made of numSlices x numStacks cells with the texture
+// coordinates of the given mapping. See GenerateSphereMesh().
+/////////////////////////////////////////////////////////////////////////////
+
+void GenerateSphereFromParams( const float *params, std::vector<MeshVertex> &vertices,
+                               std::vector<unsigned int> &indices )
+{
+    GenerateSphereMesh( (int)params[1], (int)params[2], params[3], (SphereTexCoords)(int)params[4],
+                        params[5] != 0.0f, vertices, indices );
+}
+
+void DrawSphereMesh( int numSlices, int numStacks, float radius, SphereTexCoords texCoords )
+{
+    bool wrapTexCoords = ( atlasTexObj != 0 && !usePixelLighting && texCoords == SPHERE_TEXCOORDS_PLANAR );
+    const float params[] = { SPHERE_MESH_ID, (float)numSlices, (float)numStacks, radius,
+                             (float)texCoords, (float)wrapTexCoords };
+    DrawGeneratedMesh( params, sizeof( params ) / sizeof( params[0] ), true, GenerateSphereFromParams );
+}
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Draw the teapot of glutSolidTeapot(size), with teapotSubdivisions x
+// teapotSubdivisions cells per Bezier patch. See GenerateTeapotMesh().
+/////////////////////////////////////////////////////////////////////////////
+
+void GenerateTeapotFromParams( const float *params, std::vector<MeshVertex> &vertices,
+                               std::vector<unsigned int> &indices )
+{
+    GenerateTeapotMesh( (int)params[1], params[2], vertices, indices );
+}
+
+void DrawTeapotMesh( float size )
+{
+    const float params[] = { TEAPOT_MESH_ID, (float)teapotSubdivisions, size };
+    DrawGeneratedMesh( params, sizeof( params ) / sizeof( params[0] ), true, GenerateTeapotFromParams );
+}
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// The unit cube of glutSolidCube(1.0), and the cuboid from -1 to 1 along
+// each axis, which has no normals of its own. See GenerateCubeMesh().
+/////////////////////////////////////////////////////////////////////////////
+
+void GenerateCubeFromParams( const float *, std::vector<MeshVertex> &vertices,
+                             std::vector<unsigned int> &indices )
+{
+    GenerateCubeMesh( 1.0f, vertices, indices );
+}
+
+void GenerateCuboidFromParams( const float *, std::vector<MeshVertex> &vertices,
+                               std::vector<unsigned int> &indices )
+{
+    // Texture coordinates and positions of the corners of each face.
+    static const float cuboidFaces[6][4][5] = {
+        { { 0, 0,  -1, -1,  1 }, { 1, 0,   1, -1,  1 }, { 1, 1,   1,  1,  1 }, { 0, 1,  -1,  1,  1 } },
+        { { 0, 0,  -1, -1, -1 }, { 0, 1,  -1,  1, -1 }, { 1, 1,   1,  1, -1 }, { 1, 0,   1, -1, -1 } },
+        { { 0, 0,  -1, -1,  1 }, { 0, 1,  -1,  1,  1 }, { 1, 1,  -1,  1, -1 }, { 1, 0,  -1, -1, -1 } },
+        { { 0, 0,   1, -1,  1 }, { 0, 1,   1, -1, -1 }, { 1, 1,   1,  1, -1 }, { 1, 0,   1,  1,  1 } },
+        { { 0, 0,  -1,  1,  1 }, { 0, 1,   1,  1,  1 }, { 1, 1,   1,  1, -1 }, { 1, 0,  -1,  1, -1 } },
+        { { 0, 0,  -1, -1,  1 }, { 0, 1,  -1, -1, -1 }, { 1, 1,   1, -1, -1 }, { 1, 0,   1, -1,  1 } }
+    };
+
+    vertices.clear();
+    indices.clear();
+    for ( int f = 0; f < 6; f++ )
+    {
+        const unsigned int first = (unsigned int)vertices.size();
+        for ( int c = 0; c < 4; c++ )
+        {
+            MeshVertex vertex;
+            memcpy( vertex.texCoord, &cuboidFaces[f][c][0], sizeof( vertex.texCoord ) );
+            memcpy( vertex.position, &cuboidFaces[f][c][2], sizeof( vertex.position ) );
+            vertices.push_back( vertex );
+        }
+        // Split along the same diagonal as Mesa splits GL_QUADS.
+        const unsigned int triangles[6] = { first, first + 1, first + 3, first + 1, first + 2, first + 3 };
+        indices.insert( indices.end(), triangles, triangles + 6 );
+    }
+}
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Submit a quad, sphere, teapot, cube or cuboid to the draw queue, with
+// the current draw state. When the queue is flushed, it is drawn by the
+// matching draw function below, which takes the submitted parameters.
+// The cubes, and the cuboids, that are drawn one after the other with the
+// same draw state are drawn with a single instanced call.
+//
+// Parts whose bounding boxes lie outside the culling volume are not
+// submitted. See KeepScenePart().
+/////////////////////////////////////////////////////////////////////////////
+
+// Returns true if the part of the scene with the input bounding box, in
+// the coordinates of the current modelview matrix, is to be submitted,
+// i.e. if it is not culled. While the scene is recorded, the bounds of
+// the part in world space are added to scenePartBoxes instead.
+bool KeepScenePart( const float boxMin[3], const float boxMax[3] )
+{
+    if ( !recordingScene ) return !IsBoxCulled( boxMin, boxMax );
+
+    float modelview[16], box[6];
+    glGetFloatv( GL_MODELVIEW_MATRIX, modelview );
+    GetTransformedBox( modelview, boxMin, boxMax, box );
+    scenePartBoxes.insert( scenePartBoxes.end(), box, box + 6 );
+    return true;
+}
+
+void DrawQuadFromParams( const float *params )
+{
+    SubdivideAndDrawQuad( (int)params[0], (int)params[1],
+                          params[2], params[3], params[4], params[5], params[6],
+                          params[7], params[8], params[9], params[10], params[11],
+                          params[12], params[13], params[14], params[15], params[16],
+                          params[17], params[18], params[19], params[20], params[21] );
+}
+
+void SubmitQuad( int uSteps, int vSteps,
+                 float s0, float t0, float x0, float y0, float z0,
+                 float s1, float t1, float x1, float y1, float z1,
+                 float s2, float t2, float x2, float y2, float z2,
+                 float s3, float t3, float x3, float y3, float z3 )
+{
+    const float boxMin[3] = { fminf( fminf( x0, x1 ), fminf( x2, x3 ) ), fminf( fminf( y0, y1 ), fminf( y2, y3 ) ),
+                              fminf( fminf( z0, z1 ), fminf( z2, z3 ) ) };
+    const float boxMax[3] = { fmaxf( fmaxf( x0, x1 ), fmaxf( x2, x3 ) ), fmaxf( fmaxf( y0, y1 ), fmaxf( y2, y3 ) ),
+                              fmaxf( fmaxf( z0, z1 ), fmaxf( z2, z3 ) ) };
+    if ( !KeepScenePart( boxMin, boxMax ) ) return;
+
+    const float params[] = { (float)uSteps, (float)vSteps,
+                             s0, t0, x0, y0, z0,  s1, t1, x1, y1, z1,
+                             s2, t2, x2, y2, z2,  s3, t3, x3, y3, z3 };
+    SubmitDraw( DrawQuadFromParams, params, sizeof( params ) / sizeof( params[0] ) );
+}
+
+// Submit the quad as numTilesU x numTilesV tiles, each of uSteps / numTilesU
+// x vSteps / numTilesV cells, so that each tile is culled on its own.
+// The cells are the same as those of the whole quad. Without culling, the
+// quad is submitted whole, except into the recorded scene.
+void SubmitTiledQuad( int numTilesU, int numTilesV, int uSteps, int vSteps,
+                      float s0, float t0, float x0, float y0, float z0,
+                      float s1, float t1, float x1, float y1, float z1,
+                      float s2, float t2, float x2, float y2, float z2,
+                      float s3, float t3, float x3, float y3, float z3 )
+{
+    // Texture coordinates and position of each corner.
+    const float corners[4][5] = { { s0, t0, x0, y0, z0 }, { s1, t1, x1, y1, z1 },
+                                  { s2, t2, x2, y2, z2 }, { s3, t3, x3, y3, z3 } };
+
+    if ( !useCulling && !recordingScene ) numTilesU = numTilesV = 1;
+
+    for ( int i = 0; i < numTilesU; i++ )
+    {
+        for ( int j = 0; j < numTilesV; j++ )
+        {
+            // Interpolate the tile's corners from the quad's, as the
+            // vertices of the grid are interpolated.
+            float tile[4][5];
+            for ( int c = 0; c < 4; c++ )
+            {
+                float uu = (float)( ( c == 1 || c == 2 ) ? i + 1 : i ) / numTilesU;
+                float vv = (float)( ( c >= 2 ) ? j + 1 : j ) / numTilesV;
+                for ( int k = 0; k < 5; k++ )
+                {
+                    float a = corners[0][k] + uu * ( corners[1][k] - corners[0][k] );
+                    float b = corners[3][k] + uu * ( corners[2][k] - corners[3][k] );
+                    tile[c][k] = a + vv * ( b - a );
+                }
+            }
+            SubmitQuad( uSteps / numTilesU, vSteps / numTilesV,
+                        tile[0][0], tile[0][1], tile[0][2], tile[0][3], tile[0][4],
+                        tile[1][0], tile[1][1], tile[1][2], tile[1][3], tile[1][4],
+                        tile[2][0], tile[2][1], tile[2][2], tile[2][3], tile[2][4],
+                        tile[3][0], tile[3][1], tile[3][2], tile[3][3], tile[3][4] );
+        }
+    }
+}
+
+void DrawSphereFromParams( const float *params )
+{
+    DrawSphereMesh( (int)params[0], (int)params[1], params[2], (SphereTexCoords)(int)params[3] );
+}
+
+void SubmitSphereMesh( int numSlices, int numStacks, float radius, SphereTexCoords texCoords )
+{
+    const float boxMin[3] = { -radius, -radius, -radius };
+    const float boxMax[3] = { radius, radius, radius };
+    if ( !KeepScenePart( boxMin, boxMax ) ) return;
+
+    const float params[] = { (float)numSlices, (float)numStacks, radius, (float)texCoords };
+    SubmitDraw( DrawSphereFromParams, params, sizeof( params ) / sizeof( params[0] ) );
+}
+
+void DrawTeapotFromParams( const float *params )
+{
+    DrawTeapotMesh( params[0] );
+}
+
+void SubmitTeapotMesh( float size )
+{
+    float boxMin[3], boxMax[3];
+    GetTeapotBounds( size, boxMin, boxMax );
+    if ( !KeepScenePart( boxMin, boxMax ) ) return;
+
+    SubmitDraw( DrawTeapotFromParams, &size, 1 );
+}
+
+const float cubeMeshParams[] = { CUBE_MESH_ID };
+const float cuboidMeshParams[] = { CUBOID_MESH_ID };
+
+void DrawCubeFromParams( const float * )
+{
+    DrawGeneratedMesh( cubeMeshParams, 1, true, GenerateCubeFromParams );
+}
+
+void DrawCubesInstanced( const float *, const float *modelviews, int numInstances )
+{
+    DrawGeneratedMeshInstances( cubeMeshParams, 1, true, GenerateCubeFromParams, modelviews, numInstances );
+}
+
+void SubmitCube( void )
+{
+    const float boxMin[3] = { -0.5f, -0.5f, -0.5f };
+    const float boxMax[3] = { 0.5f, 0.5f, 0.5f };
+    if ( !KeepScenePart( boxMin, boxMax ) ) return;
+
+    SubmitInstancedDraw( DrawCubeFromParams, DrawCubesInstanced, NULL, 0 );
+}
+
+void DrawCuboidFromParams( const float * )
+{
+    DrawGeneratedMesh( cuboidMeshParams, 1, false, GenerateCuboidFromParams );
+}
+
+void DrawCuboidsInstanced( const float *, const float *modelviews, int numInstances )
+{
+    DrawGeneratedMeshInstances( cuboidMeshParams, 1, false, GenerateCuboidFromParams, modelviews, numInstances );
+}
+
+void SubmitCuboid( void )
+{
+    const float boxMin[3] = { -1.0f, -1.0f, -1.0f };
+    const float boxMax[3] = { 1.0f, 1.0f, 1.0f };
+    if ( !KeepScenePart( boxMin, boxMax ) ) return;
+
+    SubmitInstancedDraw( DrawCuboidFromParams, DrawCuboidsInstanced, NULL, 0 );
+}
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Draw the room.
+// The walls, ceiling and floor are all texture-mapped, and made of tiles
+// that are culled one by one.
+/////////////////////////////////////////////////////////////////////////////
+
+void DrawRoom( void )
+{
+    const float ROOM_HALF_WIDTH = ROOM_WIDTH / 2.0f;
+
+// Ceiling.
+
+    const Material material1 = { { 0.6, 0.6, 0.6, 1.0 }, { 0.6, 0.6, 0.6, 1.0 },
+                                 { 0.2, 0.2, 0.2, 1.0 }, 8.0 };
+    SetDrawMaterial( &material1 );
+
+    SetDrawTexture( ceilingTexObj );
+    SetDrawNormal( 0.0, 0.0, -1.0 ); // Normal vector.
+    SubmitTiledQuad( ROOM_TILES, ROOM_TILES, 24, 24, 0.0, 0.0, ROOM_HALF_WIDTH, ROOM_HALF_WIDTH, ROOM_HEIGHT,
+                                                     ROOM_WIDTH, 0.0, ROOM_HALF_WIDTH, -ROOM_HALF_WIDTH, ROOM_HEIGHT,
+                                                     ROOM_WIDTH, ROOM_WIDTH, -ROOM_HALF_WIDTH, -ROOM_HALF_WIDTH, ROOM_HEIGHT,
+                                                     0.0, ROOM_WIDTH, -ROOM_HALF_WIDTH, ROOM_HALF_WIDTH, ROOM_HEIGHT );
+
+// Walls.
+
+    SetDrawTexture( brickTexObj );
+
+    // In +y direction.
+    SetDrawNormal( 0.0, -1.0, 0.0 ); // Normal vector.
+    SubmitTiledQuad( ROOM_TILES, ROOM_TILES, 24, 16, 0.0, 0.0, -ROOM_HALF_WIDTH, ROOM_HALF_WIDTH, 0.0,
+                                                     ROOM_WIDTH/2, 0.0, ROOM_HALF_WIDTH, ROOM_HALF_WIDTH, 0.0,
+                                                     ROOM_WIDTH/2, ROOM_HEIGHT/2, ROOM_HALF_WIDTH, ROOM_HALF_WIDTH, ROOM_HEIGHT,
+                                                     0.0, ROOM_HEIGHT/2, -ROOM_HALF_WIDTH, ROOM_HALF_WIDTH, ROOM_HEIGHT );
+    // In -y direction.
+    SetDrawNormal( 0.0, 1.0, 0.0 ); // Normal vector.
+    SubmitTiledQuad( ROOM_TILES, ROOM_TILES, 24, 16, 0.0, 0.0, ROOM_HALF_WIDTH, -ROOM_HALF_WIDTH, 0.0,
+                                                     ROOM_WIDTH/2, 0.0, -ROOM_HALF_WIDTH, -ROOM_HALF_WIDTH, 0.0,
+                                                     ROOM_WIDTH/2, ROOM_HEIGHT/2, -ROOM_HALF_WIDTH, -ROOM_HALF_WIDTH, ROOM_HEIGHT,
+                                                     0.0, ROOM_HEIGHT/2, ROOM_HALF_WIDTH, -ROOM_HALF_WIDTH, ROOM_HEIGHT );
+    // In +x direction.
+    SetDrawNormal( -1.0, 0.0, 0.0 ); // Normal vector.
+    SubmitTiledQuad( ROOM_TILES, ROOM_TILES, 24, 16, 0.0, 0.0, ROOM_HALF_WIDTH, ROOM_HALF_WIDTH, 0.0,
+                                                     ROOM_WIDTH/2, 0.0, ROOM_HALF_WIDTH, -ROOM_HALF_WIDTH, 0.0,
+                                                     ROOM_WIDTH/2, ROOM_HEIGHT/2, ROOM_HALF_WIDTH, -ROOM_HALF_WIDTH, ROOM_HEIGHT,
+                                                     0.0, ROOM_HEIGHT/2, ROOM_HALF_WIDTH, ROOM_HALF_WIDTH, ROOM_HEIGHT );
+    // In -x direction.
+    SetDrawNormal( 1.0, 0.0, 0.0 ); // Normal vector.
+    SubmitTiledQuad( ROOM_TILES, ROOM_TILES, 24, 16, 0.0, 0.0, -ROOM_HALF_WIDTH, -ROOM_HALF_WIDTH, 0.0,
+                                                     ROOM_WIDTH/2, 0.0, -ROOM_HALF_WIDTH, ROOM_HALF_WIDTH, 0.0,
+                                                     ROOM_WIDTH/2, ROOM_HEIGHT/2, -ROOM_HALF_WIDTH, ROOM_HALF_WIDTH, ROOM_HEIGHT,
+                                                     0.0, ROOM_HEIGHT/2, -ROOM_HALF_WIDTH, -ROOM_HALF_WIDTH, ROOM_HEIGHT );
+
+// Floor.
+
+    const Material material2 = { { 0.5, 0.5, 0.5, 1.0 }, { 0.5, 0.5, 0.5, 1.0 },
+                                 { 0.8, 0.8, 0.8, 1.0 }, 128.0 };
+    SetDrawMaterial( &material2 );
+
+    SetDrawTexture( checkerTexObj );
+    SetDrawNormal( 0.0, 0.0, 1.0 ); // Normal vector.
+    SubmitTiledQuad( ROOM_TILES, ROOM_TILES, 24, 24, 0.0, 0.0, ROOM_HALF_WIDTH, -ROOM_HALF_WIDTH, 0.0,
+                                                     ROOM_WIDTH, 0.0, ROOM_HALF_WIDTH, ROOM_HALF_WIDTH, 0.0,
+                                                     ROOM_WIDTH, ROOM_WIDTH, -ROOM_HALF_WIDTH, ROOM_HALF_WIDTH, 0.0,
+                                                     0.0, ROOM_WIDTH, -ROOM_HALF_WIDTH, -ROOM_HALF_WIDTH, 0.0 );
+}
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Draw a texture-mapped teapot.
+/////////////////////////////////////////////////////////////////////////////
+
+void DrawTeapot( void )
+{
+    double size = 0.45;
+
+    const Material material = { { 0.8, 0.8, 0.8, 1.0 }, { 0.8, 0.8, 0.8, 1.0 },
+                                { 1.0, 1.0, 1.0, 1.0 }, 128.0 };
+    SetDrawMaterial( &material );
+
+    SetDrawTexture( spotsTexObj );
+
+    SetDrawCullFace( false );   // Disable back-face culling, as the teapot has holes.
+
+    glPushMatrix();
+    glTranslated( -0.3, -0.5, size * 0.75 + TABLETOP_Z );
+    glRotated( 90.0, 0.0, 0.0, 1.0 );
+    glRotated( 90.0, 1.0, 0.0, 0.0 );
+    SubmitTeapotMesh( size ); // Also has the texture coordinates of glutSolidTeapot().
+    glPopMatrix();
+
+    SetDrawCullFace( true );    // Enable back-face culling.
+}
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Draw a non-texture-mapped sphere.
+/////////////////////////////////////////////////////////////////////////////
+
+void DrawSphere( void )
+{
+    double radius = 0.35;
+
+    const Material material = { { 0.7, 0.5, 0.2, 1.0 }, { 0.7, 0.5, 0.2, 1.0 },
+                                { 1.0, 1.0, 1.0, 1.0 }, 128.0 };
+    SetDrawMaterial( &material );
+
+    SetDrawTexture( 0 );  // Texture object ID == 0 means no texture mapping.
+
+    glPushMatrix();
+    glTranslated( 0.3, 0.5, radius + TABLETOP_Z );
+    SubmitSphereMesh( SPHERE_SLICES, SPHERE_STACKS, radius, SPHERE_TEXCOORDS_LONG_LAT );
+    glPopMatrix();
+}
+
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Draw the table.
+/////////////////////////////////////////////////////////////////////////////
+
+void DrawTable( void )
+{
+// Sides.
+
+    const Material material2 = { { 0.2, 0.3, 0.4, 1.0 }, { 0.2, 0.3, 0.4, 1.0 },
+                                 { 0.6, 0.8, 1.0, 1.0 }, 128.0 };
+    SetDrawMaterial( &material2 );
+
+    SetDrawTexture( 0 ); // Texture object ID == 0 means no texture mapping.
+
+    // In +y direction.
+    SetDrawNormal( 0.0, 1.0, 0.0 ); // Normal vector.
+    SubmitQuad( 24, 2,  0.0, 0.0, TABLETOP_X2, TABLETOP_Y2, TABLETOP_Z - TABLE_THICKNESS,
+                        1.0, 0.0, TABLETOP_X1, TABLETOP_Y2, TABLETOP_Z - TABLE_THICKNESS,
+                        1.0, 1.0, TABLETOP_X1, TABLETOP_Y2, TABLETOP_Z,
+                        0.0, 1.0, TABLETOP_X2, TABLETOP_Y2, TABLETOP_Z );
+    // In -y direction.
+    SetDrawNormal( 0.0, -1.0, 0.0 ); // Normal vector.
+    SubmitQuad( 24, 2,  0.0, 0.0, TABLETOP_X1, TABLETOP_Y1, TABLETOP_Z - TABLE_THICKNESS,
+                        1.0, 0.0, TABLETOP_X2, TABLETOP_Y1, TABLETOP_Z - TABLE_THICKNESS,
+                        1.0, 1.0, TABLETOP_X2, TABLETOP_Y1, TABLETOP_Z,
+                        0.0, 1.0, TABLETOP_X1, TABLETOP_Y1, TABLETOP_Z );
+    // In +x direction.
+    SetDrawNormal( 1.0, 0.0, 0.0 ); // Normal vector.
+    SubmitQuad( 24, 2,  0.0, 0.0, TABLETOP_X2, TABLETOP_Y1, TABLETOP_Z - TABLE_THICKNESS,
+                        1.0, 0.0, TABLETOP_X2, TABLETOP_Y2, TABLETOP_Z - TABLE_THICKNESS,
+                        1.0, 1.0, TABLETOP_X2, TABLETOP_Y2, TABLETOP_Z,
+                        0.0, 1.0, TABLETOP_X2, TABLETOP_Y1, TABLETOP_Z );
+    // In -x direction.
+    SetDrawNormal( -1.0, 0.0, 0.0 ); // Normal vector.
+    SubmitQuad( 24, 2,  0.0, 0.0, TABLETOP_X1, TABLETOP_Y2, TABLETOP_Z - TABLE_THICKNESS,
+                        1.0, 0.0, TABLETOP_X1, TABLETOP_Y1, TABLETOP_Z - TABLE_THICKNESS,
+                        1.0, 1.0, TABLETOP_X1, TABLETOP_Y1, TABLETOP_Z,
+                        0.0, 1.0, TABLETOP_X1, TABLETOP_Y2, TABLETOP_Z );
+
+// Bottom.
+
+    SetDrawNormal( 0.0, 0.0, -1.0 ); // Normal vector.
+    SubmitQuad( 24, 24, 0.0, 0.0, TABLETOP_X1, TABLETOP_Y1, TABLETOP_Z - TABLE_THICKNESS,
+                        1.0, 0.0, TABLETOP_X1, TABLETOP_Y2, TABLETOP_Z - TABLE_THICKNESS,
+                        1.0, 1.0, TABLETOP_X2, TABLETOP_Y2, TABLETOP_Z - TABLE_THICKNESS,
+                        0.0, 1.0, TABLETOP_X2, TABLETOP_Y1, TABLETOP_Z - TABLE_THICKNESS );
+
+// Legs.
+
+    const Material material3 = { { 0.4, 0.4, 0.4, 1.0 }, { 0.4, 0.4, 0.4, 1.0 },
+                                 { 0.8, 0.8, 0.8, 1.0 }, 64.0 };
+    SetDrawMaterial( &material3 );
+
+    glPushMatrix();
+    glTranslated( TABLETOP_X1 + TABLE_THICKNESS, TABLETOP_Y1 + TABLE_THICKNESS, 0.0 );
+    glScaled( TABLE_THICKNESS, TABLE_THICKNESS, TABLETOP_Z - TABLE_THICKNESS );
+    glTranslated( 0.0, 0.0, 0.5 );
+    SubmitCube();
+    glPopMatrix();
+
+    glPushMatrix();
+    glTranslated( TABLETOP_X2 - TABLE_THICKNESS, TABLETOP_Y1 + TABLE_THICKNESS, 0.0 );
+    glScaled( TABLE_THICKNESS, TABLE_THICKNESS, TABLETOP_Z - TABLE_THICKNESS );
+    glTranslated( 0.0, 0.0, 0.5 );
+    SubmitCube();
+    glPopMatrix();
+
+    glPushMatrix();
+    glTranslated( TABLETOP_X2 - TABLE_THICKNESS, TABLETOP_Y2 - TABLE_THICKNESS, 0.0 );
+    glScaled( TABLE_THICKNESS, TABLE_THICKNESS, TABLETOP_Z - TABLE_THICKNESS );
+    glTranslated( 0.0, 0.0, 0.5 );
+    SubmitCube();
+    glPopMatrix();
+
+    glPushMatrix();
+    glTranslated( TABLETOP_X1 + TABLE_THICKNESS, TABLETOP_Y2 - TABLE_THICKNESS, 0.0 );
+    glScaled( TABLE_THICKNESS, TABLE_THICKNESS, TABLETOP_Z - TABLE_THICKNESS );
+    glTranslated( 0.0, 0.0, 0.5 );
+    SubmitCube();
+    glPopMatrix();
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Draw the tabletop, textured with texObj, with the ambient and diffuse
+// terms of its material if diffuse is true, and with its specular term if
+// specular is true, so that the stencil mode can draw them apart.
+/////////////////////////////////////////////////////////////////////////////
+
+void DrawTabletop( GLuint texObj, bool diffuse, bool specular )
+{
+    Material material = { { 0.5, 0.7, 1.0, 1.0 }, { 0.5, 0.7, 1.0, 1.0 },
+                          { 0.8, 0.8, 0.8, 1.0 }, 128.0 };
+    for ( int i = 0; i < 3; i++ )
+    {
+        if ( !diffuse ) material.ambient[i] = material.diffuse[i] = 0.0f;
+        if ( !specular ) material.specular[i] = 0.0f;
+    }
+    SetDrawMaterial( &material );
+
+    SetDrawTexture( texObj );
+    SetDrawNormal( 0.0, 0.0, 1.0 );
+    SubmitQuad( 24, 24, 0.0, 0.0, TABLETOP_X1, TABLETOP_Y1, TABLETOP_Z,
+                      0.0, 1.0, TABLETOP_X2, TABLETOP_Y1, TABLETOP_Z,
+                      1.0, 1.0, TABLETOP_X2, TABLETOP_Y2, TABLETOP_Z,
+                      1.0, 0.0, TABLETOP_X1, TABLETOP_Y2, TABLETOP_Z );
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Draw the Transformer( Head and Body)
+/////////////////////////////////////////////////////////////////////////////
+void DrawTransformerHead( void )
+{
+    const Material material = { { 0.8, 0.8, 0.8, 1.0 }, { 0.8, 0.8, 0.8, 1.0 },
+                                { 1.0, 1.0, 1.0, 1.0 }, 128.0 };
+    SetDrawMaterial( &material );
+
+    SetDrawTexture( eyesTexObj );
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    glTranslated(TABLETOP_X1/2, TABLETOP_Y2/2 + TABLETOP_Y1/16,TABLETOP_Z + TABLETOP_Y2/16 + TABLETOP_Z/3 + TABLETOP_Z/6);
+    
+    // The sphere mesh is closed and faces outwards, so it is drawn with
+    // back-face culling and anti-clockwise front faces.
+    SubmitSphereMesh(HEAD_SLICES, HEAD_STACKS, TABLETOP_Y2/16, SPHERE_TEXCOORDS_PLANAR);
+    glPopMatrix();
+    
+    
+        
+    
+}
+ 
+
+void DrawTransformerBody( void )
+{
+
+    
+    const Material material = { { 0.9, 0.9, 0.9, 1.0 }, { 0.9, 0.9, 0.9, 1.0 },
+                                { 0.5, 0.5, 0.5, 1.0 }, 128.0 };
+    SetDrawMaterial( &material );
+
+    SetDrawTexture( autoBotTexObj );
+    
+    
+    
+    //Front of decepticon body
+    SetDrawNormal( 0.0, -1.0, 0.0 ); // Normal vector.
+    SubmitQuad( 24, 24,  1.0, 1.0, 2*TABLETOP_X1/3, TABLETOP_Y2/2, TABLETOP_Z + TABLETOP_Z/3 + TABLETOP_Z/6,
+                           0.0, 1.0, TABLETOP_X1/3, TABLETOP_Y2/2, TABLETOP_Z + TABLETOP_Z/3 + TABLETOP_Z/6,
+                           0.0, 0.0, TABLETOP_X1/3, TABLETOP_Y2/2, TABLETOP_Z + TABLETOP_Z/6,
+                           1.0, 0.0, 2*TABLETOP_X1/3, TABLETOP_Y2/2, TABLETOP_Z + TABLETOP_Z/6 );
+    
+    
+    
+    SetDrawTexture( eyesTexObj );
+    
+    //Back of decepticon body
+    SetDrawNormal( 0.0, -1.0, 0.0 ); // Normal vector.
+    SubmitQuad( 24, 24,  1.0, 0.0, 2*TABLETOP_X1/3, TABLETOP_Y2/2 + TABLETOP_Y1/8, TABLETOP_Z + TABLETOP_Z/3 + TABLETOP_Z/6,
+                              1.0, 1.0, 2*TABLETOP_X1/3, TABLETOP_Y2/2 + TABLETOP_Y1/8, TABLETOP_Z + TABLETOP_Z/6,
+                              0.0, 1.0, TABLETOP_X1/3, TABLETOP_Y2/2 + TABLETOP_Y1/8, TABLETOP_Z + TABLETOP_Z/6,
+                              0.0, 0.0, TABLETOP_X1/3, TABLETOP_Y2/2 + TABLETOP_Y1/8, TABLETOP_Z + TABLETOP_Z/3 + TABLETOP_Z/6);
+    
+    
+    //left sideof decepticon body
+    SetDrawNormal( 1.0, 0.0, 0.0 ); // Normal vector.
+    SubmitQuad( 24, 2,  1.0, 0.0, TABLETOP_X1/3, TABLETOP_Y2/2 + TABLETOP_Y1/8, TABLETOP_Z + TABLETOP_Z/6,
+                              1.0, 1.0, TABLETOP_X1/3, TABLETOP_Y2/2, TABLETOP_Z + TABLETOP_Z/6,
+                              0.0, 1.0, TABLETOP_X1/3, TABLETOP_Y2/2, TABLETOP_Z + TABLETOP_Z/3 + TABLETOP_Z/6,
+                              0.0, 0.0, TABLETOP_X1/3, TABLETOP_Y2/2 + TABLETOP_Y1/8, TABLETOP_Z + TABLETOP_Z/3 + TABLETOP_Z/6);
+    
+    //right of decepticon body
+    SetDrawNormal( 1.0, 0.0, 0.0 ); // Normal vector.
+    SubmitQuad( 24, 2,  1.0, 0.0, 2*TABLETOP_X1/3, TABLETOP_Y2/2 + TABLETOP_Y1/8, TABLETOP_Z + TABLETOP_Z/6,
+                              0.0, 0.0, 2*TABLETOP_X1/3, TABLETOP_Y2/2 + TABLETOP_Y1/8, TABLETOP_Z + TABLETOP_Z/3 + TABLETOP_Z/6,
+                              0.0, 1.0, 2*TABLETOP_X1/3, TABLETOP_Y2/2, TABLETOP_Z + TABLETOP_Z/3 + TABLETOP_Z/6,
+                              1.0, 1.0, 2*TABLETOP_X1/3, TABLETOP_Y2/2, TABLETOP_Z + TABLETOP_Z/6);
+
+    //bottom of decepticon body
+    SetDrawNormal( 0.0, 0.0, 1.0 ); // Normal vector.
+    SubmitQuad( 24, 2,  1.0, 0.0, TABLETOP_X1/3, TABLETOP_Y2/2 + TABLETOP_Y1/8, TABLETOP_Z + TABLETOP_Z/3 + TABLETOP_Z/6,
+                              1.0, 1.0, TABLETOP_X1/3, TABLETOP_Y2/2, TABLETOP_Z + TABLETOP_Z/3 + TABLETOP_Z/6,
+                              0.0, 1.0, 2*TABLETOP_X1/3, TABLETOP_Y2/2, TABLETOP_Z + TABLETOP_Z/3 + TABLETOP_Z/6,
+                              0.0, 0.0, 2*TABLETOP_X1/3, TABLETOP_Y2/2 + TABLETOP_Y1/8, TABLETOP_Z + TABLETOP_Z/3 + TABLETOP_Z/6);
+    
+    //top of decepticon body
+    SetDrawNormal( 0.0, 0.0, -1.0 ); // Normal vector.
+    SubmitQuad( 24, 24,  1.0, 0.0, TABLETOP_X1/3, TABLETOP_Y2/2 + TABLETOP_Y1/8, TABLETOP_Z + 0.01 + TABLETOP_Z/6,
+                              0.0, 0.0, 2*TABLETOP_X1/3, TABLETOP_Y2/2 + TABLETOP_Y1/8, TABLETOP_Z + 0.01 + TABLETOP_Z/6,
+                              0.0, 1.0, 2*TABLETOP_X1/3, TABLETOP_Y2/2, TABLETOP_Z + 0.01 + TABLETOP_Z/6,
+                              1.0, 1.0, TABLETOP_X1/3, TABLETOP_Y2/2, TABLETOP_Z + 0.01 + TABLETOP_Z/6);
+    
+    
+    //left arm
+    glPushMatrix();
+    glTranslated(TABLETOP_X1/3,TABLETOP_Y2/2 - TABLETOP_Y2/16,TABLETOP_Z + TABLETOP_Z/3 + TABLETOP_Z/30);
+    glScaled(TABLETOP_Z/20,TABLETOP_Z/20,TABLETOP_Z/9);
+    SubmitCuboid();
+    glPopMatrix();
+    
+    //right arm
+    glPushMatrix();
+    glTranslated(2 *TABLETOP_X1/3,TABLETOP_Y2/2 - TABLETOP_Y2/16,TABLETOP_Z + TABLETOP_Z/3 + TABLETOP_Z/30);
+    glScaled(TABLETOP_Z/20,TABLETOP_Z/20,TABLETOP_Z/9);
+    SubmitCuboid();
+    glPopMatrix();
+    
+    //left leg
+    glPushMatrix();
+    glTranslated(2 *TABLETOP_X1/3 - TABLETOP_X1/16,TABLETOP_Y2/2 - TABLETOP_Y2/16,TABLETOP_Z + TABLETOP_Z/8);
+    glScaled(TABLETOP_Z/25,TABLETOP_Z/20,TABLETOP_Z/15);
+    SubmitCuboid();
+    glPopMatrix();
+    
+    //right leg
+    glPushMatrix();
+    glTranslated(TABLETOP_X1/3 + TABLETOP_X1/16,TABLETOP_Y2/2 - TABLETOP_Y2/16,TABLETOP_Z + TABLETOP_Z/8);
+    glScaled(TABLETOP_Z/25,TABLETOP_Z/20,TABLETOP_Z/15);
+    SubmitCuboid();
+    glPopMatrix();
+    
+    
+    const Material material1 = { { 0.0, 0.7, 1.0, 1.0 }, { 0.0, 0.7, 1.0, 1.0 },
+                                 { 0.8, 0.8, 0.8, 1.0 }, 128.0 };
+    SetDrawMaterial( &material1 );
+    
+    
+    //eyes
+    glPushMatrix();
+    glTranslated(2 *TABLETOP_X1/3 - TABLETOP_X1/16 - TABLETOP_X1/20,TABLETOP_Y2/2 - TABLETOP_Y2/16 + TABLETOP_Y2/20 ,TABLETOP_Z + TABLETOP_Z/3 + TABLETOP_Z/4);
+    glScaled(TABLETOP_Z/100,TABLETOP_Z/100,TABLETOP_Z/100);
+    SubmitCuboid();
+    glPopMatrix();
+       
+    glPushMatrix();
+    glTranslated(TABLETOP_X1/3 + TABLETOP_X1/16 + TABLETOP_X1/20,TABLETOP_Y2/2 - TABLETOP_Y2/16 + TABLETOP_Y2/20 ,TABLETOP_Z + TABLETOP_Z/3 + TABLETOP_Z/4);
+    glScaled(TABLETOP_Z/100,TABLETOP_Z/100,TABLETOP_Z/100);
+    SubmitCuboid();
+    glPopMatrix();
+    
+}
+
+
@@ -0,0 +1,105 @@
+#include <stdlib.h>
+#include <stdio.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "mapped_file.h"
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Map the file with the input filename read-only into memory.
+// Returns 1 if successful or 0 if unsuccessful.
+// An empty file is mapped successfully with (file->data) set to NULL.
+/////////////////////////////////////////////////////////////////////////////
+
+int MapFile(const char *filename, MappedFile *file)
+{
+    file->data = NULL;
+    file->size = 0;
+    file->fileHandle = NULL;
+    file->mappingHandle = NULL;
+
+#ifdef _WIN32
+    HANDLE fileHandle = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL,
+                                    OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (fileHandle == INVALID_HANDLE_VALUE) return 0;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(fileHandle, &fileSize)) {
+        CloseHandle(fileHandle);
+        return 0;
+    }
+    file->fileHandle = fileHandle;
+    file->size = (size_t) fileSize.QuadPart;
+    if (file->size == 0) return 1;
+
+    HANDLE mappingHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mappingHandle == NULL) {
+        UnmapFile(file);
+        return 0;
+    }
+    file->mappingHandle = mappingHandle;
+
+    file->data = (const unsigned char *) MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+    if (file->data == NULL) {
+        UnmapFile(file);
+        return 0;
+    }
+    return 1;
+#else
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) return 0;
+
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0) {
+        close(fd);
+        return 0;
+    }
+    file->size = (size_t) fileStat.st_size;
+
+    if (file->size > 0) {
+        void *data = mmap(NULL, file->size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            close(fd);
+            file->size = 0;
+            return 0;
+        }
+        file->data = (const unsigned char *) data;
+    }
+
+    // The mapping stays valid after the file descriptor is closed.
+    close(fd);
+    return 1;
+#endif
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Unmap a file mapped by MapFile(). (file->data) will be set to NULL.
+/////////////////////////////////////////////////////////////////////////////
+
+void UnmapFile(MappedFile *file)
+{
+#ifdef _WIN32
+    if (file->data != NULL) UnmapViewOfFile(file->data);
+    if (file->mappingHandle != NULL) CloseHandle((HANDLE) file->mappingHandle);
+    if (file->fileHandle != NULL) CloseHandle((HANDLE) file->fileHandle);
+#else
+    if (file->data != NULL) munmap((void *) file->data, file->size);
+#endif
+
+    file->data = NULL;
+    file->size = 0;
+    file->fileHandle = NULL;
+    file->mappingHandle = NULL;
+}
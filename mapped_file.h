@@ -0,0 +1,37 @@
+#ifndef _MAPPED_FILE_H_
+#define _MAPPED_FILE_H_
+
+#include <stddef.h>
+
+/////////////////////////////////////////////////////////////////////////////
+// A file mapped read-only into memory.
+// data points to the first byte of the file and size is the file size
+// in bytes. The other fields are for internal use.
+/////////////////////////////////////////////////////////////////////////////
+
+struct MappedFile
+{
+    const unsigned char *data;
+    size_t size;
+    void *fileHandle;
+    void *mappingHandle;
+};
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Map the file with the input filename read-only into memory.
+// Returns 1 if successful or 0 if unsuccessful.
+// An empty file is mapped successfully with (file->data) set to NULL.
+/////////////////////////////////////////////////////////////////////////////
+
+extern int MapFile(const char *filename, MappedFile *file);
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Unmap a file mapped by MapFile(). (file->data) will be set to NULL.
+/////////////////////////////////////////////////////////////////////////////
+
+extern void UnmapFile(MappedFile *file);
+
+
+#endif
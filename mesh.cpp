@@ -0,0 +1,813 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <map>
+#include <vector>
+
+#ifdef __APPLE__
+#define GL_SILENCE_DEPRECATION
+#include <GLUT/glut.h>
+#else
+#include <GL/glew.h>
+#include <GL/glut.h>
+#endif
+
+#include "image_io.h"
+#include "mesh.h"
+#include "teapot_data.h"
+
+
+
+struct Mesh
+{
+    GLenum mode;
+    int numVertices;
+    int numIndices;                     // 0 if the mesh is not indexed.
+    GLenum indexType;                   // GL_UNSIGNED_SHORT if all indices fit, else GL_UNSIGNED_INT.
+    bool hasNormals;                    // False if the normal comes from the current state.
+    int vertexSize;                     // Bytes per vertex: the texture coordinates, the
+                                        // normal if any, and the position, as floats.
+    size_t numBytes;                    // Size of the vertex and index data.
+    GLuint vertexBuffer;                // 0 if the vertices are in client memory.
+    GLuint indexBuffer;                 // 0 if the indices are in client memory.
+    GLuint vertexArray;                 // 0 if vertex array objects are unsupported.
+    std::vector<float> vertexData;      // Only used without a vertex buffer.
+    std::vector<uchar> indices;         // Only used without an index buffer.
+};
+
+
+static std::map<std::vector<float>, Mesh *> meshCache;
+static MeshStats meshStats;
+
+// Per-instance attributes of the instanced draws: the matrix and the
+// normal matrix of each instance, rewritten for each draw.
+static GLuint instanceBuffer = 0;
+static std::vector<float> instanceData;
+static const int INSTANCE_SIZE = 16 + 9;   // Floats per instance.
+
+
+
+// Returns true if vertex buffer objects and vertex array objects are
+// supported, respectively.
+static bool HasVertexBuffers()
+{
+#ifdef __APPLE__
+    return true;
+#else
+    return GLEW_VERSION_1_5 || GLEW_ARB_vertex_buffer_object;
+#endif
+}
+
+static bool HasVertexArrayObjects()
+{
+#ifdef __APPLE__
+    return false;   // Apple's legacy contexts only have APPLE_vertex_array_object.
+#else
+    return GLEW_VERSION_3_0 || GLEW_ARB_vertex_array_object;
+#endif
+}
+
+
+// Set up the vertex arrays of the mesh in the current vertex array state.
+static void SetUpVertexArrays(const Mesh *mesh)
+{
+    const float *base = NULL;
+    if (mesh->vertexBuffer != 0) glBindBuffer(GL_ARRAY_BUFFER, mesh->vertexBuffer);
+    else base = mesh->vertexData.data();
+
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glTexCoordPointer(2, GL_FLOAT, mesh->vertexSize, base);
+    if (mesh->hasNormals) {
+        glEnableClientState(GL_NORMAL_ARRAY);
+        glNormalPointer(GL_FLOAT, mesh->vertexSize, base + 2);
+        glVertexPointer(3, GL_FLOAT, mesh->vertexSize, base + 5);
+    }
+    else glVertexPointer(3, GL_FLOAT, mesh->vertexSize, base + 2);
+
+    if (mesh->vertexBuffer != 0) glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Create a mesh of numVertices vertices, drawn as primitives of the input
+// mode (e.g. GL_TRIANGLES). If hasNormals is false, the normals of the
+// vertices are not stored, and the current normal is used instead.
+// If indices is not NULL, the primitives are made of the numIndices
+// vertices that it indexes, otherwise of the vertices in order.
+// Returns NULL if out of memory.
+/////////////////////////////////////////////////////////////////////////////
+
+Mesh *CreateMesh(const MeshVertex *vertices, int numVertices, bool hasNormals,
+                 const unsigned int *indices, int numIndices, unsigned int mode)
+{
+    Mesh *mesh = new Mesh;
+    mesh->mode = mode;
+    mesh->numVertices = numVertices;
+    mesh->hasNormals = hasNormals;
+    mesh->numIndices = (indices != NULL) ? numIndices : 0;
+    mesh->vertexBuffer = 0;
+    mesh->indexBuffer = 0;
+    mesh->vertexArray = 0;
+
+    // Use 16-bit indices where they fit, to halve the index data.
+    std::vector<uchar> indexData;
+    mesh->indexType = (numVertices <= 65536) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    if (mesh->indexType == GL_UNSIGNED_SHORT) {
+        indexData.resize(mesh->numIndices * sizeof(GLushort));
+        GLushort *shortIndices = (GLushort *) indexData.data();
+        for (int i = 0; i < mesh->numIndices; i++) shortIndices[i] = (GLushort) indices[i];
+    }
+    else if (mesh->numIndices > 0) {
+        indexData.assign((const uchar *) indices, (const uchar *) (indices + numIndices));
+    }
+
+    // Pack the vertices, leaving out the normals if they are not used.
+    std::vector<float> vertexData;
+    for (int i = 0; i < numVertices; i++) {
+        vertexData.insert(vertexData.end(), vertices[i].texCoord, vertices[i].texCoord + 2);
+        if (hasNormals) vertexData.insert(vertexData.end(), vertices[i].normal, vertices[i].normal + 3);
+        vertexData.insert(vertexData.end(), vertices[i].position, vertices[i].position + 3);
+    }
+    mesh->vertexSize = (hasNormals ? 8 : 5) * sizeof(float);
+    mesh->numBytes = vertexData.size() * sizeof(float) + indexData.size();
+
+    if (HasVertexBuffers()) {
+        glGenBuffers(1, &mesh->vertexBuffer);
+        glBindBuffer(GL_ARRAY_BUFFER, mesh->vertexBuffer);
+        glBufferData(GL_ARRAY_BUFFER, vertexData.size() * sizeof(float), vertexData.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        if (mesh->numIndices > 0) {
+            glGenBuffers(1, &mesh->indexBuffer);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->indexBuffer);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexData.size(), indexData.data(), GL_STATIC_DRAW);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        }
+        if (glGetError() == GL_OUT_OF_MEMORY) {
+            glDeleteBuffers(1, &mesh->vertexBuffer);
+            if (mesh->indexBuffer != 0) glDeleteBuffers(1, &mesh->indexBuffer);
+            delete mesh;
+            return NULL;
+        }
+    }
+    else {
+        mesh->vertexData.swap(vertexData);
+        mesh->indices.swap(indexData);
+    }
+
+#ifndef __APPLE__
+    if (HasVertexArrayObjects()) {
+        glGenVertexArrays(1, &mesh->vertexArray);
+        glBindVertexArray(mesh->vertexArray);
+        SetUpVertexArrays(mesh);
+        if (mesh->indexBuffer != 0) glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->indexBuffer);
+        glBindVertexArray(0);
+    }
+#endif
+
+    meshStats.numMeshes++;
+    meshStats.numBufferBytes += mesh->numBytes;
+    return mesh;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Draw the mesh with one draw call.
+/////////////////////////////////////////////////////////////////////////////
+
+void DrawMesh(const Mesh *mesh)
+{
+    const uchar *indices = (mesh->indexBuffer != 0) ? NULL : mesh->indices.data();
+
+#ifndef __APPLE__
+    if (mesh->vertexArray != 0) {
+        glBindVertexArray(mesh->vertexArray);
+        if (mesh->numIndices > 0) glDrawElements(mesh->mode, mesh->numIndices, mesh->indexType, indices);
+        else glDrawArrays(mesh->mode, 0, mesh->numVertices);
+        glBindVertexArray(0);
+    }
+    else
+#endif
+    {
+        SetUpVertexArrays(mesh);
+        if (mesh->numIndices > 0) {
+            if (mesh->indexBuffer != 0) glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->indexBuffer);
+            glDrawElements(mesh->mode, mesh->numIndices, mesh->indexType, indices);
+            if (mesh->indexBuffer != 0) glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        }
+        else glDrawArrays(mesh->mode, 0, mesh->numVertices);
+        glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+        glDisableClientState(GL_VERTEX_ARRAY);
+        if (mesh->hasNormals) glDisableClientState(GL_NORMAL_ARRAY);
+    }
+
+    meshStats.numDraws++;
+    meshStats.numVerticesDrawn += mesh->numVertices;
+    meshStats.numElementsDrawn += (mesh->numIndices > 0) ? mesh->numIndices : mesh->numVertices;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns 1 if meshes can be drawn instanced, with a vertex shader that
+// applies the instance matrices, or 0 if not.
+/////////////////////////////////////////////////////////////////////////////
+
+int HasInstancedMeshes(void)
+{
+#ifdef __APPLE__
+    return 0;
+#else
+    return (GLEW_VERSION_3_3 && HasVertexBuffers()) ? 1 : 0;
+#endif
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Set the instance attributes to the identity matrices, as they are
+// outside instanced draws. Needed once, before the first draw with a
+// program that reads them.
+/////////////////////////////////////////////////////////////////////////////
+
+void ResetMeshInstanceAttribs(void)
+{
+#ifndef __APPLE__
+    if (!HasInstancedMeshes()) return;
+    for (int i = 0; i < 4; i++)
+        glVertexAttrib4f(MESH_INSTANCE_MATRIX_ATTRIB + i, i == 0, i == 1, i == 2, i == 3);
+    for (int i = 0; i < 3; i++)
+        glVertexAttrib3f(MESH_INSTANCE_NORMAL_MATRIX_ATTRIB + i, i == 0, i == 1, i == 2);
+#endif
+}
+
+
+
+// Write the inverse transpose of the upper-left 3x3 part of the
+// column-major 4x4 matrix m to the column-major 3x3 matrix n. The matrix
+// is scaled arbitrarily, as the normals are normalized after it.
+static void GetNormalMatrix(const float *m, float *n)
+{
+    // The inverse transpose is the matrix of cofactors over the
+    // determinant, whose sign keeps the normals facing the same way.
+    float c[9] = {
+        m[5] * m[10] - m[6] * m[9],  m[6] * m[8] - m[4] * m[10],  m[4] * m[9] - m[5] * m[8],
+        m[2] * m[9] - m[1] * m[10],  m[0] * m[10] - m[2] * m[8],  m[1] * m[8] - m[0] * m[9],
+        m[1] * m[6] - m[2] * m[5],   m[2] * m[4] - m[0] * m[6],   m[0] * m[5] - m[1] * m[4]
+    };
+    float det = m[0] * c[0] + m[1] * c[1] + m[2] * c[2];
+    float scale = (det < 0.0f) ? -1.0f : 1.0f;
+    for (int i = 0; i < 9; i++) n[i] = scale * c[i];
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Draw numInstances instances of the mesh, the i-th transformed by the 4x4
+// matrix (in column-major order, as in OpenGL) at matrices + 16 * i.
+// If instanced drawing is supported, the instances are drawn with one
+// draw call, and the current program must apply the instance matrices.
+// Otherwise each instance is drawn in turn, with its matrix multiplied
+// onto the modelview matrix, so that the fixed-function pipeline draws
+// them.
+/////////////////////////////////////////////////////////////////////////////
+
+void DrawMeshInstanced(const Mesh *mesh, const float *matrices, int numInstances)
+{
+    if (numInstances <= 0) return;
+
+#ifndef __APPLE__
+    if (HasInstancedMeshes()) {
+        instanceData.resize((size_t) numInstances * INSTANCE_SIZE);
+        for (int i = 0; i < numInstances; i++) {
+            float *instance = &instanceData[(size_t) i * INSTANCE_SIZE];
+            memcpy(instance, matrices + 16 * i, 16 * sizeof(float));
+            GetNormalMatrix(matrices + 16 * i, instance + 16);
+        }
+
+        // Orphan the buffer's storage before rewriting it, so the draw does
+        // not wait for the previous draw reading it.
+        if (instanceBuffer == 0) glGenBuffers(1, &instanceBuffer);
+        glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+        glBufferData(GL_ARRAY_BUFFER, instanceData.size() * sizeof(float), NULL, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, instanceData.size() * sizeof(float), instanceData.data());
+
+        if (mesh->vertexArray != 0) glBindVertexArray(mesh->vertexArray);
+        else {
+            SetUpVertexArrays(mesh);
+            glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+            if (mesh->indexBuffer != 0) glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->indexBuffer);
+        }
+
+        const GLsizei stride = INSTANCE_SIZE * sizeof(float);
+        for (int i = 0; i < 7; i++) {
+            GLuint attrib = (i < 4) ? MESH_INSTANCE_MATRIX_ATTRIB + i : MESH_INSTANCE_NORMAL_MATRIX_ATTRIB + i - 4;
+            const float *offset = (i < 4) ? (const float *) NULL + 4 * i : (const float *) NULL + 16 + 3 * (i - 4);
+            glEnableVertexAttribArray(attrib);
+            glVertexAttribPointer(attrib, (i < 4) ? 4 : 3, GL_FLOAT, GL_FALSE, stride, offset);
+            glVertexAttribDivisor(attrib, 1);
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        const uchar *indices = (mesh->indexBuffer != 0) ? NULL : mesh->indices.data();
+        if (mesh->numIndices > 0) glDrawElementsInstanced(mesh->mode, mesh->numIndices, mesh->indexType, indices, numInstances);
+        else glDrawArraysInstanced(mesh->mode, 0, mesh->numVertices, numInstances);
+
+        // Leave the vertex arrays as DrawMesh() expects them.
+        for (int i = 0; i < 7; i++) {
+            GLuint attrib = (i < 4) ? MESH_INSTANCE_MATRIX_ATTRIB + i : MESH_INSTANCE_NORMAL_MATRIX_ATTRIB + i - 4;
+            glVertexAttribDivisor(attrib, 0);
+            glDisableVertexAttribArray(attrib);
+        }
+        if (mesh->vertexArray != 0) glBindVertexArray(0);
+        else {
+            if (mesh->indexBuffer != 0) glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+            glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+            glDisableClientState(GL_VERTEX_ARRAY);
+            if (mesh->hasNormals) glDisableClientState(GL_NORMAL_ARRAY);
+        }
+
+        // The current values of the attributes are undefined after they
+        // were read from arrays.
+        ResetMeshInstanceAttribs();
+
+        meshStats.numDraws++;
+        meshStats.numInstancesDrawn += numInstances;
+        meshStats.numVerticesDrawn += (size_t) mesh->numVertices * numInstances;
+        meshStats.numElementsDrawn += (size_t) ((mesh->numIndices > 0) ? mesh->numIndices : mesh->numVertices) * numInstances;
+        return;
+    }
+#endif
+
+    glMatrixMode(GL_MODELVIEW);
+    for (int i = 0; i < numInstances; i++) {
+        glPushMatrix();
+        glMultMatrixf(matrices + 16 * i);
+        DrawMesh(mesh);
+        glPopMatrix();
+    }
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Delete the mesh and its buffers. mesh may be NULL.
+/////////////////////////////////////////////////////////////////////////////
+
+void DeleteMesh(Mesh *mesh)
+{
+    if (mesh == NULL) return;
+
+#ifndef __APPLE__
+    if (mesh->vertexArray != 0) glDeleteVertexArrays(1, &mesh->vertexArray);
+#endif
+    if (mesh->vertexBuffer != 0) glDeleteBuffers(1, &mesh->vertexBuffer);
+    if (mesh->indexBuffer != 0) glDeleteBuffers(1, &mesh->indexBuffer);
+
+    meshStats.numMeshes--;
+    meshStats.numBufferBytes -= mesh->numBytes;
+    delete mesh;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns the mesh in the mesh cache that was added with the same
+// numParams parameters, or NULL if there is none.
+/////////////////////////////////////////////////////////////////////////////
+
+Mesh *FindCachedMesh(const float *params, int numParams)
+{
+    std::map<std::vector<float>, Mesh *>::const_iterator it =
+        meshCache.find(std::vector<float>(params, params + numParams));
+    return (it != meshCache.end()) ? it->second : NULL;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Create a mesh as with CreateMesh() and add it to the mesh cache under
+// the numParams parameters.
+// Returns the mesh, or NULL if out of memory.
+/////////////////////////////////////////////////////////////////////////////
+
+Mesh *AddCachedMesh(const float *params, int numParams,
+                    const MeshVertex *vertices, int numVertices, bool hasNormals,
+                    const unsigned int *indices, int numIndices, unsigned int mode)
+{
+    Mesh *mesh = CreateMesh(vertices, numVertices, hasNormals, indices, numIndices, mode);
+    if (mesh == NULL) return NULL;
+
+    Mesh *&entry = meshCache[std::vector<float>(params, params + numParams)];
+    DeleteMesh(entry);
+    entry = mesh;
+    return mesh;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Delete all the meshes in the mesh cache.
+/////////////////////////////////////////////////////////////////////////////
+
+void ClearMeshCache(void)
+{
+    std::map<std::vector<float>, Mesh *>::iterator it;
+    for (it = meshCache.begin(); it != meshCache.end(); ++it) DeleteMesh(it->second);
+    meshCache.clear();
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Append the (uSteps + 1) x (vSteps + 1) vertices of a grid, stored row
+// by row of vSteps + 1 vertices, to the vertices and indices of an indexed
+// mesh of GL_TRIANGLES, two triangles per cell. The cells are ordered along the
+// rows, so the vertices of the previous row are still in the
+// post-transform vertex cache.
+//
+// If wrapTexCoords is true, the texture coordinates of each cell are
+// wrapped into [0, 1] by subtracting the same whole numbers from all its
+// vertices, which requires that the cells do not cross a multiple of 1.
+// A vertex is only shared by the cells with the same shift.
+/////////////////////////////////////////////////////////////////////////////
+
+static void IndexGridMesh(int uSteps, int vSteps, const std::vector<MeshVertex> &grid, bool wrapTexCoords,
+                          std::vector<MeshVertex> &vertices, std::vector<unsigned int> &indices)
+{
+    const int rowLength = vSteps + 1;
+
+    // Without wrapping, every grid vertex is used as it is. With wrapping,
+    // each grid vertex has a copy for each shift of the cells around it.
+    struct WrappedCopy { float ds, dt; unsigned int index; };
+    std::vector<std::vector<WrappedCopy> > copies;
+
+    const unsigned int firstVertex = (unsigned int) vertices.size();
+    if (!wrapTexCoords) vertices.insert(vertices.end(), grid.begin(), grid.end());
+    else copies.resize(grid.size());
+
+    for (int u = 0; u < uSteps; u++) {
+        for (int v = 0; v < vSteps; v++) {
+            // The corners E, F, H, G of the cell, anti-clockwise.
+            int corners[4] = { u * rowLength + v, (u + 1) * rowLength + v,
+                               (u + 1) * rowLength + v + 1, u * rowLength + v + 1 };
+            unsigned int cellIndices[4];
+
+            if (!wrapTexCoords) {
+                for (int k = 0; k < 4; k++) cellIndices[k] = firstVertex + corners[k];
+            }
+            else {
+                float d[2];
+                for (int i = 0; i < 2; i++) {
+                    float minTexCoord = grid[corners[0]].texCoord[i];
+                    for (int k = 1; k < 4; k++) minTexCoord = fminf(minTexCoord, grid[corners[k]].texCoord[i]);
+                    d[i] = floorf(minTexCoord + 1e-4f);
+                }
+                for (int k = 0; k < 4; k++) {
+                    std::vector<WrappedCopy> &vertexCopies = copies[corners[k]];
+                    size_t c = 0;
+                    while (c < vertexCopies.size() && (vertexCopies[c].ds != d[0] || vertexCopies[c].dt != d[1])) c++;
+                    if (c == vertexCopies.size()) {
+                        MeshVertex vertex = grid[corners[k]];
+                        vertex.texCoord[0] -= d[0];
+                        vertex.texCoord[1] -= d[1];
+                        WrappedCopy copy = { d[0], d[1], (unsigned int) vertices.size() };
+                        vertexCopies.push_back(copy);
+                        vertices.push_back(vertex);
+                    }
+                    cellIndices[k] = vertexCopies[c].index;
+                }
+            }
+
+            // Split the cell into (E, F, G) and (F, H, G), along the same
+            // diagonal as Mesa splits GL_QUADS, so that the depths of the
+            // cells match immediate-mode quads, e.g. where the axes lie on
+            // the floor.
+            unsigned int triangles[6] = { cellIndices[0], cellIndices[1], cellIndices[3],
+                                          cellIndices[1], cellIndices[2], cellIndices[3] };
+            indices.insert(indices.end(), triangles, triangles + 6);
+        }
+    }
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Generate an indexed grid mesh of uSteps x vSteps cells over the input
+// quad, whose corners have texture coordinates texCoords[i] and positions
+// positions[i], given in anti-clockwise order. The texture coordinates and
+// positions of the grid vertices are bilinearly interpolated from the
+// corners. The mesh has no normals, and is drawn as GL_TRIANGLES with the
+// returned indices. See IndexGridMesh() for wrapTexCoords.
+/////////////////////////////////////////////////////////////////////////////
+
+void GenerateGridMesh(int uSteps, int vSteps, const float texCoords[4][2],
+                      const float positions[4][3], bool wrapTexCoords,
+                      std::vector<MeshVertex> &vertices, std::vector<unsigned int> &indices)
+{
+    const int rowLength = vSteps + 1;
+
+    // Unwrapped grid vertices, interpolated in the same order as
+    // SubdivideAndDrawQuad() does, so the results are identical.
+    std::vector<MeshVertex> grid((size_t) (uSteps + 1) * rowLength);
+    for (int u = 0; u <= uSteps; u++) {
+        float uu = (float) u / uSteps;
+        float Atc[2], Btc[2], Av[3], Bv[3];
+        for (int i = 0; i < 2; i++) {
+            Atc[i] = texCoords[0][i] + uu * (texCoords[1][i] - texCoords[0][i]);
+            Btc[i] = texCoords[3][i] + uu * (texCoords[2][i] - texCoords[3][i]);
+        }
+        for (int i = 0; i < 3; i++) {
+            Av[i] = positions[0][i] + uu * (positions[1][i] - positions[0][i]);
+            Bv[i] = positions[3][i] + uu * (positions[2][i] - positions[3][i]);
+        }
+        for (int v = 0; v <= vSteps; v++) {
+            float vv = (float) v / vSteps;
+            MeshVertex &vertex = grid[u * rowLength + v];
+            for (int i = 0; i < 2; i++) vertex.texCoord[i] = Atc[i] + vv * (Btc[i] - Atc[i]);
+            for (int i = 0; i < 3; i++) vertex.position[i] = Av[i] + vv * (Bv[i] - Av[i]);
+        }
+    }
+
+    vertices.clear();
+    indices.clear();
+    IndexGridMesh(uSteps, vSteps, grid, wrapTexCoords, vertices, indices);
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Generate an indexed sphere mesh of the given radius, centered at the
+// origin with its poles on the z axis, made of numSlices x numStacks cells
+// between the lines of longitude and latitude. The vertices have their
+// normals and the texture coordinates of the given mapping. The mesh is
+// drawn as GL_TRIANGLES with the returned indices, anti-clockwise from the
+// outside. See IndexGridMesh() for wrapTexCoords.
+//
+// The sines and cosines are looked up from tables of the numSlices + 1
+// longitudes and numStacks + 1 latitudes, so each is computed only once.
+/////////////////////////////////////////////////////////////////////////////
+
+void GenerateSphereMesh(int numSlices, int numStacks, float radius, SphereTexCoords texCoords,
+                        bool wrapTexCoords, std::vector<MeshVertex> &vertices, std::vector<unsigned int> &indices)
+{
+    std::vector<float> cosLong(numSlices + 1), sinLong(numSlices + 1);
+    for (int j = 0; j < numSlices; j++) {
+        double longitude = 2.0 * M_PI * j / numSlices;
+        cosLong[j] = (float) cos(longitude);
+        sinLong[j] = (float) sin(longitude);
+    }
+    cosLong[numSlices] = cosLong[0];    // Close the seam exactly.
+    sinLong[numSlices] = sinLong[0];
+
+    std::vector<float> cosLat(numStacks + 1), sinLat(numStacks + 1);
+    for (int i = 1; i < numStacks; i++) {
+        double latitude = M_PI * (-0.5 + (double) i / numStacks);
+        cosLat[i] = (float) cos(latitude);
+        sinLat[i] = (float) sin(latitude);
+    }
+    cosLat[0] = cosLat[numStacks] = 0.0f;   // Exact poles.
+    sinLat[0] = -1.0f;
+    sinLat[numStacks] = 1.0f;
+
+    // The grid runs eastwards along u and northwards along v.
+    std::vector<MeshVertex> grid((size_t) (numSlices + 1) * (numStacks + 1));
+    for (int j = 0; j <= numSlices; j++) {
+        for (int i = 0; i <= numStacks; i++) {
+            MeshVertex &vertex = grid[j * (numStacks + 1) + i];
+            vertex.normal[0] = cosLong[j] * cosLat[i];
+            vertex.normal[1] = sinLong[j] * cosLat[i];
+            vertex.normal[2] = sinLat[i];
+            for (int k = 0; k < 3; k++) vertex.position[k] = radius * vertex.normal[k];
+
+            if (texCoords == SPHERE_TEXCOORDS_LONG_LAT) {
+                vertex.texCoord[0] = (float) j / numSlices;
+                vertex.texCoord[1] = (float) i / numStacks;
+            }
+            else {
+                vertex.texCoord[0] = vertex.normal[0];
+                vertex.texCoord[1] = vertex.normal[2];
+            }
+        }
+    }
+
+    vertices.clear();
+    indices.clear();
+    IndexGridMesh(numSlices, numStacks, grid, wrapTexCoords, vertices, indices);
+}
+
+
+
+// Evaluate the cubic Bernstein polynomials and their derivatives at t.
+static void EvaluateBernstein(float t, float b[4], float db[4])
+{
+    float s = 1.0f - t;
+    b[0] = s * s * s;
+    b[1] = 3.0f * t * s * s;
+    b[2] = 3.0f * t * t * s;
+    b[3] = t * t * t;
+    db[0] = -3.0f * s * s;
+    db[1] = 3.0f * s * s - 6.0f * t * s;
+    db[2] = 6.0f * t * s - 3.0f * t * t;
+    db[3] = 3.0f * t * t;
+}
+
+
+// Evaluate the Bezier patch at (u, v), returning the position and the
+// unnormalized normal, dP/du x dP/dv.
+static void EvaluatePatch(const float cp[4][4][3], float u, float v, float position[3], float normal[3])
+{
+    float bu[4], dbu[4], bv[4], dbv[4];
+    EvaluateBernstein(u, bu, dbu);
+    EvaluateBernstein(v, bv, dbv);
+
+    float du[3] = { 0.0f, 0.0f, 0.0f }, dv[3] = { 0.0f, 0.0f, 0.0f };
+    for (int k = 0; k < 3; k++) position[k] = 0.0f;
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 4; j++) {
+            for (int k = 0; k < 3; k++) {
+                position[k] += bu[i] * bv[j] * cp[i][j][k];
+                du[k] += dbu[i] * bv[j] * cp[i][j][k];
+                dv[k] += bu[i] * dbv[j] * cp[i][j][k];
+            }
+        }
+    }
+    normal[0] = du[1] * dv[2] - du[2] * dv[1];
+    normal[1] = du[2] * dv[0] - du[0] * dv[2];
+    normal[2] = du[0] * dv[1] - du[1] * dv[0];
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Generate an indexed mesh of the teapot drawn by glutSolidTeapot(size),
+// in the same place, with each of its Bezier patches tessellated into
+// numSubdivisions x numSubdivisions cells (glutSolidTeapot() uses 7).
+// The vertices have their normals, and the texture coordinates of
+// glutSolidTeapot(), which go from 0 to 1 across each patch.
+/////////////////////////////////////////////////////////////////////////////
+
+void GenerateTeapotMesh(int numSubdivisions, float size,
+                        std::vector<MeshVertex> &vertices, std::vector<unsigned int> &indices)
+{
+    const int rowLength = numSubdivisions + 1;
+    std::vector<MeshVertex> grid((size_t) rowLength * rowLength);
+
+    vertices.clear();
+    indices.clear();
+
+    for (int p = 0; p < TEAPOT_NUM_PATCHES; p++) {
+        int numCopies = (p < TEAPOT_NUM_ROTATED_PATCHES) ? 4 : 2;
+        for (int c = 0; c < numCopies; c++) {
+            // The mirrored copy has its columns reversed, so that its
+            // triangles and normals still face outwards.
+            bool mirrored = (numCopies == 2 && c == 1);
+            float cp[4][4][3];
+            for (int i = 0; i < 4; i++) {
+                for (int j = 0; j < 4; j++) {
+                    const float *q = teapotControlPoints[teapotPatches[p][i * 4 + (mirrored ? 3 - j : j)]];
+                    float x = q[0], y = q[1];
+                    if (mirrored) y = -y;
+                    for (int r = 0; r < c && !mirrored; r++) {
+                        float t = x;
+                        x = y;
+                        y = -t;
+                    }
+                    cp[i][j][0] = x;
+                    cp[i][j][1] = y;
+                    cp[i][j][2] = q[2];
+                }
+            }
+
+            for (int u = 0; u <= numSubdivisions; u++) {
+                for (int v = 0; v <= numSubdivisions; v++) {
+                    float uu = (float) u / numSubdivisions, vv = (float) v / numSubdivisions;
+                    float position[3], normal[3];
+                    EvaluatePatch(cp, uu, vv, position, normal);
+
+                    // Where the patch collapses to a point, take the normal
+                    // from just inside the patch.
+                    if (normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2] < 1e-12f) {
+                        float unused[3];
+                        EvaluatePatch(cp, uu + ((uu < 0.5f) ? 1e-3f : -1e-3f),
+                                      vv + ((vv < 0.5f) ? 1e-3f : -1e-3f), unused, normal);
+                    }
+                    float length = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+                    if (length > 0.0f) for (int k = 0; k < 3; k++) normal[k] /= length;
+
+                    // Stand the teapot on the x-z plane as glutSolidTeapot() does.
+                    MeshVertex &vertex = grid[u * rowLength + v];
+                    vertex.texCoord[0] = uu;
+                    vertex.texCoord[1] = mirrored ? 1.0f - vv : vv;
+                    vertex.normal[0] = normal[0];
+                    vertex.normal[1] = normal[2];
+                    vertex.normal[2] = -normal[1];
+                    vertex.position[0] = 0.5f * size * position[0];
+                    vertex.position[1] = 0.5f * size * (position[2] - 1.575f);
+                    vertex.position[2] = -0.5f * size * position[1];
+                }
+            }
+
+            IndexGridMesh(numSubdivisions, numSubdivisions, grid, false, vertices, indices);
+        }
+    }
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Get the axis-aligned bounding box of the teapot of GenerateTeapotMesh()
+// with the given size. It bounds the control points of the patches, so
+// it holds the teapot however finely it is tessellated.
+/////////////////////////////////////////////////////////////////////////////
+
+void GetTeapotBounds(float size, float boxMin[3], float boxMax[3])
+{
+    for (int k = 0; k < 3; k++) {
+        boxMin[k] = 1e30f;
+        boxMax[k] = -1e30f;
+    }
+
+    for (int p = 0; p < TEAPOT_NUM_PATCHES; p++) {
+        int numCopies = (p < TEAPOT_NUM_ROTATED_PATCHES) ? 4 : 2;
+        for (int c = 0; c < numCopies; c++) {
+            bool mirrored = (numCopies == 2 && c == 1);
+            for (int i = 0; i < 16; i++) {
+                const float *q = teapotControlPoints[teapotPatches[p][i]];
+                float x = q[0], y = q[1];
+                if (mirrored) y = -y;
+                for (int r = 0; r < c && !mirrored; r++) {
+                    float t = x;
+                    x = y;
+                    y = -t;
+                }
+                // Placed as in GenerateTeapotMesh().
+                float position[3] = { 0.5f * size * x, 0.5f * size * (q[2] - 1.575f), -0.5f * size * y };
+                for (int k = 0; k < 3; k++) {
+                    boxMin[k] = fminf(boxMin[k], position[k]);
+                    boxMax[k] = fmaxf(boxMax[k], position[k]);
+                }
+            }
+        }
+    }
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Generate an indexed mesh of the cube drawn by glutSolidCube(size),
+// centered at the origin. Each face is made of two triangles, whose
+// vertices have the normal of the face and texture coordinates that go
+// from 0 to 1 across it.
+/////////////////////////////////////////////////////////////////////////////
+
+void GenerateCubeMesh(float size, std::vector<MeshVertex> &vertices, std::vector<unsigned int> &indices)
+{
+    // The normal of each face, and the two axes along which its texture
+    // coordinates increase, so that the corners go anti-clockwise from
+    // the outside.
+    static const float faces[6][3][3] = {
+        { {  1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 } },
+        { { -1, 0, 0 }, { 0, 0, 1 }, { 0, 1, 0 } },
+        { { 0,  1, 0 }, { 0, 0, 1 }, { 1, 0, 0 } },
+        { { 0, -1, 0 }, { 1, 0, 0 }, { 0, 0, 1 } },
+        { { 0, 0,  1 }, { 1, 0, 0 }, { 0, 1, 0 } },
+        { { 0, 0, -1 }, { 0, 1, 0 }, { 1, 0, 0 } }
+    };
+    static const float corners[4][2] = { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 1 } };
+
+    vertices.clear();
+    indices.clear();
+
+    for (int f = 0; f < 6; f++) {
+        const unsigned int first = (unsigned int) vertices.size();
+        for (int c = 0; c < 4; c++) {
+            MeshVertex vertex;
+            vertex.texCoord[0] = corners[c][0];
+            vertex.texCoord[1] = corners[c][1];
+            for (int k = 0; k < 3; k++) {
+                vertex.normal[k] = faces[f][0][k];
+                vertex.position[k] = 0.5f * size * (faces[f][0][k] + (2.0f * corners[c][0] - 1.0f) * faces[f][1][k] +
+                                                    (2.0f * corners[c][1] - 1.0f) * faces[f][2][k]);
+            }
+            vertices.push_back(vertex);
+        }
+        // Split as IndexGridMesh() splits the cells.
+        unsigned int triangles[6] = { first, first + 1, first + 3, first + 1, first + 2, first + 3 };
+        indices.insert(indices.end(), triangles, triangles + 6);
+    }
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Usage statistics of the meshes, since the start of the program.
+/////////////////////////////////////////////////////////////////////////////
+
+void GetMeshStats(MeshStats *stats)
+{
+    *stats = meshStats;
+}
@@ -0,0 +1,246 @@
+#ifndef _MESH_H_
+#define _MESH_H_
+
+#include <stddef.h>
+#include <vector>
+
+/////////////////////////////////////////////////////////////////////////////
+// Retained meshes.
+//
+// A mesh keeps the vertices of a piece of static geometry in a vertex
+// buffer object, with a vertex array object that records the vertex
+// arrays, so that the geometry is generated once and then drawn with a
+// single call. Where vertex buffer objects are unsupported, the vertices
+// are kept in client memory and drawn with vertex arrays; where vertex
+// array objects are unsupported, the vertex arrays are set up on each draw.
+//
+// The vertices have texture coordinates, positions and optionally normals.
+// Colors, and normals if the mesh has none, come from the current OpenGL
+// state, as in immediate mode.
+// A mesh may be indexed, so that vertices shared by several primitives
+// are stored, transformed and lit once.
+//
+// The mesh cache looks meshes up by the parameters that generated them,
+// such as the arguments of a function that draws a shape.
+/////////////////////////////////////////////////////////////////////////////
+
+
+struct MeshVertex
+{
+    float texCoord[2];
+    float normal[3];
+    float position[3];
+};
+
+
+struct Mesh;
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Create a mesh of numVertices vertices, drawn as primitives of the input
+// mode (e.g. GL_TRIANGLES). If hasNormals is false, the normals of the
+// vertices are not stored, and the current normal is used instead.
+// If indices is not NULL, the primitives are made of the numIndices
+// vertices that it indexes, otherwise of the vertices in order.
+// Returns NULL if out of memory.
+/////////////////////////////////////////////////////////////////////////////
+
+extern Mesh *CreateMesh( const MeshVertex *vertices, int numVertices, bool hasNormals,
+                         const unsigned int *indices, int numIndices, unsigned int mode );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Draw the mesh with one draw call.
+/////////////////////////////////////////////////////////////////////////////
+
+extern void DrawMesh( const Mesh *mesh );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Instanced drawing.
+//
+// An instance of a mesh is transformed by its own 4x4 matrix, multiplied
+// onto the current modelview matrix. The matrix and the inverse transpose
+// of its upper-left 3x3 part, which transforms the normals, are passed to
+// the vertex shader in generic vertex attributes, each column in its own:
+//
+//     layout(location = 9) in mat4 instanceMatrix;         // 9 to 12.
+//     layout(location = 13) in mat3 instanceNormalMatrix;  // 13 to 15.
+//
+// The locations leave out those that some implementations alias with the
+// built-in attributes, such as gl_MultiTexCoord0. Outside instanced draws,
+// the attributes hold the identity matrices, so the same program also
+// draws meshes that are not instanced.
+/////////////////////////////////////////////////////////////////////////////
+
+#define MESH_INSTANCE_MATRIX_ATTRIB         9
+#define MESH_INSTANCE_NORMAL_MATRIX_ATTRIB  13
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns 1 if meshes can be drawn instanced, with a vertex shader that
+// applies the instance matrices, or 0 if not.
+/////////////////////////////////////////////////////////////////////////////
+
+extern int HasInstancedMeshes( void );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Set the instance attributes to the identity matrices, as they are
+// outside instanced draws. Needed once, before the first draw with a
+// program that reads them.
+/////////////////////////////////////////////////////////////////////////////
+
+extern void ResetMeshInstanceAttribs( void );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Draw numInstances instances of the mesh, the i-th transformed by the 4x4
+// matrix (in column-major order, as in OpenGL) at matrices + 16 * i.
+// If instanced drawing is supported, the instances are drawn with one
+// draw call, and the current program must apply the instance matrices.
+// Otherwise each instance is drawn in turn, with its matrix multiplied
+// onto the modelview matrix, so that the fixed-function pipeline draws
+// them.
+/////////////////////////////////////////////////////////////////////////////
+
+extern void DrawMeshInstanced( const Mesh *mesh, const float *matrices, int numInstances );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Delete the mesh and its buffers. mesh may be NULL.
+/////////////////////////////////////////////////////////////////////////////
+
+extern void DeleteMesh( Mesh *mesh );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns the mesh in the mesh cache that was added with the same
+// numParams parameters, or NULL if there is none.
+/////////////////////////////////////////////////////////////////////////////
+
+extern Mesh *FindCachedMesh( const float *params, int numParams );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Create a mesh as with CreateMesh() and add it to the mesh cache under
+// the numParams parameters.
+// Returns the mesh, or NULL if out of memory.
+/////////////////////////////////////////////////////////////////////////////
+
+extern Mesh *AddCachedMesh( const float *params, int numParams,
+                            const MeshVertex *vertices, int numVertices, bool hasNormals,
+                            const unsigned int *indices, int numIndices, unsigned int mode );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Delete all the meshes in the mesh cache.
+/////////////////////////////////////////////////////////////////////////////
+
+extern void ClearMeshCache( void );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Mesh generators.
+//
+// The generated meshes are drawn as GL_TRIANGLES with the returned indices,
+// two triangles per cell, anti-clockwise from the front. Each vertex is
+// generated once and shared by the cells around it, and the cells are
+// ordered along the rows of the grid, so the vertices of the previous row
+// are still in the post-transform vertex cache.
+//
+// If wrapTexCoords is true, the texture coordinates of each cell are
+// wrapped into [0, 1] by subtracting the same whole numbers from all its
+// vertices, which requires that the cells do not cross a multiple of 1.
+// A vertex is then only shared by the cells with the same shift.
+/////////////////////////////////////////////////////////////////////////////
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Generate an indexed grid mesh of uSteps x vSteps cells over the input
+// quad, whose corners have texture coordinates texCoords[i] and positions
+// positions[i], given in anti-clockwise order. The texture coordinates and
+// positions of the grid vertices are bilinearly interpolated from the
+// corners. The mesh has no normals, and is drawn as GL_TRIANGLES with the
+// returned indices. See IndexGridMesh() for wrapTexCoords.
+/////////////////////////////////////////////////////////////////////////////
+
+extern void GenerateGridMesh( int uSteps, int vSteps, const float texCoords[4][2],
+                              const float positions[4][3], bool wrapTexCoords,
+                              std::vector<MeshVertex> &vertices, std::vector<unsigned int> &indices );
+
+
+// Texture coordinate mappings of GenerateSphereMesh().
+enum SphereTexCoords
+{
+    SPHERE_TEXCOORDS_LONG_LAT,  // s and t go from 0 to 1 along the longitude and latitude.
+    SPHERE_TEXCOORDS_PLANAR     // s and t are the x and z of the normal, in [-1, 1].
+};
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Generate an indexed sphere mesh of the given radius, centered at the
+// origin with its poles on the z axis, made of numSlices x numStacks cells
+// between the lines of longitude and latitude. The vertices have their
+// normals and the texture coordinates of the given mapping. The mesh is
+// drawn as GL_TRIANGLES with the returned indices, anti-clockwise from the
+// outside. See IndexGridMesh() for wrapTexCoords.
+//
+// The sines and cosines are looked up from tables of the numSlices + 1
+// longitudes and numStacks + 1 latitudes, so each is computed only once.
+/////////////////////////////////////////////////////////////////////////////
+
+extern void GenerateSphereMesh( int numSlices, int numStacks, float radius, SphereTexCoords texCoords,
+                                bool wrapTexCoords, std::vector<MeshVertex> &vertices,
+                                std::vector<unsigned int> &indices );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Generate an indexed mesh of the teapot drawn by glutSolidTeapot(size),
+// in the same place, with each of its Bezier patches tessellated into
+// numSubdivisions x numSubdivisions cells (glutSolidTeapot() uses 7).
+// The vertices have their normals, and the texture coordinates of
+// glutSolidTeapot(), which go from 0 to 1 across each patch.
+/////////////////////////////////////////////////////////////////////////////
+
+extern void GenerateTeapotMesh( int numSubdivisions, float size,
+                                std::vector<MeshVertex> &vertices, std::vector<unsigned int> &indices );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Get the axis-aligned bounding box of the teapot of GenerateTeapotMesh()
+// with the given size. It bounds the control points of the patches, so
+// it holds the teapot however finely it is tessellated.
+/////////////////////////////////////////////////////////////////////////////
+
+extern void GetTeapotBounds( float size, float boxMin[3], float boxMax[3] );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Generate an indexed mesh of the cube drawn by glutSolidCube(size),
+// centered at the origin. Each face is made of two triangles, whose
+// vertices have the normal of the face and texture coordinates that go
+// from 0 to 1 across it.
+/////////////////////////////////////////////////////////////////////////////
+
+extern void GenerateCubeMesh( float size, std::vector<MeshVertex> &vertices, std::vector<unsigned int> &indices );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Usage statistics of the meshes, since the start of the program.
+/////////////////////////////////////////////////////////////////////////////
+
+struct MeshStats
+{
+    size_t numMeshes;           // Meshes currently in existence.
+    size_t numBufferBytes;      // Bytes of vertex and index data of those meshes.
+    size_t numDraws;            // Calls of DrawMesh(), and instanced draw calls.
+    size_t numInstancesDrawn;   // Instances drawn by instanced draw calls.
+    size_t numVerticesDrawn;    // Distinct vertices of the meshes drawn, per instance.
+    size_t numElementsDrawn;    // Vertices of the primitives drawn, counting shared ones each time.
+};
+
+extern void GetMeshStats( MeshStats *stats );
+
+
+#endif
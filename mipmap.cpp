@@ -0,0 +1,639 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+
+#ifdef __APPLE__
+#define GL_SILENCE_DEPRECATION
+#include <GLUT/glut.h>
+#else
+#include <GL/glew.h>
+#include <GL/glut.h>
+#endif
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define MIPMAP_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// SSE2 is part of the x86-64 baseline, so its kernel needs no run-time check.
+#if defined(MIPMAP_X86) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define MIPMAP_HAVE_SSE2
+#endif
+
+// The AVX2 kernel is compiled for any x86 target and only used after a
+// run-time check of the CPU.
+#if defined(MIPMAP_X86) && (defined(__GNUC__) || defined(__clang__) || defined(_MSC_VER))
+#define MIPMAP_HAVE_AVX2
+#if defined(__GNUC__) || defined(__clang__)
+#define MIPMAP_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define MIPMAP_TARGET_AVX2
+#endif
+#endif
+
+#include "image_pool.h"
+#include "mipmap.h"
+#include "timer.h"
+
+
+
+// Box-filter numPairs output texels from the 2x2 texel blocks of source
+// rows row0 and row1. scratch must hold at least 2 * numPairs * numComponents
+// bytes.
+typedef void (*BoxFilterRowFunc)(const uchar *row0, const uchar *row1, int numPairs,
+                                 int numComponents, uchar *dst, uchar *scratch);
+
+static BoxFilterRowFunc boxFilterRow = NULL;
+static const char *boxFilterRowName = NULL;
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Scalar box filter kernel. It writes each output texel directly, so it
+// needs no scratch row, and only takes one to share the SIMD kernels'
+// signature.
+/////////////////////////////////////////////////////////////////////////////
+
+static void BoxFilterRowScalar(const uchar *row0, const uchar *row1, int numPairs,
+                               int numComponents, uchar *dst, uchar *)
+{
+    const int n = numComponents;
+
+    for (int x = 0; x < numPairs; x++) {
+        const uchar *a = row0 + 2 * x * n;
+        const uchar *b = row1 + 2 * x * n;
+        for (int c = 0; c < n; c++)
+            dst[x * n + c] = (uchar) ((a[c] + a[c + n] + b[c] + b[c + n] + 2) >> 2);
+    }
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Copy every other texel of the scratch row into the output row.
+// Used by the SIMD kernels, which average every texel of the source rows
+// with its right neighbor, while only the even texels are wanted.
+/////////////////////////////////////////////////////////////////////////////
+
+static void CompactEvenTexels(const uchar *scratch, int numPairs, int numComponents, uchar *dst)
+{
+    const int n = numComponents;
+
+    if (n == 4) {
+        for (int x = 0; x < numPairs; x++) memcpy(dst + 4 * x, scratch + 8 * x, 4);
+    }
+    else if (n == 3) {
+        for (int x = 0; x < numPairs; x++) {
+            dst[3 * x + 0] = scratch[6 * x + 0];
+            dst[3 * x + 1] = scratch[6 * x + 1];
+            dst[3 * x + 2] = scratch[6 * x + 2];
+        }
+    }
+    else {
+        for (int x = 0; x < numPairs; x++)
+            for (int c = 0; c < n; c++) dst[x * n + c] = scratch[2 * x * n + c];
+    }
+}
+
+
+
+#ifdef MIPMAP_HAVE_SSE2
+/////////////////////////////////////////////////////////////////////////////
+// SSE2 box filter kernel. Averages 16 bytes per iteration in 16-bit lanes.
+/////////////////////////////////////////////////////////////////////////////
+
+static void BoxFilterRowSSE2(const uchar *row0, const uchar *row1, int numPairs,
+                             int numComponents, uchar *dst, uchar *scratch)
+{
+    const int n = numComponents;
+    const int numBytes = 2 * numPairs * n - n;  // Bytes of scratch that are needed.
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i two = _mm_set1_epi16(2);
+    int k = 0;
+
+    for (; k + 16 <= numBytes; k += 16) {
+        __m128i a = _mm_loadu_si128((const __m128i *) (row0 + k));
+        __m128i b = _mm_loadu_si128((const __m128i *) (row0 + k + n));
+        __m128i c = _mm_loadu_si128((const __m128i *) (row1 + k));
+        __m128i d = _mm_loadu_si128((const __m128i *) (row1 + k + n));
+
+        __m128i lo = _mm_add_epi16(_mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero)),
+                                   _mm_add_epi16(_mm_unpacklo_epi8(c, zero), _mm_unpacklo_epi8(d, zero)));
+        __m128i hi = _mm_add_epi16(_mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero)),
+                                   _mm_add_epi16(_mm_unpackhi_epi8(c, zero), _mm_unpackhi_epi8(d, zero)));
+        lo = _mm_srli_epi16(_mm_add_epi16(lo, two), 2);
+        hi = _mm_srli_epi16(_mm_add_epi16(hi, two), 2);
+
+        _mm_storeu_si128((__m128i *) (scratch + k), _mm_packus_epi16(lo, hi));
+    }
+    for (; k < numBytes; k++)
+        scratch[k] = (uchar) ((row0[k] + row0[k + n] + row1[k] + row1[k + n] + 2) >> 2);
+
+    CompactEvenTexels(scratch, numPairs, n, dst);
+}
+#endif
+
+
+
+#ifdef MIPMAP_HAVE_AVX2
+/////////////////////////////////////////////////////////////////////////////
+// AVX2 box filter kernel. Averages 32 bytes per iteration in 16-bit lanes.
+// The unpack and pack instructions both work within 128-bit lanes, so the
+// packed result is in the original byte order.
+/////////////////////////////////////////////////////////////////////////////
+
+MIPMAP_TARGET_AVX2
+static void BoxFilterRowAVX2(const uchar *row0, const uchar *row1, int numPairs,
+                             int numComponents, uchar *dst, uchar *scratch)
+{
+    const int n = numComponents;
+    const int numBytes = 2 * numPairs * n - n;  // Bytes of scratch that are needed.
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i two = _mm256_set1_epi16(2);
+    int k = 0;
+
+    for (; k + 32 <= numBytes; k += 32) {
+        __m256i a = _mm256_loadu_si256((const __m256i *) (row0 + k));
+        __m256i b = _mm256_loadu_si256((const __m256i *) (row0 + k + n));
+        __m256i c = _mm256_loadu_si256((const __m256i *) (row1 + k));
+        __m256i d = _mm256_loadu_si256((const __m256i *) (row1 + k + n));
+
+        __m256i lo = _mm256_add_epi16(_mm256_add_epi16(_mm256_unpacklo_epi8(a, zero), _mm256_unpacklo_epi8(b, zero)),
+                                      _mm256_add_epi16(_mm256_unpacklo_epi8(c, zero), _mm256_unpacklo_epi8(d, zero)));
+        __m256i hi = _mm256_add_epi16(_mm256_add_epi16(_mm256_unpackhi_epi8(a, zero), _mm256_unpackhi_epi8(b, zero)),
+                                      _mm256_add_epi16(_mm256_unpackhi_epi8(c, zero), _mm256_unpackhi_epi8(d, zero)));
+        lo = _mm256_srli_epi16(_mm256_add_epi16(lo, two), 2);
+        hi = _mm256_srli_epi16(_mm256_add_epi16(hi, two), 2);
+
+        _mm256_storeu_si256((__m256i *) (scratch + k), _mm256_packus_epi16(lo, hi));
+    }
+    for (; k < numBytes; k++)
+        scratch[k] = (uchar) ((row0[k] + row0[k + n] + row1[k] + row1[k + n] + 2) >> 2);
+
+    CompactEvenTexels(scratch, numPairs, n, dst);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns true if the CPU and the operating system support AVX2.
+/////////////////////////////////////////////////////////////////////////////
+
+static bool CPUHasAVX2()
+{
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") != 0;
+#else
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+
+    // The OS must save the YMM registers (OSXSAVE, and XCR0 bits 1 and 2).
+    __cpuid(info, 1);
+    if ((info[2] & (1 << 27)) == 0 || (_xgetbv(0) & 6) != 6) return false;
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#endif
+}
+#endif
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Select the kernel used by the box filter.
+// Returns 1 if successful or 0 if the kernel is not supported by this
+// build or this CPU, in which case the selected kernel is unchanged.
+/////////////////////////////////////////////////////////////////////////////
+
+int SelectMipmapKernel(MipmapKernel kernel)
+{
+    switch (kernel) {
+        case MIPMAP_KERNEL_AUTO:
+            if (SelectMipmapKernel(MIPMAP_KERNEL_AVX2)) return 1;
+            if (SelectMipmapKernel(MIPMAP_KERNEL_SSE2)) return 1;
+            return SelectMipmapKernel(MIPMAP_KERNEL_SCALAR);
+
+        case MIPMAP_KERNEL_SCALAR:
+            boxFilterRow = BoxFilterRowScalar;
+            boxFilterRowName = "scalar";
+            return 1;
+
+        case MIPMAP_KERNEL_SSE2:
+#ifdef MIPMAP_HAVE_SSE2
+            boxFilterRow = BoxFilterRowSSE2;
+            boxFilterRowName = "SSE2";
+            return 1;
+#else
+            return 0;
+#endif
+
+        case MIPMAP_KERNEL_AVX2:
+#ifdef MIPMAP_HAVE_AVX2
+            if (!CPUHasAVX2()) return 0;
+            boxFilterRow = BoxFilterRowAVX2;
+            boxFilterRowName = "AVX2";
+            return 1;
+#else
+            return 0;
+#endif
+    }
+    return 0;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns the name of the kernel currently used by the box filter.
+/////////////////////////////////////////////////////////////////////////////
+
+const char *GetMipmapKernelName(void)
+{
+    if (boxFilterRow == NULL) SelectMipmapKernel(MIPMAP_KERNEL_AUTO);
+    return boxFilterRowName;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Conversion tables between 8-bit sRGB values and linear intensities,
+// for the gamma-correct filter.
+/////////////////////////////////////////////////////////////////////////////
+
+#define LINEAR_TO_SRGB_TABLE_SIZE 4096
+
+struct GammaTables
+{
+    float srgbToLinear[256];
+    uchar linearToSrgb[LINEAR_TO_SRGB_TABLE_SIZE + 1];
+
+    GammaTables()
+    {
+        for (int i = 0; i < 256; i++) {
+            double c = i / 255.0;
+            srgbToLinear[i] = (float) ((c <= 0.04045) ? c / 12.92 : pow((c + 0.055) / 1.055, 2.4));
+        }
+        for (int i = 0; i <= LINEAR_TO_SRGB_TABLE_SIZE; i++) {
+            double l = (double) i / LINEAR_TO_SRGB_TABLE_SIZE;
+            double c = (l <= 0.0031308) ? l * 12.92 : 1.055 * pow(l, 1.0 / 2.4) - 0.055;
+            linearToSrgb[i] = (uchar) (c * 255.0 + 0.5);
+        }
+    }
+};
+
+static const GammaTables &GetGammaTables()
+{
+    static const GammaTables tables;    // Initialized once, thread-safely.
+    return tables;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Filter the output texels in columns [x0, x1) and rows [y0, y1) of the
+// destination level one texel at a time. This handles any footprint
+// (1, 2 or 3 source texels in each dimension) and the gamma-correct filter.
+/////////////////////////////////////////////////////////////////////////////
+
+static void FilterRegionScalar(const uchar *src, int srcWidth, int srcHeight, int numComponents,
+                               uchar *dst, int dstWidth, int dstHeight,
+                               int x0, int x1, int y0, int y1, bool gammaCorrect)
+{
+    const int n = numComponents;
+    const GammaTables *gamma = gammaCorrect ? &GetGammaTables() : NULL;
+    // The last channel of 2- and 4-component images is alpha, which is linear.
+    const int numColorChannels = (n == 2 || n == 4) ? n - 1 : n;
+
+    for (int y = y0; y < y1; y++) {
+        int sy0 = (srcHeight == 1) ? 0 : 2 * y;
+        int sy1 = (y == dstHeight - 1) ? srcHeight : sy0 + 2;
+
+        for (int x = x0; x < x1; x++) {
+            int sx0 = (srcWidth == 1) ? 0 : 2 * x;
+            int sx1 = (x == dstWidth - 1) ? srcWidth : sx0 + 2;
+            int count = (sx1 - sx0) * (sy1 - sy0);
+
+            for (int c = 0; c < n; c++) {
+                if (gamma != NULL && c < numColorChannels) {
+                    float sum = 0.0f;
+                    for (int sy = sy0; sy < sy1; sy++)
+                        for (int sx = sx0; sx < sx1; sx++)
+                            sum += gamma->srgbToLinear[src[((size_t) sy * srcWidth + sx) * n + c]];
+                    int index = (int) (sum / count * LINEAR_TO_SRGB_TABLE_SIZE + 0.5f);
+                    dst[((size_t) y * dstWidth + x) * n + c] = gamma->linearToSrgb[index];
+                }
+                else {
+                    int sum = 0;
+                    for (int sy = sy0; sy < sy1; sy++)
+                        for (int sx = sx0; sx < sx1; sx++)
+                            sum += src[((size_t) sy * srcWidth + sx) * n + c];
+                    dst[((size_t) y * dstWidth + x) * n + c] = (uchar) ((sum + count / 2) / count);
+                }
+            }
+        }
+    }
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Compute the next mipmap level of the source image.
+/////////////////////////////////////////////////////////////////////////////
+
+static void DownsampleImage(const uchar *src, int srcWidth, int srcHeight, int numComponents,
+                            bool gammaCorrect, uchar *dst, uchar *scratch)
+{
+    const int n = numComponents;
+    int dstWidth = (srcWidth > 1) ? srcWidth / 2 : 1;
+    int dstHeight = (srcHeight > 1) ? srcHeight / 2 : 1;
+
+    // The texels whose footprint is exactly 2x2 go through the box filter
+    // kernel. The others lie in the last column or row when the source
+    // dimension is odd, or in the only column or row when it is 1.
+    int boxWidth = (srcWidth < 2) ? 0 : dstWidth - (srcWidth & 1);
+    int boxHeight = (srcHeight < 2) ? 0 : dstHeight - (srcHeight & 1);
+    if (gammaCorrect) boxWidth = boxHeight = 0;
+
+    if (boxWidth > 0) {
+        if (boxFilterRow == NULL) SelectMipmapKernel(MIPMAP_KERNEL_AUTO);
+        for (int y = 0; y < boxHeight; y++) {
+            const uchar *row0 = src + (size_t) (2 * y) * srcWidth * n;
+            boxFilterRow(row0, row0 + (size_t) srcWidth * n, boxWidth, n,
+                         dst + (size_t) y * dstWidth * n, scratch);
+        }
+    }
+    else boxHeight = 0;
+
+    FilterRegionScalar(src, srcWidth, srcHeight, n, dst, dstWidth, dstHeight,
+                       boxWidth, dstWidth, 0, boxHeight, gammaCorrect);
+    FilterRegionScalar(src, srcWidth, srcHeight, n, dst, dstWidth, dstHeight,
+                       0, dstWidth, boxHeight, dstHeight, gammaCorrect);
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns the number of mipmap levels of an image, including level 0.
+/////////////////////////////////////////////////////////////////////////////
+
+int GetNumMipmapLevels(int imageWidth, int imageHeight)
+{
+    int size = (imageWidth > imageHeight) ? imageWidth : imageHeight;
+    int numLevels = 1;
+    while (size > 1) {
+        size /= 2;
+        numLevels++;
+    }
+    return numLevels;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns the total size in bytes of mipmap levels 1 and above of an image.
+/////////////////////////////////////////////////////////////////////////////
+
+size_t GetMipmapChainSize(int imageWidth, int imageHeight, int numComponents)
+{
+    size_t size = 0;
+    int w = imageWidth, h = imageHeight;
+
+    while (w > 1 || h > 1) {
+        w = (w > 1) ? w / 2 : 1;
+        h = (h > 1) ? h / 2 : 1;
+        size += (size_t) w * h * numComponents;
+    }
+    return size;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Build mipmap levels 1 and above of the input image, which is level 0.
+// The levels are stored one after another, from level 1 upwards, in
+// mipmapChain, which must be at least GetMipmapChainSize() bytes.
+// Returns 1 if successful or 0 if memory cannot be allocated.
+/////////////////////////////////////////////////////////////////////////////
+
+int BuildMipmapChain(const uchar *imageData, int imageWidth, int imageHeight,
+                     int numComponents, bool gammaCorrect, uchar *mipmapChain)
+{
+    uchar *scratch = (uchar *) AllocatePooledBlock((size_t) imageWidth * numComponents + 64);
+    if (scratch == NULL) return 0;
+    const uchar *src = imageData;
+    uchar *dst = mipmapChain;
+    int w = imageWidth, h = imageHeight;
+
+    while (w > 1 || h > 1) {
+        DownsampleImage(src, w, h, numComponents, gammaCorrect, dst, scratch);
+        w = (w > 1) ? w / 2 : 1;
+        h = (h > 1) ? h / 2 : 1;
+        src = dst;
+        dst += (size_t) w * h * numComponents;
+    }
+
+    FreePooledBlock(scratch);
+    return 1;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Get the OpenGL pixel format and sized internal format of images with
+// the given number of components.
+/////////////////////////////////////////////////////////////////////////////
+
+static void GetTextureFormats(int numComponents, GLenum *format, GLenum *internalFormat)
+{
+    switch (numComponents) {
+        case 1:  *format = GL_LUMINANCE;        *internalFormat = GL_LUMINANCE8;          break;
+        case 2:  *format = GL_LUMINANCE_ALPHA;  *internalFormat = GL_LUMINANCE8_ALPHA8;   break;
+        case 4:  *format = GL_RGBA;             *internalFormat = GL_RGBA8;               break;
+        default: *format = GL_RGB;              *internalFormat = GL_RGB8;                break;
+    }
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns true if non-power-of-two textures are supported.
+/////////////////////////////////////////////////////////////////////////////
+
+static bool HasNonPowerOfTwoTextures()
+{
+#ifdef __APPLE__
+    return true;    // All Macs support OpenGL 2.1.
+#else
+    return GLEW_VERSION_2_0 || GLEW_ARB_texture_non_power_of_two;
+#endif
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Allocate immutable storage for a complete mipmap chain in the texture
+// object currently bound to GL_TEXTURE_2D, if the OpenGL implementation
+// supports immutable texture storage and non-power-of-two textures.
+// Returns 1 if the storage has been allocated or 0 otherwise.
+// UploadMipmappedTexture() fills in storage allocated by this function.
+/////////////////////////////////////////////////////////////////////////////
+
+int AllocateMipmappedTexture(int imageWidth, int imageHeight, int numComponents)
+{
+#ifdef __APPLE__
+    return 0;
+#else
+    if (!(GLEW_VERSION_4_2 || GLEW_ARB_texture_storage) || !HasNonPowerOfTwoTextures()) return 0;
+
+    GLenum format, internalFormat;
+    GetTextureFormats(numComponents, &format, &internalFormat);
+    glTexStorage2D(GL_TEXTURE_2D, GetNumMipmapLevels(imageWidth, imageHeight), internalFormat,
+                   imageWidth, imageHeight);
+    return 1;
+#endif
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Build the mipmaps of the input image and upload the image and all its
+// mipmap levels into the texture object currently bound to GL_TEXTURE_2D.
+// If the bound texture has no immutable storage, it is allocated here,
+// or the levels are specified with glTexImage2D() where immutable storage
+// is unsupported. Where non-power-of-two textures are unsupported,
+// this falls back to gluBuild2DMipmaps(). Returns 1 if successful or 0
+// if memory cannot be allocated, in which case nothing is uploaded.
+/////////////////////////////////////////////////////////////////////////////
+
+int UploadMipmappedTexture(const uchar *imageData, int imageWidth, int imageHeight,
+                           int numComponents, bool gammaCorrect)
+{
+    GLenum format, internalFormat;
+    GetTextureFormats(numComponents, &format, &internalFormat);
+
+    if (!HasNonPowerOfTwoTextures()) {
+        return gluBuild2DMipmaps(GL_TEXTURE_2D, numComponents, imageWidth, imageHeight,
+                                 format, GL_UNSIGNED_BYTE, imageData) == 0;
+    }
+
+    int numLevels = GetNumMipmapLevels(imageWidth, imageHeight);
+    uchar *mipmapChain = (uchar *) AllocatePooledBlock(GetMipmapChainSize(imageWidth, imageHeight, numComponents));
+    if (mipmapChain == NULL) return 0;
+    if (!BuildMipmapChain(imageData, imageWidth, imageHeight, numComponents, gammaCorrect, mipmapChain)) {
+        FreePooledBlock(mipmapChain);
+        return 0;
+    }
+
+    GLint immutable = GL_FALSE;
+#ifndef __APPLE__
+    if (GLEW_VERSION_4_2 || GLEW_ARB_texture_storage) {
+        glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_IMMUTABLE_FORMAT, &immutable);
+        if (!immutable) immutable = AllocateMipmappedTexture(imageWidth, imageHeight, numComponents);
+    }
+#endif
+
+    GLint unpackAlignment;
+    glGetIntegerv(GL_UNPACK_ALIGNMENT, &unpackAlignment);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    const uchar *levelData = imageData;
+    int w = imageWidth, h = imageHeight;
+    for (int level = 0; level < numLevels; level++) {
+        if (immutable)
+            glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, w, h, format, GL_UNSIGNED_BYTE, levelData);
+        else
+            glTexImage2D(GL_TEXTURE_2D, level, internalFormat, w, h, 0, format, GL_UNSIGNED_BYTE, levelData);
+
+        levelData = (level == 0) ? mipmapChain : levelData + (size_t) w * h * numComponents;
+        w = (w > 1) ? w / 2 : 1;
+        h = (h > 1) ? h / 2 : 1;
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, numLevels - 1);
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, unpackAlignment);
+    FreePooledBlock(mipmapChain);
+    return 1;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Measure the time taken to build and upload the mipmaps of each of the
+// input image files with gluBuild2DMipmaps(), and with every kernel of
+// the in-tree mipmap builder, and print the results.
+// An OpenGL context must be current.
+/////////////////////////////////////////////////////////////////////////////
+
+void BenchmarkMipmaps(int numImages, const char * const *filenames)
+{
+    const int numRuns = 5;
+    const MipmapKernel kernels[] = { MIPMAP_KERNEL_SCALAR, MIPMAP_KERNEL_SSE2, MIPMAP_KERNEL_AVX2 };
+    const char *kernelNames[] = { "scalar", "SSE2", "AVX2" };
+    const int numKernels = sizeof(kernels) / sizeof(kernels[0]);
+
+    printf("Best of %d runs, in ms. 'build' is the CPU mipmap build only;\n"
+           "'upload' also includes uploading all levels to a new texture.\n\n", numRuns);
+    printf("%-22s %-11s %12s", "image", "size", "gluBuild2D");
+    for (int k = 0; k < numKernels; k++) printf(" %8s build", kernelNames[k]);
+    printf(" %12s %12s\n", "upload", "gamma upload");
+
+    for (int i = 0; i < numImages; i++) {
+        uchar *imageData;
+        int w, h, n;
+        if (!ReadImageFile(filenames[i], &imageData, &w, &h, &n)) continue;
+
+        const char *name = strrchr(filenames[i], '/');
+        printf("%-22s %5dx%-5d", (name != NULL) ? name + 1 : filenames[i], w, h);
+
+        GLenum format, internalFormat;
+        GetTextureFormats(n, &format, &internalFormat);
+        std::vector<uchar> mipmapChain(GetMipmapChainSize(w, h, n));
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+        // Times for: GLU, each kernel, upload, gamma-correct upload.
+        double bestMs[3 + numKernels];
+        for (int t = 0; t < 3 + numKernels; t++) bestMs[t] = -1.0;
+
+        for (int run = 0; run < numRuns; run++) {
+            for (int t = 0; t < 3 + numKernels; t++) {
+                bool isBuild = (t >= 1 && t <= numKernels);
+                if (isBuild && !SelectMipmapKernel(kernels[t - 1])) continue;
+                if (!isBuild) SelectMipmapKernel(MIPMAP_KERNEL_AUTO);
+
+                GLuint texObj;
+                glGenTextures(1, &texObj);
+                glBindTexture(GL_TEXTURE_2D, texObj);
+                glFinish();
+
+                double startMs = GetWallClockMs();
+                if (t == 0)
+                    gluBuild2DMipmaps(GL_TEXTURE_2D, n, w, h, format, GL_UNSIGNED_BYTE, imageData);
+                else if (isBuild)
+                    BuildMipmapChain(imageData, w, h, n, false, mipmapChain.data());
+                else
+                    UploadMipmappedTexture(imageData, w, h, n, t == 2 + numKernels);
+                glFinish();
+                double runMs = GetWallClockMs() - startMs;
+
+                glDeleteTextures(1, &texObj);
+                if (bestMs[t] < 0.0 || runMs < bestMs[t]) bestMs[t] = runMs;
+            }
+        }
+
+        for (int t = 0; t < 3 + numKernels; t++) {
+            if (bestMs[t] < 0.0) printf(" %*s", (t >= 1 && t <= numKernels) ? 14 : 12, "n/a");
+            else printf(" %*.2f", (t >= 1 && t <= numKernels) ? 14 : 12, bestMs[t]);
+        }
+        printf("\n");
+
+        DeallocateImageData(&imageData);
+    }
+
+    SelectMipmapKernel(MIPMAP_KERNEL_AUTO);
+    printf("\nIn-tree mipmap builder uses the %s kernel.\n", GetMipmapKernelName());
+}
@@ -0,0 +1,109 @@
+#ifndef _MIPMAP_H_
+#define _MIPMAP_H_
+
+#include <stddef.h>
+#include "image_io.h"
+
+/////////////////////////////////////////////////////////////////////////////
+// CPU mipmap generation.
+//
+// Each level is half the size of the previous level in each dimension,
+// rounded down, down to the 1x1 level, as in OpenGL. Non-power-of-two
+// images are not rescaled. Each texel of a level is the box-filtered
+// average of the 2x2 texels below it; where a dimension of the previous
+// level is odd, the last texel in that dimension averages 3 texels instead.
+//
+// The 2x2 box filter has SSE2 and AVX2 kernels. The fastest kernel that the
+// CPU supports is selected at run time. With gamma correction, the color
+// channels are averaged in linear space, treating the texels as sRGB;
+// the gamma-correct filter has only a scalar kernel.
+//
+// All images are tightly packed, with numComponents (1 to 4) bytes per texel.
+/////////////////////////////////////////////////////////////////////////////
+
+enum MipmapKernel
+{
+    MIPMAP_KERNEL_AUTO,     // Fastest kernel supported by the CPU.
+    MIPMAP_KERNEL_SCALAR,
+    MIPMAP_KERNEL_SSE2,
+    MIPMAP_KERNEL_AVX2
+};
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Select the kernel used by the box filter.
+// Returns 1 if successful or 0 if the kernel is not supported by this
+// build or this CPU, in which case the selected kernel is unchanged.
+/////////////////////////////////////////////////////////////////////////////
+
+extern int SelectMipmapKernel( MipmapKernel kernel );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns the name of the kernel currently used by the box filter.
+/////////////////////////////////////////////////////////////////////////////
+
+extern const char *GetMipmapKernelName( void );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns the number of mipmap levels of an image, including level 0.
+/////////////////////////////////////////////////////////////////////////////
+
+extern int GetNumMipmapLevels( int imageWidth, int imageHeight );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns the total size in bytes of mipmap levels 1 and above of an image.
+/////////////////////////////////////////////////////////////////////////////
+
+extern size_t GetMipmapChainSize( int imageWidth, int imageHeight, int numComponents );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Build mipmap levels 1 and above of the input image, which is level 0.
+// The levels are stored one after another, from level 1 upwards, in
+// mipmapChain, which must be at least GetMipmapChainSize() bytes.
+// Returns 1 if successful or 0 if memory cannot be allocated.
+/////////////////////////////////////////////////////////////////////////////
+
+extern int BuildMipmapChain( const uchar *imageData, int imageWidth, int imageHeight,
+                             int numComponents, bool gammaCorrect, uchar *mipmapChain );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Allocate immutable storage for a complete mipmap chain in the texture
+// object currently bound to GL_TEXTURE_2D, if the OpenGL implementation
+// supports immutable texture storage and non-power-of-two textures.
+// Returns 1 if the storage has been allocated or 0 otherwise.
+// UploadMipmappedTexture() fills in storage allocated by this function.
+/////////////////////////////////////////////////////////////////////////////
+
+extern int AllocateMipmappedTexture( int imageWidth, int imageHeight, int numComponents );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Build the mipmaps of the input image and upload the image and all its
+// mipmap levels into the texture object currently bound to GL_TEXTURE_2D.
+// If the bound texture has no immutable storage, it is allocated here,
+// or the levels are specified with glTexImage2D() where immutable storage
+// is unsupported. Where non-power-of-two textures are unsupported,
+// this falls back to gluBuild2DMipmaps(). Returns 1 if successful or 0
+// if memory cannot be allocated, in which case nothing is uploaded.
+/////////////////////////////////////////////////////////////////////////////
+
+extern int UploadMipmappedTexture( const uchar *imageData, int imageWidth, int imageHeight,
+                                   int numComponents, bool gammaCorrect );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Measure the time taken to build and upload the mipmaps of each of the
+// input image files with gluBuild2DMipmaps(), and with every kernel of
+// the in-tree mipmap builder, and print the results.
+// An OpenGL context must be current.
+/////////////////////////////////////////////////////////////////////////////
+
+extern void BenchmarkMipmaps( int numImages, const char * const *filenames );
+
+
+#endif
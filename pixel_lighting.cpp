@@ -0,0 +1,201 @@
+#include <stdlib.h>
+
+#ifdef __APPLE__
+#define GL_SILENCE_DEPRECATION
+#include <GLUT/glut.h>
+#else
+#include <GL/glew.h>
+#include <GL/glut.h>
+#endif
+
+#include "mesh.h"
+#include "pixel_lighting.h"
+#include "shader_program.h"
+
+
+
+// The vertices are transformed by the instance matrices of DrawMeshInstanced(),
+// which are the identity matrices outside instanced draws.
+static const char *vertexShaderSource =
+    "#version 330 compatibility\n"
+    "\n"
+    "layout(location = 9) in mat4 instanceMatrix;\n"          // MESH_INSTANCE_MATRIX_ATTRIB
+    "layout(location = 13) in mat3 instanceNormalMatrix;\n"   // MESH_INSTANCE_NORMAL_MATRIX_ATTRIB
+    "\n"
+    "out vec3 eyePosition;\n"
+    "out vec3 eyeNormal;\n"
+    "out vec2 texCoord;\n"
+    "\n"
+    "void main()\n"
+    "{\n"
+    "    vec4 vertex = instanceMatrix * gl_Vertex;\n"
+    "    vec4 position = gl_ModelViewMatrix * vertex;\n"
+    "    eyePosition = position.xyz / position.w;\n"
+    "    eyeNormal = gl_NormalMatrix * ( instanceNormalMatrix * gl_Normal );\n"
+    "    texCoord = gl_MultiTexCoord0.st;\n"
+    "    gl_ClipVertex = position;\n"                            // For the user clip planes.
+    "    gl_Position = gl_ModelViewProjectionMatrix * vertex;\n"
+    "}\n";
+
+static const char *fragmentShaderSource =
+    "#version 330 compatibility\n"
+    "\n"
+    "#define MAX_LIGHTS 2\n"               // MAX_PIXEL_LIGHTS
+    "\n"
+    "in vec3 eyePosition;\n"
+    "in vec3 eyeNormal;\n"
+    "in vec2 texCoord;\n"
+    "\n"
+    "uniform bool lightEnabled[MAX_LIGHTS];\n"
+    "uniform bool textured;\n"
+    "uniform bool repeatInRegion;\n"
+    "uniform sampler2D texMap;\n"
+    "\n"
+    "layout(location = 0) out vec4 fragColor;\n"
+    "\n"
+    "void main()\n"
+    "{\n"
+    "    // Two-sided lighting: back faces are lit with the back material\n"
+    "    // and the reversed normal.\n"
+    "    vec3 n = normalize( gl_FrontFacing ? eyeNormal : -eyeNormal );\n"
+    "    vec3 v = normalize( -eyePosition );\n"
+    "\n"
+    "    vec4 color = gl_FrontFacing ? gl_FrontLightModelProduct.sceneColor\n"
+    "                                : gl_BackLightModelProduct.sceneColor;\n"
+    "    vec3 specular = vec3( 0.0 );\n"
+    "    float shininess = gl_FrontFacing ? gl_FrontMaterial.shininess : gl_BackMaterial.shininess;\n"
+    "\n"
+    "    for ( int i = 0; i < MAX_LIGHTS; i++ )\n"
+    "    {\n"
+    "        if ( !lightEnabled[i] ) continue;\n"
+    "        gl_LightProducts product = gl_FrontFacing ? gl_FrontLightProduct[i] : gl_BackLightProduct[i];\n"
+    "\n"
+    "        vec4 lightPosition = gl_LightSource[i].position;\n"
+    "        vec3 l = lightPosition.xyz - eyePosition * lightPosition.w;\n"
+    "        float attenuation = 1.0;\n"
+    "        if ( lightPosition.w != 0.0 )\n"
+    "        {\n"
+    "            float d = length( l );\n"
+    "            attenuation = 1.0 / ( gl_LightSource[i].constantAttenuation +\n"
+    "                                  gl_LightSource[i].linearAttenuation * d +\n"
+    "                                  gl_LightSource[i].quadraticAttenuation * d * d );\n"
+    "        }\n"
+    "        l = normalize( l );\n"
+    "\n"
+    "        float nDotL = dot( n, l );\n"
+    "        color += attenuation * ( product.ambient + max( nDotL, 0.0 ) * product.diffuse );\n"
+    "        if ( nDotL > 0.0 )\n"
+    "        {\n"
+    "            float nDotH = max( dot( n, normalize( l + v ) ), 0.0 );\n"
+    "            specular += attenuation * pow( nDotH, shininess ) * product.specular.rgb;\n"
+    "        }\n"
+    "    }\n"
+    "\n"
+    "    color.rgb = clamp( color.rgb, 0.0, 1.0 );\n"
+    "    color.a = gl_FrontFacing ? gl_FrontMaterial.diffuse.a : gl_BackMaterial.diffuse.a;\n"
+    "\n"
+    "    if ( textured )\n"
+    "    {\n"
+    "        // The gradients are taken before the coordinates repeat, so\n"
+    "        // the mipmap level does not jump at the repeats.\n"
+    "        mat4 m = gl_TextureMatrix[0];\n"
+    "        vec2 tc = repeatInRegion ? fract( texCoord ) : texCoord;\n"
+    "        vec2 dx = ( m * vec4( dFdx( texCoord ), 0.0, 0.0 ) ).st;\n"
+    "        vec2 dy = ( m * vec4( dFdy( texCoord ), 0.0, 0.0 ) ).st;\n"
+    "        color *= textureGrad( texMap, ( m * vec4( tc, 0.0, 1.0 ) ).st, dx, dy );\n"
+    "    }\n"
+    "\n"
+    "    // Separate specular color: the specular light is added after texturing.\n"
+    "    fragColor = vec4( min( color.rgb + clamp( specular, 0.0, 1.0 ), 1.0 ), color.a );\n"
+    "}\n";
+
+
+static GLuint program = 0;
+static GLint lightEnabledLocation = -1;
+static GLint texturedLocation = -1;
+static GLint repeatInRegionLocation = -1;
+static bool active = false;
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Compile and link the program.
+// Returns 1 if successful, or 0 if GLSL 3.30 is unsupported or the program
+// fails to build, in which case the build log is printed to stderr.
+/////////////////////////////////////////////////////////////////////////////
+
+int InitPixelLighting(void)
+{
+    if (program != 0) return 1;
+    if (!HasGLSL330()) return 0;
+
+    program = BuildShaderProgram("per-pixel lighting", vertexShaderSource, fragmentShaderSource);
+    if (program == 0) return 0;
+
+    lightEnabledLocation = glGetUniformLocation(program, "lightEnabled");
+    texturedLocation = glGetUniformLocation(program, "textured");
+    repeatInRegionLocation = glGetUniformLocation(program, "repeatInRegion");
+
+    glUseProgram(program);
+    glUniform1i(glGetUniformLocation(program, "texMap"), 0);
+    glUseProgram(0);
+    return 1;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Use the program for the following draws, with the lights that are
+// enabled at the time of the call, until EndPixelLighting().
+/////////////////////////////////////////////////////////////////////////////
+
+void BeginPixelLighting(void)
+{
+    if (program == 0) return;
+    glUseProgram(program);
+
+    GLint lightEnabled[MAX_PIXEL_LIGHTS];
+    for (int i = 0; i < MAX_PIXEL_LIGHTS; i++)
+        lightEnabled[i] = glIsEnabled(GL_LIGHT0 + i);
+    glUniform1iv(lightEnabledLocation, MAX_PIXEL_LIGHTS, lightEnabled);
+    ResetMeshInstanceAttribs();
+
+    active = true;
+    SetPixelLightingTexture(false, false);
+}
+
+void EndPixelLighting(void)
+{
+    if (!active) return;
+    glUseProgram(0);
+    active = false;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Set whether the following draws are textured from texture unit 0, and
+// whether their texture coordinates repeat within [0, 1] before the
+// texture matrix is applied. Has no effect outside BeginPixelLighting()
+// and EndPixelLighting().
+/////////////////////////////////////////////////////////////////////////////
+
+void SetPixelLightingTexture(bool textured, bool repeatInRegion)
+{
+    if (!active) return;
+    glUniform1i(texturedLocation, textured ? 1 : 0);
+    glUniform1i(repeatInRegionLocation, repeatInRegion ? 1 : 0);
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Delete the program.
+/////////////////////////////////////////////////////////////////////////////
+
+void DeletePixelLighting(void)
+{
+    EndPixelLighting();
+    if (program != 0) glDeleteProgram(program);
+    program = 0;
+}
@@ -0,0 +1,62 @@
+#ifndef _PIXEL_LIGHTING_H_
+#define _PIXEL_LIGHTING_H_
+
+/////////////////////////////////////////////////////////////////////////////
+// Per-pixel lighting.
+//
+// A GLSL 3.30 program that lights each fragment with the Blinn-Phong model
+// of the fixed-function pipeline, instead of lighting the vertices and
+// interpolating the colors (Gouraud shading). Flat surfaces then need no
+// tessellation for their specular highlights to look right.
+//
+// The program reads the lights, the light model, the material and the
+// matrices from the OpenGL state, through the built-in uniforms of the
+// compatibility profile, so it matches the fixed-function lighting that is
+// set up for it: local viewer, two-sided lighting and separate specular
+// color, with the enabled lights among the first MAX_PIXEL_LIGHTS.
+// Spotlights are not supported. Texture unit 0 modulates the lit color,
+// as with GL_MODULATE. The program applies the instance matrices of
+// DrawMeshInstanced(), so it also draws instanced meshes.
+/////////////////////////////////////////////////////////////////////////////
+
+#define MAX_PIXEL_LIGHTS    2
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Compile and link the program.
+// Returns 1 if successful, or 0 if GLSL 3.30 is unsupported or the program
+// fails to build, in which case the build log is printed to stderr.
+/////////////////////////////////////////////////////////////////////////////
+
+extern int InitPixelLighting( void );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Use the program for the following draws, with the lights that are
+// enabled at the time of the call, until EndPixelLighting().
+/////////////////////////////////////////////////////////////////////////////
+
+extern void BeginPixelLighting( void );
+extern void EndPixelLighting( void );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Set whether the following draws are textured from texture unit 0, and
+// whether their texture coordinates repeat within [0, 1] before the
+// texture matrix is applied. The latter repeats a texture within its
+// region of a texture atlas, so that a single quad can tile a texture
+// that is packed into an atlas. Has no effect outside
+// BeginPixelLighting() and EndPixelLighting().
+/////////////////////////////////////////////////////////////////////////////
+
+extern void SetPixelLightingTexture( bool textured, bool repeatInRegion );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Delete the program.
+/////////////////////////////////////////////////////////////////////////////
+
+extern void DeletePixelLighting( void );
+
+
+#endif
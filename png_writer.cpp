@@ -0,0 +1,998 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PNG_HAVE_SSE2
+#include <emmintrin.h>
+#endif
+
+#include "stb_image_write.h"
+
+#include "png_writer.h"
+#include "timer.h"
+
+
+
+#define PNG_CHUNK_SIZE          (256 * 1024)    // Target filtered bytes per chunk.
+
+#define DEFLATE_WINDOW_SIZE     32768
+#define DEFLATE_MIN_MATCH       3
+#define DEFLATE_MAX_MATCH       258
+#define DEFLATE_HASH_BITS       15
+#define DEFLATE_MAX_CHAIN       32      // Max candidates tried per match search.
+
+#define ADLER32_BASE            65521u
+
+
+// Code tables of the fixed Huffman codes of deflate (RFC 1951, 3.2.6).
+// The codes are stored bit-reversed, ready to be written LSB-first.
+struct DeflateTables
+{
+    uint16_t literalCode[288];
+    uint8_t literalBits[288];
+    uint8_t distanceCode[30];
+
+    uint8_t lengthSymbol[DEFLATE_MAX_MATCH + 1];    // Length code index of each match length.
+    uint16_t lengthBase[29];
+    uint8_t lengthExtraBits[29];
+    uint16_t distanceBase[30];
+    uint8_t distanceExtraBits[30];
+    uint8_t distanceSymbol[512];    // For distances 1-256, then by (distance - 1) >> 7.
+
+    uint32_t crc32[256];
+
+    DeflateTables()
+    {
+        for (int i = 0; i < 288; i++) {
+            int code, bits;
+            if (i < 144)      { code = 0x30 + i;          bits = 8; }
+            else if (i < 256) { code = 0x190 + i - 144;   bits = 9; }
+            else if (i < 280) { code = i - 256;           bits = 7; }
+            else              { code = 0xc0 + i - 280;    bits = 8; }
+            literalCode[i] = (uint16_t) ReverseBits(code, bits);
+            literalBits[i] = (uint8_t) bits;
+        }
+        for (int i = 0; i < 30; i++) distanceCode[i] = (uint8_t) ReverseBits(i, 5);
+
+        int length = 3;
+        for (int i = 0; i < 28; i++) {
+            lengthExtraBits[i] = (uint8_t) ((i < 8) ? 0 : (i - 4) / 4);
+            lengthBase[i] = (uint16_t) length;
+            for (int j = 0; j < (1 << lengthExtraBits[i]); j++) lengthSymbol[length++] = (uint8_t) i;
+        }
+        lengthExtraBits[28] = 0;
+        lengthBase[28] = DEFLATE_MAX_MATCH;
+        lengthSymbol[DEFLATE_MAX_MATCH] = 28;
+
+        int distance = 1;
+        for (int i = 0; i < 30; i++) {
+            distanceExtraBits[i] = (uint8_t) ((i < 4) ? 0 : (i - 2) / 2);
+            distanceBase[i] = (uint16_t) distance;
+            distance += 1 << distanceExtraBits[i];
+        }
+        for (int d = 1; d <= 256; d++) distanceSymbol[d - 1] = (uint8_t) SlowDistanceSymbol(d);
+        for (int k = 2; k < 256; k++) distanceSymbol[256 + k] = (uint8_t) SlowDistanceSymbol((k << 7) + 1);
+
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+            crc32[i] = c;
+        }
+    }
+
+    static int ReverseBits(int code, int bits)
+    {
+        int reversed = 0;
+        for (int i = 0; i < bits; i++) reversed |= ((code >> i) & 1) << (bits - 1 - i);
+        return reversed;
+    }
+
+    int SlowDistanceSymbol(int distance) const
+    {
+        int symbol = 0;
+        while (symbol < 29 && distanceBase[symbol + 1] <= distance) symbol++;
+        return symbol;
+    }
+
+    int DistanceSymbol(int distance) const
+    {
+        return (distance <= 256) ? distanceSymbol[distance - 1] : distanceSymbol[256 + ((distance - 1) >> 7)];
+    }
+};
+
+static const DeflateTables &GetDeflateTables()
+{
+    static const DeflateTables tables;    // Initialized once, thread-safely.
+    return tables;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Checksums.
+/////////////////////////////////////////////////////////////////////////////
+
+// Update a running CRC-32, which starts at 0xffffffff and is inverted at the end.
+static uint32_t UpdateCRC32(uint32_t crc, const uchar *data, size_t size)
+{
+    const uint32_t *table = GetDeflateTables().crc32;
+    for (size_t i = 0; i < size; i++) crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    return crc;
+}
+
+
+static uint32_t ComputeAdler32(const uchar *data, size_t size)
+{
+    uint32_t a = 1, b = 0;
+    while (size > 0) {
+        size_t n = (size < 5552) ? size : 5552;     // Largest n that cannot overflow b.
+        size -= n;
+        while (n-- > 0) {
+            a += *data++;
+            b += a;
+        }
+        a %= ADLER32_BASE;
+        b %= ADLER32_BASE;
+    }
+    return (b << 16) | a;
+}
+
+
+// Returns the Adler-32 of the concatenation of two byte sequences, from
+// their checksums and the length of the second one (as zlib's adler32_combine).
+static uint32_t CombineAdler32(uint32_t adler1, uint32_t adler2, size_t size2)
+{
+    uint32_t rem = (uint32_t) (size2 % ADLER32_BASE);
+    uint32_t sum1 = adler1 & 0xffff;
+    uint32_t sum2 = (uint32_t) (((uint64_t) rem * sum1) % ADLER32_BASE);
+    sum1 += (adler2 & 0xffff) + ADLER32_BASE - 1;
+    sum2 += ((adler1 >> 16) & 0xffff) + ((adler2 >> 16) & 0xffff) + ADLER32_BASE - rem;
+    if (sum1 >= ADLER32_BASE) sum1 -= ADLER32_BASE;
+    if (sum1 >= ADLER32_BASE) sum1 -= ADLER32_BASE;
+    if (sum2 >= 2 * ADLER32_BASE) sum2 -= 2 * ADLER32_BASE;
+    if (sum2 >= ADLER32_BASE) sum2 -= ADLER32_BASE;
+    return sum1 | (sum2 << 16);
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Deflate compressor with fixed Huffman codes and hash-chain LZ77 matching.
+/////////////////////////////////////////////////////////////////////////////
+
+struct BitWriter
+{
+    std::vector<uchar> *out;
+    uint32_t bitBuffer;
+    int numBits;
+};
+
+static inline void PutBits(BitWriter *writer, uint32_t bits, int numBits)
+{
+    writer->bitBuffer |= bits << writer->numBits;
+    writer->numBits += numBits;
+    while (writer->numBits >= 8) {
+        writer->out->push_back((uchar) writer->bitBuffer);
+        writer->bitBuffer >>= 8;
+        writer->numBits -= 8;
+    }
+}
+
+static inline void AlignToByte(BitWriter *writer)
+{
+    if (writer->numBits > 0) PutBits(writer, 0, 8 - writer->numBits);
+}
+
+static inline uint32_t HashBytes(const uchar *p)
+{
+    uint32_t v = p[0] | (p[1] << 8) | (p[2] << 16);
+    return (v * 2654435761u) >> (32 - DEFLATE_HASH_BITS);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Compress data[dictSize, dictSize + size) as one fixed-Huffman block and
+// append it to out. The dictSize bytes before it, which must be at most
+// DEFLATE_WINDOW_SIZE, are only used as the LZ77 dictionary.
+// If last is false, the block is not marked final and is followed by an
+// empty stored block, so that the output ends on a byte boundary and the
+// next chunk's blocks can be appended to it.
+/////////////////////////////////////////////////////////////////////////////
+
+static void DeflateChunk(const uchar *data, size_t dictSize, size_t size, bool last,
+                         std::vector<uchar> *out)
+{
+    const DeflateTables &tables = GetDeflateTables();
+    const int end = (int) (dictSize + size);
+
+    std::vector<int> head(1 << DEFLATE_HASH_BITS, -1);
+    std::vector<int> prev(end);
+
+    BitWriter writer = { out, 0, 0 };
+    PutBits(&writer, last ? 1 : 0, 1);  // BFINAL
+    PutBits(&writer, 1, 2);             // BTYPE: fixed Huffman codes.
+
+    for (int pos = 0; pos + DEFLATE_MIN_MATCH <= (int) dictSize; pos++) {
+        uint32_t h = HashBytes(data + pos);
+        prev[pos] = head[h];
+        head[h] = pos;
+    }
+
+    int pos = (int) dictSize;
+    while (pos < end) {
+        int bestLength = 0, bestDistance = 0;
+
+        if (pos + DEFLATE_MIN_MATCH <= end) {
+            const int maxLength = std::min(DEFLATE_MAX_MATCH, end - pos);
+            const uchar *cur = data + pos;
+            uint32_t h = HashBytes(cur);
+            int candidate = head[h];
+
+            for (int chain = 0; candidate >= 0 && chain < DEFLATE_MAX_CHAIN; chain++) {
+                if (pos - candidate > DEFLATE_WINDOW_SIZE) break;
+                const uchar *match = data + candidate;
+                if (match[bestLength] == cur[bestLength]) {
+                    int length = 0;
+                    while (length < maxLength && match[length] == cur[length]) length++;
+                    if (length > bestLength) {
+                        bestLength = length;
+                        bestDistance = pos - candidate;
+                        if (length == maxLength) break;
+                    }
+                }
+                candidate = prev[candidate];
+            }
+            prev[pos] = head[h];
+            head[h] = pos;
+        }
+
+        if (bestLength >= DEFLATE_MIN_MATCH) {
+            int ls = tables.lengthSymbol[bestLength];
+            PutBits(&writer, tables.literalCode[257 + ls], tables.literalBits[257 + ls]);
+            PutBits(&writer, bestLength - tables.lengthBase[ls], tables.lengthExtraBits[ls]);
+            int ds = tables.DistanceSymbol(bestDistance);
+            PutBits(&writer, tables.distanceCode[ds], 5);
+            PutBits(&writer, bestDistance - tables.distanceBase[ds], tables.distanceExtraBits[ds]);
+
+            // Add the positions inside the match to the hash chains.
+            for (int i = pos + 1; i < pos + bestLength && i + DEFLATE_MIN_MATCH <= end; i++) {
+                uint32_t h = HashBytes(data + i);
+                prev[i] = head[h];
+                head[h] = i;
+            }
+            pos += bestLength;
+        }
+        else {
+            PutBits(&writer, tables.literalCode[data[pos]], tables.literalBits[data[pos]]);
+            pos++;
+        }
+    }
+    PutBits(&writer, tables.literalCode[256], tables.literalBits[256]);    // End of block.
+
+    if (!last) {
+        PutBits(&writer, 0, 3);     // Empty stored block, not final.
+        AlignToByte(&writer);
+        PutBits(&writer, 0x0000, 16);
+        PutBits(&writer, 0xffff, 16);
+    }
+    AlignToByte(&writer);
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// PNG row filters.
+/////////////////////////////////////////////////////////////////////////////
+
+static inline int PaethPredictor(int a, int b, int c)
+{
+    int pa = abs(b - c), pb = abs(a - c), pc = abs(a + b - 2 * c);
+    if (pa <= pb && pa <= pc) return a;
+    return (pb <= pc) ? b : c;
+}
+
+
+// Compute the filtered bytes [i0, i1) of the row with each of the filters
+// Sub, Up, Average and Paeth into filtered[0..3], and add the sums of the
+// absolute values of the filtered bytes, taken as signed, to cost[0..4]
+// (cost[0] is for no filter).
+static void FilterBytesScalar(const uchar *row, const uchar *prevRow, int bpp, int i0, int i1,
+                              uchar *filtered[4], uint64_t cost[5])
+{
+    for (int i = i0; i < i1; i++) {
+        int x = row[i], b = prevRow[i];
+        int a = (i >= bpp) ? row[i - bpp] : 0;
+        int c = (i >= bpp) ? prevRow[i - bpp] : 0;
+
+        uchar f0 = (uchar) x;
+        uchar f1 = (uchar) (x - a);
+        uchar f2 = (uchar) (x - b);
+        uchar f3 = (uchar) (x - ((a + b) >> 1));
+        uchar f4 = (uchar) (x - PaethPredictor(a, b, c));
+        filtered[0][i] = f1;
+        filtered[1][i] = f2;
+        filtered[2][i] = f3;
+        filtered[3][i] = f4;
+
+        cost[0] += abs((signed char) f0);
+        cost[1] += abs((signed char) f1);
+        cost[2] += abs((signed char) f2);
+        cost[3] += abs((signed char) f3);
+        cost[4] += abs((signed char) f4);
+    }
+}
+
+
+#ifdef PNG_HAVE_SSE2
+// Sum of the absolute values of the 16 bytes taken as signed, in two 64-bit lanes.
+static inline __m128i SumAbsSigned(__m128i v)
+{
+    __m128i absV = _mm_min_epu8(v, _mm_sub_epi8(_mm_setzero_si128(), v));
+    return _mm_sad_epu8(absV, _mm_setzero_si128());
+}
+
+
+// Paeth predictor of 8 pixels' bytes in 16-bit lanes.
+static inline __m128i PaethPredictor16(__m128i a, __m128i b, __m128i c)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i bc = _mm_sub_epi16(b, c);
+    __m128i ac = _mm_sub_epi16(a, c);
+    __m128i pa = _mm_max_epi16(bc, _mm_sub_epi16(zero, bc));
+    __m128i pb = _mm_max_epi16(ac, _mm_sub_epi16(zero, ac));
+    __m128i abc = _mm_add_epi16(bc, ac);
+    __m128i pc = _mm_max_epi16(abc, _mm_sub_epi16(zero, abc));
+
+    __m128i useA = _mm_andnot_si128(_mm_or_si128(_mm_cmpgt_epi16(pa, pb), _mm_cmpgt_epi16(pa, pc)),
+                                    _mm_set1_epi16(-1));
+    __m128i useB = _mm_andnot_si128(useA, _mm_andnot_si128(_mm_cmpgt_epi16(pb, pc), _mm_set1_epi16(-1)));
+    __m128i useC = _mm_andnot_si128(_mm_or_si128(useA, useB), _mm_set1_epi16(-1));
+
+    return _mm_or_si128(_mm_or_si128(_mm_and_si128(useA, a), _mm_and_si128(useB, b)),
+                        _mm_and_si128(useC, c));
+}
+
+
+// SSE2 version of FilterBytesScalar() for i0 >= bpp, 16 bytes at a time.
+// Returns the index of the first byte that has not been filtered.
+static int FilterBytesSSE2(const uchar *row, const uchar *prevRow, int bpp, int i0, int i1,
+                           uchar *filtered[4], uint64_t cost[5])
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi8(1);
+    __m128i sum[5];
+    for (int f = 0; f < 5; f++) sum[f] = zero;
+
+    int i = i0;
+    for (; i + 16 <= i1; i += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i *) (row + i));
+        __m128i a = _mm_loadu_si128((const __m128i *) (row + i - bpp));
+        __m128i b = _mm_loadu_si128((const __m128i *) (prevRow + i));
+        __m128i c = _mm_loadu_si128((const __m128i *) (prevRow + i - bpp));
+
+        // floor((a + b) / 2), from the rounded-up average.
+        __m128i avg = _mm_sub_epi8(_mm_avg_epu8(a, b), _mm_and_si128(_mm_xor_si128(a, b), one));
+
+        __m128i paethLo = PaethPredictor16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero),
+                                           _mm_unpacklo_epi8(c, zero));
+        __m128i paethHi = PaethPredictor16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero),
+                                           _mm_unpackhi_epi8(c, zero));
+        __m128i paeth = _mm_packus_epi16(paethLo, paethHi);
+
+        __m128i f1 = _mm_sub_epi8(x, a);
+        __m128i f2 = _mm_sub_epi8(x, b);
+        __m128i f3 = _mm_sub_epi8(x, avg);
+        __m128i f4 = _mm_sub_epi8(x, paeth);
+        _mm_storeu_si128((__m128i *) (filtered[0] + i), f1);
+        _mm_storeu_si128((__m128i *) (filtered[1] + i), f2);
+        _mm_storeu_si128((__m128i *) (filtered[2] + i), f3);
+        _mm_storeu_si128((__m128i *) (filtered[3] + i), f4);
+
+        sum[0] = _mm_add_epi64(sum[0], SumAbsSigned(x));
+        sum[1] = _mm_add_epi64(sum[1], SumAbsSigned(f1));
+        sum[2] = _mm_add_epi64(sum[2], SumAbsSigned(f2));
+        sum[3] = _mm_add_epi64(sum[3], SumAbsSigned(f3));
+        sum[4] = _mm_add_epi64(sum[4], SumAbsSigned(f4));
+    }
+
+    for (int f = 0; f < 5; f++) {
+        uint64_t lanes[2];
+        _mm_storeu_si128((__m128i *) lanes, sum[f]);
+        cost[f] += lanes[0] + lanes[1];
+    }
+    return i;
+}
+#endif
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Filter one row of rowBytes bytes into out, which receives the filter type
+// byte followed by the filtered row. prevRow is the unfiltered row above it,
+// which is all zeros for the first row of the image. If prevRow is NULL,
+// the row above is unknown, and only the filters that do not use it (None
+// and Sub) are considered. scratch must hold 4 * rowBytes bytes.
+/////////////////////////////////////////////////////////////////////////////
+
+static void FilterRow(const uchar *row, const uchar *prevRow, int rowBytes, int bpp,
+                      uchar *out, uchar *scratch, const uchar *zeroRow)
+{
+    uchar *filtered[4] = { scratch, scratch + rowBytes, scratch + 2 * rowBytes, scratch + 3 * rowBytes };
+    uint64_t cost[5] = { 0, 0, 0, 0, 0 };
+    int numFilters = (prevRow != NULL) ? 5 : 2;
+    if (prevRow == NULL) prevRow = zeroRow;
+
+    int i = std::min(bpp, rowBytes);
+    FilterBytesScalar(row, prevRow, bpp, 0, i, filtered, cost);
+#ifdef PNG_HAVE_SSE2
+    i = FilterBytesSSE2(row, prevRow, bpp, i, rowBytes, filtered, cost);
+#endif
+    FilterBytesScalar(row, prevRow, bpp, i, rowBytes, filtered, cost);
+
+    int best = 0;
+    for (int f = 1; f < numFilters; f++) {
+        if (cost[f] < cost[best]) best = f;
+    }
+
+    out[0] = (uchar) best;
+    memcpy(out + 1, (best == 0) ? row : filtered[best - 1], rowBytes);
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Parallel encoding of a band of rows.
+/////////////////////////////////////////////////////////////////////////////
+
+// A band of consecutive rows of the image, which is encoded as a whole.
+struct PNGBand
+{
+    const uchar *imageData;     // The band's rows, with the bottom row first.
+    int imageWidth, numRows, numComponents;
+    const uchar *rowAbove;      // The unfiltered row above the band's top row,
+                                // all zeros at the top of the image, or NULL if unknown.
+};
+
+
+// A range of rows of a band that is filtered and compressed independently.
+struct PNGChunk
+{
+    int firstRow, numRows;      // Rows in PNG order, from the top of the band.
+    std::vector<uchar> data;    // Compressed data.
+    uint32_t adler;             // Adler-32 of the filtered rows of this chunk.
+    uint32_t crc;               // Running CRC-32 of "IDAT" and data.
+};
+
+
+// Returns the unfiltered row of the band, counted from the top.
+static inline const uchar *GetPNGRow(const PNGBand *band, int row)
+{
+    size_t rowBytes = (size_t) band->imageWidth * band->numComponents;
+    return band->imageData + (size_t) (band->numRows - 1 - row) * rowBytes;
+}
+
+
+// Filter and compress one chunk of the band. If zlibHeader is true, the
+// zlib stream header is put in front of the compressed data. If finalBlock
+// is true, the compressed data ends the deflate stream.
+static void EncodeChunk(const PNGBand *band, PNGChunk *chunk, bool zlibHeader, bool finalBlock)
+{
+    const int rowBytes = band->imageWidth * band->numComponents;
+    const size_t filteredRowBytes = (size_t) rowBytes + 1;
+
+    // The chunk's dictionary is the end of the chunk before it, so the
+    // rows that it comes from are filtered again here.
+    int numDictRows = (int) ((DEFLATE_WINDOW_SIZE + filteredRowBytes - 1) / filteredRowBytes);
+    numDictRows = std::min(numDictRows, chunk->firstRow);
+    int row0 = chunk->firstRow - numDictRows;
+    int numRows = numDictRows + chunk->numRows;
+
+    std::vector<uchar> filtered(numRows * filteredRowBytes);
+    std::vector<uchar> scratch(4 * (size_t) rowBytes);
+    std::vector<uchar> zeroRow(rowBytes, 0);
+
+    for (int r = 0; r < numRows; r++) {
+        int row = row0 + r;
+        const uchar *prevRow = (row == 0) ? band->rowAbove : GetPNGRow(band, row - 1);
+        FilterRow(GetPNGRow(band, row), prevRow, rowBytes, band->numComponents,
+                  filtered.data() + r * filteredRowBytes, scratch.data(), zeroRow.data());
+    }
+
+    size_t dictBytes = std::min((size_t) numDictRows * filteredRowBytes, (size_t) DEFLATE_WINDOW_SIZE);
+    size_t dictStart = numDictRows * filteredRowBytes - dictBytes;
+    size_t chunkBytes = chunk->numRows * filteredRowBytes;
+
+    chunk->adler = ComputeAdler32(filtered.data() + numDictRows * filteredRowBytes, chunkBytes);
+
+    chunk->data.clear();
+    chunk->data.reserve(chunkBytes / 2);
+    if (zlibHeader) {
+        chunk->data.push_back(0x78);    // Deflate with a 32 KB window.
+        chunk->data.push_back(0x5e);
+    }
+    DeflateChunk(filtered.data() + dictStart, dictBytes, chunkBytes, finalBlock, &chunk->data);
+
+    chunk->crc = UpdateCRC32(0xffffffffu, (const uchar *) "IDAT", 4);
+    chunk->crc = UpdateCRC32(chunk->crc, chunk->data.data(), chunk->data.size());
+}
+
+
+struct EncodeJobs
+{
+    const PNGBand *band;
+    std::vector<PNGChunk> *chunks;
+    bool zlibHeader, finalBlock;
+    std::atomic<int> nextChunk;
+};
+
+static void EncodeWorker(EncodeJobs *jobs)
+{
+    const int numChunks = (int) jobs->chunks->size();
+    for (;;) {
+        int index = jobs->nextChunk.fetch_add(1);
+        if (index >= numChunks) return;
+        EncodeChunk(jobs->band, &(*jobs->chunks)[index],
+                    jobs->zlibHeader && index == 0, jobs->finalBlock && index == numChunks - 1);
+    }
+}
+
+
+// Split the band into chunks and encode them with numThreads worker threads.
+// Returns the Adler-32 of all the filtered rows of the band.
+static uint32_t EncodeBand(const PNGBand *band, bool zlibHeader, bool finalBlock, int numThreads,
+                           std::vector<PNGChunk> *chunks)
+{
+    size_t filteredRowBytes = (size_t) band->imageWidth * band->numComponents + 1;
+    int rowsPerChunk = (int) std::max((size_t) 1, PNG_CHUNK_SIZE / filteredRowBytes);
+    int numChunks = (band->numRows + rowsPerChunk - 1) / rowsPerChunk;
+
+    chunks->resize(numChunks);
+    for (int i = 0; i < numChunks; i++) {
+        (*chunks)[i].firstRow = i * rowsPerChunk;
+        (*chunks)[i].numRows = std::min(rowsPerChunk, band->numRows - (*chunks)[i].firstRow);
+    }
+
+    if (numThreads <= 0) numThreads = (int) std::thread::hardware_concurrency();
+    if (numThreads > numChunks) numThreads = numChunks;
+
+    EncodeJobs jobs;
+    jobs.band = band;
+    jobs.chunks = chunks;
+    jobs.zlibHeader = zlibHeader;
+    jobs.finalBlock = finalBlock;
+    jobs.nextChunk = 0;
+
+    if (numThreads <= 1) {
+        EncodeWorker(&jobs);
+    }
+    else {
+        std::vector<std::thread> workers;
+        for (int i = 0; i < numThreads; i++) workers.push_back(std::thread(EncodeWorker, &jobs));
+        for (size_t i = 0; i < workers.size(); i++) workers[i].join();
+    }
+
+    uint32_t adler = (*chunks)[0].adler;
+    for (int i = 1; i < numChunks; i++)
+        adler = CombineAdler32(adler, (*chunks)[i].adler, (*chunks)[i].numRows * filteredRowBytes);
+    return adler;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// File output.
+/////////////////////////////////////////////////////////////////////////////
+
+static void PutUint32BE(uchar *p, uint32_t v)
+{
+    p[0] = (uchar) (v >> 24);
+    p[1] = (uchar) (v >> 16);
+    p[2] = (uchar) (v >> 8);
+    p[3] = (uchar) v;
+}
+
+
+// Write a PNG chunk whose data is split into two parts; part2 may be empty.
+// crc is the running CRC-32 of the chunk type and part1.
+static int WritePNGChunk(FILE *fp, const char *type, const uchar *part1, size_t size1,
+                         const uchar *part2, size_t size2, uint32_t crc)
+{
+    uchar header[8], trailer[4];
+    PutUint32BE(header, (uint32_t) (size1 + size2));
+    memcpy(header + 4, type, 4);
+    crc = UpdateCRC32(crc, part2, size2);
+    PutUint32BE(trailer, crc ^ 0xffffffffu);
+
+    return fwrite(header, 1, 8, fp) == 8 &&
+           fwrite(part1, 1, size1, fp) == size1 &&
+           fwrite(part2, 1, size2, fp) == size2 &&
+           fwrite(trailer, 1, 4, fp) == 4;
+}
+
+
+// Write a PNG chunk whose data and CRC have been computed beforehand.
+static int WritePNGChunk(FILE *fp, const char *type, const uchar *data, size_t size)
+{
+    uint32_t crc = UpdateCRC32(0xffffffffu, (const uchar *) type, 4);
+    return WritePNGChunk(fp, type, data, size, NULL, 0, UpdateCRC32(crc, data, size));
+}
+
+
+// Write the PNG signature and the IHDR chunk.
+static int WritePNGHeader(FILE *fp, int imageWidth, int imageHeight, int numComponents)
+{
+    static const uchar signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+    static const uchar colorTypes[5] = { 0, 0, 4, 2, 6 };   // By number of components.
+
+    uchar ihdr[13];
+    PutUint32BE(ihdr, imageWidth);
+    PutUint32BE(ihdr + 4, imageHeight);
+    ihdr[8] = 8;                                // Bit depth.
+    ihdr[9] = colorTypes[numComponents];
+    ihdr[10] = ihdr[11] = ihdr[12] = 0;         // Deflate, adaptive filtering, no interlace.
+
+    return fwrite(signature, 1, 8, fp) == 8 && WritePNGChunk(fp, "IHDR", ihdr, 13);
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Save an image to the output filename in PNG format, encoding it with
+// numThreads worker threads. If numThreads is 0, one thread per hardware
+// core is used. If numThreads is 1, the image is encoded on the calling
+// thread.
+// Returns 1 if successful or 0 if unsuccessful.
+/////////////////////////////////////////////////////////////////////////////
+
+int WritePNGFile(const char *filename, const uchar *imageData,
+                 int imageWidth, int imageHeight, int numComponents, int numThreads)
+{
+    if (imageWidth <= 0 || imageHeight <= 0 || numComponents < 1 || numComponents > 4) {
+        fprintf(stderr, "Error: Cannot write image file %s.\n", filename);
+        return 0;
+    }
+
+    std::vector<uchar> zeroRow((size_t) imageWidth * numComponents, 0);
+    PNGBand band = { imageData, imageWidth, imageHeight, numComponents, zeroRow.data() };
+
+    std::vector<PNGChunk> chunks;
+    uchar adlerBytes[4];
+    PutUint32BE(adlerBytes, EncodeBand(&band, true, true, numThreads, &chunks));
+
+    FILE *fp = fopen(filename, "wb");
+    int success = (fp != NULL) && WritePNGHeader(fp, imageWidth, imageHeight, numComponents);
+
+    // The Adler-32 of the whole stream goes at the end of the last IDAT chunk.
+    for (size_t i = 0; success && i < chunks.size(); i++) {
+        bool last = (i == chunks.size() - 1);
+        success = WritePNGChunk(fp, "IDAT", chunks[i].data.data(), chunks[i].data.size(),
+                                adlerBytes, last ? 4 : 0, chunks[i].crc);
+    }
+    if (success) success = WritePNGChunk(fp, "IEND", NULL, 0);
+    if (fp != NULL && fclose(fp) != 0) success = 0;
+
+    if (!success) {
+        fprintf(stderr, "Error: Cannot write image file %s.\n", filename);
+        return 0;
+    }
+    return 1;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Streaming writer.
+/////////////////////////////////////////////////////////////////////////////
+
+// A compressed band kept in the spill file until the bands above it
+// have been written.
+struct SpilledBand
+{
+    int numRows;
+    long offset;                        // Position in the spill file.
+    std::vector<size_t> chunkSizes;
+    std::vector<uint32_t> chunkCRCs;
+    uint32_t adler;
+};
+
+
+struct PNGStreamWriter
+{
+    FILE *fp;
+    std::string filename;
+    int imageWidth, imageHeight, numComponents;
+    int numThreads;
+    int success;
+
+    int nextRow;        // Next PNG row to be written, counted from the top.
+    uint32_t adler;     // Adler-32 of the filtered rows written so far.
+
+    FILE *spillFile;                            // Created when first needed.
+    std::map<int, SpilledBand> spilledBands;    // By first PNG row.
+
+    // The unfiltered bottom row of each band received, by the PNG row below it.
+    std::map<int, std::vector<uchar> > bottomRows;
+};
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Start writing a PNG file of the given size band by band.
+// Returns NULL if the file cannot be created.
+/////////////////////////////////////////////////////////////////////////////
+
+PNGStreamWriter *BeginPNGStream(const char *filename, int imageWidth, int imageHeight,
+                                int numComponents, int numThreads)
+{
+    FILE *fp = NULL;
+    if (imageWidth > 0 && imageHeight > 0 && numComponents >= 1 && numComponents <= 4)
+        fp = fopen(filename, "wb");
+
+    static const uchar zlibHeader[2] = { 0x78, 0x5e };
+    if (fp == NULL || !WritePNGHeader(fp, imageWidth, imageHeight, numComponents) ||
+        !WritePNGChunk(fp, "IDAT", zlibHeader, 2)) {
+        fprintf(stderr, "Error: Cannot write image file %s.\n", filename);
+        if (fp != NULL) {
+            fclose(fp);
+            remove(filename);
+        }
+        return NULL;
+    }
+
+    PNGStreamWriter *writer = new PNGStreamWriter;
+    writer->fp = fp;
+    writer->filename = filename;
+    writer->imageWidth = imageWidth;
+    writer->imageHeight = imageHeight;
+    writer->numComponents = numComponents;
+    writer->numThreads = numThreads;
+    writer->success = 1;
+    writer->nextRow = 0;
+    writer->adler = 1;      // Adler-32 of no data.
+    writer->spillFile = NULL;
+    return writer;
+}
+
+
+
+// Write the compressed chunks of the band at writer->nextRow, reading them
+// from the spill file if chunks is NULL.
+static int WriteBandChunks(PNGStreamWriter *writer, const SpilledBand &band,
+                           const std::vector<PNGChunk> *chunks)
+{
+    size_t filteredRowBytes = (size_t) writer->imageWidth * writer->numComponents + 1;
+    writer->adler = CombineAdler32(writer->adler, band.adler, band.numRows * filteredRowBytes);
+    writer->nextRow += band.numRows;
+
+    if (chunks != NULL) {
+        for (size_t i = 0; i < chunks->size(); i++) {
+            const PNGChunk &chunk = (*chunks)[i];
+            if (!WritePNGChunk(writer->fp, "IDAT", chunk.data.data(), chunk.data.size(), NULL, 0, chunk.crc))
+                return 0;
+        }
+        return 1;
+    }
+
+    std::vector<uchar> data;
+    if (fseek(writer->spillFile, band.offset, SEEK_SET) != 0) return 0;
+    for (size_t i = 0; i < band.chunkSizes.size(); i++) {
+        data.resize(band.chunkSizes[i]);
+        if (fread(data.data(), 1, data.size(), writer->spillFile) != data.size()) return 0;
+        if (!WritePNGChunk(writer->fp, "IDAT", data.data(), data.size(), NULL, 0, band.chunkCRCs[i])) return 0;
+    }
+    return 1;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Write the numRows rows of the image starting at row firstRow, counted
+// from the bottom as in the rest of image_io, with the bottom row first.
+// Returns 1 if successful or 0 if unsuccessful.
+/////////////////////////////////////////////////////////////////////////////
+
+int WritePNGStreamBand(PNGStreamWriter *writer, int firstRow, int numRows, const uchar *bandData)
+{
+    if (!writer->success) return 0;
+
+    const size_t rowBytes = (size_t) writer->imageWidth * writer->numComponents;
+    const int pngFirstRow = writer->imageHeight - (firstRow + numRows);
+    const int pngEndRow = pngFirstRow + numRows;
+
+    // The band must not overlap the rows written or received so far.
+    std::map<int, SpilledBand>::iterator next = writer->spilledBands.lower_bound(pngFirstRow);
+    bool overlaps = (next != writer->spilledBands.end() && next->first < pngEndRow);
+    if (next != writer->spilledBands.begin()) {
+        std::map<int, SpilledBand>::iterator prev = next;
+        --prev;
+        if (prev->first + prev->second.numRows > pngFirstRow) overlaps = true;
+    }
+    if (numRows <= 0 || firstRow < 0 || pngFirstRow < writer->nextRow || overlaps) {
+        fprintf(stderr, "Error: Invalid band of rows %d to %d for image file %s.\n",
+                firstRow, firstRow + numRows - 1, writer->filename.c_str());
+        writer->success = 0;
+        return 0;
+    }
+
+    // Use the row above the band for filtering if it has been received.
+    std::vector<uchar> rowAbove;
+    std::map<int, std::vector<uchar> >::iterator above = writer->bottomRows.find(pngFirstRow);
+    if (above != writer->bottomRows.end()) {
+        rowAbove.swap(above->second);
+        writer->bottomRows.erase(above);
+    }
+    else if (pngFirstRow == 0) rowAbove.assign(rowBytes, 0);
+
+    writer->bottomRows[pngEndRow].assign(bandData, bandData + rowBytes);
+
+    PNGBand band = { bandData, writer->imageWidth, numRows, writer->numComponents,
+                     rowAbove.empty() ? NULL : rowAbove.data() };
+    std::vector<PNGChunk> chunks;
+
+    SpilledBand encoded;
+    encoded.numRows = numRows;
+    encoded.adler = EncodeBand(&band, false, false, writer->numThreads, &chunks);
+
+    if (pngFirstRow == writer->nextRow) {
+        // Write the band, then the spilled bands that now follow on from it.
+        int success = WriteBandChunks(writer, encoded, &chunks);
+        std::map<int, SpilledBand>::iterator spilled;
+        while (success && (spilled = writer->spilledBands.find(writer->nextRow)) != writer->spilledBands.end()) {
+            success = WriteBandChunks(writer, spilled->second, NULL);
+            writer->spilledBands.erase(spilled);
+        }
+        if (!success) {
+            fprintf(stderr, "Error: Cannot write image file %s.\n", writer->filename.c_str());
+            writer->success = 0;
+        }
+        return writer->success;
+    }
+
+    // Spill the band until the bands above it have been written.
+    if (writer->spillFile == NULL) writer->spillFile = tmpfile();
+    int success = (writer->spillFile != NULL) && fseek(writer->spillFile, 0, SEEK_END) == 0;
+    if (success) encoded.offset = ftell(writer->spillFile);
+    for (size_t i = 0; success && i < chunks.size(); i++) {
+        success = fwrite(chunks[i].data.data(), 1, chunks[i].data.size(), writer->spillFile) == chunks[i].data.size();
+        encoded.chunkSizes.push_back(chunks[i].data.size());
+        encoded.chunkCRCs.push_back(chunks[i].crc);
+    }
+    if (!success) {
+        fprintf(stderr, "Error: Cannot write temporary file for image file %s.\n", writer->filename.c_str());
+        writer->success = 0;
+        return 0;
+    }
+    writer->spilledBands[pngFirstRow] = encoded;
+    return 1;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Finish the PNG file and destroy the writer.
+// Returns 1 if successful, or 0 if any write failed or if any row of the
+// image has not been written, in which case the file is deleted.
+/////////////////////////////////////////////////////////////////////////////
+
+int EndPNGStream(PNGStreamWriter *writer)
+{
+    if (writer->success && writer->nextRow != writer->imageHeight) {
+        fprintf(stderr, "Error: Rows missing from image file %s.\n", writer->filename.c_str());
+        writer->success = 0;
+    }
+    int success = writer->success;
+
+    // An empty final block ends the deflate stream, followed by the Adler-32.
+    uchar trailer[6] = { 0x03, 0x00 };
+    PutUint32BE(trailer + 2, writer->adler);
+    if (success) success = WritePNGChunk(writer->fp, "IDAT", trailer, 6) && WritePNGChunk(writer->fp, "IEND", NULL, 0);
+    if (fclose(writer->fp) != 0) success = 0;
+    if (writer->spillFile != NULL) fclose(writer->spillFile);
+
+    if (!success) {
+        if (writer->success) fprintf(stderr, "Error: Cannot write image file %s.\n", writer->filename.c_str());
+        remove(writer->filename.c_str());
+    }
+    delete writer;
+    return success;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Measure the throughput of WritePNGFile() with different numbers of
+// threads, and of stb_image_write, at several image resolutions, and print
+// the results. The test images are tiled from the input image file.
+/////////////////////////////////////////////////////////////////////////////
+
+void BenchmarkPNGWriter(const char *sourceFilename)
+{
+    const int numRuns = 3;
+    const int resolutions[][2] = { { 800, 600 }, { 1920, 1080 }, { 3840, 2160 }, { 7680, 4320 } };
+    const int numResolutions = sizeof(resolutions) / sizeof(resolutions[0]);
+    const char *outFilename = "png_writer_bench.png";
+
+    uchar *source;
+    int sourceWidth, sourceHeight, sourceComponents;
+    if (!ReadImageFile(sourceFilename, &source, &sourceWidth, &sourceHeight, &sourceComponents)) return;
+
+    // Thread counts: 1, 2, 4, ... and the number of hardware cores.
+    int maxThreads = std::max(1, (int) std::thread::hardware_concurrency());
+    std::vector<int> threadCounts;
+    for (int t = 1; t < maxThreads; t *= 2) threadCounts.push_back(t);
+    threadCounts.push_back(maxThreads);
+
+    printf("RGB images tiled from %s. Best of %d runs, in MB/s of raw pixels.\n\n", sourceFilename, numRuns);
+    printf("%-11s %10s", "size", "stb");
+    for (size_t t = 0; t < threadCounts.size(); t++) printf(" %7d thr", threadCounts[t]);
+    printf(" %12s %12s %6s\n", "stb bytes", "our bytes", "check");
+
+    for (int r = 0; r < numResolutions; r++) {
+        const int w = resolutions[r][0], h = resolutions[r][1];
+        std::vector<uchar> image((size_t) w * h * 3);
+        for (int y = 0; y < h; y++) {
+            for (int x = 0; x < w; x++) {
+                const uchar *s = source + ((size_t) (y % sourceHeight) * sourceWidth + x % sourceWidth) * sourceComponents;
+                uchar *d = &image[((size_t) y * w + x) * 3];
+                for (int c = 0; c < 3; c++) d[c] = s[(sourceComponents < 3) ? 0 : c];
+            }
+        }
+        const double rawMB = (double) image.size() / (1024.0 * 1024.0);
+
+        printf("%5dx%-5d", w, h);
+
+        // stb_image_write baseline.
+        double bestMs = -1.0;
+        for (int run = 0; run < numRuns; run++) {
+            double startMs = GetWallClockMs();
+            stbi_write_png(outFilename, w, h, 3, image.data(), 0);
+            double runMs = GetWallClockMs() - startMs;
+            if (bestMs < 0.0 || runMs < bestMs) bestMs = runMs;
+        }
+        printf(" %10.1f", rawMB / (bestMs / 1000.0));
+        FILE *fp = fopen(outFilename, "rb");
+        long stbBytes = 0;
+        if (fp != NULL) {
+            fseek(fp, 0, SEEK_END);
+            stbBytes = ftell(fp);
+            fclose(fp);
+        }
+
+        for (size_t t = 0; t < threadCounts.size(); t++) {
+            bestMs = -1.0;
+            for (int run = 0; run < numRuns; run++) {
+                double startMs = GetWallClockMs();
+                WritePNGFile(outFilename, image.data(), w, h, 3, threadCounts[t]);
+                double runMs = GetWallClockMs() - startMs;
+                if (bestMs < 0.0 || runMs < bestMs) bestMs = runMs;
+            }
+            printf(" %11.1f", rawMB / (bestMs / 1000.0));
+        }
+
+        // Decode the last output and compare it with the input.
+        long ourBytes = 0;
+        fp = fopen(outFilename, "rb");
+        if (fp != NULL) {
+            fseek(fp, 0, SEEK_END);
+            ourBytes = ftell(fp);
+            fclose(fp);
+        }
+        uchar *decoded = NULL;
+        int dw, dh, dn;
+        bool match = ReadImageFile(outFilename, &decoded, &dw, &dh, &dn) && dw == w && dh == h && dn == 3 &&
+                     memcmp(decoded, image.data(), image.size()) == 0;
+        if (decoded != NULL) DeallocateImageData(&decoded);
+
+        printf(" %12ld %12ld %6s\n", stbBytes, ourBytes, match ? "ok" : "FAIL");
+    }
+
+    remove(outFilename);
+    DeallocateImageData(&source);
+}
@@ -0,0 +1,95 @@
+#ifndef _PNG_WRITER_H_
+#define _PNG_WRITER_H_
+
+#include "image_io.h"
+
+/////////////////////////////////////////////////////////////////////////////
+// Multithreaded PNG writer.
+//
+// The rows of the image are split into chunks that are filtered and
+// deflated independently by a pool of worker threads, in the style of
+// pigz. Each chunk still uses the last 32 KB of the chunk before it as
+// its LZ77 dictionary, so little compression is lost. Every chunk except
+// the last one ends on a byte boundary with an empty stored block, so
+// the compressed chunks can simply be concatenated into one zlib stream.
+// The Adler-32 checksums of the chunks are combined into the checksum of
+// the whole stream, and each chunk is written as its own IDAT chunk.
+//
+// The filter type of each row is chosen by the minimum sum of absolute
+// differences heuristic, with SSE2 code where available.
+/////////////////////////////////////////////////////////////////////////////
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Save an image to the output filename in PNG format, encoding it with
+// numThreads worker threads. If numThreads is 0, one thread per hardware
+// core is used. If numThreads is 1, the image is encoded on the calling
+// thread.
+// Returns 1 if successful or 0 if unsuccessful.
+// The image layout is the same as for SaveImageToFilePNG(): numComponents
+// (1 to 4) bytes per pixel, tightly packed, with the first pixel at the
+// bottom-left of the image.
+/////////////////////////////////////////////////////////////////////////////
+
+extern int WritePNGFile(const char *filename, const uchar *imageData,
+                        int imageWidth, int imageHeight, int numComponents, int numThreads);
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Streaming PNG writer, for images too large to hold in memory at once,
+// such as poster-size offscreen renders.
+//
+// The image is passed in bands of consecutive rows, which are encoded in
+// parallel like whole images by WritePNGFile(). Bands may be passed in any
+// order. A band that follows on from the rows already written is written
+// to the file straight away; any other band is compressed and kept in a
+// temporary file until the bands above it have been written. So only one
+// band of uncompressed pixels is held in memory at any time. Bands are
+// best passed from the top of the image down, in which case nothing is
+// kept in the temporary file and each band is filtered with the row above
+// it, like a whole image.
+/////////////////////////////////////////////////////////////////////////////
+
+struct PNGStreamWriter;
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Start writing a PNG file of the given size band by band, encoding each
+// band with numThreads worker threads, as for WritePNGFile().
+// Returns NULL if the file cannot be created.
+/////////////////////////////////////////////////////////////////////////////
+
+extern PNGStreamWriter *BeginPNGStream(const char *filename, int imageWidth, int imageHeight,
+                                       int numComponents, int numThreads);
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Write the numRows rows of the image starting at row firstRow, counted
+// from the bottom of the image. bandData has the same layout as a whole
+// image for WritePNGFile(), with the band's bottom row first. Bands must
+// not overlap. The data may be reused as soon as the function returns.
+// Returns 1 if successful or 0 if unsuccessful.
+/////////////////////////////////////////////////////////////////////////////
+
+extern int WritePNGStreamBand(PNGStreamWriter *writer, int firstRow, int numRows, const uchar *bandData);
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Finish the PNG file and destroy the writer.
+// Returns 1 if successful, or 0 if any write failed or if any row of the
+// image has not been written, in which case the file is deleted.
+/////////////////////////////////////////////////////////////////////////////
+
+extern int EndPNGStream(PNGStreamWriter *writer);
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Measure the throughput of WritePNGFile() with different numbers of
+// threads, and of stb_image_write, at several image resolutions, and print
+// the results. The test images are tiled from the input image file.
+/////////////////////////////////////////////////////////////////////////////
+
+extern void BenchmarkPNGWriter(const char *sourceFilename);
+
+
+#endif
@@ -0,0 +1,347 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+
+#ifdef __APPLE__
+#define GL_SILENCE_DEPRECATION
+#include <GLUT/glut.h>
+#else
+#include <GL/glew.h>
+#include <GL/glut.h>
+#endif
+
+#include "render_target.h"
+
+
+
+struct RenderTarget
+{
+    int width, height;          // Full size, which is that of the texture.
+    float scale;                // Set by the frame budget.
+    float maxScale;             // Set by how much of the view the texture covers.
+    GLuint texObj;
+    GLuint framebuffer;         // Drawn into, with the two renderbuffers.
+    GLuint colorBuffer;
+    GLuint depthBuffer;
+    GLuint resolveFramebuffer;  // With the texture attached.
+    GLint savedViewport[4];
+};
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns 1 if render targets are supported or 0 if not.
+/////////////////////////////////////////////////////////////////////////////
+
+int HasRenderTargets(void)
+{
+#ifdef __APPLE__
+    return 0;   // Apple's legacy contexts only have the EXT framebuffer functions.
+#else
+    return (GLEW_VERSION_3_0 || GLEW_ARB_framebuffer_object) ? 1 : 0;
+#endif
+}
+
+
+
+// The scale that the target is drawn at, under its maximum scale.
+static float GetDrawnScale(const RenderTarget *target)
+{
+    return (target->scale < target->maxScale) ? target->scale : target->maxScale;
+}
+
+// The size of the part of the target that is drawn at its scale.
+static void GetScaledSize(const RenderTarget *target, int *width, int *height)
+{
+    float scale = GetDrawnScale(target);
+    *width = (int)(scale * target->width + 0.5f);
+    *height = (int)(scale * target->height + 0.5f);
+    if (*width < 1) *width = 1;
+    if (*height < 1) *height = 1;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Create a render target of width x height pixels, which is resolved into
+// the input texture object. The storage of the texture is allocated here,
+// with all its mipmap levels; its filtering is left as it is. The scale
+// starts at 1. Returns NULL if the framebuffer cannot be created.
+/////////////////////////////////////////////////////////////////////////////
+
+RenderTarget *CreateRenderTarget(unsigned int texObj, int width, int height)
+{
+    RenderTarget *target = new RenderTarget;
+    target->width = width;
+    target->height = height;
+    target->scale = 1.0f;
+    target->maxScale = 1.0f;
+    target->texObj = texObj;
+
+    GLint boundTexObj = 0;
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &boundTexObj);
+    glBindTexture(GL_TEXTURE_2D, texObj);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, boundTexObj);
+
+    glGenRenderbuffers(1, &target->colorBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, target->colorBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glGenRenderbuffers(1, &target->depthBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, target->depthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glGenFramebuffers(1, &target->framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, target->framebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, target->colorBuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, target->depthBuffer);
+    bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+
+    glGenFramebuffers(1, &target->resolveFramebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, target->resolveFramebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texObj, 0);
+    complete = complete && glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    if (!complete) {
+        fprintf(stderr, "Error: Cannot create a %d x %d render target.\n", width, height);
+        DeleteRenderTarget(target);
+        return NULL;
+    }
+    return target;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Draw into the render target until EndRenderTarget(). The viewport is set
+// to the scaled size of the target, and restored afterwards.
+// EndRenderTarget() resolves the image into the texture, and regenerates
+// its mipmaps, leaving the texture binding as it was, and goes back to
+// drawing into the window.
+/////////////////////////////////////////////////////////////////////////////
+
+void BeginRenderTarget(RenderTarget *target)
+{
+    int width, height;
+    GetScaledSize(target, &width, &height);
+    glGetIntegerv(GL_VIEWPORT, target->savedViewport);
+    glBindFramebuffer(GL_FRAMEBUFFER, target->framebuffer);
+    glViewport(0, 0, width, height);
+}
+
+void EndRenderTarget(RenderTarget *target)
+{
+    // Stretch the drawn part over the whole texture, filtering only if it
+    // is scaled.
+    int width, height;
+    GetScaledSize(target, &width, &height);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, target->framebuffer);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, target->resolveFramebuffer);
+    glBlitFramebuffer(0, 0, width, height, 0, 0, target->width, target->height, GL_COLOR_BUFFER_BIT,
+                      (width == target->width && height == target->height) ? GL_NEAREST : GL_LINEAR);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    GLint boundTexObj = 0;
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &boundTexObj);
+    glBindTexture(GL_TEXTURE_2D, target->texObj);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, boundTexObj);
+
+    glViewport(target->savedViewport[0], target->savedViewport[1], target->savedViewport[2], target->savedViewport[3]);
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Adjust the scale of the target, so that a pass that took passMs to draw
+// into it takes about budgetMs, taking the cost of the pass to be in
+// proportion to its number of pixels. The scale is kept from minScale to
+// 1, and starts from the scale that the pass was drawn at, which may have
+// been lowered by the maximum scale. It moves halfway to the new scale at
+// a time, and only if it is off by more than a few percent, so that it
+// settles despite the noise and the latency of the timings.
+/////////////////////////////////////////////////////////////////////////////
+
+void UpdateRenderTargetScale(RenderTarget *target, double passMs, double budgetMs, float minScale)
+{
+    if (!(passMs > 0.0)) return;
+
+    float drawnScale = GetDrawnScale(target);
+    float scale = (budgetMs > 0.0) ? drawnScale * (float)sqrt(budgetMs / passMs) : minScale;
+    if (scale < minScale) scale = minScale;
+    if (scale > 1.0f) scale = 1.0f;
+
+    if (fabsf(scale - drawnScale) <= 0.03f * drawnScale) {
+        if (scale == minScale || scale == 1.0f) target->scale = scale;
+        return;
+    }
+    target->scale = 0.5f * (drawnScale + scale);
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Get and set the scale of the target, the fraction of its width and
+// height that is drawn, from 0 to 1.
+/////////////////////////////////////////////////////////////////////////////
+
+float GetRenderTargetScale(const RenderTarget *target)
+{
+    return target->scale;
+}
+
+void SetRenderTargetScale(RenderTarget *target, float scale)
+{
+    target->scale = (scale < 0.0f) ? 0.0f : (scale > 1.0f) ? 1.0f : scale;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Set the maximum scale of the target, from 0 to 1, under which the target
+// is drawn whatever its scale, e.g. when the texture covers few pixels.
+// It starts at 1.
+/////////////////////////////////////////////////////////////////////////////
+
+void SetRenderTargetMaxScale(RenderTarget *target, float maxScale)
+{
+    target->maxScale = (maxScale < 0.0f) ? 0.0f : (maxScale > 1.0f) ? 1.0f : maxScale;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Delete the render target. The texture is not deleted.
+/////////////////////////////////////////////////////////////////////////////
+
+void DeleteRenderTarget(RenderTarget *target)
+{
+    if (target == NULL) return;
+    glDeleteFramebuffers(1, &target->framebuffer);
+    glDeleteFramebuffers(1, &target->resolveFramebuffer);
+    glDeleteRenderbuffers(1, &target->colorBuffer);
+    glDeleteRenderbuffers(1, &target->depthBuffer);
+    delete target;
+}
+
+
+
+struct FrameCache
+{
+    int width, height;          // Size of the saved image, or 0 if none is saved.
+    GLenum depthFormat;         // That of the window, which the blits require.
+    GLuint framebuffer;
+    GLuint colorBuffer;
+    GLuint depthBuffer;
+};
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Create a frame cache. The storage is allocated as frames are saved.
+/////////////////////////////////////////////////////////////////////////////
+
+FrameCache *CreateFrameCache(void)
+{
+    FrameCache *cache = new FrameCache;
+    cache->width = 0;
+    cache->height = 0;
+
+    // Depth blits need the same formats on both sides.
+    GLint depthBits = 0, stencilBits = 0;
+    glGetIntegerv(GL_DEPTH_BITS, &depthBits);
+    glGetIntegerv(GL_STENCIL_BITS, &stencilBits);
+    if (stencilBits > 0)
+        cache->depthFormat = GL_DEPTH24_STENCIL8;
+    else if (depthBits <= 16)
+        cache->depthFormat = GL_DEPTH_COMPONENT16;
+    else if (depthBits <= 24)
+        cache->depthFormat = GL_DEPTH_COMPONENT24;
+    else
+        cache->depthFormat = GL_DEPTH_COMPONENT32;
+
+    glGenFramebuffers(1, &cache->framebuffer);
+    glGenRenderbuffers(1, &cache->colorBuffer);
+    glGenRenderbuffers(1, &cache->depthBuffer);
+    return cache;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Save the lower-left width x height pixels of the color and the depth
+// buffers of the window into the cache, reallocating its storage if the
+// size has changed. Returns 1 if successful or 0 if not, in which case
+// the cache is left empty.
+/////////////////////////////////////////////////////////////////////////////
+
+int SaveFrameCache(FrameCache *cache, int width, int height)
+{
+    if (cache->width != width || cache->height != height) {
+        glBindRenderbuffer(GL_RENDERBUFFER, cache->colorBuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+        glBindRenderbuffer(GL_RENDERBUFFER, cache->depthBuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, cache->depthFormat, width, height);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+        GLenum attachment = (cache->depthFormat == GL_DEPTH24_STENCIL8) ? GL_DEPTH_STENCIL_ATTACHMENT
+                                                                          : GL_DEPTH_ATTACHMENT;
+        glBindFramebuffer(GL_FRAMEBUFFER, cache->framebuffer);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, cache->colorBuffer);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, attachment, GL_RENDERBUFFER, cache->depthBuffer);
+        bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        cache->width = complete ? width : 0;
+        cache->height = complete ? height : 0;
+        if (!complete) return 0;
+    }
+
+    while (glGetError() != GL_NO_ERROR) {}
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, cache->framebuffer);
+    glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    // The blit fails if the depth formats differ after all.
+    if (glGetError() != GL_NO_ERROR) {
+        cache->width = cache->height = 0;
+        return 0;
+    }
+    return 1;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Copy the saved color and depth buffers back into the window. Returns 1
+// if successful or 0 if no frame of width x height pixels is saved.
+/////////////////////////////////////////////////////////////////////////////
+
+int RestoreFrameCache(const FrameCache *cache, int width, int height)
+{
+    if (cache->width == 0 || cache->width != width || cache->height != height) return 0;
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, cache->framebuffer);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    return 1;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Delete the frame cache.
+/////////////////////////////////////////////////////////////////////////////
+
+void DeleteFrameCache(FrameCache *cache)
+{
+    if (cache == NULL) return;
+    glDeleteFramebuffers(1, &cache->framebuffer);
+    glDeleteRenderbuffers(1, &cache->colorBuffer);
+    glDeleteRenderbuffers(1, &cache->depthBuffer);
+    delete cache;
+}
@@ -0,0 +1,133 @@
+#ifndef _RENDER_TARGET_H_
+#define _RENDER_TARGET_H_
+
+/////////////////////////////////////////////////////////////////////////////
+// Offscreen render targets with dynamic resolution.
+//
+// A render target draws into a framebuffer object of its own, at a size
+// that is independent of the window's, and is then resolved into a
+// mipmapped texture of that size, which the scene samples. The image may
+// be drawn at a fraction of the full size, the target's scale, in the
+// lower-left corner of the framebuffer, and is stretched over the texture
+// as it is resolved. So the scale can change from frame to frame, e.g.
+// to keep the frame time within a budget, and the window can be resized,
+// without reallocating the framebuffer or the texture.
+/////////////////////////////////////////////////////////////////////////////
+
+
+struct RenderTarget;
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns 1 if render targets are supported or 0 if not.
+/////////////////////////////////////////////////////////////////////////////
+
+extern int HasRenderTargets( void );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Create a render target of width x height pixels, which is resolved into
+// the input texture object. The storage of the texture is allocated here,
+// with all its mipmap levels; its filtering is left as it is. The scale
+// starts at 1. Returns NULL if the framebuffer cannot be created.
+/////////////////////////////////////////////////////////////////////////////
+
+extern RenderTarget *CreateRenderTarget( unsigned int texObj, int width, int height );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Draw into the render target until EndRenderTarget(). The viewport is set
+// to the scaled size of the target, and restored afterwards.
+// EndRenderTarget() resolves the image into the texture, and regenerates
+// its mipmaps, leaving the texture binding as it was, and goes back to
+// drawing into the window.
+/////////////////////////////////////////////////////////////////////////////
+
+extern void BeginRenderTarget( RenderTarget *target );
+extern void EndRenderTarget( RenderTarget *target );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Adjust the scale of the target, so that a pass that took passMs to draw
+// into it takes about budgetMs, taking the cost of the pass to be in
+// proportion to its number of pixels. The scale is kept from minScale to
+// 1, and starts from the scale that the pass was drawn at, which may have
+// been lowered by the maximum scale. It moves halfway to the new scale at
+// a time, and only if it is off by more than a few percent, so that it
+// settles despite the noise and the latency of the timings.
+/////////////////////////////////////////////////////////////////////////////
+
+extern void UpdateRenderTargetScale( RenderTarget *target, double passMs, double budgetMs, float minScale );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Get and set the scale of the target, the fraction of its width and
+// height that is drawn, from 0 to 1.
+/////////////////////////////////////////////////////////////////////////////
+
+extern float GetRenderTargetScale( const RenderTarget *target );
+extern void SetRenderTargetScale( RenderTarget *target, float scale );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Set the maximum scale of the target, from 0 to 1, under which the target
+// is drawn whatever its scale, e.g. when the texture covers few pixels.
+// It starts at 1.
+/////////////////////////////////////////////////////////////////////////////
+
+extern void SetRenderTargetMaxScale( RenderTarget *target, float maxScale );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Delete the render target. The texture is not deleted.
+/////////////////////////////////////////////////////////////////////////////
+
+extern void DeleteRenderTarget( RenderTarget *target );
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Frame caches.
+//
+// A frame cache holds a copy of the color and the depth buffers of the
+// window, so that a frame whose scene has not changed can be restored,
+// and only what is drawn on top of the scene redrawn. It needs the same
+// support as render targets.
+/////////////////////////////////////////////////////////////////////////////
+
+struct FrameCache;
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Create a frame cache. The storage is allocated as frames are saved.
+/////////////////////////////////////////////////////////////////////////////
+
+extern FrameCache *CreateFrameCache( void );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Save the lower-left width x height pixels of the color and the depth
+// buffers of the window into the cache, reallocating its storage if the
+// size has changed. Returns 1 if successful or 0 if not, in which case
+// the cache is left empty.
+/////////////////////////////////////////////////////////////////////////////
+
+extern int SaveFrameCache( FrameCache *cache, int width, int height );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Copy the saved color and depth buffers back into the window. Returns 1
+// if successful or 0 if no frame of width x height pixels is saved.
+/////////////////////////////////////////////////////////////////////////////
+
+extern int RestoreFrameCache( const FrameCache *cache, int width, int height );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Delete the frame cache.
+/////////////////////////////////////////////////////////////////////////////
+
+extern void DeleteFrameCache( FrameCache *cache );
+
+
+#endif
@@ -0,0 +1,95 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <vector>
+
+#ifdef __APPLE__
+#define GL_SILENCE_DEPRECATION
+#include <GLUT/glut.h>
+#else
+#include <GL/glew.h>
+#include <GL/glut.h>
+#endif
+
+#include "shader_program.h"
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns 1 if GLSL 3.30 programs are supported or 0 if not.
+/////////////////////////////////////////////////////////////////////////////
+
+int HasGLSL330(void)
+{
+#ifdef __APPLE__
+    return 0;   // Apple's legacy contexts only have GLSL 1.20.
+#else
+    return GLEW_VERSION_3_3 ? 1 : 0;
+#endif
+}
+
+
+
+// Compile a shader of the given type. Returns the shader, or 0 if it fails
+// to compile, after printing the compile log.
+static GLuint CompileShader(const char *name, GLenum type, const char *source)
+{
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, NULL);
+    glCompileShader(shader);
+
+    GLint compiled = GL_FALSE;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+    if (compiled) return shader;
+
+    GLint logLength = 0;
+    glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &logLength);
+    std::vector<char> log(logLength + 1, '\0');
+    glGetShaderInfoLog(shader, logLength, NULL, log.data());
+    fprintf(stderr, "Error: Cannot compile the %s shader of the %s program:\n%s\n",
+            (type == GL_VERTEX_SHADER) ? "vertex" : "fragment", name, log.data());
+    glDeleteShader(shader);
+    return 0;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Compile the vertex shader and the fragment shader from their sources,
+// and link them into a program. fragmentShaderSource may be NULL, in which
+// case the fragments are processed by the fixed-function pipeline.
+// Returns the program, or 0 if it fails to build, in which case the build
+// log is printed to stderr under the given name of the program.
+/////////////////////////////////////////////////////////////////////////////
+
+unsigned int BuildShaderProgram(const char *name, const char *vertexShaderSource,
+                                const char *fragmentShaderSource)
+{
+    GLuint vertexShader = CompileShader(name, GL_VERTEX_SHADER, vertexShaderSource);
+    GLuint fragmentShader = 0;
+    if (fragmentShaderSource != NULL) fragmentShader = CompileShader(name, GL_FRAGMENT_SHADER, fragmentShaderSource);
+    if (vertexShader == 0 || (fragmentShaderSource != NULL && fragmentShader == 0)) {
+        if (vertexShader != 0) glDeleteShader(vertexShader);
+        if (fragmentShader != 0) glDeleteShader(fragmentShader);
+        return 0;
+    }
+
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vertexShader);
+    if (fragmentShader != 0) glAttachShader(program, fragmentShader);
+    glLinkProgram(program);
+    glDeleteShader(vertexShader);   // Deleted with the program.
+    if (fragmentShader != 0) glDeleteShader(fragmentShader);
+
+    GLint linked = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (!linked) {
+        GLint logLength = 0;
+        glGetProgramiv(program, GL_INFO_LOG_LENGTH, &logLength);
+        std::vector<char> log(logLength + 1, '\0');
+        glGetProgramInfoLog(program, logLength, NULL, log.data());
+        fprintf(stderr, "Error: Cannot link the %s program:\n%s\n", name, log.data());
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
@@ -0,0 +1,33 @@
+#ifndef _SHADER_PROGRAM_H_
+#define _SHADER_PROGRAM_H_
+
+/////////////////////////////////////////////////////////////////////////////
+// GLSL programs.
+//
+// The programs of the renderer are written in GLSL 3.30 for the
+// compatibility profile, so that they can read the lights, the materials
+// and the matrices from the fixed-function state through the built-in
+// uniforms.
+/////////////////////////////////////////////////////////////////////////////
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns 1 if GLSL 3.30 programs are supported or 0 if not.
+/////////////////////////////////////////////////////////////////////////////
+
+extern int HasGLSL330( void );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Compile the vertex shader and the fragment shader from their sources,
+// and link them into a program. fragmentShaderSource may be NULL, in which
+// case the fragments are processed by the fixed-function pipeline.
+// Returns the program, or 0 if it fails to build, in which case the build
+// log is printed to stderr under the given name of the program.
+/////////////////////////////////////////////////////////////////////////////
+
+extern unsigned int BuildShaderProgram( const char *name, const char *vertexShaderSource,
+                                        const char *fragmentShaderSource );
+
+
+#endif
@@ -0,0 +1,232 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <vector>
+
+#ifdef __APPLE__
+#define GL_SILENCE_DEPRECATION
+#include <GLUT/glut.h>
+#else
+#include <GL/glew.h>
+#include <GL/glut.h>
+#endif
+
+#include "image_io.h"
+#include "image_pool.h"
+#include "mipmap.h"
+#include "texture_atlas.h"
+#include "texture_compression.h"
+
+
+
+// Placement of an image in the atlas, in texels.
+struct AtlasTile
+{
+    int index;                  // Index of the input image.
+    int width, height;          // Size of the image, without the gutter.
+    int x, y;                   // Bottom-left corner of the image in the atlas.
+};
+
+
+static inline int RoundUpToGutter(int n)
+{
+    return (n + TEXTURE_ATLAS_GUTTER - 1) / TEXTURE_ATLAS_GUTTER * TEXTURE_ATLAS_GUTTER;
+}
+
+static bool IsTallerTile(const AtlasTile *a, const AtlasTile *b)
+{
+    return a->height > b->height;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Place the tiles in shelves of the given atlas width, tallest first.
+// Every image and its gutter starts on a multiple of TEXTURE_ATLAS_GUTTER
+// texels, so each 2x2 texel block of the mipmap levels up to
+// TEXTURE_ATLAS_MAX_LEVEL, and each 4x4 compression block of the levels
+// up to TEXTURE_ATLAS_MAX_COMPRESSED_LEVEL, lies within one tile.
+// Returns the height of the atlas.
+/////////////////////////////////////////////////////////////////////////////
+
+static int PackTiles(std::vector<AtlasTile> &tiles, int atlasWidth)
+{
+    std::vector<AtlasTile *> order;
+    for (size_t i = 0; i < tiles.size(); i++) order.push_back(&tiles[i]);
+    std::stable_sort(order.begin(), order.end(), IsTallerTile);
+
+    int shelfY = 0, shelfHeight = 0, x = 0;
+    for (size_t i = 0; i < order.size(); i++) {
+        int paddedWidth = RoundUpToGutter(order[i]->width) + 2 * TEXTURE_ATLAS_GUTTER;
+        int paddedHeight = RoundUpToGutter(order[i]->height) + 2 * TEXTURE_ATLAS_GUTTER;
+        if (x > 0 && x + paddedWidth > atlasWidth) {
+            shelfY += shelfHeight;
+            shelfHeight = 0;
+            x = 0;
+        }
+        order[i]->x = x + TEXTURE_ATLAS_GUTTER;
+        order[i]->y = shelfY + TEXTURE_ATLAS_GUTTER;
+        x += paddedWidth;
+        shelfHeight = std::max(shelfHeight, paddedHeight);
+    }
+    return shelfY + shelfHeight;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Place the images of the given sizes in a roughly square atlas, and
+// return the tiles, the size of the atlas and the region of each image.
+// Returns 1 if successful, or 0 if the atlas would be too large or if
+// non-power-of-two textures are unsupported.
+/////////////////////////////////////////////////////////////////////////////
+
+static int LayOutAtlas(int numImages, const int *imageWidths, const int *imageHeights,
+                       std::vector<AtlasTile> &tiles, int *atlasWidth, int *atlasHeight,
+                       AtlasRegion *regions)
+{
+#ifndef __APPLE__
+    if (!(GLEW_VERSION_2_0 || GLEW_ARB_texture_non_power_of_two)) return 0;
+#endif
+
+    tiles.resize(numImages);
+    size_t totalArea = 0;
+    int maxWidth = 0;
+    for (int i = 0; i < numImages; i++) {
+        tiles[i].index = i;
+        tiles[i].width = imageWidths[i];
+        tiles[i].height = imageHeights[i];
+        int paddedWidth = RoundUpToGutter(tiles[i].width) + 2 * TEXTURE_ATLAS_GUTTER;
+        int paddedHeight = RoundUpToGutter(tiles[i].height) + 2 * TEXTURE_ATLAS_GUTTER;
+        totalArea += (size_t) paddedWidth * paddedHeight;
+        maxWidth = std::max(maxWidth, paddedWidth);
+    }
+
+    GLint maxTextureSize;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+    *atlasWidth = std::max(maxWidth, RoundUpToGutter((int) ceil(sqrt((double) totalArea))));
+    *atlasHeight = PackTiles(tiles, *atlasWidth);
+    if (*atlasWidth > maxTextureSize || *atlasHeight > maxTextureSize) return 0;
+
+    for (int i = 0; i < numImages; i++) {
+        const AtlasTile &tile = tiles[i];
+        regions[tile.index].s0 = (float) tile.x / *atlasWidth;
+        regions[tile.index].t0 = (float) tile.y / *atlasHeight;
+        regions[tile.index].s1 = (float) (tile.x + tile.width) / *atlasWidth;
+        regions[tile.index].t1 = (float) (tile.y + tile.height) / *atlasHeight;
+    }
+    return 1;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Work out the size of the atlas of numImages images of the given sizes,
+// and the region of each image in it, without building the atlas.
+// BuildTextureAtlas() lays out the same images in the same way, so this
+// is enough to use an atlas whose texels were stored earlier, e.g. in the
+// baked-texture cache.
+// Returns 1 if successful, or 0 if the atlas would be too large or if
+// non-power-of-two textures are unsupported.
+/////////////////////////////////////////////////////////////////////////////
+
+int PackTextureAtlas(int numImages, const int *imageWidths, const int *imageHeights,
+                     int *atlasWidth, int *atlasHeight, AtlasRegion *regions)
+{
+    std::vector<AtlasTile> tiles;
+    return LayOutAtlas(numImages, imageWidths, imageHeights, tiles, atlasWidth, atlasHeight, regions);
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Pack the numImages decoded RGB images into one atlas, build its mipmaps
+// with BuildMipmapChain(), and upload them into the texture object
+// currently bound to GL_TEXTURE_2D, compressed to BC1 if compress is true
+// and compressed textures are supported. A NULL image is packed as a
+// single white texel, for drawing untextured objects with the atlas still
+// bound, and its size must be given as 1x1.
+// The region of each image in the atlas is returned in regions.
+// Returns 1 if successful, or 0 if the atlas would be too large, if memory
+// cannot be allocated, or if non-power-of-two textures are unsupported.
+/////////////////////////////////////////////////////////////////////////////
+
+int BuildTextureAtlas(int numImages, const uchar * const *images, const int *imageWidths,
+                      const int *imageHeights, bool gammaCorrect, bool compress, AtlasRegion *regions)
+{
+    std::vector<AtlasTile> tiles;
+    int atlasWidth, atlasHeight;
+    if (!LayOutAtlas(numImages, imageWidths, imageHeights, tiles, &atlasWidth, &atlasHeight, regions))
+        return 0;
+
+    GLenum compressedFormat = (compress && HasTextureCompression()) ? GetCompressedTextureFormat(3) : 0;
+    int maxLevel = (compressedFormat != 0) ? TEXTURE_ATLAS_MAX_COMPRESSED_LEVEL : TEXTURE_ATLAS_MAX_LEVEL;
+    int numLevels = std::min(maxLevel + 1, GetNumMipmapLevels(atlasWidth, atlasHeight));
+
+    // Level 0 has the largest blocks, so its buffer is reused for the others.
+    uchar *atlas = (uchar *) AllocatePooledBlock((size_t) atlasWidth * atlasHeight * 3);
+    uchar *mipmapChain = (uchar *) AllocatePooledBlock(GetMipmapChainSize(atlasWidth, atlasHeight, 3));
+    uchar *blocks = NULL;
+    if (compressedFormat != 0)
+        blocks = (uchar *) AllocatePooledBlock(GetCompressedImageSize(atlasWidth, atlasHeight, 3));
+    if (atlas == NULL || mipmapChain == NULL || (compressedFormat != 0 && blocks == NULL)) {
+        FreePooledBlock(blocks);        // Any of them may be NULL.
+        FreePooledBlock(mipmapChain);
+        FreePooledBlock(atlas);
+        return 0;
+    }
+
+    // Copy each image into the atlas, wrapping around into its gutter.
+    const uchar white[3] = { 255, 255, 255 };
+    memset(atlas, 0, (size_t) atlasWidth * atlasHeight * 3);
+    for (int i = 0; i < numImages; i++) {
+        const AtlasTile &tile = tiles[i];
+        const uchar *pixels = (images[tile.index] != NULL) ? images[tile.index] : white;
+        int paddedWidth = RoundUpToGutter(tile.width) + 2 * TEXTURE_ATLAS_GUTTER;
+        int paddedHeight = RoundUpToGutter(tile.height) + 2 * TEXTURE_ATLAS_GUTTER;
+
+        for (int y = -TEXTURE_ATLAS_GUTTER; y < paddedHeight - TEXTURE_ATLAS_GUTTER; y++) {
+            int srcY = ((y % tile.height) + tile.height) % tile.height;
+            uchar *dst = atlas + ((size_t) (tile.y + y) * atlasWidth + tile.x - TEXTURE_ATLAS_GUTTER) * 3;
+            for (int x = -TEXTURE_ATLAS_GUTTER; x < paddedWidth - TEXTURE_ATLAS_GUTTER; x++, dst += 3) {
+                int srcX = ((x % tile.width) + tile.width) % tile.width;
+                memcpy(dst, pixels + ((size_t) srcY * tile.width + srcX) * 3, 3);
+            }
+        }
+    }
+
+    if (!BuildMipmapChain(atlas, atlasWidth, atlasHeight, 3, gammaCorrect, mipmapChain)) {
+        FreePooledBlock(blocks);
+        FreePooledBlock(mipmapChain);
+        FreePooledBlock(atlas);
+        return 0;
+    }
+
+    GLint unpackAlignment;
+    glGetIntegerv(GL_UNPACK_ALIGNMENT, &unpackAlignment);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    const uchar *levelData = atlas;
+    int w = atlasWidth, h = atlasHeight;
+    for (int level = 0; level < numLevels; level++) {
+        if (compressedFormat != 0) {
+            size_t size = GetCompressedImageSize(w, h, 3);
+            CompressImage(levelData, w, h, 3, blocks);
+            glCompressedTexImage2D(GL_TEXTURE_2D, level, compressedFormat, w, h, 0, (GLsizei) size, blocks);
+        }
+        else
+            glTexImage2D(GL_TEXTURE_2D, level, GL_RGB8, w, h, 0, GL_RGB, GL_UNSIGNED_BYTE, levelData);
+        levelData = (level == 0) ? mipmapChain : levelData + (size_t) w * h * 3;
+        w = (w > 1) ? w / 2 : 1;
+        h = (h > 1) ? h / 2 : 1;
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, numLevels - 1);
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, unpackAlignment);
+    FreePooledBlock(blocks);
+    FreePooledBlock(mipmapChain);
+    FreePooledBlock(atlas);
+    return 1;
+}
@@ -0,0 +1,68 @@
+#ifndef _TEXTURE_ATLAS_H_
+#define _TEXTURE_ATLAS_H_
+
+#include "image_io.h"
+
+/////////////////////////////////////////////////////////////////////////////
+// Texture atlas packer.
+//
+// Packs the images of several textures into one texture, so that objects
+// with different textures can be drawn without binding another texture
+// in between. Each packed image is surrounded by a gutter of
+// TEXTURE_ATLAS_GUTTER texels that repeat the image, so that bilinear
+// filtering at the edges of the image wraps around like GL_REPEAT.
+// Only the mipmap levels in which the gutter is at least one texel wide
+// are built, so the images never bleed into each other. A compressed atlas
+// only has the levels in which it is at least one 4x4 block wide, so that
+// no block holds texels of two images.
+//
+// The atlas has no GL_REPEAT of its own. Texture coordinates must be in
+// the range [0, 1] of the packed image, and are mapped into its region of
+// the atlas, e.g. with the texture matrix.
+/////////////////////////////////////////////////////////////////////////////
+
+#define TEXTURE_ATLAS_GUTTER        16
+#define TEXTURE_ATLAS_MAX_LEVEL     4       // log2(TEXTURE_ATLAS_GUTTER).
+#define TEXTURE_ATLAS_MAX_COMPRESSED_LEVEL  2   // log2(TEXTURE_ATLAS_GUTTER / 4).
+
+
+// The texture coordinates of the corners of a packed image in the atlas.
+struct AtlasRegion
+{
+    float s0, t0;       // Bottom-left corner.
+    float s1, t1;       // Top-right corner.
+};
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Work out the size of the atlas of numImages images of the given sizes,
+// and the region of each image in it, without building the atlas.
+// BuildTextureAtlas() lays out the same images in the same way, so this
+// is enough to use an atlas whose texels were stored earlier, e.g. in the
+// baked-texture cache.
+// Returns 1 if successful, or 0 if the atlas would be too large or if
+// non-power-of-two textures are unsupported.
+/////////////////////////////////////////////////////////////////////////////
+
+extern int PackTextureAtlas( int numImages, const int *imageWidths, const int *imageHeights,
+                             int *atlasWidth, int *atlasHeight, AtlasRegion *regions );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Pack the numImages decoded RGB images into one atlas, build its mipmaps
+// with BuildMipmapChain(), and upload them into the texture object
+// currently bound to GL_TEXTURE_2D, compressed to BC1 if compress is true
+// and compressed textures are supported. A NULL image is packed as a
+// single white texel, for drawing untextured objects with the atlas still
+// bound, and its size must be given as 1x1.
+// The region of each image in the atlas is returned in regions.
+// Returns 1 if successful, or 0 if the atlas would be too large, if memory
+// cannot be allocated, or if non-power-of-two textures are unsupported.
+/////////////////////////////////////////////////////////////////////////////
+
+extern int BuildTextureAtlas( int numImages, const uchar * const *images, const int *imageWidths,
+                              const int *imageHeights, bool gammaCorrect, bool compress,
+                              AtlasRegion *regions );
+
+
+#endif
@@ -0,0 +1,271 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <string>
+
+#ifdef __APPLE__
+#define GL_SILENCE_DEPRECATION
+#include <GLUT/glut.h>
+#else
+#include <GL/glew.h>
+#include <GL/glut.h>
+#endif
+
+#ifdef _WIN32
+#include <direct.h>
+#define mkdir(path, mode) _mkdir(path)
+#else
+#include <sys/stat.h>
+#endif
+
+#include "image_pool.h"
+#include "mapped_file.h"
+#include "texture_cache.h"
+#include "texture_compression.h"
+
+
+
+// Layout of a cache file. All fields are in the byte order of the machine
+// that wrote the file; a file from a machine of the other byte order fails
+// the magic number check and is simply rebuilt.
+//
+//     TextureCacheHeader
+//     TextureCacheLevel[numLevels]
+//     pixel data of level 0, level 1, ...
+//
+// The pixel data is either tightly packed GL_RGB texels or, for compressed
+// textures, the compressed blocks of each level.
+
+#define TEXTURE_CACHE_MAGIC     0x58455442u     // "BTEX" read as a little-endian integer.
+#define TEXTURE_CACHE_VERSION   4u
+#define TEXTURE_CACHE_MAX_LEVELS 32
+
+struct TextureCacheHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t sourceHash;
+    uint32_t numComponents;
+    uint32_t numLevels;
+    uint32_t internalFormat;    // GL_RGB8, or the compressed format of the levels.
+    uint32_t padding;
+};
+
+struct TextureCacheLevel
+{
+    uint32_t width;
+    uint32_t height;
+    uint64_t offset;    // Offset of the level's pixels from the start of the file.
+    uint64_t size;      // Size of the level's pixels in bytes.
+};
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Compute a 64-bit hash of the content of the file with the input filename.
+// Returns 1 if successful or 0 if the file cannot be read.
+/////////////////////////////////////////////////////////////////////////////
+
+int HashFileContent(const char *filename, unsigned long long *hash)
+{
+    MappedFile file;
+    if (!MapFile(filename, &file)) return 0;
+
+    // 64-bit FNV-1a.
+    uint64_t h = 14695981039346656037ull;
+    for (size_t i = 0; i < file.size; i++) {
+        h ^= file.data[i];
+        h *= 1099511628211ull;
+    }
+
+    UnmapFile(&file);
+    *hash = h;
+    return 1;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns the name of the cache file in cacheDir for the source image file
+// sourceFilename, which is given relative to the execution path.
+// Textures built differently from the same source image are told apart
+// by variant, which is added to the name unless it is empty.
+/////////////////////////////////////////////////////////////////////////////
+
+std::string GetTextureCacheFilename(const std::string &cacheDir, const char *sourceFilename,
+                                    const char *variant)
+{
+    std::string name = sourceFilename;
+    for (size_t i = 0; i < name.size(); i++) {
+        if (name[i] == '/' || name[i] == '\\' || name[i] == ':') name[i] = '_';
+    }
+    if (variant != NULL && variant[0] != '\0') name += std::string(".") + variant;
+    return cacheDir + "/" + name + ".texcache";
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Upload all the mipmap levels stored in the cache file into the texture
+// object currently bound to GL_TEXTURE_2D.
+// Returns 1 if successful, or 0 if the cache file is missing, stale
+// (its source hash differs from sourceHash) or corrupted. Nothing is
+// uploaded if 0 is returned.
+/////////////////////////////////////////////////////////////////////////////
+
+int UploadCachedTexture(const char *cacheFilename, unsigned long long sourceHash)
+{
+    MappedFile file;
+    if (!MapFile(cacheFilename, &file)) return 0;
+
+    // Validate the whole file before uploading anything.
+    const TextureCacheHeader *header = (const TextureCacheHeader *) file.data;
+    const TextureCacheLevel *levels = (const TextureCacheLevel *) (file.data + sizeof(TextureCacheHeader));
+
+    int valid = file.size >= sizeof(TextureCacheHeader) &&
+                header->magic == TEXTURE_CACHE_MAGIC &&
+                header->version == TEXTURE_CACHE_VERSION &&
+                header->sourceHash == sourceHash &&
+                header->numLevels >= 1 && header->numLevels <= TEXTURE_CACHE_MAX_LEVELS &&
+                file.size >= sizeof(TextureCacheHeader) + header->numLevels * sizeof(TextureCacheLevel);
+
+    // Compressed levels can only be used where the format is supported.
+    bool compressed = valid && header->internalFormat != GL_RGB8;
+    if (compressed)
+        valid = header->internalFormat == GetCompressedTextureFormat(header->numComponents) && HasTextureCompression();
+    else if (valid)
+        valid = header->numComponents == 3;
+
+    for (uint32_t i = 0; valid && i < header->numLevels; i++) {
+        uint64_t size = compressed ? GetCompressedImageSize(levels[i].width, levels[i].height, header->numComponents)
+                                   : (uint64_t) levels[i].width * levels[i].height * header->numComponents;
+        valid = size == levels[i].size &&
+                levels[i].offset <= file.size && levels[i].size <= file.size - levels[i].offset;
+    }
+
+    if (!valid) {
+        UnmapFile(&file);
+        return 0;
+    }
+
+    // Upload straight from the mapped file, one mipmap level at a time.
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (uint32_t i = 0; i < header->numLevels; i++) {
+        if (compressed)
+            glCompressedTexImage2D(GL_TEXTURE_2D, i, header->internalFormat, levels[i].width, levels[i].height, 0,
+                                   (GLsizei) levels[i].size, file.data + levels[i].offset);
+        else
+            glTexImage2D(GL_TEXTURE_2D, i, GL_RGB, levels[i].width, levels[i].height, 0,
+                         GL_RGB, GL_UNSIGNED_BYTE, file.data + levels[i].offset);
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, header->numLevels - 1);
+
+    UnmapFile(&file);
+    return 1;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Read back all the mipmap levels of the GL_RGB texture, or of the texture
+// compressed by UploadCompressedMipmappedTexture(), currently bound to
+// GL_TEXTURE_2D and write them to the cache file, tagged with sourceHash.
+// The cache directory is created if it does not exist.
+// Returns 1 if successful or 0 if unsuccessful.
+/////////////////////////////////////////////////////////////////////////////
+
+int BakeCachedTexture(const char *cacheFilename, unsigned long long sourceHash)
+{
+    TextureCacheHeader header;
+    TextureCacheLevel levels[TEXTURE_CACHE_MAX_LEVELS];
+
+    header.magic = TEXTURE_CACHE_MAGIC;
+    header.version = TEXTURE_CACHE_VERSION;
+    header.sourceHash = sourceHash;
+    header.numComponents = 3;
+    header.numLevels = 0;
+    header.internalFormat = GL_RGB8;
+    header.padding = 0;
+
+    // Compressed textures are stored as they are.
+    GLint compressed = GL_FALSE;
+    glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_COMPRESSED, &compressed);
+    if (compressed) {
+        GLint internalFormat = 0;
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_INTERNAL_FORMAT, &internalFormat);
+        if ((GLuint) internalFormat == GetCompressedTextureFormat(4)) header.numComponents = 4;
+        else if ((GLuint) internalFormat != GetCompressedTextureFormat(3)) return 0;
+        header.internalFormat = internalFormat;
+    }
+
+    // Collect the level sizes, down to the 1x1 level.
+    uint64_t offset = sizeof(TextureCacheHeader);
+    for (int i = 0; i < TEXTURE_CACHE_MAX_LEVELS; i++) {
+        GLint w = 0, h = 0;
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, i, GL_TEXTURE_WIDTH, &w);
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, i, GL_TEXTURE_HEIGHT, &h);
+        if (w <= 0 || h <= 0) break;
+
+        levels[i].width = w;
+        levels[i].height = h;
+        levels[i].size = compressed ? GetCompressedImageSize(w, h, header.numComponents) : (uint64_t) w * h * 3;
+        header.numLevels++;
+        if (w == 1 && h == 1) break;
+    }
+    if (header.numLevels == 0) return 0;
+
+    offset += header.numLevels * sizeof(TextureCacheLevel);
+    for (uint32_t i = 0; i < header.numLevels; i++) {
+        levels[i].offset = offset;
+        offset += levels[i].size;
+    }
+
+    // Write to a temporary file first, so that an interrupted bake never
+    // leaves a truncated cache file behind.
+    std::string dir = cacheFilename;
+    size_t slash = dir.find_last_of("/\\");
+    if (slash != std::string::npos) mkdir(dir.substr(0, slash).c_str(), 0755);
+
+    std::string tmpFilename = std::string(cacheFilename) + ".tmp";
+    FILE *fp = fopen(tmpFilename.c_str(), "wb");
+    if (fp == NULL) {
+        fprintf(stderr, "Warning: Cannot write texture cache file %s.\n", tmpFilename.c_str());
+        return 0;
+    }
+
+    int success = fwrite(&header, sizeof(header), 1, fp) == 1 &&
+                  fwrite(levels, sizeof(TextureCacheLevel), header.numLevels, fp) == header.numLevels;
+
+    // Level 0 is the largest level, so its buffer is reused for the others.
+    unsigned char *pixels = (unsigned char *) AllocatePooledBlock(levels[0].size);
+    if (pixels == NULL) success = 0;
+
+    GLint packAlignment;
+    glGetIntegerv(GL_PACK_ALIGNMENT, &packAlignment);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    for (uint32_t i = 0; success && i < header.numLevels; i++) {
+        if (compressed)
+            glGetCompressedTexImage(GL_TEXTURE_2D, i, pixels);
+        else
+            glGetTexImage(GL_TEXTURE_2D, i, GL_RGB, GL_UNSIGNED_BYTE, pixels);
+        success = fwrite(pixels, 1, levels[i].size, fp) == levels[i].size;
+    }
+    glPixelStorei(GL_PACK_ALIGNMENT, packAlignment);
+    FreePooledBlock(pixels);
+
+    if (fclose(fp) != 0) success = 0;
+
+    // On Windows, rename() does not replace an existing file, so the old
+    // cache file is only removed if the rename fails, before retrying it.
+    if (success && rename(tmpFilename.c_str(), cacheFilename) != 0) {
+        remove(cacheFilename);
+        success = rename(tmpFilename.c_str(), cacheFilename) == 0;
+    }
+    if (!success) {
+        fprintf(stderr, "Warning: Cannot write texture cache file %s.\n", cacheFilename);
+        remove(tmpFilename.c_str());
+        return 0;
+    }
+    return 1;
+}
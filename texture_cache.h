@@ -0,0 +1,61 @@
+#ifndef _TEXTURE_CACHE_H_
+#define _TEXTURE_CACHE_H_
+
+#include <string>
+
+/////////////////////////////////////////////////////////////////////////////
+// The baked-texture cache keeps the fully decoded pixels and the complete
+// mipmap chain of a texture in a binary file, so that a later run can
+// upload the texture straight from the memory-mapped file without decoding
+// the source image or generating mipmaps.
+// Compressed textures are stored as their compressed blocks, so they are
+// not encoded again either.
+//
+// Each cache file records a hash of the content of its source image file.
+// A cache file whose hash does not match the current source file is stale
+// and is ignored, and is overwritten when the texture is baked again.
+/////////////////////////////////////////////////////////////////////////////
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Compute a 64-bit hash of the content of the file with the input filename.
+// Returns 1 if successful or 0 if the file cannot be read.
+/////////////////////////////////////////////////////////////////////////////
+
+extern int HashFileContent(const char *filename, unsigned long long *hash);
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns the name of the cache file in cacheDir for the source image file
+// sourceFilename, which is given relative to the execution path.
+// Textures built differently from the same source image are told apart
+// by variant, which is added to the name unless it is empty.
+/////////////////////////////////////////////////////////////////////////////
+
+extern std::string GetTextureCacheFilename(const std::string &cacheDir, const char *sourceFilename,
+                                           const char *variant);
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Upload all the mipmap levels stored in the cache file into the texture
+// object currently bound to GL_TEXTURE_2D.
+// Returns 1 if successful, or 0 if the cache file is missing, stale
+// (its source hash differs from sourceHash) or corrupted. Nothing is
+// uploaded if 0 is returned.
+/////////////////////////////////////////////////////////////////////////////
+
+extern int UploadCachedTexture(const char *cacheFilename, unsigned long long sourceHash);
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Read back all the mipmap levels of the GL_RGB texture, or of the texture
+// compressed by UploadCompressedMipmappedTexture(), currently bound to
+// GL_TEXTURE_2D and write them to the cache file, tagged with sourceHash.
+// The cache directory is created if it does not exist.
+// Returns 1 if successful or 0 if unsuccessful.
+/////////////////////////////////////////////////////////////////////////////
+
+extern int BakeCachedTexture(const char *cacheFilename, unsigned long long sourceHash);
+
+
+#endif
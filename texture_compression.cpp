@@ -0,0 +1,546 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <vector>
+
+#ifdef __APPLE__
+#define GL_SILENCE_DEPRECATION
+#include <GLUT/glut.h>
+#include <OpenGL/glext.h>
+#else
+#include <GL/glew.h>
+#include <GL/glut.h>
+#endif
+
+#include "image_pool.h"
+#include "mipmap.h"
+#include "texture_compression.h"
+#include "timer.h"
+
+
+
+// A 4x4 block of texels, always with 4 components.
+struct TexelBlock
+{
+    int texels[16][4];
+};
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns 1 if the OpenGL implementation supports S3TC textures or 0 if not.
+/////////////////////////////////////////////////////////////////////////////
+
+int HasTextureCompression(void)
+{
+#ifdef __APPLE__
+    return 1;   // All Macs support S3TC.
+#else
+    return GLEW_EXT_texture_compression_s3tc ? 1 : 0;
+#endif
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns the OpenGL internal format of compressed images with the given
+// number of components (3 or 4), or 0 if there is none.
+/////////////////////////////////////////////////////////////////////////////
+
+unsigned int GetCompressedTextureFormat(int numComponents)
+{
+    switch (numComponents) {
+        case 3:  return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+        case 4:  return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+        default: return 0;
+    }
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns the size in bytes of the compressed blocks of an image of the
+// given size and number of components (3 or 4).
+/////////////////////////////////////////////////////////////////////////////
+
+size_t GetCompressedImageSize(int imageWidth, int imageHeight, int numComponents)
+{
+    size_t numBlocks = (size_t) ((imageWidth + 3) / 4) * ((imageHeight + 3) / 4);
+    return numBlocks * ((numComponents == 4) ? 16 : 8);
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// BC1 color block encoder.
+/////////////////////////////////////////////////////////////////////////////
+
+static inline int ClampToByte(float v)
+{
+    return (v <= 0.0f) ? 0 : (v >= 255.0f) ? 255 : (int) (v + 0.5f);
+}
+
+static inline uint16_t PackRGB565(const float rgb[3])
+{
+    int r = (ClampToByte(rgb[0]) * 31 + 127) / 255;
+    int g = (ClampToByte(rgb[1]) * 63 + 127) / 255;
+    int b = (ClampToByte(rgb[2]) * 31 + 127) / 255;
+    return (uint16_t) ((r << 11) | (g << 5) | b);
+}
+
+static inline void UnpackRGB565(uint16_t c, int rgb[3])
+{
+    int r = (c >> 11) & 31, g = (c >> 5) & 63, b = c & 31;
+    rgb[0] = (r << 3) | (r >> 2);
+    rgb[1] = (g << 2) | (g >> 4);
+    rgb[2] = (b << 3) | (b >> 2);
+}
+
+
+// Choose the nearest of the 4 colors of the palette of endpoints c0 > c1
+// for every texel. Returns the squared error of the block.
+static int ChooseColorIndices(const TexelBlock &block, uint16_t c0, uint16_t c1, uint32_t *indices)
+{
+    int palette[4][3];
+    UnpackRGB565(c0, palette[0]);
+    UnpackRGB565(c1, palette[1]);
+    for (int c = 0; c < 3; c++) {
+        palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+        palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+    }
+
+    int error = 0;
+    *indices = 0;
+    for (int i = 0; i < 16; i++) {
+        int best = 0, bestError = 0x7fffffff;
+        for (int p = 0; p < 4; p++) {
+            int dr = block.texels[i][0] - palette[p][0];
+            int dg = block.texels[i][1] - palette[p][1];
+            int db = block.texels[i][2] - palette[p][2];
+            int e = dr * dr + dg * dg + db * db;
+            if (e < bestError) {
+                bestError = e;
+                best = p;
+            }
+        }
+        *indices |= (uint32_t) best << (2 * i);
+        error += bestError;
+    }
+    return error;
+}
+
+
+// Quantize the endpoints and choose the indices, keeping the result in
+// (*bestC0, *bestC1, *bestIndices) if its error is below (*bestError).
+static void TryColorEndpoints(const TexelBlock &block, const float end0[3], const float end1[3],
+                              uint16_t *bestC0, uint16_t *bestC1, uint32_t *bestIndices, int *bestError)
+{
+    uint16_t c0 = PackRGB565(end0);
+    uint16_t c1 = PackRGB565(end1);
+    if (c0 < c1) {
+        uint16_t t = c0;
+        c0 = c1;
+        c1 = t;
+    }
+
+    uint32_t indices;
+    int error;
+    if (c0 == c1) {
+        // All texels use c0. Equal endpoints would select the 3-color mode
+        // of BC1, in which index 0 still means c0.
+        int rgb[3];
+        UnpackRGB565(c0, rgb);
+        indices = 0;
+        error = 0;
+        for (int i = 0; i < 16; i++) {
+            for (int c = 0; c < 3; c++) error += (block.texels[i][c] - rgb[c]) * (block.texels[i][c] - rgb[c]);
+        }
+    }
+    else error = ChooseColorIndices(block, c0, c1, &indices);
+
+    if (error < *bestError) {
+        *bestC0 = c0;
+        *bestC1 = c1;
+        *bestIndices = indices;
+        *bestError = error;
+    }
+}
+
+
+// Encode the colors of the block into 8 bytes of BC1.
+// The endpoints are first taken along the principal axis of the colors,
+// then refined once by least squares for the chosen indices.
+static void EncodeColorBlock(const TexelBlock &block, uchar *out)
+{
+    float mean[3] = { 0.0f, 0.0f, 0.0f };
+    for (int i = 0; i < 16; i++) {
+        for (int c = 0; c < 3; c++) mean[c] += block.texels[i][c];
+    }
+    for (int c = 0; c < 3; c++) mean[c] /= 16.0f;
+
+    float cov[6] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };   // rr, rg, rb, gg, gb, bb.
+    for (int i = 0; i < 16; i++) {
+        float r = block.texels[i][0] - mean[0];
+        float g = block.texels[i][1] - mean[1];
+        float b = block.texels[i][2] - mean[2];
+        cov[0] += r * r; cov[1] += r * g; cov[2] += r * b;
+        cov[3] += g * g; cov[4] += g * b; cov[5] += b * b;
+    }
+
+    // Principal axis by power iteration.
+    float axis[3] = { 1.0f, 1.0f, 1.0f };
+    for (int iter = 0; iter < 8; iter++) {
+        float x = cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2];
+        float y = cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2];
+        float z = cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2];
+        float len = sqrtf(x * x + y * y + z * z);
+        if (len < 1e-6f) break;
+        axis[0] = x / len;
+        axis[1] = y / len;
+        axis[2] = z / len;
+    }
+
+    float tMin = 0.0f, tMax = 0.0f;
+    for (int i = 0; i < 16; i++) {
+        float t = (block.texels[i][0] - mean[0]) * axis[0] + (block.texels[i][1] - mean[1]) * axis[1] +
+                  (block.texels[i][2] - mean[2]) * axis[2];
+        if (t < tMin) tMin = t;
+        if (t > tMax) tMax = t;
+    }
+
+    // Inset the endpoints a little, as the extremes are usually outliers.
+    float inset = (tMax - tMin) / 16.0f;
+    tMin += inset;
+    tMax -= inset;
+
+    float end0[3], end1[3];
+    for (int c = 0; c < 3; c++) {
+        end0[c] = mean[c] + axis[c] * tMax;
+        end1[c] = mean[c] + axis[c] * tMin;
+    }
+
+    uint16_t c0 = 0, c1 = 0;
+    uint32_t indices = 0;
+    int error = 0x7fffffff;
+    TryColorEndpoints(block, end0, end1, &c0, &c1, &indices, &error);
+
+    // Least-squares fit of the endpoints to the chosen indices.
+    if (c0 != c1) {
+        static const float weights[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+        float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+        float ax[3] = { 0.0f, 0.0f, 0.0f }, bx[3] = { 0.0f, 0.0f, 0.0f };
+        for (int i = 0; i < 16; i++) {
+            float a = weights[(indices >> (2 * i)) & 3], b = 1.0f - a;
+            aa += a * a;
+            ab += a * b;
+            bb += b * b;
+            for (int c = 0; c < 3; c++) {
+                ax[c] += a * block.texels[i][c];
+                bx[c] += b * block.texels[i][c];
+            }
+        }
+        float det = aa * bb - ab * ab;
+        if (fabsf(det) > 1e-6f) {
+            for (int c = 0; c < 3; c++) {
+                end0[c] = (ax[c] * bb - bx[c] * ab) / det;
+                end1[c] = (bx[c] * aa - ax[c] * ab) / det;
+            }
+            TryColorEndpoints(block, end0, end1, &c0, &c1, &indices, &error);
+        }
+    }
+
+    out[0] = (uchar) c0;
+    out[1] = (uchar) (c0 >> 8);
+    out[2] = (uchar) c1;
+    out[3] = (uchar) (c1 >> 8);
+    for (int i = 0; i < 4; i++) out[4 + i] = (uchar) (indices >> (8 * i));
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// BC3 alpha block encoder.
+/////////////////////////////////////////////////////////////////////////////
+
+// Encode the alphas of the block into 8 bytes, with the endpoints at the
+// minimum and maximum alpha and 6 values interpolated between them.
+static void EncodeAlphaBlock(const TexelBlock &block, uchar *out)
+{
+    int a0 = 0, a1 = 255;
+    for (int i = 0; i < 16; i++) {
+        if (block.texels[i][3] > a0) a0 = block.texels[i][3];
+        if (block.texels[i][3] < a1) a1 = block.texels[i][3];
+    }
+
+    uint64_t indices = 0;
+    if (a0 > a1) {
+        int palette[8];
+        palette[0] = a0;
+        palette[1] = a1;
+        for (int p = 2; p < 8; p++) palette[p] = ((8 - p) * a0 + (p - 1) * a1) / 7;
+
+        for (int i = 0; i < 16; i++) {
+            int best = 0, bestError = 256;
+            for (int p = 0; p < 8; p++) {
+                int e = abs(block.texels[i][3] - palette[p]);
+                if (e < bestError) {
+                    bestError = e;
+                    best = p;
+                }
+            }
+            indices |= (uint64_t) best << (3 * i);
+        }
+    }
+
+    out[0] = (uchar) a0;
+    out[1] = (uchar) a1;
+    for (int i = 0; i < 6; i++) out[2 + i] = (uchar) (indices >> (8 * i));
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Compress an image with 3 (to BC1) or 4 (to BC3) components into blocks,
+// which must hold GetCompressedImageSize() bytes. The blocks are in the
+// same row order as the image, as expected by glCompressedTexImage2D().
+/////////////////////////////////////////////////////////////////////////////
+
+void CompressImage(const uchar *imageData, int imageWidth, int imageHeight,
+                   int numComponents, uchar *blocks)
+{
+    const int numBlocksX = (imageWidth + 3) / 4;
+    const int numBlocksY = (imageHeight + 3) / 4;
+
+    for (int by = 0; by < numBlocksY; by++) {
+        for (int bx = 0; bx < numBlocksX; bx++) {
+            // Blocks that overhang the image repeat its last row and column.
+            TexelBlock block;
+            for (int i = 0; i < 16; i++) {
+                int x = bx * 4 + (i & 3), y = by * 4 + (i >> 2);
+                if (x >= imageWidth) x = imageWidth - 1;
+                if (y >= imageHeight) y = imageHeight - 1;
+                const uchar *texel = imageData + ((size_t) y * imageWidth + x) * numComponents;
+                for (int c = 0; c < 4; c++) block.texels[i][c] = (c < numComponents) ? texel[c] : 255;
+            }
+
+            if (numComponents == 4) {
+                EncodeAlphaBlock(block, blocks);
+                blocks += 8;
+            }
+            EncodeColorBlock(block, blocks);
+            blocks += 8;
+        }
+    }
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Build the mipmaps of the input image, compress the image and all its
+// mipmap levels, and upload them into the texture object currently bound
+// to GL_TEXTURE_2D. The texture must not have immutable storage.
+// Falls back to UploadMipmappedTexture() where compressed textures or
+// non-power-of-two textures are unsupported, or if numComponents is not
+// 3 or 4. Returns 1 if successful or 0 if memory cannot be allocated, in
+// which case nothing is uploaded.
+/////////////////////////////////////////////////////////////////////////////
+
+int UploadCompressedMipmappedTexture(const uchar *imageData, int imageWidth, int imageHeight,
+                                     int numComponents, bool gammaCorrect)
+{
+#ifndef __APPLE__
+    bool hasNonPowerOfTwo = GLEW_VERSION_2_0 || GLEW_ARB_texture_non_power_of_two;
+#else
+    bool hasNonPowerOfTwo = true;
+#endif
+    GLenum internalFormat = GetCompressedTextureFormat(numComponents);
+    if (!HasTextureCompression() || !hasNonPowerOfTwo || internalFormat == 0) {
+        return UploadMipmappedTexture(imageData, imageWidth, imageHeight, numComponents, gammaCorrect);
+    }
+
+    // Level 0 has the largest blocks, so its buffer is reused for the others.
+    int numLevels = GetNumMipmapLevels(imageWidth, imageHeight);
+    uchar *mipmapChain = (uchar *) AllocatePooledBlock(GetMipmapChainSize(imageWidth, imageHeight, numComponents));
+    uchar *blocks = (uchar *) AllocatePooledBlock(GetCompressedImageSize(imageWidth, imageHeight, numComponents));
+    if (mipmapChain == NULL || blocks == NULL ||
+        !BuildMipmapChain(imageData, imageWidth, imageHeight, numComponents, gammaCorrect, mipmapChain)) {
+        FreePooledBlock(blocks);        // Either may be NULL.
+        FreePooledBlock(mipmapChain);
+        return 0;
+    }
+
+    const uchar *levelData = imageData;
+    int w = imageWidth, h = imageHeight;
+    for (int level = 0; level < numLevels; level++) {
+        size_t size = GetCompressedImageSize(w, h, numComponents);
+        CompressImage(levelData, w, h, numComponents, blocks);
+        glCompressedTexImage2D(GL_TEXTURE_2D, level, internalFormat, w, h, 0, (GLsizei) size, blocks);
+
+        levelData = (level == 0) ? mipmapChain : levelData + (size_t) w * h * numComponents;
+        w = (w > 1) ? w / 2 : 1;
+        h = (h > 1) ? h / 2 : 1;
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, numLevels - 1);
+
+    FreePooledBlock(blocks);
+    FreePooledBlock(mipmapChain);
+    return 1;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns the PSNR in dB of the compressed blocks against the input image,
+// over the color components.
+/////////////////////////////////////////////////////////////////////////////
+
+static double ComputeCompressionPSNR(const uchar *imageData, int imageWidth, int imageHeight,
+                                     int numComponents, const uchar *blocks)
+{
+    const int numBlocksX = (imageWidth + 3) / 4;
+    const int blockSize = (numComponents == 4) ? 16 : 8;
+    double sumSquares = 0.0;
+
+    for (int y = 0; y < imageHeight; y++) {
+        for (int x = 0; x < imageWidth; x++) {
+            const uchar *block = blocks + ((size_t) (y / 4) * numBlocksX + x / 4) * blockSize + blockSize - 8;
+            uint16_t c0 = (uint16_t) (block[0] | (block[1] << 8));
+            uint16_t c1 = (uint16_t) (block[2] | (block[3] << 8));
+            int index = (block[4 + (y & 3)] >> (2 * (x & 3))) & 3;
+
+            int rgb0[3], rgb1[3];
+            UnpackRGB565(c0, rgb0);
+            UnpackRGB565(c1, rgb1);
+            const uchar *texel = imageData + ((size_t) y * imageWidth + x) * numComponents;
+            for (int c = 0; c < 3; c++) {
+                int v;
+                if (index == 0) v = rgb0[c];
+                else if (index == 1) v = rgb1[c];
+                else if (c0 > c1 || numComponents == 4)
+                    v = (index == 2) ? (2 * rgb0[c] + rgb1[c]) / 3 : (rgb0[c] + 2 * rgb1[c]) / 3;
+                else
+                    v = (index == 2) ? (rgb0[c] + rgb1[c]) / 2 : 0;
+                sumSquares += (double) (v - texel[c]) * (v - texel[c]);
+            }
+        }
+    }
+
+    double mse = sumSquares / ((double) imageWidth * imageHeight * 3);
+    return (mse > 0.0) ? 10.0 * log10(255.0 * 255.0 / mse) : 99.0;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// For each of the input image files, measure the time taken to compress
+// its mipmap chain, the texture memory and the upload time of the
+// compressed and of the uncompressed mipmap chain, and the error of the
+// compression, and print the results.
+// An OpenGL context must be current.
+/////////////////////////////////////////////////////////////////////////////
+
+void BenchmarkTextureCompression(int numImages, const char * const *filenames)
+{
+    const int numRuns = 5;
+
+    if (!HasTextureCompression()) {
+        printf("S3TC textures are not supported.\n");
+        return;
+    }
+
+    printf("Best of %d runs. Memory is for the whole mipmap chain; the upload\n"
+           "times are for uploading the prebuilt mipmap chain to a new texture.\n\n", numRuns);
+    printf("%-22s %-11s %-4s %10s %10s %10s %10s %10s %10s %8s\n", "image", "size", "fmt",
+           "encode ms", "raw KB", "comp KB", "mem saved", "raw ms", "comp ms", "PSNR dB");
+
+    size_t totalRawBytes = 0, totalCompressedBytes = 0;
+    double totalRawMs = 0.0, totalCompressedMs = 0.0;
+
+    for (int i = 0; i < numImages; i++) {
+        Image image;
+        if (!ReadImage(filenames[i], &image)) continue;
+        const int w = image.Width(), h = image.Height(), n = image.NumComponents();
+        GLenum internalFormat = GetCompressedTextureFormat(n);
+        if (internalFormat == 0) continue;
+
+        const int numLevels = GetNumMipmapLevels(w, h);
+        std::vector<uchar> mipmapChain(GetMipmapChainSize(w, h, n));
+        BuildMipmapChain(image.Data(), w, h, n, false, mipmapChain.data());
+
+        // The levels, uncompressed and compressed.
+        std::vector<const uchar *> rawLevels(numLevels);
+        std::vector<size_t> compressedOffsets(numLevels + 1);
+        const uchar *levelData = image.Data();
+        size_t rawBytes = 0;
+        compressedOffsets[0] = 0;
+        for (int level = 0, lw = w, lh = h; level < numLevels; level++) {
+            rawLevels[level] = levelData;
+            levelData = (level == 0) ? mipmapChain.data() : levelData + (size_t) lw * lh * n;
+            rawBytes += (size_t) lw * lh * n;
+            compressedOffsets[level + 1] = compressedOffsets[level] + GetCompressedImageSize(lw, lh, n);
+            lw = (lw > 1) ? lw / 2 : 1;
+            lh = (lh > 1) ? lh / 2 : 1;
+        }
+        std::vector<uchar> compressed(compressedOffsets[numLevels]);
+
+        double encodeMs = -1.0, rawMs = -1.0, compressedMs = -1.0;
+        for (int run = 0; run < numRuns; run++) {
+            double startMs = GetWallClockMs();
+            for (int level = 0, lw = w, lh = h; level < numLevels; level++) {
+                CompressImage(rawLevels[level], lw, lh, n, compressed.data() + compressedOffsets[level]);
+                lw = (lw > 1) ? lw / 2 : 1;
+                lh = (lh > 1) ? lh / 2 : 1;
+            }
+            double runMs = GetWallClockMs() - startMs;
+            if (encodeMs < 0.0 || runMs < encodeMs) encodeMs = runMs;
+
+            for (int t = 0; t < 2; t++) {
+                GLuint texObj;
+                glGenTextures(1, &texObj);
+                glBindTexture(GL_TEXTURE_2D, texObj);
+                glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+                glFinish();
+
+                startMs = GetWallClockMs();
+                for (int level = 0, lw = w, lh = h; level < numLevels; level++) {
+                    if (t == 0)
+                        glTexImage2D(GL_TEXTURE_2D, level, (n == 4) ? GL_RGBA8 : GL_RGB8, lw, lh, 0,
+                                     (n == 4) ? GL_RGBA : GL_RGB, GL_UNSIGNED_BYTE, rawLevels[level]);
+                    else
+                        glCompressedTexImage2D(GL_TEXTURE_2D, level, internalFormat, lw, lh, 0,
+                                               (GLsizei) (compressedOffsets[level + 1] - compressedOffsets[level]),
+                                               compressed.data() + compressedOffsets[level]);
+                    lw = (lw > 1) ? lw / 2 : 1;
+                    lh = (lh > 1) ? lh / 2 : 1;
+                }
+                glFinish();
+                runMs = GetWallClockMs() - startMs;
+
+                glDeleteTextures(1, &texObj);
+                double &bestMs = (t == 0) ? rawMs : compressedMs;
+                if (bestMs < 0.0 || runMs < bestMs) bestMs = runMs;
+            }
+        }
+
+        size_t compressedBytes = compressed.size();
+        const char *name = strrchr(filenames[i], '/');
+        printf("%-22s %5dx%-5d %-4s %10.2f %10.1f %10.1f %9.1f%% %10.2f %10.2f %8.2f\n",
+               (name != NULL) ? name + 1 : filenames[i], w, h, (n == 4) ? "BC3" : "BC1",
+               encodeMs, rawBytes / 1024.0, compressedBytes / 1024.0,
+               100.0 * (1.0 - (double) compressedBytes / rawBytes), rawMs, compressedMs,
+               ComputeCompressionPSNR(image.Data(), w, h, n, compressed.data()));
+
+        totalRawBytes += rawBytes;
+        totalCompressedBytes += compressedBytes;
+        totalRawMs += rawMs;
+        totalCompressedMs += compressedMs;
+    }
+
+    if (totalRawBytes > 0) {
+        printf("\nTotal: %.1f KB -> %.1f KB of texture memory (%.1f%% saved), "
+               "upload %.2f ms -> %.2f ms.\n", totalRawBytes / 1024.0, totalCompressedBytes / 1024.0,
+               100.0 * (1.0 - (double) totalCompressedBytes / totalRawBytes), totalRawMs, totalCompressedMs);
+    }
+}
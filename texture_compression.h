@@ -0,0 +1,79 @@
+#ifndef _TEXTURE_COMPRESSION_H_
+#define _TEXTURE_COMPRESSION_H_
+
+#include <stddef.h>
+#include "image_io.h"
+
+/////////////////////////////////////////////////////////////////////////////
+// Block-compressed textures.
+//
+// RGB images are compressed to BC1 (DXT1) and RGBA images to BC3 (DXT5),
+// the S3TC formats, which store every 4x4 block of texels in 8 or 16 bytes.
+// A BC1 texture takes one sixth of the memory of the same texture in
+// GL_RGB8, and the compressed blocks are uploaded as they are.
+//
+// Encoding is far slower than decoding an image, so it is meant to be done
+// once, offline: the compressed mipmap chain is stored in the baked-texture
+// cache and later runs upload the blocks straight from the cache file.
+/////////////////////////////////////////////////////////////////////////////
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns 1 if the OpenGL implementation supports S3TC textures or 0 if not.
+/////////////////////////////////////////////////////////////////////////////
+
+extern int HasTextureCompression( void );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns the OpenGL internal format of compressed images with the given
+// number of components (3 or 4), or 0 if there is none.
+/////////////////////////////////////////////////////////////////////////////
+
+extern unsigned int GetCompressedTextureFormat( int numComponents );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns the size in bytes of the compressed blocks of an image of the
+// given size and number of components (3 or 4).
+/////////////////////////////////////////////////////////////////////////////
+
+extern size_t GetCompressedImageSize( int imageWidth, int imageHeight, int numComponents );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Compress an image with 3 (to BC1) or 4 (to BC3) components into blocks,
+// which must hold GetCompressedImageSize() bytes. The blocks are in the
+// same row order as the image, as expected by glCompressedTexImage2D().
+/////////////////////////////////////////////////////////////////////////////
+
+extern void CompressImage( const uchar *imageData, int imageWidth, int imageHeight,
+                           int numComponents, uchar *blocks );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Build the mipmaps of the input image, compress the image and all its
+// mipmap levels, and upload them into the texture object currently bound
+// to GL_TEXTURE_2D. The texture must not have immutable storage.
+// Falls back to UploadMipmappedTexture() where compressed textures or
+// non-power-of-two textures are unsupported, or if numComponents is not
+// 3 or 4. Returns 1 if successful or 0 if memory cannot be allocated, in
+// which case nothing is uploaded.
+/////////////////////////////////////////////////////////////////////////////
+
+extern int UploadCompressedMipmappedTexture( const uchar *imageData, int imageWidth, int imageHeight,
+                                             int numComponents, bool gammaCorrect );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// For each of the input image files, measure the time taken to compress
+// its mipmap chain, the texture memory and the upload time of the
+// compressed and of the uncompressed mipmap chain, and the error of the
+// compression, and print the results.
+// An OpenGL context must be current.
+/////////////////////////////////////////////////////////////////////////////
+
+extern void BenchmarkTextureCompression( int numImages, const char * const *filenames );
+
+
+#endif
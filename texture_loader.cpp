@@ -0,0 +1,140 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "texture_loader.h"
+
+
+
+// A decoded image waiting to be handed to the calling thread.
+struct DecodedImage
+{
+    int index;
+    int success;
+    Image image;
+};
+
+
+// State shared between the worker threads and the calling thread.
+struct DecodeQueue
+{
+    int numImages;
+    const char * const *filenames;
+    std::atomic<int> nextIndex;     // Next image to be claimed by a worker.
+
+    std::mutex mutex;
+    std::condition_variable imageDecoded;
+    std::deque<DecodedImage> decoded;   // Protected by mutex.
+};
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Decode the image at the given index in the filename list.
+/////////////////////////////////////////////////////////////////////////////
+
+static DecodedImage DecodeImage(int index, const char * const *filenames)
+{
+    DecodedImage decoded;
+    decoded.index = index;
+    decoded.success = ReadImage(filenames[index], &decoded.image, true);
+    return decoded;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Worker thread body. Repeatedly claims the next undecoded image, decodes
+// it and queues the result for the calling thread.
+/////////////////////////////////////////////////////////////////////////////
+
+static void DecodeWorker(DecodeQueue *queue)
+{
+    for (;;) {
+        int index = queue->nextIndex.fetch_add(1);
+        if (index >= queue->numImages) return;
+
+        DecodedImage decoded = DecodeImage(index, queue->filenames);
+        {
+            std::lock_guard<std::mutex> lock(queue->mutex);
+            queue->decoded.push_back(std::move(decoded));
+        }
+        queue->imageDecoded.notify_one();
+    }
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Pass a decoded image to the callback and return its pixels to the pool.
+// Returns the success status of the decode.
+/////////////////////////////////////////////////////////////////////////////
+
+static int DeliverImage(DecodedImage *decoded, ImageReadyFunc imageReady, void *userData)
+{
+    if (!decoded->success) return 0;
+
+    const Image &image = decoded->image;
+    imageReady(decoded->index, image.Data(), image.Width(), image.Height(), image.NumComponents(), userData);
+    decoded->image.Reset();
+    return 1;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Decode the numImages image files with numThreads worker threads, and
+// pass each decoded image to imageReady() on the calling thread as soon as
+// it is ready. The images may be delivered in any order.
+// If numThreads is 0, one thread per hardware core is used.
+// If numThreads is 1, the images are decoded one after another on the
+// calling thread without starting any worker thread.
+// Returns 1 if all images are decoded successfully or 0 if any fails.
+/////////////////////////////////////////////////////////////////////////////
+
+int LoadImageFiles(int numImages, const char * const *filenames, int numThreads,
+                   ImageReadyFunc imageReady, void *userData)
+{
+    if (numThreads <= 0) numThreads = (int) std::thread::hardware_concurrency();
+    if (numThreads > numImages) numThreads = numImages;
+
+    int allSuccess = 1;
+
+    if (numThreads <= 1) {
+        for (int i = 0; i < numImages; i++) {
+            DecodedImage decoded = DecodeImage(i, filenames);
+            if (!DeliverImage(&decoded, imageReady, userData)) allSuccess = 0;
+        }
+        return allSuccess;
+    }
+
+    DecodeQueue queue;
+    queue.numImages = numImages;
+    queue.filenames = filenames;
+    queue.nextIndex = 0;
+
+    std::vector<std::thread> workers;
+    for (int i = 0; i < numThreads; i++)
+        workers.push_back(std::thread(DecodeWorker, &queue));
+
+    // Upload each image while the workers are still decoding the others.
+    for (int numDelivered = 0; numDelivered < numImages; numDelivered++) {
+        DecodedImage decoded;
+        {
+            std::unique_lock<std::mutex> lock(queue.mutex);
+            queue.imageDecoded.wait(lock, [&queue] { return !queue.decoded.empty(); });
+            decoded = std::move(queue.decoded.front());
+            queue.decoded.pop_front();
+        }
+        if (!DeliverImage(&decoded, imageReady, userData)) allSuccess = 0;
+    }
+
+    for (size_t i = 0; i < workers.size(); i++) workers[i].join();
+    return allSuccess;
+}
@@ -0,0 +1,34 @@
+#ifndef _TEXTURE_LOADER_H_
+#define _TEXTURE_LOADER_H_
+
+#include "image_io.h"
+
+/////////////////////////////////////////////////////////////////////////////
+// Callback that receives one decoded image.
+// index is the position of the image's filename in the input list.
+// The image data is owned by the loader and goes back to the image pool
+// after the callback returns.
+// The callback is always called on the thread that called the loader,
+// so it may safely make OpenGL calls.
+/////////////////////////////////////////////////////////////////////////////
+
+typedef void (*ImageReadyFunc)(int index, const uchar *imageData,
+                               int imageWidth, int imageHeight, int numComponents,
+                               void *userData);
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Decode the numImages image files with numThreads worker threads, and
+// pass each decoded image to imageReady() on the calling thread as soon as
+// it is ready. The images may be delivered in any order.
+// If numThreads is 0, one thread per hardware core is used.
+// If numThreads is 1, the images are decoded one after another on the
+// calling thread without starting any worker thread.
+// Returns 1 if all images are decoded successfully or 0 if any fails.
+/////////////////////////////////////////////////////////////////////////////
+
+extern int LoadImageFiles(int numImages, const char * const *filenames, int numThreads,
+                          ImageReadyFunc imageReady, void *userData);
+
+
+#endif
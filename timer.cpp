@@ -0,0 +1,142 @@
+#include <stdlib.h>
+#include <chrono>
+
+#ifdef __APPLE__
+#define GL_SILENCE_DEPRECATION
+#include <GLUT/glut.h>
+#else
+#include <GL/glew.h>
+#include <GL/glut.h>
+#endif
+
+#include "timer.h"
+
+
+#define GPU_TIMER_RING_SIZE     4   // Measurements that may be waiting for their results.
+
+
+struct GPUTimer
+{
+    unsigned int queries[GPU_TIMER_RING_SIZE][2];   // Timestamps at the start and at the end.
+    bool pending[GPU_TIMER_RING_SIZE];              // True while the result is not read yet.
+    int next;                                       // The slot of the next measurement.
+    int oldest;                                     // The slot of the oldest pending measurement.
+    bool measuring;                                 // True between Begin and End, unless skipped.
+    double lastMs;
+};
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns the current wall-clock time in milliseconds.
+// Only differences between two returned values are meaningful.
+/////////////////////////////////////////////////////////////////////////////
+
+double GetWallClockMs()
+{
+    using namespace std::chrono;
+    return duration<double, std::milli>(steady_clock::now().time_since_epoch()).count();
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Create a GPU timer. Returns NULL if timer queries are unsupported.
+// An OpenGL context must be current.
+/////////////////////////////////////////////////////////////////////////////
+
+GPUTimer *CreateGPUTimer()
+{
+#ifdef __APPLE__
+    return NULL;    // Apple's legacy contexts have no timestamp queries.
+#else
+    if (!GLEW_VERSION_3_3 && !GLEW_ARB_timer_query) return NULL;
+
+    GPUTimer *timer = new GPUTimer;
+    glGenQueries(2 * GPU_TIMER_RING_SIZE, &timer->queries[0][0]);
+    for (int i = 0; i < GPU_TIMER_RING_SIZE; i++) timer->pending[i] = false;
+    timer->next = 0;
+    timer->oldest = 0;
+    timer->measuring = false;
+    timer->lastMs = -1.0;
+    return timer;
+#endif
+}
+
+
+
+// Read the results of the pending measurements that are ready, oldest
+// first, stopping at the first that is not.
+static void ReadGPUTimerResults(GPUTimer *timer)
+{
+#ifndef __APPLE__
+    while (timer->pending[timer->oldest]) {
+        GLuint ready = GL_FALSE;
+        glGetQueryObjectuiv(timer->queries[timer->oldest][1], GL_QUERY_RESULT_AVAILABLE, &ready);
+        if (!ready) break;
+
+        // The start is ready if the end is, as it was issued before it.
+        GLuint64 start = 0, end = 0;
+        glGetQueryObjectui64v(timer->queries[timer->oldest][0], GL_QUERY_RESULT, &start);
+        glGetQueryObjectui64v(timer->queries[timer->oldest][1], GL_QUERY_RESULT, &end);
+        timer->lastMs = (double)(end - start) * 1.0e-6;
+        timer->pending[timer->oldest] = false;
+        timer->oldest = (timer->oldest + 1) % GPU_TIMER_RING_SIZE;
+    }
+#endif
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Start and end a measurement. A measurement is skipped if the ring is
+// full of measurements whose results are not ready yet.
+/////////////////////////////////////////////////////////////////////////////
+
+void BeginGPUTimer(GPUTimer *timer)
+{
+#ifndef __APPLE__
+    ReadGPUTimerResults(timer);
+    timer->measuring = !timer->pending[timer->next];
+    if (timer->measuring) glQueryCounter(timer->queries[timer->next][0], GL_TIMESTAMP);
+#endif
+}
+
+void EndGPUTimer(GPUTimer *timer)
+{
+#ifndef __APPLE__
+    if (!timer->measuring) return;
+    glQueryCounter(timer->queries[timer->next][1], GL_TIMESTAMP);
+    timer->pending[timer->next] = true;
+    timer->next = (timer->next + 1) % GPU_TIMER_RING_SIZE;
+    timer->measuring = false;
+#endif
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns the GPU time in milliseconds of the latest measurement whose
+// result is ready, or -1 if none is ready yet.
+/////////////////////////////////////////////////////////////////////////////
+
+double GetGPUTimerMs(GPUTimer *timer)
+{
+    ReadGPUTimerResults(timer);
+    return timer->lastMs;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Delete the GPU timer.
+/////////////////////////////////////////////////////////////////////////////
+
+void DeleteGPUTimer(GPUTimer *timer)
+{
+    if (timer == NULL) return;
+#ifndef __APPLE__
+    glDeleteQueries(2 * GPU_TIMER_RING_SIZE, &timer->queries[0][0]);
+#endif
+    delete timer;
+}
@@ -0,0 +1,57 @@
+#ifndef _TIMER_H_
+#define _TIMER_H_
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns the current wall-clock time in milliseconds.
+// Only differences between two returned values are meaningful.
+/////////////////////////////////////////////////////////////////////////////
+
+extern double GetWallClockMs();
+
+
+/////////////////////////////////////////////////////////////////////////////
+// GPU timers.
+//
+// A GPU timer measures the time that the GPU takes to execute the commands
+// between BeginGPUTimer() and EndGPUTimer(), with timestamp queries, so
+// timers may be nested. The results are read back when they are ready,
+// a frame or a few later, so the CPU never waits for the GPU; a ring of
+// queries lets a measurement start before the previous ones are read.
+/////////////////////////////////////////////////////////////////////////////
+
+struct GPUTimer;
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Create a GPU timer. Returns NULL if timer queries are unsupported.
+// An OpenGL context must be current.
+/////////////////////////////////////////////////////////////////////////////
+
+extern GPUTimer *CreateGPUTimer();
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Start and end a measurement. A measurement is skipped if the ring is
+// full of measurements whose results are not ready yet.
+/////////////////////////////////////////////////////////////////////////////
+
+extern void BeginGPUTimer( GPUTimer *timer );
+extern void EndGPUTimer( GPUTimer *timer );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns the GPU time in milliseconds of the latest measurement whose
+// result is ready, or -1 if none is ready yet.
+/////////////////////////////////////////////////////////////////////////////
+
+extern double GetGPUTimerMs( GPUTimer *timer );
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Delete the GPU timer.
+/////////////////////////////////////////////////////////////////////////////
+
+extern void DeleteGPUTimer( GPUTimer *timer );
+
+
+#endif